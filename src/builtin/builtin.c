@@ -5,7 +5,11 @@
  * This file is licensed under the GNU General Public License v3 or later.
  * See <https://www.gnu.org/licenses/> for details.
  */
+#define _DEFAULT_SOURCE
+
 #include "builtin.h"
+#include "expander/arith.h"
+#include <ctype.h>
 
 static builtin_entry_t *builtins = NULL;
 
@@ -21,6 +25,14 @@ void builtin_init() {
   shput(builtins, "bg", builtin_bg);
   shput(builtins, "history", builtin_history);
   shput(builtins, "type", builtin_fn_type);
+  shput(builtins, "hash", builtin_hash);
+  shput(builtins, "export", builtin_export);
+  shput(builtins, "unset", builtin_unset);
+  shput(builtins, "let", builtin_let);
+  shput(builtins, "batch", builtin_batch);
+  shput(builtins, "source", builtin_source);
+  shput(builtins, ".", builtin_source);
+  shput(builtins, "set", builtin_set);
 }
 
 /* --- BUILTIN LOOKUP --- */
@@ -29,6 +41,19 @@ bool builtin_is_builtin(char *name) { return shget(builtins, name) != NULL; }
 
 builtin_fn_t builtin_get_function(char *name) { return shget(builtins, name); }
 
+size_t builtin_count(void) { return (size_t)shlen(builtins); }
+
+const char *builtin_name_at(size_t i) { return builtins[i].key; }
+
+bool builtin_is_pure(const char *name) {
+  static const char *pure[] = {"echo", "pwd", "type"};
+  for (size_t i = 0; i < sizeof(pure) / sizeof(pure[0]); i++) {
+    if (strcmp(name, pure[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
 /* --- CLASSIC BUILTINS --- */
 
 int builtin_cd(int argc, char *argv[]) {
@@ -46,8 +71,9 @@ int builtin_cd(int argc, char *argv[]) {
 }
 
 int builtin_echo(int argc, char *argv[]) {
+  // no trailing blank, it would end up in command substitutions
   for (int i = 1; i < argc; i++)
-    printf("%s ", argv[i]);
+    printf(i > 1 ? " %s" : "%s", argv[i]);
 
   printf("\n");
   return 0;
@@ -85,4 +111,105 @@ int builtin_fn_type(int argc, char *argv[]) {
     }
   }
   return 0;
-}
\ No newline at end of file
+}
+
+int builtin_hash(int argc, char *argv[]) {
+  if (argc == 1) {
+    command_hash_print();
+    return 0;
+  }
+
+  if (strcmp(argv[1], "-r") == 0) {
+    command_hash_flush();
+    return 0;
+  }
+
+  // '~user' home directories
+  if (strcmp(argv[1], "-u") == 0) {
+    passwd_cache_flush();
+    return 0;
+  }
+
+  // hashing a name again refreshes its location
+  int status = 0;
+  for (int i = 1; i < argc; i++) {
+    if (builtin_is_builtin(argv[i]))
+      continue;
+    command_hash_forget(argv[i]);
+    if (!command_hash_lookup(argv[i])) {
+      fprintf(stderr, "hash: %s: not found\n", argv[i]);
+      status = 1;
+    }
+  }
+  return status;
+}
+
+static bool is_valid_identifier(const char *name, size_t len) {
+  if (len == 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_'))
+    return false;
+  for (size_t i = 1; i < len; i++) {
+    if (!isalnum((unsigned char)name[i]) && name[i] != '_')
+      return false;
+  }
+  return true;
+}
+
+int builtin_export(int argc, char *argv[]) {
+  shell_state_t *sh_state = shell_state_get();
+  if (argc == 1) {
+    for (int i = 0; i < shlen(sh_state->environment); i++)
+      printf("export %s=\"%s\"\n", sh_state->environment[i].key,
+             shell_state_getenv(sh_state->environment[i].key));
+    return 0;
+  }
+
+  int status = 0;
+  for (int i = 1; i < argc; i++) {
+    char *eq = strchr(argv[i], '=');
+    size_t name_len = eq ? (size_t)(eq - argv[i]) : strlen(argv[i]);
+    if (!is_valid_identifier(argv[i], name_len)) {
+      fprintf(stderr, "export: '%s': not a valid identifier\n", argv[i]);
+      status = 1;
+      continue;
+    }
+
+    char *name = xstrdup_n(argv[i], name_len);
+    if (eq)
+      shell_state_setenv(name, eq + 1);
+
+    // exported variables are inherited by the commands run afterwards
+    shell_state_export(name);
+    free(name);
+  }
+  return status;
+}
+
+int builtin_unset(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    shell_state_unsetenv(argv[i]);
+    unsetenv(argv[i]);
+  }
+  return 0;
+}
+
+// each argument is an expression, the status tells whether the last one is 0
+int builtin_let(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "let: expression expected\n");
+    return 1;
+  }
+
+  long long value = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!arith_eval_str(argv[i], &value))
+      return 1;
+  }
+  return value != 0 ? 0 : 1;
+}
+
+// 'batch' is a prefix handled by the executor, it only gets here when it
+// cannot apply (e.g. inside a pipeline)
+int builtin_batch(int argc, char *argv[]) {
+  fprintf(stderr, "batch: only valid as the prefix of a simple command\n");
+  return 2;
+}
@@ -10,6 +10,8 @@
 #ifndef NOVASH_BUILTIN_H
 #define NOVASH_BUILTIN_H
 
+#include "executor/command_hash.h"
+#include "shell/passwd_cache.h"
 #include "shell/state.h"
 #include "utils/collections.h"
 #include "utils/system/syscall.h"
@@ -32,14 +34,34 @@ void builtin_init();
 bool builtin_is_builtin(char *name);
 builtin_fn_t builtin_get_function(char *name);
 
+/**
+ * @brief Number of builtins, to list their names with builtin_name_at().
+ */
+size_t builtin_count(void);
+const char *builtin_name_at(size_t i);
+
+/**
+ * @brief Tells whether a builtin only writes to its output, without reading
+ * its input nor changing the state of the shell. Such builtins can run in the
+ * shell process where a subshell is expected (command substitution).
+ */
+bool builtin_is_pure(const char *name);
+
 /* builtin commands */
 int builtin_cd(int argc, char *argv[]);
 int builtin_echo(int argc, char *argv[]);
 int builtin_exit(int argc, char *argv[]);
 int builtin_pwd(int argc, char *argv[]);
 int builtin_fn_type(int argc, char *argv[]);
+int builtin_hash(int argc, char *argv[]);
+int builtin_export(int argc, char *argv[]);
+int builtin_unset(int argc, char *argv[]);
+int builtin_let(int argc, char *argv[]);
+int builtin_batch(int argc, char *argv[]);
 
 int builtin_history(int argc, char *argv[]);
+int builtin_source(int argc, char *argv[]);
+int builtin_set(int argc, char *argv[]);
 
 int builtin_jobs(int argc, char *argv[]);
 int builtin_fg(int argc, char *argv[]);
@@ -6,6 +6,7 @@
  * See <https://www.gnu.org/licenses/> for details.
  */
 #include "history/history.h"
+#include "history/history_index.h"
 #include "builtin.h"
 
 int builtin_history(int argc, char *argv[]) {
@@ -25,6 +26,7 @@ int builtin_history(int argc, char *argv[]) {
 
       hist->cmd_count = 0;
       hist->start = 0;
+      history_index_free();
     }
   }
   return 0;
@@ -17,7 +17,8 @@ int builtin_jobs(int argc, char *argv[]) {
   shell_jobs_t *sh_jobs = shell_state_get_jobs();
   job_t *job = sh_jobs->jobs;
   while (job) {
-    jobs_print_job_status(job);
+    if (!job->is_procsub)
+      jobs_print_job_status(job);
     job = job->next;
   }
 
@@ -0,0 +1,83 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "builtin.h"
+#include <stddef.h>
+
+typedef struct {
+  const char *name;
+  size_t offset;           /**< Offset of the bool in shell_flags_t */
+  void (*on_enable)(void); /**< Optional hook run by 'set -o name' */
+} shell_option_t;
+
+// options that can be toggled with 'set -o name' / 'set +o name'
+static const shell_option_t options[] = {
+    {"autobatch", offsetof(shell_flags_t, auto_batch), NULL},
+#ifdef NSH_LINE_EDITOR
+    {"autosuggest", offsetof(shell_flags_t, autosuggest), NULL},
+#endif
+    {"globprune", offsetof(shell_flags_t, glob_prune), NULL},
+#ifdef NSH_LINE_EDITOR
+    {"highlight", offsetof(shell_flags_t, highlight), NULL},
+#endif
+    {"history", offsetof(shell_flags_t, history_enabled), NULL},
+#ifdef NSH_LINE_EDITOR
+    {"lineedit", offsetof(shell_flags_t, line_edit), NULL},
+#endif
+    {"userprefetch", offsetof(shell_flags_t, user_prefetch),
+     passwd_cache_prefetch},
+};
+
+static const shell_option_t *find_option(const char *name) {
+  for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+    if (strcmp(options[i].name, name) == 0)
+      return &options[i];
+  }
+  return NULL;
+}
+
+static bool *option_flag(const shell_option_t *opt) {
+  shell_state_t *sh_state = shell_state_get();
+  return (bool *)((char *)&sh_state->flags + opt->offset);
+}
+
+static void print_options(void) {
+  for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++)
+    printf("%-16s%s\n", options[i].name,
+           *option_flag(&options[i]) ? "on" : "off");
+}
+
+int builtin_set(int argc, char *argv[]) {
+  if (argc == 1 || (argc == 2 && strcmp(argv[1], "-o") == 0)) {
+    print_options();
+    return 0;
+  }
+
+  int status = 0;
+  for (int i = 1; i < argc; i++) {
+    bool enable = strcmp(argv[i], "-o") == 0;
+    if (!enable && strcmp(argv[i], "+o") != 0) {
+      fprintf(stderr, "set: %s: invalid option\n", argv[i]);
+      return 2;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "set: %s: option name required\n", argv[i]);
+      return 2;
+    }
+
+    const shell_option_t *opt = find_option(argv[++i]);
+    if (!opt) {
+      fprintf(stderr, "set: %s: invalid option name\n", argv[i]);
+      status = 1;
+      continue;
+    }
+    *option_flag(opt) = enable;
+    if (enable && opt->on_enable)
+      opt->on_enable();
+  }
+  return status;
+}
@@ -0,0 +1,17 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "shell/source.h"
+#include "builtin.h"
+
+int builtin_source(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "%s: filename argument required\n", argv[0]);
+    return 2;
+  }
+  return source_run_file(argv[1]);
+}
@@ -0,0 +1,106 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "batch.h"
+#include "shell/config.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern char **environ;
+
+size_t batch_arg_limit(void) {
+  long arg_max = sysconf(_SC_ARG_MAX);
+  if (arg_max <= 0)
+    arg_max = _POSIX_ARG_MAX;
+
+  size_t reserved = BATCH_ARG_HEADROOM + sizeof(char *);
+  for (char **env = environ; env && *env; env++)
+    reserved += strlen(*env) + 1 + sizeof(char *);
+  return (size_t)arg_max > reserved ? (size_t)arg_max - reserved : 0;
+}
+
+static inline size_t arg_size(char *const *argv, size_t i, size_t argc,
+                              bool packed) {
+  size_t len = packed && i + 1 < argc ? (size_t)(argv[i + 1] - argv[i])
+                                      : strlen(argv[i]) + 1;
+  return len + sizeof(char *);
+}
+
+size_t batch_argv_size(char *const *argv, size_t from, size_t to,
+                       bool packed) {
+  if (packed && to > from)
+    return (size_t)(argv[to - 1] - argv[from]) + strlen(argv[to - 1]) + 1 +
+           (to - from) * sizeof(char *);
+
+  size_t size = 0;
+  for (size_t i = from; i < to; i++)
+    size += arg_size(argv, i, to, false);
+  return size;
+}
+
+batch_chunk_t *batch_split(char *const *argv, size_t from, size_t fixed,
+                           size_t end, size_t argc, bool packed,
+                           size_t limit) {
+  // the NULL terminator and the arguments repeated in every chunk
+  size_t base = sizeof(char *) + batch_argv_size(argv, from, fixed, packed) +
+                batch_argv_size(argv, end, argc, packed);
+
+  batch_chunk_t *chunks = NULL;
+  batch_chunk_t chunk = {.start = fixed, .end = fixed};
+  size_t size = base;
+  for (size_t i = fixed; i < end; i++) {
+    size_t s = arg_size(argv, i, argc, packed);
+    if (chunk.end > chunk.start && size + s > limit) {
+      arrpush(chunks, chunk);
+      chunk.start = i;
+      size = base;
+    }
+    size += s;
+    chunk.end = i + 1;
+  }
+  arrpush(chunks, chunk);
+  return chunks;
+}
+
+bool batch_parse_options(char *const *argv, size_t argc, size_t *skip,
+                         int *parallel) {
+  size_t i = 1;
+  *parallel = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "--") == 0) {
+      i++;
+      break;
+    }
+    if (strncmp(argv[i], "-j", 2) != 0) {
+      nsh_msg("batch: %s: invalid option\n", argv[i]);
+      return false;
+    }
+
+    const char *n = argv[i][2] ? &argv[i][2] : argv[++i];
+    char *end;
+    long value = n ? strtol(n, &end, 10) : 0;
+    if (!n || *end != '\0' || value < 1 || value > BATCH_MAX_PARALLEL) {
+      nsh_msg("batch: -j: expected a number between 1 and %d\n",
+              BATCH_MAX_PARALLEL);
+      return false;
+    }
+    *parallel = (int)value;
+  }
+
+  if (i >= argc) {
+    nsh_msg("%s", "batch: command expected\n");
+    return false;
+  }
+  *skip = i;
+  return true;
+}
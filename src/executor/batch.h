@@ -0,0 +1,72 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Splitting of argument lists too large for execve(), which fails with E2BIG
+ * when the arguments and the environment exceed ARG_MAX.
+ *
+ * The arguments split are the fields of the last run of words holding globs,
+ * brace expansions, command substitutions or unquoted variables
+ * (cmd_node_t.argv_spread and argv_spread_end). The arguments before them are
+ * repeated in front of every chunk, the way 'find | xargs cmd fixed...' would
+ * run, and the arguments after them at its end, so that 'batch cp *.log
+ * dest/' copies every chunk to dest/. A command is split when it is prefixed
+ * with 'batch', or under 'set -o autobatch' when it would not fit.
+ */
+
+/**
+ * @brief Arguments of a command run by one invocation: argv[start, end),
+ * between the fixed arguments.
+ */
+typedef struct {
+  size_t start;
+  size_t end;
+} batch_chunk_t;
+
+/**
+ * @brief Bytes available to the arguments of a command: ARG_MAX minus the
+ * size of the environment and some headroom, pointers included.
+ */
+size_t batch_arg_limit(void);
+
+/**
+ * @brief Size taken by argv[from, to) once passed to execve(), pointers
+ * included.
+ * @param packed the strings are packed in order in a single buffer, as built
+ * by expand_argv_parts(): their sizes are the distance between them
+ */
+size_t batch_argv_size(char *const *argv, size_t from, size_t to,
+                       bool packed);
+
+/**
+ * @brief Splits argv[fixed, end) into chunks that fit in limit once
+ * argv[from, fixed) is put in front of each of them and argv[end, argc)
+ * after. An argument too large to fit in any chunk gets one of its own.
+ * @return stb_ds array of chunks covering argv[fixed, end) in order, at
+ * least one (maybe empty)
+ */
+batch_chunk_t *batch_split(char *const *argv, size_t from, size_t fixed,
+                           size_t end, size_t argc, bool packed,
+                           size_t limit);
+
+/**
+ * @brief Parses the options of the 'batch' prefix: '-j N' runs up to N
+ * invocations at once, '--' ends the options.
+ * @param skip set to the index of the command after the prefix
+ * @param parallel set to the number of invocations run at once
+ * @return false on an invalid option (already reported)
+ */
+bool batch_parse_options(char *const *argv, size_t argc, size_t *skip,
+                         int *parallel);
+
+#endif // __BATCH_H__
@@ -0,0 +1,134 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _DEFAULT_SOURCE
+
+#include "command_hash.h"
+#include "utils/utils.h"
+#include <time.h>
+
+static command_hash_entry_t *table = NULL;
+// commands not found by command_hash_exists(), with their expiry time
+static struct {
+  char *key;
+  time_t value;
+} *misses = NULL;
+static uint64_t generation = 0;
+// generation of the PATH variable the table was filled with
+static uint64_t path_gen = 0;
+static bool path_gen_set = false;
+
+static void free_table(void) {
+  for (int i = 0; i < shlen(table); i++)
+    free(table[i].value.path);
+  shfree(table);
+  table = NULL;
+  shfree(misses);
+  misses = NULL;
+}
+
+static time_t now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+void command_hash_flush(void) {
+  free_table();
+  generation++;
+}
+
+// flush the table when PATH was assigned since it was filled
+static void check_path(void) {
+  uint64_t gen = shell_state_getenv_gen("PATH");
+  if (path_gen_set && gen == path_gen)
+    return;
+
+  path_gen = gen;
+  path_gen_set = true;
+  command_hash_flush();
+}
+
+uint64_t command_hash_generation(void) {
+  check_path();
+  return generation;
+}
+
+const char *command_hash_lookup(const char *name) {
+  if (!name || !*name || strchr(name, '/'))
+    return NULL;
+
+  check_path();
+  if (!table)
+    sh_new_strdup(table);
+
+  command_hash_entry_t *entry = shgetp_null(table, name);
+  if (entry) {
+    entry->value.hits++;
+    return entry->value.path;
+  }
+
+  char *path = is_in_path((char *)name);
+  if (!path)
+    return NULL;
+
+  command_hash_value_t value = {.path = path, .hits = 1};
+  shput(table, name, value);
+  if (misses)
+    (void)shdel(misses, name);
+  return path;
+}
+
+bool command_hash_exists(const char *name) {
+  if (!name || !*name || strchr(name, '/'))
+    return false;
+
+  check_path();
+  if (!table)
+    sh_new_strdup(table);
+  if (shgetp_null(table, name))
+    return true;
+  if (!misses)
+    sh_new_strdup(misses);
+  ptrdiff_t i = shgeti(misses, name);
+  if (i >= 0 && misses[i].value > now_sec())
+    return false;
+
+  // a command found here has not been run yet, it is hashed without hits
+  char *path = is_in_path((char *)name);
+  if (path) {
+    shput(table, name, ((command_hash_value_t){.path = path, .hits = 0}));
+    return true;
+  }
+  shput(misses, name, now_sec() + COMMAND_HASH_NEG_TTL);
+  return false;
+}
+
+void command_hash_forget(const char *name) {
+  command_hash_entry_t *entry = shgetp_null(table, name);
+  if (!entry)
+    return;
+  free(entry->value.path);
+  (void)shdel(table, name);
+  generation++;
+}
+
+void command_hash_print(void) {
+  if (shlen(table) == 0) {
+    printf("hash: hash table empty\n");
+    return;
+  }
+
+  printf("hits\tcommand\n");
+  for (int i = 0; i < shlen(table); i++)
+    printf("%4u\t%s\n", table[i].value.hits, table[i].value.path);
+}
+
+void command_hash_free(void) {
+  free_table();
+  path_gen_set = false;
+}
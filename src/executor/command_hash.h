@@ -0,0 +1,70 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __COMMAND_HASH_H__
+#define __COMMAND_HASH_H__
+
+#include "utils/collections.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Resolved location of an external command.
+ */
+typedef struct {
+  char *path;    /**< Absolute path found in PATH */
+  unsigned hits; /**< Number of lookups served by this entry */
+} command_hash_value_t;
+
+typedef struct {
+  char *key;
+  command_hash_value_t value;
+} command_hash_entry_t;
+
+/**
+ * @brief Returns the current generation of the table.
+ * The generation is bumped whenever the table is flushed, either explicitly
+ * or because PATH changed, so that callers caching a resolved path can tell
+ * whether it is still valid.
+ */
+uint64_t command_hash_generation(void);
+
+/**
+ * @brief Resolves an external command through PATH, remembering the result.
+ * Names containing a '/' are not searched and yield NULL. Commands that are
+ * not found are not remembered so that newly installed ones are picked up.
+ * @param name the command name
+ * @return the path owned by the table (valid until the next flush) or NULL
+ */
+const char *command_hash_lookup(const char *name);
+
+/**
+ * @brief Tells whether a command would be found in PATH, for display while
+ * a line is typed. Unlike command_hash_lookup(), a command that is not found
+ * is remembered for COMMAND_HASH_NEG_TTL seconds, so asking again on every
+ * keystroke does not search PATH each time.
+ */
+bool command_hash_exists(const char *name);
+
+/**
+ * @brief Forgets the remembered location of a command.
+ */
+void command_hash_forget(const char *name);
+
+/**
+ * @brief Forgets every remembered location.
+ */
+void command_hash_flush(void);
+
+/**
+ * @brief Prints the remembered commands and their hits count.
+ */
+void command_hash_print(void);
+
+void command_hash_free(void);
+
+#endif // __COMMAND_HASH_H__
@@ -6,7 +6,66 @@
  * See <https://www.gnu.org/licenses/> for details.
  */
 
+#define _GNU_SOURCE
+
 #include "executor.h"
+#include "executor/batch.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Writes the whole buffer, retrying on short writes.
+ * @return false on error
+ */
+static bool write_all(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    buf += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+/**
+ * @brief Opens a descriptor reading the body of a here-document, without
+ * touching the filesystem. A body fitting in the pipe buffer is written to a
+ * pipe at once; a larger one would block the writer, it goes to a memfd that
+ * is sealed and rewound.
+ * @return the descriptor or -1 on error
+ */
+static int open_heredoc(const char *body, size_t len) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1)
+    return -1;
+  int pipe_sz = fcntl(fds[1], F_GETPIPE_SZ);
+  if (pipe_sz > 0 && len <= (size_t)pipe_sz) {
+    bool ok = write_all(fds[1], body, len);
+    close(fds[1]);
+    if (!ok) {
+      close(fds[0]);
+      return -1;
+    }
+    return fds[0];
+  }
+  close(fds[0]);
+  close(fds[1]);
+
+  int fd = memfd_create("nsh-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd == -1)
+    return -1;
+  if (!write_all(fd, body, len) ||
+      fcntl(fd, F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1 ||
+      lseek(fd, 0, SEEK_SET) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
 
 /**
  * @brief Configures I/O redirection based on the command node's settings.
@@ -19,6 +78,38 @@ static int handle_redirection(redirection_t *redir) {
   for (int i = 0; i < arrlen(redir); i++) {
     redirection_t r = redir[i];
 
+    if (r.type == REDIR_HEREDOC || r.type == REDIR_HERESTRING) {
+      const char *body = r.target ? r.target : "";
+      size_t len = strlen(body);
+      int fd = -1;
+      if (r.type == REDIR_HERESTRING) {
+        char *line = xmalloc(len + 2);
+        memcpy(line, body, len);
+        memcpy(line + len, "\n", 2);
+        fd = open_heredoc(line, len + 1);
+        free(line);
+      } else {
+        fd = open_heredoc(body, len);
+      }
+      if (fd == -1) {
+        nsh_msg("here-document: %s\n", strerror(errno));
+        return 1;
+      }
+      // the descriptor may already be the target if it was closed, it must
+      // then outlive exec
+      if (fd == r.fd) {
+        fcntl(fd, F_SETFD, 0);
+        continue;
+      }
+      if (dup2(fd, r.fd) == -1) {
+        perror("dup2 failed");
+        close(fd);
+        return 1;
+      }
+      close(fd);
+      continue;
+    }
+
     int oflag = (r.type == REDIR_IN)    ? O_RDONLY
                 : (r.type == REDIR_OUT) ? (O_WRONLY | O_CREAT | O_TRUNC)
                                         : (O_WRONLY | O_CREAT | O_APPEND);
@@ -38,21 +129,34 @@ static int handle_redirection(redirection_t *redir) {
 
 // Execute the process (builtin or external)
 static void execute_process(process_t *proc) {
-  if (builtin_is_builtin(proc->argv[0])) {
-    builtin_fn_t f = builtin_get_function(proc->argv[0]);
+  // redirections only
+  if (!proc->argv[0])
+    _exit(EXIT_SUCCESS);
+
+  if (proc->builtin) {
     int argc = (int)arrlen(proc->argv);
-    _exit(f(argc, proc->argv));
-  } else {
-    char *path = is_in_path(proc->argv[0]);
-    if (!path) {
-      fprintf(stderr, "%s: command not found\n", proc->argv[0]);
-      _exit(EXIT_CHILD_FAILURE);
-    }
-    execv(path, proc->argv);
-    perror("exec failed");
-    free(path);
+    _exit(proc->builtin(argc, proc->argv));
+  }
+
+  const char *path = proc->path;
+  if (!path && strchr(proc->argv[0], '/'))
+    path = proc->argv[0];
+  if (!path) {
+    fprintf(stderr, "%s: command not found\n", proc->argv[0]);
     _exit(EXIT_CHILD_FAILURE);
   }
+  execv(path, proc->argv);
+
+  // the hashed location may be stale (command moved or removed), fall back to
+  // a fresh PATH search
+  if (errno == ENOENT && proc->path) {
+    char *fresh = is_in_path(proc->argv[0]);
+    if (fresh && strcmp(fresh, proc->path) != 0)
+      execv(fresh, proc->argv);
+    free(fresh);
+  }
+  perror("exec failed");
+  _exit(EXIT_CHILD_FAILURE);
 }
 
 static inline void executor_context_close_pipes(executor_ctx_t *ctx) {
@@ -113,8 +217,7 @@ static int handle_pure_builtin_execution(process_t *proc) {
 
   pr_info("Executing pure builtin command '%s' in shell process",
           proc->argv[0]);
-  builtin_fn_t f = builtin_get_function(proc->argv[0]);
-  status = f((int)arrlen(proc->argv), proc->argv);
+  status = proc->builtin((int)arrlen(proc->argv), proc->argv);
 
   dup2(stdin_bak, STDIN_FILENO);
   close(stdin_bak);
@@ -123,6 +226,27 @@ static int handle_pure_builtin_execution(process_t *proc) {
   return status;
 }
 
+static inline int process_exit_status(process_t *proc) {
+  if (proc->state == PROCESS_KILLED)
+    return 128 + proc->status;
+  return proc->status;
+}
+
+// exit status of a job is the one of its last process, or the first failure
+// of a batch
+static int job_exit_status(job_t *job) {
+  process_t *last = job->first_process;
+  while (last && last->next) {
+    if (job->is_batch && process_exit_status(last) != 0)
+      return process_exit_status(last);
+    last = last->next;
+  }
+
+  if (!last)
+    return 0;
+  return process_exit_status(last);
+}
+
 int handle_foreground_execution(job_t *job, int sfd) {
   xtcsetpgrp(STDIN_FILENO, job->pgid);
 
@@ -172,13 +296,16 @@ int handle_foreground_execution(job_t *job, int sfd) {
       }
     }
   }
+  int status = job_exit_status(job);
   jobs_remove_job(job->pgid);
   shell_regain_control();
-  return 0;
+  return status;
 }
 
 static int handle_background_execution(job_t *job, pid_t pgid) {
-  printf("[%zu] %d\n", job->id, pgid);
+  // the notice is for the user, a subshell or a script prints none
+  if (shell_state_get()->flags.interactive)
+    printf("[%zu] %d\n", job->id, pgid);
   return 0;
 }
 
@@ -226,11 +353,12 @@ static int run_job(job_t *job) {
   jobs_add_job(job);
   process_t *proc = job->first_process;
 
-  if (proc->next == NULL && builtin_is_builtin(proc->argv[0])) {
+  if (proc->next == NULL && proc->builtin) {
     // Pure builtin execution (no fork)
     // job's pgid and processes' pids are not set in this case
     int status = handle_pure_builtin_execution(proc);
     jobs_remove_job(0); // pgid is 0 for pure builtins
+    last_exec->exit_status = status;
     return status;
   }
 
@@ -241,7 +369,7 @@ static int run_job(job_t *job) {
     int fd[2] = {-1, -1};
     ctx.out_fd = -1;
 
-    if (proc->next) {
+    if (proc->next && !job->is_batch) {
       xpipe(fd);
       ctx.out_fd = fd[1];
     }
@@ -302,6 +430,39 @@ static int run_job(job_t *job) {
   return status;
 }
 
+/**
+ * @brief Resolves the builtin or the executable of a command.
+ * Static commands carry their builtin from the static pass and keep their
+ * executable path in the AST until the command hash is invalidated, other
+ * commands are resolved at each execution through the command hash.
+ */
+static void resolve_command(cmd_node_t *cmd, process_t *proc) {
+  if (arrlen(cmd->argv) == 0)
+    return;
+
+  if (!cmd->is_static) {
+    proc->builtin = builtin_get_function(cmd->argv[0]);
+    if (!proc->builtin) {
+      const char *path = command_hash_lookup(cmd->argv[0]);
+      proc->path = path ? xstrdup(path) : NULL;
+    }
+    return;
+  }
+
+  proc->builtin = cmd->builtin;
+  if (proc->builtin)
+    return;
+
+  uint64_t gen = command_hash_generation();
+  if (!cmd->exec_path || cmd->exec_path_gen != gen) {
+    free(cmd->exec_path);
+    const char *path = command_hash_lookup(cmd->argv[0]);
+    cmd->exec_path = path ? xstrdup(path) : NULL;
+    cmd->exec_path_gen = gen;
+  }
+  proc->path = cmd->exec_path ? xstrdup(cmd->exec_path) : NULL;
+}
+
 // Create a process from a command AST node and add it to the job
 static void compile_command_job(ast_node_t *cmd_node, job_t *job) {
   if (!cmd_node || cmd_node->type != NODE_CMD)
@@ -314,6 +475,7 @@ static void compile_command_job(ast_node_t *cmd_node, job_t *job) {
   // Warning: shallow copy of argv and redirections cause they belong
   // to the AST that lives during all the execution
   process_t *proc = jobs_new_process(cmd, true);
+  resolve_command(cmd, proc);
   proc->parent_job = job;
   job->is_background = cmd->is_bg;
   jobs_add_process_to_job(job, proc);
@@ -330,8 +492,270 @@ static void compile_pipeline_job(ast_node_t *node, job_t *job) {
   }
 }
 
+/* --- BATCHES --- */
+
+// the process running argv[skip, fixed), one chunk of arguments, then
+// argv[end, argc)
+static process_t *batch_new_process(cmd_node_t *cmd, size_t skip,
+                                    size_t fixed, size_t end,
+                                    batch_chunk_t chunk, bool append) {
+  char **argv = NULL;
+  for (size_t i = skip; i < fixed; i++)
+    arrpush(argv, cmd->argv[i]);
+  for (size_t i = chunk.start; i < chunk.end; i++)
+    arrpush(argv, cmd->argv[i]);
+  for (size_t i = end; i < (size_t)arrlen(cmd->argv); i++)
+    arrpush(argv, cmd->argv[i]);
+
+  cmd_node_t chunk_cmd = {.argv = argv, .redir = cmd->redir};
+  process_t *proc = jobs_new_process(&chunk_cmd, true);
+  resolve_command(&chunk_cmd, proc);
+  arrfree(argv);
+
+  for (int i = 0; i < arrlen(proc->redir) && append; i++) {
+    if (proc->redir[i].type == REDIR_OUT)
+      proc->redir[i].type = REDIR_APPEND;
+  }
+  return proc;
+}
+
+/**
+ * @brief Runs a command whose trailing arguments are split into chunks
+ * fitting in ARG_MAX, see batch.h. Invocations run in waves of 'parallel'
+ * processes, a background batch runs all of them in a single job.
+ * @param skip index of the command in argv, after the 'batch' prefix
+ * @return the first non-zero status of the invocations, 0 if all succeeded
+ */
+static int exec_batch(ast_node_t *ast_node, size_t skip, int parallel) {
+  cmd_node_t *cmd = &ast_node->cmd;
+  size_t argc = (size_t)arrlen(cmd->argv);
+  // without a spreading word, every argument after the command is split
+  bool spread = cmd->argv_spread > skip;
+  size_t fixed = spread ? cmd->argv_spread : skip + 1;
+  size_t end = spread ? cmd->argv_spread_end : argc;
+  if (fixed > argc)
+    fixed = argc;
+  if (end < fixed)
+    end = fixed;
+
+  batch_chunk_t *chunks =
+      batch_split(cmd->argv, skip, fixed, end, argc, cmd->argv_arena != NULL,
+                  batch_arg_limit());
+  size_t n = (size_t)arrlen(chunks);
+  pr_debug("batch: %zu arguments in %zu invocations", end - fixed, n);
+
+  // an output redirection truncates its file once, every invocation appends
+  bool append = n > 1;
+  for (int i = 0; i < arrlen(cmd->redir) && append; i++) {
+    if (cmd->redir[i].type != REDIR_OUT || !cmd->redir[i].target)
+      continue;
+    int fd = open(cmd->redir[i].target, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1)
+      close(fd);
+  }
+
+  size_t wave = cmd->is_bg ? n : (size_t)parallel;
+  int status = 0;
+  for (size_t i = 0; i < n; i += wave) {
+    job_t *job = jobs_new_job();
+    job->command =
+        cmd->raw_str ? xstrdup(cmd->raw_str) : xstrdup("<unknown>");
+    job->is_background = cmd->is_bg;
+    job->is_batch = true;
+    for (size_t k = i; k < i + wave && k < n; k++) {
+      process_t *proc =
+          batch_new_process(cmd, skip, fixed, end, chunks[k], append);
+      proc->parent_job = job;
+      jobs_add_process_to_job(job, proc);
+    }
+
+    int st = run_job(job);
+    if (status == 0)
+      status = st;
+    if (st == 128 + SIGINT || st == JOB_STOPPED_EXIT_CODE)
+      break;
+  }
+  arrfree(chunks);
+
+  shell_state_get_last_exec()->exit_status = status;
+  return status;
+}
+
+/**
+ * @brief Tells whether a command runs as a batch and how.
+ * @param skip set to the index of the command after the 'batch' prefix
+ * @param status set to 2 when the prefix is invalid
+ */
+static bool batch_wanted(cmd_node_t *cmd, size_t *skip, int *parallel,
+                         int *status) {
+  size_t argc = (size_t)arrlen(cmd->argv);
+  if (argc == 0)
+    return false;
+
+  if (strcmp(cmd->argv[0], "batch") == 0) {
+    if (!batch_parse_options(cmd->argv, argc, skip, parallel)) {
+      *status = 2;
+      return false;
+    }
+    return true;
+  }
+
+  // splitting is only worth checking when it could happen
+  if (!shell_state_get()->flags.auto_batch || cmd->argv_spread == 0)
+    return false;
+  *skip = 0;
+  *parallel = 1;
+  return batch_argv_size(cmd->argv, 0, argc, cmd->argv_arena != NULL) +
+             sizeof(char *) >
+         batch_arg_limit();
+}
+
+/**
+ * @brief Expands a command or a pipeline right before it runs, so that it
+ * sees the state left by the previous commands and branches that never run
+ * are never expanded.
+ * @return 0 on success, 1 if the expansion failed (error already reported)
+ */
+static int expand_for_exec(ast_node_t *ast_node) {
+  expander_expand_ast(ast_node);
+  if (!ast_node->invalid)
+    return 0;
+
+  shell_state_get_last_exec()->exit_status = 1;
+  return 1;
+}
+
+/**
+ * @brief Runs the first clause of a case command with a pattern matching its
+ * word. Patterns are expanded one at a time, up to the first match.
+ * @return status of the clause, 0 if none matched
+ */
+static int exec_case_clauses(ast_node_t *ast_node) {
+  case_node_t *c = &ast_node->case_stmt;
+  shell_last_exec_t *last_exec = shell_state_get_last_exec();
+  bool invalid = false;
+
+  char *word = expand_word_str(c->word, &c->word_memo, &invalid);
+  if (invalid) {
+    last_exec->exit_status = 1;
+    return 1;
+  }
+
+  size_t word_len = strlen(word);
+  for (int i = 0; i < arrlen(c->items); i++) {
+    case_item_t *item = &c->items[i];
+    for (int j = 0; j < arrlen(item->patterns); j++) {
+      char *pattern = expand_pattern(item->patterns[j], &invalid);
+      if (invalid) {
+        free(word);
+        last_exec->exit_status = 1;
+        return 1;
+      }
+
+      bool matched = pattern_match(pattern_get(pattern), word, word_len);
+      free(pattern);
+      if (!matched)
+        continue;
+
+      free(word);
+      if (item->body)
+        return exec_node(item->body);
+      last_exec->exit_status = 0;
+      return 0;
+    }
+  }
+
+  free(word);
+  last_exec->exit_status = 0;
+  return 0;
+}
+
+/**
+ * @brief Runs the body of a for loop once per field of its words, the
+ * variable being set to the field beforehand. Words holding braces are
+ * enumerated one word at a time so that '{1..1000000}' never exists in full.
+ * @return status of the last iteration, 0 if the loop did not iterate
+ */
+static int exec_for_words(ast_node_t *ast_node) {
+  for_node_t *f = &ast_node->for_stmt;
+  shell_last_exec_t *last_exec = shell_state_get_last_exec();
+  bool invalid = false;
+  int status = 0;
+
+  if (arrlen(f->memos) != arrlen(f->words)) {
+    arrsetlen(f->memos, arrlen(f->words));
+    memset(f->memos, 0, sizeof(word_memo_t) * (size_t)arrlen(f->memos));
+  }
+
+  // an interrupted body stops the whole loop, as in other shells
+  bool interrupted = false;
+  for (int i = 0; i < arrlen(f->words) && !interrupted; i++) {
+    brace_iter_t *it = NULL;
+    word_part_t *word = f->words[i];
+    word_memo_t *memo = &f->memos[i];
+    if (brace_has_expansion(word)) {
+      it = brace_iter_new(word);
+      memo = NULL;
+      word = brace_iter_next(it);
+    }
+
+    for (; word && !interrupted; word = it ? brace_iter_next(it) : NULL) {
+      char **fields = expand_word_fields(word, memo, &invalid);
+      for (int j = 0; j < arrlen(fields) && !invalid; j++) {
+        shell_state_setenv(f->var, fields[j]);
+        status = 0;
+        if (f->body)
+          status = exec_node(f->body);
+        if (status == 128 + SIGINT) {
+          interrupted = true;
+          break;
+        }
+      }
+      for (int j = 0; j < arrlen(fields); j++)
+        free(fields[j]);
+      arrfree(fields);
+      if (invalid) {
+        brace_iter_free(it);
+        last_exec->exit_status = 1;
+        return 1;
+      }
+    }
+    brace_iter_free(it);
+  }
+
+  last_exec->exit_status = status;
+  return status;
+}
+
+// process substitutions in the words of case and for live as long as the
+// whole command
+static int exec_case(ast_node_t *ast_node) {
+  size_t procsub = procsub_mark();
+  int status = exec_case_clauses(ast_node);
+  procsub_close_from(procsub);
+  return status;
+}
+
+static int exec_for(ast_node_t *ast_node) {
+  size_t procsub = procsub_mark();
+  int status = exec_for_words(ast_node);
+  procsub_close_from(procsub);
+  return status;
+}
+
+/**
+ * @brief Runs '(( expression ))'.
+ * @return 0 if the expression is not zero, 1 if it is zero or invalid
+ */
+static int exec_arith(ast_node_t *ast_node) {
+  long long value = 0;
+  int status = expand_arith(ast_node->arith.expr, &value) && value != 0 ? 0 : 1;
+  shell_state_get_last_exec()->exit_status = status;
+  return status;
+}
+
 int exec_node(ast_node_t *ast_node) {
-  if (!ast_node || ast_node->invalid)
+  if (!ast_node)
     return -1;
 
   int status = 0;
@@ -356,16 +780,50 @@ int exec_node(ast_node_t *ast_node) {
   }
 
   case NODE_PIPELINE: {
+    size_t procsub = procsub_mark();
+    if (expand_for_exec(ast_node) != 0) {
+      procsub_close_from(procsub);
+      return 1;
+    }
     job_t *job = jobs_new_job();
     compile_pipeline_job(ast_node, job);
     status = run_job(job);
+    // the processes inherited the substitutions they use
+    procsub_close_from(procsub);
     break;
   }
 
+  case NODE_CASE:
+    status = exec_case(ast_node);
+    break;
+
+  case NODE_FOR:
+    status = exec_for(ast_node);
+    break;
+
+  case NODE_ARITH:
+    status = exec_arith(ast_node);
+    break;
+
   case NODE_CMD: {
-    job_t *job = jobs_new_job();
-    compile_command_job(ast_node, job);
-    status = run_job(job);
+    size_t procsub = procsub_mark();
+    if (expand_for_exec(ast_node) != 0) {
+      procsub_close_from(procsub);
+      return 1;
+    }
+    size_t skip = 0;
+    int parallel = 1;
+    status = 0;
+    if (batch_wanted(&ast_node->cmd, &skip, &parallel, &status)) {
+      status = exec_batch(ast_node, skip, parallel);
+    } else if (status == 0) {
+      job_t *job = jobs_new_job();
+      compile_command_job(ast_node, job);
+      status = run_job(job);
+    } else {
+      shell_state_get_last_exec()->exit_status = status;
+    }
+    procsub_close_from(procsub);
     break;
   }
 
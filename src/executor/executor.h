@@ -19,7 +19,9 @@
 #include <unistd.h>
 
 #include "builtin/builtin.h"
+#include "executor/command_hash.h"
 #include "executor/jobs.h"
+#include "expander/expander.h"
 #include "parser/parser.h"
 #include "shell/signal.h"
 #include "utils/log.h"
@@ -40,7 +42,8 @@ int handle_foreground_execution(job_t *job, int sfd);
 /**
  * @brief Execute an AST node.
  * Traverses the node and dispatches execution according to its type
- * (pipeline, command, logical operator, etc.).
+ * (pipeline, command, logical operator, etc.). Commands and pipelines are
+ * expanded right before they run.
  * @param ast_node Root AST node to execute
  * @return Exit status of the command
  */
@@ -13,11 +13,23 @@ process_t *jobs_new_process(cmd_node_t *cmd, bool deep_copy) {
 
   char **argv_cp = NULL;
   if (deep_copy) {
-    argv_cp = NULL;
+    // all the strings are packed in a single buffer, large glob expansions
+    // cost one allocation instead of one per argument
+    size_t total = 0;
+    for (int i = 0; i < arrlen(cmd->argv); i++)
+      total += strlen(cmd->argv[i]) + 1;
+
+    char *arena = xmalloc(total > 0 ? total : 1);
+    arrsetlen(argv_cp, arrlen(cmd->argv));
+    size_t off = 0;
     for (int i = 0; i < arrlen(cmd->argv); i++) {
-      arrpush(argv_cp, xstrdup(cmd->argv[i]));
+      size_t len = strlen(cmd->argv[i]) + 1;
+      memcpy(arena + off, cmd->argv[i], len);
+      argv_cp[i] = arena + off;
+      off += len;
     }
     arrpushnc(argv_cp, NULL);
+    process->argv_arena = arena;
   } else {
     argv_cp = cmd->argv;
     arrpushnc(argv_cp, NULL);
@@ -63,18 +75,21 @@ void jobs_free_process(process_t *process, bool deep_free) {
 
   if (deep_free) {
     if (process->argv) {
-      for (size_t i = 0; process->argv[i] != NULL; i++) {
-        free(process->argv[i]);
+      if (process->argv_arena) {
+        free(process->argv_arena);
+      } else {
+        for (size_t i = 0; process->argv[i] != NULL; i++)
+          free(process->argv[i]);
       }
       arrfree(process->argv);
     }
     if (process->redir) {
-      for (size_t i = 0; process->redir[i].target != NULL; i++) {
+      for (int i = 0; i < arrlen(process->redir); i++)
         free(process->redir[i].target);
-      }
       arrfree(process->redir);
     }
   }
+  free(process->path);
   free(process);
 }
 
@@ -43,7 +43,10 @@ typedef enum {
 typedef struct process_t {
   pid_t pid;                // Process ID
   char **argv;              // Command arguments
+  char *argv_arena;         // Buffer holding the argv strings (deep copies)
   redirection_t *redir;     // I/O redirections
+  int (*builtin)(int, char *[]); // Resolved builtin or NULL
+  char *path;               // Resolved executable path or NULL
   process_state_e state;    // Process state
   int status;               // Exit status or signal
   struct process_t *next;   // Next process in pipeline
@@ -57,6 +60,8 @@ typedef struct job_t {
   process_t *first_process; // First process in pipeline
   char *command;            // Original command line
   bool is_background;       // True if background job
+  bool is_procsub;          // Process substitution, reaped silently
+  bool is_batch;            // Processes run side by side, not piped
   job_state_e state;        // Job state
   unsigned live_processes;  // Count of running processes
   struct job_t *prev;       // Previous job in job list
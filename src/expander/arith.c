@@ -0,0 +1,756 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "expander/arith.h"
+#include "shell/config.h"
+#include "shell/state.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+  OP_NUM,
+  OP_VAR,
+  OP_NEG,
+  OP_NOT,
+  OP_BNOT,
+  OP_PREINC,
+  OP_PREDEC,
+  OP_POSTINC,
+  OP_POSTDEC,
+  // binary operations, also the operation of a compound assignment
+  OP_POW,
+  OP_MUL,
+  OP_DIV,
+  OP_MOD,
+  OP_ADD,
+  OP_SUB,
+  OP_SHL,
+  OP_SHR,
+  OP_LT,
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  OP_BAND,
+  OP_BXOR,
+  OP_BOR,
+  // operations evaluating their operands lazily or in order
+  OP_AND,
+  OP_OR,
+  OP_COND,
+  OP_COMMA,
+  OP_ASSIGN,
+} arith_op_e;
+
+/**
+ * @brief Node of a compiled expression, operands are indices in the node
+ * array of the expression.
+ */
+typedef struct {
+  arith_op_e op;
+  arith_op_e assign_op; /**< Operation of a compound assignment, OP_NUM for
+                           a plain '=' */
+  int lhs;
+  int rhs;
+  int third; /**< Else branch of '?:' */
+  long long num;
+  char *name; /**< Variable of OP_VAR, assignments and increments */
+} arith_node_t;
+
+struct arith_t {
+  char *src;
+  arith_node_t *nodes;
+  int root;    /**< -1 for an empty expression */
+  char *error; /**< Syntax error, reported when evaluated */
+};
+
+/* --- TOKENS --- */
+
+typedef enum { TK_END, TK_NUM, TK_NAME, TK_OP, TK_BAD } arith_tok_e;
+
+// longest operators first, so that the first prefix found is the token
+static const char *const operators[] = {
+    "<<=", ">>=", "**", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+    "++",  "--",  "+=", "-=", "*=", "/=", "%=", "&=", "^=", "|=", "+",
+    "-",   "*",   "/",  "%",  "<",  ">",  "&",  "|",  "^",  "!",  "~",
+    "=",   "?",   ":",  "(",  ")",  ",",
+};
+
+typedef struct {
+  arith_t *a;
+  const char *s;
+  size_t pos;
+
+  arith_tok_e kind; /**< Current token */
+  size_t tok_start;
+  const char *op; /**< Operator of a TK_OP token */
+  long long num;
+  size_t name_len; /**< Length of a TK_NAME token, at tok_start */
+} arith_parser_t;
+
+static int digit_value(char c) {
+  if (isdigit((unsigned char)c))
+    return c - '0';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A' + 36;
+  if (c == '@')
+    return 62;
+  if (c == '_')
+    return 63;
+  return 64;
+}
+
+/**
+ * @brief Scans a constant: decimal, 0x hexadecimal, 0 octal or base#digits
+ * with a base up to 64. Values wrap around on overflow like additions do.
+ * @return false if a digit is out of its base
+ */
+static bool scan_number(arith_parser_t *p) {
+  const char *s = p->s;
+  size_t i = p->pos;
+  unsigned long long base = 10;
+  unsigned long long v = 0;
+
+  if (s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+    base = 16;
+    i += 2;
+  } else if (s[i] == '0') {
+    base = 8;
+  } else {
+    size_t j = i;
+    unsigned long long prefix = 0;
+    while (isdigit((unsigned char)s[j]) && prefix <= 64)
+      prefix = prefix * 10 + (unsigned long long)(s[j++] - '0');
+    if (s[j] == '#') {
+      if (prefix < 2 || prefix > 64)
+        return false;
+      base = prefix;
+      i = j + 1;
+    }
+  }
+
+  size_t start = i;
+  while (isalnum((unsigned char)s[i]) || s[i] == '@' || s[i] == '_') {
+    int d = digit_value(s[i]);
+    // letters of bases up to 36 are case insensitive
+    if (base <= 36 && d >= 36)
+      d -= 26;
+    if ((unsigned long long)d >= base)
+      return false;
+    v = v * base + (unsigned long long)d;
+    i++;
+  }
+  if (i == start && base != 8)
+    return false;
+
+  p->num = (long long)v;
+  p->pos = i;
+  return true;
+}
+
+static void next(arith_parser_t *p) {
+  const char *s = p->s;
+  while (isspace((unsigned char)s[p->pos]))
+    p->pos++;
+  p->tok_start = p->pos;
+
+  char c = s[p->pos];
+  if (c == '\0') {
+    p->kind = TK_END;
+  } else if (isdigit((unsigned char)c)) {
+    p->kind = scan_number(p) ? TK_NUM : TK_BAD;
+  } else if (isalpha((unsigned char)c) || c == '_') {
+    while (isalnum((unsigned char)s[p->pos]) || s[p->pos] == '_')
+      p->pos++;
+    p->kind = TK_NAME;
+    p->name_len = p->pos - p->tok_start;
+  } else {
+    p->kind = TK_BAD;
+    for (size_t i = 0; i < sizeof(operators) / sizeof(*operators); i++) {
+      size_t len = strlen(operators[i]);
+      if (strncmp(s + p->pos, operators[i], len) == 0) {
+        p->kind = TK_OP;
+        p->op = operators[i];
+        p->pos += len;
+        break;
+      }
+    }
+  }
+}
+
+static bool is_op(arith_parser_t *p, const char *op) {
+  return p->kind == TK_OP && strcmp(p->op, op) == 0;
+}
+
+/* --- PARSER --- */
+
+// binding powers, from the loosest to the tightest
+enum {
+  BP_COMMA = 1,
+  BP_ASSIGN,
+  BP_COND,
+  BP_OR,
+  BP_AND,
+  BP_BOR,
+  BP_BXOR,
+  BP_BAND,
+  BP_EQUALITY,
+  BP_RELATION,
+  BP_SHIFT,
+  BP_ADD,
+  BP_MUL,
+  BP_POW,
+  BP_PREFIX,
+  BP_POSTFIX,
+};
+
+typedef struct {
+  const char *tok;
+  arith_op_e op;
+  int bp;
+} arith_infix_t;
+
+static const arith_infix_t infixes[] = {
+    {",", OP_COMMA, BP_COMMA},  {"?", OP_COND, BP_COND},
+    {"||", OP_OR, BP_OR},       {"&&", OP_AND, BP_AND},
+    {"|", OP_BOR, BP_BOR},      {"^", OP_BXOR, BP_BXOR},
+    {"&", OP_BAND, BP_BAND},    {"==", OP_EQ, BP_EQUALITY},
+    {"!=", OP_NE, BP_EQUALITY}, {"<", OP_LT, BP_RELATION},
+    {"<=", OP_LE, BP_RELATION}, {">", OP_GT, BP_RELATION},
+    {">=", OP_GE, BP_RELATION}, {"<<", OP_SHL, BP_SHIFT},
+    {">>", OP_SHR, BP_SHIFT},   {"+", OP_ADD, BP_ADD},
+    {"-", OP_SUB, BP_ADD},      {"*", OP_MUL, BP_MUL},
+    {"/", OP_DIV, BP_MUL},      {"%", OP_MOD, BP_MUL},
+    {"**", OP_POW, BP_POW},     {"=", OP_NUM, BP_ASSIGN},
+    {"+=", OP_ADD, BP_ASSIGN},  {"-=", OP_SUB, BP_ASSIGN},
+    {"*=", OP_MUL, BP_ASSIGN},  {"/=", OP_DIV, BP_ASSIGN},
+    {"%=", OP_MOD, BP_ASSIGN},  {"<<=", OP_SHL, BP_ASSIGN},
+    {">>=", OP_SHR, BP_ASSIGN}, {"&=", OP_BAND, BP_ASSIGN},
+    {"^=", OP_BXOR, BP_ASSIGN}, {"|=", OP_BOR, BP_ASSIGN},
+};
+
+static const arith_infix_t *find_infix(arith_parser_t *p) {
+  if (p->kind != TK_OP)
+    return NULL;
+  for (size_t i = 0; i < sizeof(infixes) / sizeof(*infixes); i++) {
+    if (strcmp(infixes[i].tok, p->op) == 0)
+      return &infixes[i];
+  }
+  return NULL;
+}
+
+static void syntax_error(arith_parser_t *p, const char *what) {
+  if (p->a->error)
+    return;
+  const char *tok = p->s + p->tok_start;
+  size_t len = strlen(p->a->src) + strlen(what) + strlen(tok) + 48;
+  p->a->error = xmalloc(len);
+  snprintf(p->a->error, len, "%s: %s (error token is \"%s\")", p->a->src,
+           what, tok);
+}
+
+static int add_node(arith_parser_t *p, arith_node_t node) {
+  arrpush(p->a->nodes, node);
+  return (int)arrlen(p->a->nodes) - 1;
+}
+
+static bool is_const(arith_parser_t *p, int i) {
+  return p->a->nodes[i].op == OP_NUM;
+}
+
+static bool apply_binary(arith_op_e op, long long x, long long y,
+                         long long *r, const char **error);
+
+static int parse_expr(arith_parser_t *p, int min_bp);
+
+static int parse_prefix(arith_parser_t *p) {
+  if (p->kind == TK_NUM) {
+    int i = add_node(p, (arith_node_t){.op = OP_NUM, .num = p->num});
+    next(p);
+    return i;
+  }
+  if (p->kind == TK_NAME) {
+    char *name = xstrdup_n(p->s + p->tok_start, p->name_len);
+    int i = add_node(p, (arith_node_t){.op = OP_VAR, .name = name});
+    next(p);
+    return i;
+  }
+  if (p->kind == TK_BAD && isdigit((unsigned char)p->s[p->tok_start])) {
+    syntax_error(p, "value too great for base");
+    return -1;
+  }
+  if (p->kind != TK_OP) {
+    syntax_error(p, "syntax error: operand expected");
+    return -1;
+  }
+
+  if (is_op(p, "(")) {
+    next(p);
+    int i = parse_expr(p, BP_COMMA);
+    if (i < 0)
+      return -1;
+    if (!is_op(p, ")")) {
+      syntax_error(p, "missing ')'");
+      return -1;
+    }
+    next(p);
+    return i;
+  }
+
+  if (is_op(p, "++") || is_op(p, "--")) {
+    arith_op_e op = is_op(p, "++") ? OP_PREINC : OP_PREDEC;
+    next(p);
+    int var = parse_expr(p, BP_PREFIX);
+    if (var < 0)
+      return -1;
+    if (p->a->nodes[var].op != OP_VAR) {
+      syntax_error(p, "variable expected after '++' or '--'");
+      return -1;
+    }
+    p->a->nodes[var].op = op;
+    return var;
+  }
+
+  arith_op_e op;
+  if (is_op(p, "-"))
+    op = OP_NEG;
+  else if (is_op(p, "!"))
+    op = OP_NOT;
+  else if (is_op(p, "~"))
+    op = OP_BNOT;
+  else if (is_op(p, "+"))
+    op = OP_NUM; // no-op
+  else {
+    syntax_error(p, "syntax error: operand expected");
+    return -1;
+  }
+  next(p);
+  int operand = parse_expr(p, BP_PREFIX);
+  if (operand < 0 || op == OP_NUM)
+    return operand;
+
+  if (is_const(p, operand)) {
+    arith_node_t *n = &p->a->nodes[operand];
+    n->num = op == OP_NEG   ? (long long)(0ULL - (unsigned long long)n->num)
+             : op == OP_NOT ? !n->num
+                            : ~n->num;
+    return operand;
+  }
+  return add_node(p, (arith_node_t){.op = op, .lhs = operand});
+}
+
+// folds lhs op rhs into lhs when both are constants
+static int fold_binary(arith_parser_t *p, arith_op_e op, int lhs, int rhs) {
+  if (is_const(p, lhs) && is_const(p, rhs)) {
+    long long r;
+    const char *error = NULL;
+    // an erroneous operation is kept, it is reported when evaluated
+    if (apply_binary(op, p->a->nodes[lhs].num, p->a->nodes[rhs].num, &r,
+                     &error)) {
+      p->a->nodes[lhs].num = r;
+      return lhs;
+    }
+  }
+  return add_node(p, (arith_node_t){.op = op, .lhs = lhs, .rhs = rhs});
+}
+
+static int parse_infix(arith_parser_t *p, const arith_infix_t *in, int lhs) {
+  arith_node_t *nodes = p->a->nodes;
+
+  if (in->bp == BP_ASSIGN) {
+    if (nodes[lhs].op != OP_VAR) {
+      syntax_error(p, "attempted assignment to non-variable");
+      return -1;
+    }
+    next(p);
+    int rhs = parse_expr(p, BP_ASSIGN); // right associative
+    if (rhs < 0)
+      return -1;
+    nodes = p->a->nodes;
+    nodes[lhs].op = OP_ASSIGN;
+    nodes[lhs].assign_op = in->op;
+    nodes[lhs].rhs = rhs;
+    return lhs;
+  }
+
+  if (in->op == OP_COND) {
+    next(p);
+    int then = parse_expr(p, BP_COMMA);
+    if (then < 0)
+      return -1;
+    if (!is_op(p, ":")) {
+      syntax_error(p, "':' expected for conditional expression");
+      return -1;
+    }
+    next(p);
+    int otherwise = parse_expr(p, BP_COND); // right associative
+    if (otherwise < 0)
+      return -1;
+    if (is_const(p, lhs))
+      return p->a->nodes[lhs].num ? then : otherwise;
+    return add_node(p, (arith_node_t){.op = OP_COND,
+                                      .lhs = lhs,
+                                      .rhs = then,
+                                      .third = otherwise});
+  }
+
+  next(p);
+  int rhs = parse_expr(p, in->op == OP_POW ? in->bp : in->bp + 1);
+  if (rhs < 0)
+    return -1;
+
+  // the right operand of a decided '&&' or '||' is never evaluated
+  if ((in->op == OP_AND || in->op == OP_OR) && is_const(p, lhs)) {
+    long long v = p->a->nodes[lhs].num;
+    if (in->op == OP_AND ? !v : v) {
+      p->a->nodes[lhs].num = in->op == OP_OR;
+      return lhs;
+    }
+    if (is_const(p, rhs)) {
+      p->a->nodes[lhs].num = p->a->nodes[rhs].num != 0;
+      return lhs;
+    }
+  }
+  if (in->op == OP_AND || in->op == OP_OR || in->op == OP_COMMA) {
+    if (in->op == OP_COMMA && is_const(p, lhs))
+      return rhs;
+    return add_node(p,
+                    (arith_node_t){.op = in->op, .lhs = lhs, .rhs = rhs});
+  }
+  return fold_binary(p, in->op, lhs, rhs);
+}
+
+static int parse_expr(arith_parser_t *p, int min_bp) {
+  int lhs = parse_prefix(p);
+  while (lhs >= 0) {
+    if ((is_op(p, "++") || is_op(p, "--")) && BP_POSTFIX >= min_bp) {
+      if (p->a->nodes[lhs].op != OP_VAR) {
+        syntax_error(p, "variable expected before '++' or '--'");
+        return -1;
+      }
+      p->a->nodes[lhs].op = is_op(p, "++") ? OP_POSTINC : OP_POSTDEC;
+      next(p);
+      continue;
+    }
+
+    const arith_infix_t *in = find_infix(p);
+    if (!in || in->bp < min_bp)
+      break;
+    lhs = parse_infix(p, in, lhs);
+  }
+  return lhs;
+}
+
+arith_t *arith_compile(const char *src) {
+  arith_t *a = xcalloc(1, sizeof(arith_t));
+  a->src = xstrdup(src);
+  a->root = -1;
+
+  arith_parser_t p = {.a = a, .s = a->src};
+  next(&p);
+  if (p.kind == TK_END)
+    return a;
+
+  a->root = parse_expr(&p, BP_COMMA);
+  if (a->root >= 0 && p.kind != TK_END)
+    syntax_error(&p, "syntax error in expression");
+  return a;
+}
+
+void arith_free(arith_t *a) {
+  if (!a)
+    return;
+  for (int i = 0; i < arrlen(a->nodes); i++)
+    free(a->nodes[i].name);
+  arrfree(a->nodes);
+  free(a->error);
+  free(a->src);
+  free(a);
+}
+
+bool arith_is_const(const arith_t *a, long long *value) {
+  if (a->error || (a->root >= 0 && a->nodes[a->root].op != OP_NUM))
+    return false;
+  if (value)
+    *value = a->root >= 0 ? a->nodes[a->root].num : 0;
+  return true;
+}
+
+/* --- EVALUATION --- */
+
+// the arithmetic wraps around like the one of the machine
+static long long wrap(unsigned long long v) { return (long long)v; }
+
+static bool apply_binary(arith_op_e op, long long x, long long y,
+                         long long *r, const char **error) {
+  unsigned long long ux = (unsigned long long)x;
+  unsigned long long uy = (unsigned long long)y;
+  switch (op) {
+  case OP_POW: {
+    if (y < 0) {
+      *error = "exponent less than 0";
+      return false;
+    }
+    unsigned long long acc = 1;
+    for (unsigned long long base = ux, e = uy; e; e >>= 1) {
+      if (e & 1)
+        acc *= base;
+      base *= base;
+    }
+    *r = wrap(acc);
+    return true;
+  }
+  case OP_MUL:
+    *r = wrap(ux * uy);
+    return true;
+  case OP_DIV:
+  case OP_MOD:
+    if (y == 0) {
+      *error = "division by 0";
+      return false;
+    }
+    // LLONG_MIN / -1 overflows
+    if (y == -1)
+      *r = op == OP_DIV ? wrap(0ULL - ux) : 0;
+    else
+      *r = op == OP_DIV ? x / y : x % y;
+    return true;
+  case OP_ADD:
+    *r = wrap(ux + uy);
+    return true;
+  case OP_SUB:
+    *r = wrap(ux - uy);
+    return true;
+  case OP_SHL:
+    *r = wrap(ux << (uy & 63));
+    return true;
+  case OP_SHR:
+    *r = x >> (uy & 63);
+    return true;
+  case OP_LT:
+    *r = x < y;
+    return true;
+  case OP_LE:
+    *r = x <= y;
+    return true;
+  case OP_GT:
+    *r = x > y;
+    return true;
+  case OP_GE:
+    *r = x >= y;
+    return true;
+  case OP_EQ:
+    *r = x == y;
+    return true;
+  case OP_NE:
+    *r = x != y;
+    return true;
+  case OP_BAND:
+    *r = x & y;
+    return true;
+  case OP_BXOR:
+    *r = x ^ y;
+    return true;
+  case OP_BOR:
+    *r = x | y;
+    return true;
+  default:
+    *error = "invalid operation";
+    return false;
+  }
+}
+
+static bool eval_top(const arith_t *a, long long *value, int depth);
+
+/**
+ * @brief Reads a variable as an integer. Unset and empty variables are 0,
+ * a value that is not an integer is evaluated as an expression.
+ */
+static bool read_var(const arith_t *a, const char *name, long long *value,
+                     int depth) {
+  if (shell_state_getenv_int(name, value))
+    return true;
+
+  const char *s = shell_state_getenv(name);
+  while (s && isspace((unsigned char)*s))
+    s++;
+  if (!s || !*s) {
+    *value = 0;
+    return true;
+  }
+  if (depth >= ARITH_MAX_DEPTH) {
+    nsh_msg("%s: expression recursion level exceeded\n", a->src);
+    return false;
+  }
+
+  // not through the cache, the caller's expression may be cached
+  arith_t *sub = arith_compile(s);
+  bool ok = eval_top(sub, value, depth + 1);
+  arith_free(sub);
+  return ok;
+}
+
+static bool eval(const arith_t *a, int i, long long *value, int depth) {
+  const arith_node_t *n = &a->nodes[i];
+  long long x, y;
+
+  switch (n->op) {
+  case OP_NUM:
+    *value = n->num;
+    return true;
+  case OP_VAR:
+    return read_var(a, n->name, value, depth);
+  case OP_NEG:
+  case OP_NOT:
+  case OP_BNOT:
+    if (!eval(a, n->lhs, &x, depth))
+      return false;
+    *value = n->op == OP_NEG   ? wrap(0ULL - (unsigned long long)x)
+             : n->op == OP_NOT ? !x
+                               : ~x;
+    return true;
+  case OP_PREINC:
+  case OP_PREDEC:
+  case OP_POSTINC:
+  case OP_POSTDEC: {
+    if (!read_var(a, n->name, &x, depth))
+      return false;
+    unsigned long long ux = (unsigned long long)x;
+    long long updated = wrap(n->op == OP_PREINC || n->op == OP_POSTINC
+                                 ? ux + 1
+                                 : ux - 1);
+    shell_state_setenv_int(n->name, updated);
+    *value = n->op == OP_PREINC || n->op == OP_PREDEC ? updated : x;
+    return true;
+  }
+  case OP_AND:
+  case OP_OR:
+    if (!eval(a, n->lhs, &x, depth))
+      return false;
+    if (n->op == OP_AND ? !x : x) {
+      *value = n->op == OP_OR;
+      return true;
+    }
+    if (!eval(a, n->rhs, &y, depth))
+      return false;
+    *value = y != 0;
+    return true;
+  case OP_COND:
+    if (!eval(a, n->lhs, &x, depth))
+      return false;
+    return eval(a, x ? n->rhs : n->third, value, depth);
+  case OP_COMMA:
+    return eval(a, n->lhs, &x, depth) && eval(a, n->rhs, value, depth);
+  case OP_ASSIGN:
+    if (!eval(a, n->rhs, &y, depth))
+      return false;
+    if (n->assign_op != OP_NUM) {
+      const char *error = NULL;
+      if (!read_var(a, n->name, &x, depth))
+        return false;
+      if (!apply_binary(n->assign_op, x, y, &y, &error)) {
+        nsh_msg("%s: %s\n", a->src, error);
+        return false;
+      }
+    }
+    shell_state_setenv_int(n->name, y);
+    *value = y;
+    return true;
+  default: {
+    const char *error = NULL;
+    if (!eval(a, n->lhs, &x, depth) || !eval(a, n->rhs, &y, depth))
+      return false;
+    if (!apply_binary(n->op, x, y, value, &error)) {
+      nsh_msg("%s: %s\n", a->src, error);
+      return false;
+    }
+    return true;
+  }
+  }
+}
+
+static bool eval_top(const arith_t *a, long long *value, int depth) {
+  if (a->error) {
+    nsh_msg("%s\n", a->error);
+    return false;
+  }
+  if (a->root < 0) {
+    *value = 0;
+    return true;
+  }
+  return eval(a, a->root, value, depth);
+}
+
+bool arith_eval(const arith_t *a, long long *value) {
+  return eval_top(a, value, 0);
+}
+
+/* --- CACHE --- */
+
+typedef struct {
+  arith_t *expr;
+  uint64_t last_use;
+} arith_cache_value_t;
+
+typedef struct {
+  char *key;
+  arith_cache_value_t value;
+} arith_cache_entry_t;
+
+static arith_cache_entry_t *arith_cache = NULL;
+static uint64_t arith_clock = 0;
+
+static void evict_lru(void) {
+  int victim = 0;
+  for (int i = 1; i < shlen(arith_cache); i++) {
+    if (arith_cache[i].value.last_use < arith_cache[victim].value.last_use)
+      victim = i;
+  }
+  // the key is released by shdel(), look it up through a copy
+  char *key = xstrdup(arith_cache[victim].key);
+  arith_free(arith_cache[victim].value.expr);
+  (void)shdel(arith_cache, key);
+  free(key);
+}
+
+const arith_t *arith_get(const char *src) {
+  if (!arith_cache)
+    sh_new_strdup(arith_cache);
+
+  ptrdiff_t idx = shgeti(arith_cache, src);
+  if (idx >= 0) {
+    arith_cache[idx].value.last_use = ++arith_clock;
+    return arith_cache[idx].value.expr;
+  }
+
+  if (shlen(arith_cache) >= ARITH_CACHE_SIZE)
+    evict_lru();
+
+  arith_cache_value_t value = {.expr = arith_compile(src),
+                               .last_use = ++arith_clock};
+  shput(arith_cache, src, value);
+  return value.expr;
+}
+
+void arith_cache_free(void) {
+  for (int i = 0; i < shlen(arith_cache); i++)
+    arith_free(arith_cache[i].value.expr);
+  shfree(arith_cache);
+  arith_cache = NULL;
+}
+
+bool arith_eval_str(const char *src, long long *value) {
+  return arith_eval(arith_get(src), value);
+}
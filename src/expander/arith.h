@@ -0,0 +1,69 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __ARITH_H__
+#define __ARITH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Shell arithmetic, shared by $((...)), ((...)) and the 'let' builtin.
+ *
+ * Expressions are compiled by a Pratt parser into a tree of operations on
+ * 64-bit signed integers, with the operators and precedences of C (plus '**'
+ * for exponentiation). Subexpressions made of constants only are folded while
+ * parsing. Variables are read and assigned through the integer values kept by
+ * the shell state, so that a counter updated in a loop is never formatted nor
+ * parsed back; a variable holding anything else than an integer is itself
+ * evaluated as an expression.
+ */
+
+typedef struct arith_t arith_t;
+
+/**
+ * @brief Compiles an expression. A syntax error is not reported here but
+ * recorded in the result, arith_eval() reports it.
+ * @return heap-allocated expression, to be released with arith_free()
+ */
+arith_t *arith_compile(const char *src);
+
+void arith_free(arith_t *a);
+
+/**
+ * @brief Returns the compiled form of an expression through a small LRU
+ * cache keyed by its text.
+ * @note The expression is owned by the cache and stays valid until the next
+ * call. Not thread-safe, the cache is only used from the main thread.
+ */
+const arith_t *arith_get(const char *src);
+
+/**
+ * @brief Drops every cached expression.
+ */
+void arith_cache_free(void);
+
+/**
+ * @brief Tells whether an expression was folded into a constant.
+ * @param value set to the constant (may be NULL)
+ */
+bool arith_is_const(const arith_t *a, long long *value);
+
+/**
+ * @brief Evaluates an expression, assignments included. Errors (syntax,
+ * division by zero...) are reported on stderr.
+ * @param value set to the value of the expression, 0 for an empty one
+ * @return false on error
+ */
+bool arith_eval(const arith_t *a, long long *value);
+
+/**
+ * @brief Compiles, through the cache, and evaluates an expression.
+ */
+bool arith_eval_str(const char *src, long long *value);
+
+#endif // __ARITH_H__
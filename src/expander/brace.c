@@ -0,0 +1,372 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "expander/brace.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct brace_word_t brace_word_t;
+
+/**
+ * @brief One brace of a word: a list of alternatives or a sequence.
+ */
+typedef struct {
+  bool is_seq;
+  brace_word_t **alts; /**< Alternatives, each may hold braces itself */
+  size_t alt;          /**< Current alternative */
+
+  bool is_char;      /**< Sequence of letters rather than integers */
+  long long first;   /**< First element of the sequence */
+  long long last;    /**< Bound of the sequence, reached or not */
+  long long incr;    /**< Signed step between two elements */
+  long long cur;     /**< Current element */
+  int width;         /**< Zero-padded width of the elements, 0 if none */
+  char text[32];     /**< Text of the current element */
+} brace_slot_t;
+
+/**
+ * @brief A part of a word: a plain part or one of the braces.
+ */
+typedef struct {
+  word_part_t part; /**< Plain part, unused for braces */
+  int slot;         /**< Index of the brace in slots, -1 for a plain part */
+} brace_item_t;
+
+struct brace_word_t {
+  brace_item_t *items;
+  brace_slot_t *slots;
+  word_part_t *owned; /**< Parts allocated for this word, freed with it */
+};
+
+struct brace_iter_t {
+  brace_word_t *root;
+  word_part_t *out; /**< Current word, reused from one call to the next */
+  bool started;
+  bool done;
+};
+
+bool brace_has_expansion(word_part_t *word) {
+  for (int i = 0; i < arrlen(word); i++) {
+    if (word[i].type == WORD_BRACE)
+      return true;
+  }
+  return false;
+}
+
+/* --- COMPILATION --- */
+
+static brace_word_t *word_compile(word_part_t *parts, word_part_t *owned);
+static void word_free(brace_word_t *w);
+
+// parses a signed integer filling exactly len bytes
+static bool parse_int(const char *s, size_t len, long long *out) {
+  if (len == 0 || len > 20)
+    return false;
+  char buf[24];
+  memcpy(buf, s, len);
+  buf[len] = '\0';
+
+  char *end = NULL;
+  errno = 0;
+  *out = strtoll(buf, &end, 10);
+  return errno == 0 && *end == '\0' && (isdigit((unsigned char)buf[0]) ||
+                                        (len > 1 && strchr("+-", buf[0])));
+}
+
+// an endpoint like "05" or "-05" asks for zero-padded elements
+static bool is_padded(const char *s, size_t len) {
+  if (len > 0 && (*s == '-' || *s == '+')) {
+    s++;
+    len--;
+  }
+  return len > 1 && *s == '0';
+}
+
+/**
+ * @brief Parses 'x..y' or 'x..y..incr' where x and y are both integers or
+ * both single letters.
+ */
+static bool parse_sequence(const char *body, brace_slot_t *slot) {
+  const char *dots = strstr(body, "..");
+  if (!dots)
+    return false;
+  const char *x = body;
+  size_t x_len = (size_t)(dots - body);
+  const char *y = dots + 2;
+  const char *dots2 = strstr(y, "..");
+  size_t y_len = dots2 ? (size_t)(dots2 - y) : strlen(y);
+
+  long long incr = 1;
+  if (dots2 && !parse_int(dots2 + 2, strlen(dots2 + 2), &incr))
+    return false;
+  if (incr == LLONG_MIN)
+    return false;
+  incr = llabs(incr);
+  if (incr == 0)
+    incr = 1;
+
+  if (x_len == 1 && y_len == 1 && isalpha((unsigned char)*x) &&
+      isalpha((unsigned char)*y)) {
+    slot->is_char = true;
+    slot->first = (unsigned char)*x;
+    slot->last = (unsigned char)*y;
+  } else if (parse_int(x, x_len, &slot->first) &&
+             parse_int(y, y_len, &slot->last)) {
+    if (is_padded(x, x_len) || is_padded(y, y_len))
+      slot->width = (int)(x_len > y_len ? x_len : y_len);
+  } else {
+    return false;
+  }
+
+  slot->is_seq = true;
+  slot->incr = slot->first <= slot->last ? incr : -incr;
+  return true;
+}
+
+/**
+ * @brief Splits a brace body on its top-level commas. Quotes, escapes and
+ * nested braces (${...} included) are skipped.
+ * @return stb_ds array of offsets of the commas, NULL if there is none
+ */
+static size_t *find_commas(const char *body) {
+  size_t *commas = NULL;
+  quote_context_e quote = QUOTE_NONE;
+  int depth = 0;
+  for (size_t i = 0; body[i]; i++) {
+    char c = body[i];
+    if (quote == QUOTE_SINGLE) {
+      if (c == '\'')
+        quote = QUOTE_NONE;
+    } else if (c == '\\' && body[i + 1]) {
+      i++;
+    } else if (c == '"') {
+      quote = quote == QUOTE_DOUBLE ? QUOTE_NONE : QUOTE_DOUBLE;
+    } else if (quote == QUOTE_DOUBLE) {
+      continue;
+    } else if (c == '\'') {
+      quote = QUOTE_SINGLE;
+    } else if (c == '{') {
+      depth++;
+    } else if (c == '}') {
+      depth--;
+    } else if (c == ',' && depth == 0) {
+      arrpush(commas, i);
+    }
+  }
+  return commas;
+}
+
+/**
+ * @brief Compiles the body of a brace into a slot.
+ * @return false if the body is neither a list nor a valid sequence
+ */
+static bool slot_compile(const char *body, brace_slot_t *slot) {
+  *slot = (brace_slot_t){0};
+  size_t *commas = find_commas(body);
+  if (!commas)
+    return parse_sequence(body, slot);
+
+  size_t start = 0;
+  for (int i = 0; i <= arrlen(commas); i++) {
+    size_t end = i < arrlen(commas) ? commas[i] : strlen(body);
+    word_part_t *parts = lexer_word_parts(body + start, end - start);
+    arrpush(slot->alts, word_compile(parts, parts));
+    start = end + 1;
+  }
+  arrfree(commas);
+  return true;
+}
+
+/**
+ * @brief Compiles a word.
+ * @param owned parts to release with the word (may be NULL)
+ */
+static brace_word_t *word_compile(word_part_t *parts, word_part_t *owned) {
+  brace_word_t *w = xcalloc(1, sizeof(brace_word_t));
+  w->owned = owned;
+
+  for (int i = 0; i < arrlen(parts); i++) {
+    brace_item_t item = {.part = parts[i], .slot = -1};
+    if (parts[i].type == WORD_BRACE) {
+      brace_slot_t slot;
+      if (slot_compile(parts[i].value, &slot)) {
+        item.slot = (int)arrlen(w->slots);
+        arrpush(w->slots, slot);
+      } else {
+        // not an expansion after all, the braces are kept
+        size_t len = strlen(parts[i].value) + 3;
+        char *text = xmalloc(len);
+        snprintf(text, len, "{%s}", parts[i].value);
+        item.part = (word_part_t){WORD_LITERAL, QUOTE_NONE, text};
+        arrpush(w->owned, item.part);
+      }
+    }
+    arrpush(w->items, item);
+  }
+  return w;
+}
+
+static void word_free(brace_word_t *w) {
+  if (!w)
+    return;
+  for (int i = 0; i < arrlen(w->slots); i++) {
+    for (int j = 0; j < arrlen(w->slots[i].alts); j++)
+      word_free(w->slots[i].alts[j]);
+    arrfree(w->slots[i].alts);
+  }
+  arrfree(w->slots);
+  arrfree(w->items);
+  for (int i = 0; i < arrlen(w->owned); i++)
+    free(w->owned[i].value);
+  arrfree(w->owned);
+  free(w);
+}
+
+/* --- ENUMERATION --- */
+
+static void word_reset(brace_word_t *w);
+static bool word_advance(brace_word_t *w);
+
+static void slot_format(brace_slot_t *s) {
+  if (s->is_char)
+    snprintf(s->text, sizeof(s->text), "%c", (char)s->cur);
+  else
+    snprintf(s->text, sizeof(s->text), "%0*lld", s->width, s->cur);
+}
+
+static void slot_reset(brace_slot_t *s) {
+  if (s->is_seq) {
+    s->cur = s->first;
+    slot_format(s);
+    return;
+  }
+  s->alt = 0;
+  word_reset(s->alts[0]);
+}
+
+static bool slot_advance(brace_slot_t *s) {
+  if (s->is_seq) {
+    long long next;
+    if (__builtin_add_overflow(s->cur, s->incr, &next))
+      return false;
+    if (s->incr > 0 ? next > s->last : next < s->last)
+      return false;
+    s->cur = next;
+    slot_format(s);
+    return true;
+  }
+
+  if (word_advance(s->alts[s->alt]))
+    return true;
+  if (++s->alt == (size_t)arrlen(s->alts))
+    return false;
+  word_reset(s->alts[s->alt]);
+  return true;
+}
+
+static void word_reset(brace_word_t *w) {
+  for (int i = 0; i < arrlen(w->slots); i++)
+    slot_reset(&w->slots[i]);
+}
+
+// moves to the next combination, the last slot turning fastest
+static bool word_advance(brace_word_t *w) {
+  for (int i = (int)arrlen(w->slots) - 1; i >= 0; i--) {
+    if (slot_advance(&w->slots[i]))
+      return true;
+    slot_reset(&w->slots[i]);
+  }
+  return false;
+}
+
+static void word_emit(brace_word_t *w, word_part_t **out) {
+  for (int i = 0; i < arrlen(w->items); i++) {
+    brace_item_t *item = &w->items[i];
+    if (item->slot < 0) {
+      arrpush(*out, item->part);
+      continue;
+    }
+
+    brace_slot_t *s = &w->slots[item->slot];
+    if (s->is_seq)
+      arrpush(*out, ((word_part_t){WORD_LITERAL, QUOTE_NONE, s->text}));
+    else
+      word_emit(s->alts[s->alt], out);
+  }
+}
+
+static size_t mul_sat(size_t a, size_t b) {
+  size_t r;
+  return __builtin_mul_overflow(a, b, &r) ? SIZE_MAX : r;
+}
+
+static size_t add_sat(size_t a, size_t b) {
+  size_t r;
+  return __builtin_add_overflow(a, b, &r) ? SIZE_MAX : r;
+}
+
+static size_t word_count(brace_word_t *w) {
+  size_t count = 1;
+  for (int i = 0; i < arrlen(w->slots); i++) {
+    brace_slot_t *s = &w->slots[i];
+    size_t n = 0;
+    if (s->is_seq) {
+      unsigned long long span =
+          s->incr > 0 ? (unsigned long long)s->last - (unsigned long long)s->first
+                      : (unsigned long long)s->first - (unsigned long long)s->last;
+      unsigned long long step = (unsigned long long)llabs(s->incr);
+      n = span / step >= SIZE_MAX ? SIZE_MAX : (size_t)(span / step) + 1;
+    } else {
+      for (int j = 0; j < arrlen(s->alts); j++)
+        n = add_sat(n, word_count(s->alts[j]));
+    }
+    count = mul_sat(count, n);
+  }
+  return count;
+}
+
+/* --- ITERATOR --- */
+
+brace_iter_t *brace_iter_new(word_part_t *word) {
+  brace_iter_t *it = xcalloc(1, sizeof(brace_iter_t));
+  it->root = word_compile(word, NULL);
+  return it;
+}
+
+word_part_t *brace_iter_next(brace_iter_t *it) {
+  if (it->done)
+    return NULL;
+
+  if (!it->started) {
+    word_reset(it->root);
+    it->started = true;
+  } else if (!word_advance(it->root)) {
+    it->done = true;
+    return NULL;
+  }
+
+  if (it->out)
+    arrdeln(it->out, 0, (size_t)arrlen(it->out));
+  word_emit(it->root, &it->out);
+  return it->out;
+}
+
+size_t brace_iter_count(brace_iter_t *it) { return word_count(it->root); }
+
+void brace_iter_free(brace_iter_t *it) {
+  if (!it)
+    return;
+  word_free(it->root);
+  arrfree(it->out);
+  free(it);
+}
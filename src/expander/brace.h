@@ -0,0 +1,55 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __BRACE_H__
+#define __BRACE_H__
+
+#include "lexer/lexer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Brace expansion: {a,b,c} alternatives and {x..y[..incr]} sequences of
+ * integers or letters, possibly nested.
+ *
+ * A word holding braces is compiled into slots, one per brace, and the words
+ * it stands for are enumerated one at a time like an odometer whose
+ * rightmost slot turns fastest. Nothing is materialized: the memory used is
+ * bounded by the size of the word whatever the number of words it expands
+ * to, so that large sequences can be streamed.
+ */
+
+typedef struct brace_iter_t brace_iter_t;
+
+/**
+ * @brief Tells whether a word holds a brace expansion.
+ */
+bool brace_has_expansion(word_part_t *word);
+
+/**
+ * @brief Compiles the braces of a word. Invalid sequences such as {a..1}
+ * are kept as literal text.
+ * @param word the word, must outlive the iterator
+ */
+brace_iter_t *brace_iter_new(word_part_t *word);
+
+/**
+ * @brief Returns the next word of the expansion, as parts without braces
+ * left to be expanded further.
+ * @return stb_ds array owned by the iterator and valid until the next call,
+ * NULL once every word was returned
+ */
+word_part_t *brace_iter_next(brace_iter_t *it);
+
+/**
+ * @brief Number of words the expansion yields, SIZE_MAX if it overflows.
+ */
+size_t brace_iter_count(brace_iter_t *it);
+
+void brace_iter_free(brace_iter_t *it);
+
+#endif // __BRACE_H__
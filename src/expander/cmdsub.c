@@ -0,0 +1,341 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "expander/cmdsub.h"
+// executor.h sets _DEFAULT_SOURCE before any system header
+#include "executor/executor.h"
+#include "builtin/builtin.h"
+#include "expander/expander.h"
+#include "shell/config.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// smallest read issued on the output, the buffer doubles when it is full
+#define CMDSUB_READ_MIN 4096
+
+typedef struct {
+  char *key;
+  ast_node_t *value; /**< NULL for an empty body */
+} cmdsub_cache_entry_t;
+
+static cmdsub_cache_entry_t *cache = NULL;
+
+/* --- PARSING --- */
+
+ast_node_t *cmdsub_parse(const char *body, bool *transient, bool *error) {
+  cmdsub_cache_entry_t *entry = cache ? shgetp_null(cache, body) : NULL;
+  if (entry)
+    return entry->value;
+
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)body);
+  parser_t p = {.lex = lex,
+                .tok = {.type = TOK_EOF, .raw_value = NULL, .parts = NULL}};
+  ast_node_t *ast = parser_parse(&p);
+  lexer_free(lex);
+  if (p.error) {
+    *error = true;
+    return NULL;
+  }
+  expander_static_pass(ast);
+
+  if (shlen(cache) >= CMDSUB_CACHE_SIZE) {
+    *transient = true;
+    return ast;
+  }
+  if (!cache)
+    sh_new_strdup(cache);
+  shput(cache, body, ast);
+  return ast;
+}
+
+/* --- OUTPUT --- */
+
+/**
+ * @brief Reads fd up to its end into a heap buffer.
+ * @param hint expected size of the content, 0 if unknown
+ */
+static char *read_all(int fd, size_t hint, size_t *len) {
+  // one spare byte for the NUL and one so that the read seeing EOF has room
+  size_t cap = hint + 2 > CMDSUB_READ_MIN ? hint + 2 : CMDSUB_READ_MIN;
+  char *buf = xmalloc(cap);
+  size_t n = 0;
+
+  for (;;) {
+    if (n + 1 == cap) {
+      cap *= 2;
+      buf = xrealloc(buf, cap);
+    }
+    ssize_t r = read(fd, buf + n, cap - n - 1);
+    if (r == -1 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      break;
+    n += (size_t)r;
+  }
+  buf[n] = '\0';
+  *len = n;
+  return buf;
+}
+
+// NUL bytes cannot be part of a word and trailing newlines are removed, both
+// in place
+static void trim_output(char *buf, size_t *len) {
+  size_t n = *len;
+  if (memchr(buf, '\0', n)) {
+    size_t j = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (buf[i] != '\0')
+        buf[j++] = buf[i];
+    }
+    n = j;
+  }
+  while (n > 0 && buf[n - 1] == '\n')
+    n--;
+  buf[n] = '\0';
+  *len = n;
+}
+
+/* --- $(<file) --- */
+
+/**
+ * @brief Handles a body made of a single input redirection, which stands for
+ * the content of the file.
+ * @return false if the body has another form
+ */
+static bool run_read_file(const char *body, char **out, size_t *len,
+                          int *status, bool *invalid) {
+  while (*body == ' ' || *body == '\t' || *body == '\n')
+    body++;
+  if (body[0] != '<' || body[1] == '<')
+    return false;
+
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)body + 1);
+  token_t word = lexer_next_token(lex);
+  token_t next = lexer_next_token(lex);
+  while (next.type == TOK_NEWLINE)
+    next = lexer_next_token(lex);
+  bool match = word.type == TOK_WORD && next.type == TOK_EOF;
+  lexer_free_token(&next);
+  lexer_free(lex);
+  if (!match) {
+    lexer_free_token(&word);
+    return false;
+  }
+
+  char *path = expand_word_str(word.parts, NULL, invalid);
+  lexer_free_token(&word);
+  if (*invalid)
+    return true;
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd == -1) {
+    nsh_msg("%s: %s\n", path, strerror(errno));
+    *out = xstrdup("");
+    *len = 0;
+    *status = 1;
+  } else {
+    size_t hint = fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+                      ? (size_t)st.st_size
+                      : 0;
+    *out = read_all(fd, hint, len);
+    *status = 0;
+    close(fd);
+  }
+  free(path);
+  return true;
+}
+
+/* --- IN-PROCESS BODIES --- */
+
+// tells whether an arithmetic expression has =, op=, ++ or --
+static bool arith_assigns(const char *expr) {
+  for (const char *c = expr; *c; c++) {
+    if ((c[0] == '+' || c[0] == '-') && c[1] == c[0])
+      return true;
+    if (c[0] != '=')
+      continue;
+    if (c[1] == '=') {
+      c++;
+      continue;
+    }
+    // <= and >= compare, but <<= and >>= assign
+    char prev = c > expr ? c[-1] : '\0';
+    if ((prev != '<' && prev != '>' && prev != '!') ||
+        (c - expr >= 2 && c[-2] == prev && prev != '!'))
+      return true;
+  }
+  return false;
+}
+
+static bool word_assigns(word_part_t *word) {
+  for (int i = 0; i < arrlen(word); i++) {
+    if (word[i].type == WORD_PARAM && strchr(word[i].value, '='))
+      return true;
+    if (word[i].type == WORD_ARITH && arith_assigns(word[i].value))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Tells whether a body can run without a subshell: every command is
+ * a pure builtin named by a literal word, without redirection nor ${x:=w} or
+ * $((x += 1)) assignment that would outlive the substitution.
+ */
+static bool is_pure_body(ast_node_t *ast) {
+  if (ast->type != NODE_SEQUENCE)
+    return false;
+
+  for (int i = 0; i < arrlen(ast->seq.nodes); i++) {
+    ast_node_t *node = ast->seq.nodes[i];
+    if (node->type != NODE_CMD)
+      return false;
+    cmd_node_t *cmd = &node->cmd;
+    if (cmd->is_bg || arrlen(cmd->redir) > 0 || arrlen(cmd->argv_parts) == 0)
+      return false;
+
+    word_part_t *name = cmd->argv_parts[0];
+    if (arrlen(name) != 1 || name[0].type != WORD_LITERAL ||
+        !builtin_is_pure(name[0].value))
+      return false;
+    for (int j = 1; j < arrlen(cmd->argv_parts); j++) {
+      if (word_assigns(cmd->argv_parts[j]))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Runs a pure body in the shell process. Each command is expanded
+ * first, then runs with its output sent to a memfd, which unlike a pipe
+ * never blocks however much is written.
+ * @return the output or NULL if it could not be captured
+ */
+static char *run_in_process(ast_node_t *ast, size_t *len, int *status) {
+  int fd = memfd_create("nsh-cmdsub", MFD_CLOEXEC);
+  if (fd == -1)
+    return NULL;
+  int saved = dup(STDOUT_FILENO);
+  if (saved == -1) {
+    close(fd);
+    return NULL;
+  }
+
+  shell_last_exec_t *last_exec = shell_state_get_last_exec();
+  for (int i = 0; i < arrlen(ast->seq.nodes); i++) {
+    ast_node_t *node = ast->seq.nodes[i];
+    expander_expand_ast(node);
+    *status = 1;
+    if (!node->invalid) {
+      cmd_node_t *cmd = &node->cmd;
+      builtin_fn_t fn = builtin_get_function(cmd->argv[0]);
+      fflush(stdout);
+      dup2(fd, STDOUT_FILENO);
+      *status = fn((int)arrlen(cmd->argv), cmd->argv);
+      fflush(stdout);
+      dup2(saved, STDOUT_FILENO);
+    }
+    last_exec->exit_status = *status;
+  }
+  close(saved);
+
+  struct stat st;
+  size_t hint = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+  lseek(fd, 0, SEEK_SET);
+  char *out = read_all(fd, hint, len);
+  close(fd);
+  return out;
+}
+
+/* --- FORKED BODIES --- */
+
+static char *run_forked(ast_node_t *ast, size_t *len, int *status) {
+  int fds[2];
+  xpipe(fds);
+  fflush(NULL);
+
+  pid_t pid = xfork();
+  if (pid == 0) {
+    /* CHILD: the subshell, its state dies with it. It stays in the group
+     * of the shell but leaves the terminal and the job notices to it. */
+    shell_state_t *sh_state = shell_state_get();
+    sh_state->flags.interactive = false;
+    sh_state->flags.job_control = false;
+    close(fds[0]);
+    xdup2(fds[1], STDOUT_FILENO, true);
+    close(fds[1]);
+    int st = exec_node(ast);
+    fflush(NULL);
+    _exit(st < 0 ? 0 : st & 0xff);
+  }
+
+  close(fds[1]);
+  char *out = read_all(fds[0], 0, len);
+  close(fds[0]);
+
+  int wstatus = 0;
+  while (waitpid(pid, &wstatus, 0) == -1 && errno == EINTR)
+    ;
+  *status = WIFSIGNALED(wstatus) ? 128 + WTERMSIG(wstatus)
+                                 : WEXITSTATUS(wstatus);
+  pr_debug("cmdsub: forked pid %d, %zu bytes, status %d", pid, *len,
+           *status);
+  return out;
+}
+
+char *cmdsub_run(const char *body, bool *invalid) {
+  char *out = NULL;
+  size_t len = 0;
+  int status = 0;
+
+  if (!run_read_file(body, &out, &len, &status, invalid)) {
+    bool transient = false;
+    ast_node_t *ast = cmdsub_parse(body, &transient, invalid);
+    if (*invalid)
+      return NULL;
+
+    if (!ast)
+      out = xstrdup("");
+    else if (is_pure_body(ast))
+      out = run_in_process(ast, &len, &status);
+    if (!out)
+      out = run_forked(ast, &len, &status);
+    if (transient)
+      parser_free_ast(ast);
+  }
+  if (*invalid) {
+    free(out);
+    return NULL;
+  }
+
+  trim_output(out, &len);
+  shell_state_get_last_exec()->exit_status = status;
+  return out;
+}
+
+size_t cmdsub_cache_size(void) { return (size_t)shlen(cache); }
+
+void cmdsub_cache_free(void) {
+  for (int i = 0; i < shlen(cache); i++)
+    parser_free_ast(cache[i].value);
+  shfree(cache);
+  cache = NULL;
+}
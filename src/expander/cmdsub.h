@@ -0,0 +1,58 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __CMDSUB_H__
+#define __CMDSUB_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct ast_node_t ast_node_t;
+
+/*
+ * Command substitution: $(...) and `...`.
+ *
+ * Forking is what makes substitutions expensive in loops, so it is avoided
+ * whenever the subshell would not be observable:
+ *  - $(<file) reads the file directly;
+ *  - a body made of pure builtins (see builtin_is_pure()) runs in the shell
+ *    process, its output captured in a memfd;
+ *  - anything else runs in a forked shell whose output is read from a pipe
+ *    with large reads into a buffer growing geometrically.
+ * Bodies are parsed once and their AST is kept for the next substitutions
+ * of the same text.
+ */
+
+/**
+ * @brief Runs the body of a command substitution. $? is set to its status.
+ * @param body the command text between the parentheses or backquotes
+ * @param invalid set when the body has a syntax error
+ * @return heap-allocated output without its trailing newlines, NULL when
+ * invalid is set
+ */
+char *cmdsub_run(const char *body, bool *invalid);
+
+/**
+ * @brief Returns the AST of a body, from the cache when it was parsed before.
+ * Shared with process substitutions.
+ * @param transient set when the AST is not cached and must be freed
+ * @param error set on a syntax error
+ * @return the AST, NULL for an empty body or on error
+ */
+ast_node_t *cmdsub_parse(const char *body, bool *transient, bool *error);
+
+/**
+ * @brief Number of substitution bodies whose AST is cached.
+ */
+size_t cmdsub_cache_size(void);
+
+/**
+ * @brief Frees the cached ASTs.
+ */
+void cmdsub_cache_free(void);
+
+#endif // __CMDSUB_H__
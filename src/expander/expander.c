@@ -7,18 +7,58 @@
  */
 #include "expander.h"
 
+// true when the previous expansion of the command can be kept as is
+static bool cmd_memo_is_fresh(cmd_node_t *cmd) {
+  if (!cmd->argv || arrlen(cmd->argv_memo) != arrlen(cmd->argv_parts))
+    return false;
+
+  for (int i = 0; i < arrlen(cmd->argv_memo); i++) {
+    if (!expand_memo_is_fresh(&cmd->argv_memo[i]))
+      return false;
+  }
+  for (int i = 0; i < arrlen(cmd->redir); i++) {
+    if (cmd->redir[i].target_parts &&
+        !expand_memo_is_fresh(&cmd->redir[i].target_memo))
+      return false;
+  }
+  return true;
+}
+
 static void expander_expand_cmd(ast_node_t *node) {
-  if (node->cmd.argv_parts) {
-    arrfree(node->cmd.argv);
-    node->cmd.argv = expand_argv_parts(node->cmd.argv_parts, &node->invalid);
+  cmd_node_t *cmd = &node->cmd;
+  // argv and targets of static commands were built once by the static pass
+  if (cmd->is_static)
+    return;
+
+  // the AST may be expanded several times (cached ASTs), nothing to do if
+  // none of the variables and directories the words depend on changed
+  if (!node->invalid && cmd_memo_is_fresh(cmd))
+    return;
+
+  // otherwise drop the results of the previous expansion, words whose memo
+  // is still fresh are not expanded again
+  node->invalid = false;
+  if (cmd->argv_parts) {
+    if (arrlen(cmd->argv_memo) != arrlen(cmd->argv_parts)) {
+      arrsetlen(cmd->argv_memo, arrlen(cmd->argv_parts));
+      memset(cmd->argv_memo, 0,
+             sizeof(word_memo_t) * (size_t)arrlen(cmd->argv_memo));
+    }
+
+    parser_free_argv(cmd);
+    cmd->argv =
+        expand_argv_parts(cmd->argv_parts, cmd->argv_memo, &cmd->argv_arena,
+                          &cmd->argv_spread, &cmd->argv_spread_end,
+                          &node->invalid);
   }
 
-  if (node->cmd.redir) {
-    for (int i = 0; i < arrlen(node->cmd.redir); i++) {
-      redirection_t *r = &node->cmd.redir[i];
+  if (cmd->redir) {
+    for (int i = 0; i < arrlen(cmd->redir); i++) {
+      redirection_t *r = &cmd->redir[i];
       if (r->target_parts) {
         free(r->target);
-        r->target = expand_redirection_target(r->target_parts, &node->invalid);
+        r->target = expand_redirection_target(r->target_parts, &r->target_memo,
+                                              &node->invalid);
       }
     }
   }
@@ -33,16 +73,39 @@ void expander_expand_ast(ast_node_t *node) {
     expander_expand_cmd(node);
     break;
   case NODE_PIPELINE:
-    for (int i = 0; i < arrlen(node->pipe.nodes); i++)
+    node->invalid = false;
+    for (int i = 0; i < arrlen(node->pipe.nodes); i++) {
       expander_expand_ast(node->pipe.nodes[i]);
+      node->invalid |= node->pipe.nodes[i]->invalid;
+    }
     break;
   case NODE_CONDITIONAL:
+    // conditionals and sequences are flagged as well but the executor still
+    // runs their valid children
     expander_expand_ast(node->cond.left);
     expander_expand_ast(node->cond.right);
+    node->invalid = node->cond.left->invalid || node->cond.right->invalid;
     break;
   case NODE_SEQUENCE:
-    for (int i = 0; i < arrlen(node->seq.nodes); i++)
+    node->invalid = false;
+    for (int i = 0; i < arrlen(node->seq.nodes); i++) {
       expander_expand_ast(node->seq.nodes[i]);
+      node->invalid |= node->seq.nodes[i]->invalid;
+    }
+    break;
+  case NODE_CASE:
+    // the word and the patterns are expanded by the executor, one pattern
+    // at a time until one matches
+    node->invalid = false;
+    break;
+  case NODE_FOR:
+    // the words are expanded by the executor as the loop goes, the body is
+    // expanded again on every iteration
+    node->invalid = false;
+    break;
+  case NODE_ARITH:
+    // the expression is expanded and evaluated by the executor
+    node->invalid = false;
     break;
   }
 }
\ No newline at end of file
@@ -15,4 +15,14 @@
 
 void expander_expand_ast(ast_node_t *node);
 
+/**
+ * @brief Marks the commands made of literal words only (no parameter, tilde
+ * or glob) as static and precomputes their argv, redirection targets and
+ * builtin. Static commands are skipped by expander_expand_ast() and their
+ * executable path is resolved once by the executor, which matters for
+ * cached ASTs and scripts.
+ * @param node root of a freshly parsed AST
+ */
+void expander_static_pass(ast_node_t *node);
+
 #endif // NOVASH_EXPANDER_H
\ No newline at end of file
@@ -0,0 +1,806 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "expander/glob.h"
+#include "expander/pattern.h"
+#include "shell/config.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include "utils/thread_pool.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// large reads keep the number of getdents64 calls low on huge directories
+#define GLOB_GETDENTS_BUF_SIZE (256 * 1024)
+// '**' walks many small directories, each worker task uses a smaller buffer
+#define GLOBSTAR_GETDENTS_BUF_SIZE (32 * 1024)
+#define GLOBSTAR_MAX_THREADS 4
+
+struct linux_dirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+static glob_dir_entry_t *dir_cache = NULL;
+static uint64_t use_clock = 0;
+
+/* --- SORTING --- */
+
+static void merge_sort_rec(char **a, char **tmp, size_t n) {
+  if (n < 2)
+    return;
+
+  size_t mid = n / 2;
+  merge_sort_rec(a, tmp, mid);
+  merge_sort_rec(a + mid, tmp, n - mid);
+  // already ordered halves are common (directories are often created in
+  // order), skip the merge
+  if (strcmp(a[mid - 1], a[mid]) <= 0)
+    return;
+
+  size_t i = 0, j = mid, k = 0;
+  while (i < mid && j < n)
+    tmp[k++] = strcmp(a[j], a[i]) < 0 ? a[j++] : a[i++];
+  while (i < mid)
+    tmp[k++] = a[i++];
+  while (j < n)
+    tmp[k++] = a[j++];
+  memcpy(a, tmp, n * sizeof(char *));
+}
+
+void glob_sort(char **strs, size_t n) {
+  if (n < 2)
+    return;
+  char **tmp = xmalloc(n * sizeof(char *));
+  merge_sort_rec(strs, tmp, n);
+  free(tmp);
+}
+
+/* --- DIRECTORY LISTING CACHE --- */
+
+static void free_dir(glob_dir_t *dir) {
+  free(dir->path);
+  arrfree(dir->arena);
+  arrfree(dir->names);
+  free(dir);
+}
+
+/**
+ * @brief Reads every entry of an open directory with getdents64.
+ * Each name is stored in the arena preceded by its type so that both move
+ * together when the names are sorted.
+ * @param cancel checked between reads to stop early (may be NULL)
+ * @return false if reading failed or was cancelled
+ */
+static bool read_entries(int fd, size_t buf_size, char **arena, char ***names,
+                         atomic_bool *cancel) {
+  char *buf = xmalloc(buf_size);
+  size_t *offsets = NULL;
+  long n;
+  while ((n = syscall(SYS_getdents64, fd, buf, buf_size)) > 0) {
+    if (cancel && atomic_load_explicit(cancel, memory_order_relaxed))
+      break;
+
+    for (long pos = 0; pos < n;) {
+      struct linux_dirent64 *d = (struct linux_dirent64 *)(buf + pos);
+      pos += d->d_reclen;
+
+      const char *name = d->d_name;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        continue;
+
+      size_t len = strlen(name) + 1;
+      size_t off = (size_t)arrlen(*arena);
+      arrsetlen(*arena, off + 1 + len);
+      (*arena)[off] = (char)d->d_type;
+      memcpy(*arena + off + 1, name, len);
+      arrpush(offsets, off + 1);
+    }
+  }
+  free(buf);
+
+  // the arena does not move anymore, offsets can become pointers
+  arrsetlen(*names, arrlen(offsets));
+  for (int i = 0; i < arrlen(offsets); i++)
+    (*names)[i] = *arena + offsets[i];
+  arrfree(offsets);
+  return n == 0;
+}
+
+/**
+ * @brief Reads a directory and sorts its entries.
+ * @return the listing or NULL if the directory cannot be read
+ */
+static glob_dir_t *read_dir(const char *path, const struct stat *st) {
+  int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1)
+    return NULL;
+
+  glob_dir_t *dir = xcalloc(1, sizeof(glob_dir_t));
+  dir->path = xstrdup(path);
+  dir->dev = st->st_dev;
+  dir->ino = st->st_ino;
+  dir->mtime = st->st_mtim;
+  // a directory modified during the current second may change again without
+  // its mtime changing
+  dir->racy = st->st_mtim.tv_sec >= time(NULL);
+
+  if (!read_entries(fd, GLOB_GETDENTS_BUF_SIZE, &dir->arena, &dir->names,
+                    NULL))
+    pr_warn("glob: cannot read directory %s", path);
+  close(fd);
+
+  glob_sort(dir->names, (size_t)arrlen(dir->names));
+  return dir;
+}
+
+static void evict_one(void) {
+  int victim = -1;
+  for (int i = 0; i < shlen(dir_cache); i++) {
+    glob_dir_t *dir = dir_cache[i].value;
+    if (dir->refs > 0)
+      continue;
+    if (victim == -1 || dir->last_use < dir_cache[victim].value->last_use)
+      victim = i;
+  }
+  if (victim == -1)
+    return;
+
+  glob_dir_t *dir = dir_cache[victim].value;
+  (void)shdel(dir_cache, dir->path);
+  free_dir(dir);
+}
+
+/**
+ * @brief Returns the listing of a directory, pinned until release_dir().
+ * @return the listing or NULL if the directory cannot be read
+ */
+static glob_dir_t *acquire_dir(const char *path) {
+  struct stat st;
+  if (stat(path, &st) == -1 || !S_ISDIR(st.st_mode))
+    return NULL;
+
+  if (!dir_cache)
+    sh_new_strdup(dir_cache);
+
+  glob_dir_t *dir = shget(dir_cache, path);
+  if (dir && !dir->racy && dir->dev == st.st_dev && dir->ino == st.st_ino &&
+      dir->mtime.tv_sec == st.st_mtim.tv_sec &&
+      dir->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+    dir->refs++;
+    dir->last_use = ++use_clock;
+    return dir;
+  }
+
+  glob_dir_t *fresh = read_dir(path, &st);
+  if (!fresh)
+    return NULL;
+
+  if (dir && dir->refs == 0) {
+    (void)shdel(dir_cache, path);
+    free_dir(dir);
+  } else if (dir) {
+    // still walked by an outer level, keep it out of the table
+    dir->path[0] = '\0';
+    (void)shdel(dir_cache, path);
+  }
+
+  if (shlen(dir_cache) >= GLOB_DIR_CACHE_SIZE)
+    evict_one();
+
+  fresh->refs = 1;
+  fresh->last_use = ++use_clock;
+  shput(dir_cache, path, fresh);
+  return fresh;
+}
+
+static void release_dir(glob_dir_t *dir) {
+  dir->refs--;
+  // detached listings are not in the table anymore
+  if (dir->refs == 0 && dir->path[0] == '\0')
+    free_dir(dir);
+}
+
+void glob_cache_free(void) {
+  for (int i = 0; i < shlen(dir_cache); i++)
+    free_dir(dir_cache[i].value);
+  shfree(dir_cache);
+  dir_cache = NULL;
+}
+
+static int name_cmp(const void *key, const void *elem) {
+  return strcmp(key, *(char *const *)elem);
+}
+
+uint8_t glob_cached_type(const char *path) {
+  size_t len = strlen(path);
+  const char *slash = memrchr(path, '/', len);
+  // a trailing '/' was added to a match by the pattern
+  if (!dir_cache || len == 0 || (slash && slash[1] == '\0'))
+    return DT_UNKNOWN;
+
+  char *key;
+  if (!slash)
+    key = xstrdup(".");
+  else if (slash == path)
+    key = xstrdup("/");
+  else
+    key = xstrdup_n(path, (size_t)(slash - path));
+  glob_dir_t *dir = shget(dir_cache, key);
+  free(key);
+  if (!dir)
+    return DT_UNKNOWN;
+
+  const char *name = slash ? slash + 1 : path;
+  char **found = bsearch(name, dir->names, (size_t)arrlen(dir->names),
+                         sizeof(char *), name_cmp);
+  return found ? glob_dir_type(*found) : DT_UNKNOWN;
+}
+
+/* --- MATCHING --- */
+
+// a leading '.' of a name must be matched explicitly
+static bool name_matches(const pattern_t *pat, const char *name) {
+  if (name[0] == '.' && !pat->leading_dot)
+    return false;
+  return pattern_match(pat, name, strlen(name));
+}
+
+bool glob_match(const char *p, const char *s) {
+  pattern_t *pat = pattern_compile(p);
+  bool matched = name_matches(pat, s);
+  pattern_free(pat);
+  return matched;
+}
+
+/* --- EXPANSION --- */
+
+typedef struct {
+  char **comps;     /**< Pattern components */
+  pattern_t **pats; /**< Compiled magic components, NULL for the others */
+  bool dir_only;  /**< The pattern ends with a '/' */
+  int flags;      /**< GLOB_NATIVE_* flags */
+  char *path;     /**< stb_ds array, path built so far (not NUL-terminated) */
+  char ***out;
+  size_t count;
+  bool globstar;    /**< A '**' component was walked */
+  bool interrupted; /**< A '**' walk was cancelled by SIGINT */
+} glob_walk_t;
+
+static bool has_magic(const char *s) {
+  for (; *s; s++) {
+    if (*s == '\\' && s[1])
+      s++;
+    else if (*s == '*' || *s == '?' || *s == '[')
+      return true;
+  }
+  return false;
+}
+
+static void path_append(glob_walk_t *w, const char *name, bool unescape) {
+  size_t len = (size_t)arrlen(w->path);
+  if (len > 0 && w->path[len - 1] != '/')
+    arrpush(w->path, '/');
+  for (; *name; name++) {
+    if (unescape && *name == '\\' && name[1])
+      name++;
+    arrpush(w->path, *name);
+  }
+}
+
+static void emit(glob_walk_t *w) {
+  size_t len = (size_t)arrlen(w->path);
+  char *match = xmalloc(len + 2);
+  memcpy(match, w->path, len);
+  if (w->dir_only && (len == 0 || match[len - 1] != '/'))
+    match[len++] = '/';
+  match[len] = '\0';
+  arrpush(*w->out, match);
+  w->count++;
+}
+
+static bool path_is_dir(glob_walk_t *w) {
+  arrpush(w->path, '\0');
+  struct stat st;
+  bool is_dir = stat(w->path, &st) == 0 && S_ISDIR(st.st_mode);
+  (void)arrpop(w->path);
+  return is_dir;
+}
+
+/* --- GLOBSTAR --- */
+
+static inline bool is_globstar(const char *comp) {
+  return comp[0] == '*' && comp[1] == '*' && comp[2] == '\0';
+}
+
+static bool is_vcs_dir(const char *name) {
+  static const char *const vcs_dirs[] = {".git", ".hg",   ".svn",
+                                         ".bzr", "_darcs", "CVS"};
+  for (size_t i = 0; i < sizeof(vcs_dirs) / sizeof(vcs_dirs[0]); i++) {
+    if (strcmp(name, vcs_dirs[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
+/* Directory fd shared by a task and the subtasks opening entries from it */
+typedef struct {
+  int fd;
+  atomic_uint refs;
+} dir_handle_t;
+
+typedef struct {
+  char **comps;
+  pattern_t **pats;
+  int rest; /**< First component matched below each visited directory */
+  bool dir_only;
+  bool prune;
+  thread_pool_t *pool;
+  atomic_bool cancelled;
+  atomic_size_t pending; /**< Tasks queued or running */
+  int done_fd;           /**< eventfd signaled when pending drops to 0 */
+  pthread_mutex_t lock;
+  char **results;
+} globstar_t;
+
+typedef struct {
+  globstar_t *gs;
+  dir_handle_t *parent; /**< NULL for the starting directory */
+  char *name;           /**< Name in parent, or path of the start */
+  char *path;           /**< Path used to build the matches */
+} globstar_task_t;
+
+static void handle_release(dir_handle_t *h) {
+  if (atomic_fetch_sub(&h->refs, 1) == 1) {
+    close(h->fd);
+    free(h);
+  }
+}
+
+static char *join_path(const char *dir, const char *name, bool slash) {
+  size_t dir_len = strlen(dir);
+  size_t name_len = strlen(name);
+  char *out = xmalloc(dir_len + name_len + 3);
+  size_t len = 0;
+  if (dir_len > 0) {
+    memcpy(out, dir, dir_len);
+    len = dir_len;
+    if (out[len - 1] != '/')
+      out[len++] = '/';
+  }
+  memcpy(out + len, name, name_len);
+  len += name_len;
+  if (slash)
+    out[len++] = '/';
+  out[len] = '\0';
+  return out;
+}
+
+// entries '**' descends into: no symlinks, pruned names are skipped
+static bool should_descend(globstar_t *gs, int fd, const char *name) {
+  if (gs->prune && (name[0] == '.' || is_vcs_dir(name)))
+    return false;
+
+  uint8_t type = glob_dir_type(name);
+  if (type == DT_DIR)
+    return true;
+  if (type != DT_UNKNOWN)
+    return false;
+
+  struct stat st;
+  return fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+         S_ISDIR(st.st_mode);
+}
+
+static bool entry_is_dir(int fd, const char *name) {
+  uint8_t type = glob_dir_type(name);
+  if (type == DT_DIR)
+    return true;
+  if (type != DT_LNK && type != DT_UNKNOWN)
+    return false;
+
+  struct stat st;
+  return fstatat(fd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+}
+
+/**
+ * @brief Matches the components from idx on below an open directory.
+ * @param names entries of fd if already read, NULL to read them on demand
+ */
+static void match_rest(globstar_t *gs, int fd, const char *path,
+                       char **names, int idx, char ***out) {
+  if (atomic_load_explicit(&gs->cancelled, memory_order_relaxed))
+    return;
+
+  char *arena = NULL;
+  char **own_names = NULL;
+  int ncomps = (int)arrlen(gs->comps);
+  const char *comp = idx < ncomps ? gs->comps[idx] : NULL;
+
+  // a literal component is looked up directly, no listing needed
+  if (comp && !has_magic(comp)) {
+    char *name = xmalloc(strlen(comp) + 1);
+    size_t len = 0;
+    for (const char *c = comp; *c; c++) {
+      if (*c == '\\' && c[1])
+        c++;
+      name[len++] = *c;
+    }
+    name[len] = '\0';
+
+    if (idx == ncomps - 1) {
+      struct stat st;
+      if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+          (!gs->dir_only || (fstatat(fd, name, &st, 0) == 0 &&
+                             S_ISDIR(st.st_mode))))
+        arrpush(*out, join_path(path, name, gs->dir_only));
+    } else {
+      int sub = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (sub != -1) {
+        char *sub_path = join_path(path, name, false);
+        match_rest(gs, sub, sub_path, NULL, idx + 1, out);
+        free(sub_path);
+        close(sub);
+      }
+    }
+    free(name);
+    return;
+  }
+
+  if (!names) {
+    read_entries(fd, GLOBSTAR_GETDENTS_BUF_SIZE, &arena, &own_names,
+                 &gs->cancelled);
+    names = own_names;
+  }
+
+  for (int i = 0; i < arrlen(names); i++) {
+    const char *name = names[i];
+
+    if (!comp) {
+      // the pattern ends with '**': every entry of every visited directory
+      if (name[0] == '.')
+        continue;
+      if (!gs->dir_only)
+        arrpush(*out, join_path(path, name, false));
+      else if (entry_is_dir(fd, name))
+        arrpush(*out, join_path(path, name, true));
+      continue;
+    }
+
+    if (is_globstar(comp)) {
+      // nested '**': walk the subtree serially from this directory
+      if (!should_descend(gs, fd, name))
+        continue;
+      int sub = openat(fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW |
+                                     O_CLOEXEC);
+      if (sub == -1)
+        continue;
+      char *sub_path = join_path(path, name, false);
+      match_rest(gs, sub, sub_path, NULL, idx, out);
+      free(sub_path);
+      close(sub);
+      continue;
+    }
+
+    if (!name_matches(gs->pats[idx], name))
+      continue;
+
+    bool last = idx == ncomps - 1;
+    if (last && !gs->dir_only) {
+      arrpush(*out, join_path(path, name, false));
+    } else if (entry_is_dir(fd, name)) {
+      if (last) {
+        arrpush(*out, join_path(path, name, true));
+        continue;
+      }
+      int sub = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (sub == -1)
+        continue;
+      char *sub_path = join_path(path, name, false);
+      match_rest(gs, sub, sub_path, NULL, idx + 1, out);
+      free(sub_path);
+      close(sub);
+    }
+  }
+
+  // '**' also matches zero directories
+  if (comp && is_globstar(comp))
+    match_rest(gs, fd, path, names, idx + 1, out);
+
+  arrfree(own_names);
+  arrfree(arena);
+}
+
+static void globstar_submit(globstar_t *gs, dir_handle_t *parent, char *name,
+                            char *path);
+
+static void globstar_task(void *arg) {
+  globstar_task_t *t = arg;
+  globstar_t *gs = t->gs;
+
+  int fd = -1;
+  if (!atomic_load_explicit(&gs->cancelled, memory_order_relaxed)) {
+    int dirfd = t->parent ? t->parent->fd : AT_FDCWD;
+    fd = openat(dirfd, t->name,
+                O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  }
+  if (t->parent)
+    handle_release(t->parent);
+
+  if (fd != -1) {
+    char *arena = NULL;
+    char **names = NULL;
+    read_entries(fd, GLOBSTAR_GETDENTS_BUF_SIZE, &arena, &names,
+                 &gs->cancelled);
+
+    dir_handle_t *h = xmalloc(sizeof(dir_handle_t));
+    h->fd = fd;
+    atomic_init(&h->refs, 1);
+
+    for (int i = 0; i < arrlen(names); i++) {
+      if (atomic_load_explicit(&gs->cancelled, memory_order_relaxed))
+        break;
+      if (!should_descend(gs, fd, names[i]))
+        continue;
+      atomic_fetch_add(&h->refs, 1);
+      globstar_submit(gs, h, xstrdup(names[i]),
+                      join_path(t->path, names[i], false));
+    }
+
+    char **local = NULL;
+    match_rest(gs, fd, t->path, names, gs->rest, &local);
+    if (arrlen(local) > 0) {
+      pthread_mutex_lock(&gs->lock);
+      for (int i = 0; i < arrlen(local); i++)
+        arrpush(gs->results, local[i]);
+      pthread_mutex_unlock(&gs->lock);
+    }
+    arrfree(local);
+    arrfree(names);
+    arrfree(arena);
+    handle_release(h);
+  }
+
+  free(t->name);
+  free(t->path);
+  free(t);
+
+  if (atomic_fetch_sub(&gs->pending, 1) == 1) {
+    uint64_t one = 1;
+    (void)write(gs->done_fd, &one, sizeof(one));
+  }
+}
+
+static void globstar_submit(globstar_t *gs, dir_handle_t *parent, char *name,
+                            char *path) {
+  globstar_task_t *t = xmalloc(sizeof(globstar_task_t));
+  *t = (globstar_task_t){
+      .gs = gs, .parent = parent, .name = name, .path = path};
+  atomic_fetch_add(&gs->pending, 1);
+  thread_pool_submit(gs->pool, globstar_task, t);
+}
+
+/**
+ * @brief Walks the tree below the current path for a '**' component.
+ * Directories are read in parallel, each one relative to its parent fd, and
+ * the rest of the pattern is matched below each of them. SIGINT is read
+ * from a signalfd while the walk runs and cancels it.
+ */
+static void globstar(glob_walk_t *w, int idx) {
+  globstar_t gs = {.comps = w->comps,
+                   .pats = w->pats,
+                   .dir_only = w->dir_only,
+                   .prune = w->flags & GLOB_NATIVE_PRUNE,
+                   .results = NULL};
+  // consecutive '**' are the same as a single one
+  while (idx + 1 < arrlen(w->comps) && is_globstar(w->comps[idx + 1]))
+    idx++;
+  gs.rest = idx + 1;
+  atomic_init(&gs.cancelled, false);
+  atomic_init(&gs.pending, 0);
+  pthread_mutex_init(&gs.lock, NULL);
+  w->globstar = true;
+
+  // workers inherit the blocked mask, SIGINT is only seen by the signalfd
+  sigset_t mask, prev_mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  pthread_sigmask(SIG_BLOCK, &mask, &prev_mask);
+  int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  gs.done_fd = eventfd(0, EFD_CLOEXEC);
+
+  gs.pool = thread_pool_new(thread_pool_default_size(GLOBSTAR_MAX_THREADS));
+  size_t len = (size_t)arrlen(w->path);
+  char *start = len ? xstrdup_n(w->path, len) : xstrdup(".");
+  char *path = len ? xstrdup_n(w->path, len) : xstrdup("");
+  globstar_submit(&gs, NULL, start, path);
+
+  struct pollfd pfds[2] = {{.fd = gs.done_fd, .events = POLLIN},
+                           {.fd = sfd, .events = POLLIN}};
+  while (atomic_load(&gs.pending) > 0) {
+    if (poll(pfds, sfd != -1 ? 2 : 1, -1) == -1 && errno != EINTR)
+      break;
+    struct signalfd_siginfo si;
+    if ((pfds[1].revents & POLLIN) && read(sfd, &si, sizeof(si)) > 0)
+      atomic_store(&gs.cancelled, true);
+  }
+  thread_pool_free(gs.pool);
+
+  // a SIGINT received after the walk must not reach the shell either
+  if (sfd != -1) {
+    struct signalfd_siginfo si;
+    while (read(sfd, &si, sizeof(si)) > 0)
+      atomic_store(&gs.cancelled, true);
+    close(sfd);
+  }
+  close(gs.done_fd);
+  pthread_sigmask(SIG_SETMASK, &prev_mask, NULL);
+  pthread_mutex_destroy(&gs.lock);
+
+  if (atomic_load(&gs.cancelled)) {
+    w->interrupted = true;
+    for (int i = 0; i < arrlen(gs.results); i++)
+      free(gs.results[i]);
+  } else {
+    for (int i = 0; i < arrlen(gs.results); i++)
+      arrpush(*w->out, gs.results[i]);
+    w->count += (size_t)arrlen(gs.results);
+  }
+  arrfree(gs.results);
+}
+
+/* --- WALK --- */
+
+static void walk(glob_walk_t *w, int idx) {
+  int ncomps = (int)arrlen(w->comps);
+  bool last = idx == ncomps - 1;
+  const char *comp = w->comps[idx];
+  size_t saved_len = (size_t)arrlen(w->path);
+
+  if (is_globstar(comp)) {
+    globstar(w, idx);
+    return;
+  }
+
+  if (!has_magic(comp)) {
+    path_append(w, comp, true);
+    if (!last) {
+      walk(w, idx + 1);
+    } else {
+      arrpush(w->path, '\0');
+      struct stat st;
+      bool exists = lstat(w->path, &st) == 0;
+      (void)arrpop(w->path);
+      if (exists && (!w->dir_only || path_is_dir(w)))
+        emit(w);
+    }
+    arrsetlen(w->path, saved_len);
+    return;
+  }
+
+  arrpush(w->path, '\0');
+  glob_dir_t *dir = acquire_dir(saved_len ? w->path : ".");
+  arrsetlen(w->path, saved_len);
+  if (!dir)
+    return;
+
+  bool need_dir = !last || w->dir_only;
+  for (int i = 0; i < arrlen(dir->names); i++) {
+    if (!name_matches(w->pats[idx], dir->names[i]))
+      continue;
+
+    path_append(w, dir->names[i], false);
+    uint8_t type = glob_dir_type(dir->names[i]);
+    bool is_dir = type == DT_DIR ||
+                  ((type == DT_LNK || type == DT_UNKNOWN) && need_dir &&
+                   path_is_dir(w));
+    if (!need_dir)
+      emit(w);
+    else if (is_dir)
+      last ? emit(w) : walk(w, idx + 1);
+    arrsetlen(w->path, saved_len);
+  }
+  release_dir(dir);
+}
+
+ssize_t glob_expand(const char *pattern, int flags, char ***out) {
+  glob_walk_t w = {.out = out, .flags = flags};
+  size_t first = (size_t)arrlen(*out);
+
+  const char *p = pattern;
+  if (*p == '/') {
+    arrpush(w.path, '/');
+    while (*p == '/')
+      p++;
+  }
+
+  // split on '/', a trailing '/' only matches directories
+  while (*p) {
+    const char *end = strchr(p, '/');
+    size_t len = end ? (size_t)(end - p) : strlen(p);
+    arrpush(w.comps, xstrdup_n(p, len));
+    if (!end)
+      break;
+    p = end;
+    while (*p == '/')
+      p++;
+    if (!*p)
+      w.dir_only = true;
+  }
+
+  for (int i = 0; i < arrlen(w.comps); i++) {
+    bool magic = has_magic(w.comps[i]) && !is_globstar(w.comps[i]);
+    arrpush(w.pats, magic ? pattern_compile(w.comps[i]) : NULL);
+  }
+
+  if (arrlen(w.comps) > 0)
+    walk(&w, 0);
+
+  // every level is walked in order, but "a-b/x" sorts before "a/x": results
+  // spanning several directories or marked with a '/' are sorted again as
+  // whole paths
+  bool multi_level = w.dir_only;
+  for (int i = 0; i < arrlen(w.comps) - 1; i++)
+    multi_level |= has_magic(w.comps[i]);
+  if (multi_level || w.globstar)
+    glob_sort(*out + first, w.count);
+
+  // several '**' can reach the same path along different routes
+  if (w.globstar && w.count > 1) {
+    size_t kept = 1;
+    for (size_t i = 1; i < w.count; i++) {
+      char *s = (*out)[first + i];
+      if (strcmp(s, (*out)[first + kept - 1]) == 0)
+        free(s);
+      else
+        (*out)[first + kept++] = s;
+    }
+    arrsetlen(*out, first + kept);
+    w.count = kept;
+  }
+
+  for (int i = 0; i < arrlen(w.comps); i++) {
+    free(w.comps[i]);
+    pattern_free(w.pats[i]);
+  }
+  arrfree(w.comps);
+  arrfree(w.pats);
+  arrfree(w.path);
+  return w.interrupted ? -1 : (ssize_t)w.count;
+}
+
+char *glob_escape(const char *s) {
+  size_t len = 0;
+  for (const char *p = s; *p; p++)
+    len += strchr("*?[\\", *p) ? 2 : 1;
+
+  char *out = xmalloc(len + 1);
+  char *o = out;
+  for (const char *p = s; *p; p++) {
+    if (strchr("*?[\\", *p))
+      *o++ = '\\';
+    *o++ = *p;
+  }
+  *o = '\0';
+  return out;
+}
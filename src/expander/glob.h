@@ -0,0 +1,92 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __NOVASH_GLOB_H__
+#define __NOVASH_GLOB_H__
+
+#include "utils/collections.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * @brief Sorted listing of a directory, shared through the listing cache.
+ * Names live in a single arena, each one preceded by the d_type reported by
+ * getdents64 (DT_UNKNOWN on filesystems that do not fill it).
+ */
+typedef struct {
+  char *path; /**< Directory as given by the pattern ("." for the cwd) */
+  dev_t dev;
+  ino_t ino;
+  struct timespec mtime;
+  char *arena;   /**< stb_ds array holding every (type, name) pair */
+  char **names;  /**< stb_ds array of names sorted byte-wise */
+  bool racy;     /**< Modified during the second it was read */
+  unsigned refs; /**< Pinned while a pattern walks it */
+  uint64_t last_use;
+} glob_dir_t;
+
+// d_type of a name of a listing
+#define glob_dir_type(name) ((uint8_t)(name)[-1])
+
+typedef struct {
+  char *key;
+  glob_dir_t *value;
+} glob_dir_entry_t;
+
+/**
+ * @brief Matches a name against a single pattern component.
+ * Supports '*', '?', bracket expressions ('!' or '^' negation, ranges) and
+ * backslash escapes. A leading '.' must be matched explicitly.
+ * @param pattern pattern component (no '/')
+ * @param name file name
+ */
+bool glob_match(const char *pattern, const char *name);
+
+// '**' skips hidden and version control directories
+#define GLOB_NATIVE_PRUNE (1 << 0)
+
+/**
+ * @brief Expands a pattern against the filesystem.
+ * Directories are read through the listing cache: a listing is reused as long
+ * as the directory keeps its identity and mtime. Matches are appended to out
+ * in byte-wise order, as new heap strings.
+ * A '**' component matches any number of directories. The tree is walked in
+ * parallel without following symlinks and can be interrupted with SIGINT.
+ * @param pattern pattern where quoted magic characters are escaped by '\'
+ * @param flags GLOB_NATIVE_* flags
+ * @param out stb_ds array the matches are appended to
+ * @return number of matches, -1 if a '**' walk was interrupted
+ */
+ssize_t glob_expand(const char *pattern, int flags, char ***out);
+
+/**
+ * @brief Returns the d_type of a path from the cached listing of its
+ * directory, as left by the last glob_expand() that read it.
+ * @return the type or DT_UNKNOWN if the listing or the name is not cached
+ */
+uint8_t glob_cached_type(const char *path);
+
+/**
+ * @brief Escapes the glob magic characters and backslashes of a string.
+ * @return heap-allocated escaped string
+ */
+char *glob_escape(const char *s);
+
+/**
+ * @brief Sorts an array of strings in byte-wise order (stable merge sort).
+ */
+void glob_sort(char **strs, size_t n);
+
+/**
+ * @brief Drops every cached directory listing.
+ */
+void glob_cache_free(void);
+
+#endif // __NOVASH_GLOB_H__
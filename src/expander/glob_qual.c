@@ -0,0 +1,475 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "expander/glob_qual.h"
+#include "expander/glob.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include "utils/thread_pool.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// below this many paths the statx calls are issued by the shell itself
+#define QUAL_STAT_BATCH 256
+#define QUAL_MAX_THREADS 4
+
+typedef enum { QUAL_TYPE, QUAL_EXEC, QUAL_SIZE, QUAL_TIME } qual_kind_e;
+
+typedef struct {
+  qual_kind_e kind;
+  bool negate;
+  mode_t types[2]; /**< S_IF* types accepted by QUAL_TYPE (0 if unused) */
+  char field;      /**< 'm', 'a' or 'c' for QUAL_TIME */
+  char op;         /**< '+' (more), '-' (less) or '=' for SIZE and TIME */
+  uint64_t unit;   /**< Bytes or seconds per unit */
+  uint64_t n;
+} qual_test_t;
+
+typedef struct {
+  char key; /**< 'n', 'L', 'm', 'a', 'c' or 'N' */
+  bool reverse;
+} qual_sort_t;
+
+struct glob_qual_t {
+  qual_test_t *tests; /**< stb_ds array */
+  qual_sort_t *sorts; /**< stb_ds array, the first key sorts first */
+  bool follow;        /**< Symlinks are followed */
+  bool null_glob;
+  bool has_slice;
+  long long slice_from;
+  long long slice_to;
+  unsigned mask; /**< STATX_* fields the tests and sorts need */
+};
+
+/* --- PARSING --- */
+
+static bool parse_number(const char **p, const char *end, uint64_t *n) {
+  if (*p == end || !isdigit((unsigned char)**p))
+    return false;
+  *n = 0;
+  for (; *p < end && isdigit((unsigned char)**p); (*p)++)
+    *n = *n * 10 + (uint64_t)(**p - '0');
+  return true;
+}
+
+static bool parse_signed(const char **p, const char *end, long long *n) {
+  bool neg = *p < end && **p == '-';
+  if (neg)
+    (*p)++;
+  uint64_t u;
+  if (!parse_number(p, end, &u))
+    return false;
+  *n = neg ? -(long long)u : (long long)u;
+  return true;
+}
+
+static uint64_t size_unit(char c) {
+  switch (tolower((unsigned char)c)) {
+  case 'p':
+    return 512;
+  case 'k':
+    return 1ULL << 10;
+  case 'm':
+    return 1ULL << 20;
+  case 'g':
+    return 1ULL << 30;
+  case 't':
+    return 1ULL << 40;
+  default:
+    return 0;
+  }
+}
+
+static uint64_t time_unit(char c) {
+  switch (c) {
+  case 'M':
+    return 30 * 86400;
+  case 'w':
+    return 7 * 86400;
+  case 'd':
+    return 86400;
+  case 'h':
+    return 3600;
+  case 'm':
+    return 60;
+  case 's':
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static unsigned time_mask(char field) {
+  return field == 'm' ? STATX_MTIME : field == 'a' ? STATX_ATIME : STATX_CTIME;
+}
+
+// [+-]n following L or m, a, c and their unit
+static bool parse_amount(const char **p, const char *end, qual_test_t *t) {
+  t->op = '=';
+  if (*p < end && (**p == '+' || **p == '-'))
+    t->op = *(*p)++;
+  return parse_number(p, end, &t->n);
+}
+
+static bool parse_slice(const char **p, const char *end, glob_qual_t *q) {
+  if (!parse_signed(p, end, &q->slice_from))
+    return false;
+  q->slice_to = q->slice_from;
+  if (*p < end && **p == ',') {
+    (*p)++;
+    if (!parse_signed(p, end, &q->slice_to))
+      return false;
+  }
+  if (*p == end || **p != ']')
+    return false;
+  (*p)++;
+  q->has_slice = true;
+  return true;
+}
+
+glob_qual_t *glob_qual_parse(const char *spec, size_t len) {
+  glob_qual_t *q = xcalloc(1, sizeof(glob_qual_t));
+  const char *p = spec;
+  const char *end = spec + len;
+  bool negate = false;
+
+  while (p < end) {
+    char c = *p++;
+    qual_test_t t = {.negate = negate};
+    switch (c) {
+    case '^':
+      negate = !negate;
+      continue;
+    case '-':
+      q->follow = true;
+      continue;
+    case 'N':
+      q->null_glob = true;
+      continue;
+    case '.':
+    case '/':
+    case '@':
+    case '=':
+    case 'p':
+      t.kind = QUAL_TYPE;
+      t.types[0] = c == '.'   ? S_IFREG
+                   : c == '/' ? S_IFDIR
+                   : c == '@' ? S_IFLNK
+                   : c == '=' ? S_IFSOCK
+                              : S_IFIFO;
+      q->mask |= STATX_TYPE;
+      break;
+    case '%':
+      t.kind = QUAL_TYPE;
+      t.types[0] = p < end && *p == 'c' ? S_IFCHR : S_IFBLK;
+      if (p < end && (*p == 'b' || *p == 'c'))
+        p++;
+      else
+        t.types[1] = S_IFCHR;
+      q->mask |= STATX_TYPE;
+      break;
+    case '*':
+      t.kind = QUAL_EXEC;
+      q->mask |= STATX_TYPE | STATX_MODE;
+      break;
+    case 'L':
+      t.kind = QUAL_SIZE;
+      t.unit = p < end ? size_unit(*p) : 0;
+      if (t.unit)
+        p++;
+      else
+        t.unit = 1;
+      if (!parse_amount(&p, end, &t))
+        goto bad_number;
+      q->mask |= STATX_SIZE;
+      break;
+    case 'm':
+    case 'a':
+    case 'c':
+      t.kind = QUAL_TIME;
+      t.field = c;
+      t.unit = p < end ? time_unit(*p) : 0;
+      if (t.unit)
+        p++;
+      else
+        t.unit = 86400;
+      if (!parse_amount(&p, end, &t))
+        goto bad_number;
+      q->mask |= time_mask(c);
+      break;
+    case 'o':
+    case 'O': {
+      char key = p < end ? *p++ : '\0';
+      if (!key || !strchr("nLmacN", key)) {
+        nsh_msg("glob qualifier: unknown sort key after '%c'\n", c);
+        goto error;
+      }
+      arrpush(q->sorts, ((qual_sort_t){.key = key, .reverse = c == 'O'}));
+      if (key == 'L')
+        q->mask |= STATX_SIZE;
+      else if (strchr("mac", key))
+        q->mask |= time_mask(key);
+      continue;
+    }
+    case '[':
+      if (!parse_slice(&p, end, q)) {
+        nsh_msg("%s", "glob qualifier: invalid subscript\n");
+        goto error;
+      }
+      continue;
+    default:
+      nsh_msg("glob qualifier: unknown qualifier '%c'\n", c);
+      goto error;
+    }
+    arrpush(q->tests, t);
+  }
+  return q;
+
+bad_number:
+  nsh_msg("glob qualifier: number expected in '%.*s'\n", (int)len, spec);
+error:
+  glob_qual_free(q);
+  return NULL;
+}
+
+void glob_qual_free(glob_qual_t *q) {
+  if (!q)
+    return;
+  arrfree(q->tests);
+  arrfree(q->sorts);
+  free(q);
+}
+
+bool glob_qual_null_glob(const glob_qual_t *q) { return q->null_glob; }
+
+/* --- METADATA --- */
+
+typedef struct {
+  char *path;
+  size_t pos;  /**< Index in the walk order, keeps the sort stable */
+  mode_t type; /**< S_IF* type, 0 while unknown */
+  bool need_stat;
+  bool gone; /**< The file could not be stat'ed */
+  struct statx stx;
+} qual_meta_t;
+
+typedef struct {
+  qual_meta_t **metas;
+  size_t n;
+  unsigned mask;
+  bool follow;
+} stat_batch_t;
+
+static void stat_one(qual_meta_t *m, unsigned mask, bool follow) {
+  int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+  int rc = statx(AT_FDCWD, m->path, flags, mask, &m->stx);
+  // a dangling symlink is qualified by itself
+  if (rc == -1 && follow)
+    rc = statx(AT_FDCWD, m->path, flags | AT_SYMLINK_NOFOLLOW, mask, &m->stx);
+  if (rc == -1) {
+    m->gone = true;
+    return;
+  }
+  m->type = m->stx.stx_mode & S_IFMT;
+}
+
+static void stat_batch_task(void *arg) {
+  stat_batch_t *b = arg;
+  for (size_t i = 0; i < b->n; i++)
+    stat_one(b->metas[i], b->mask, b->follow);
+}
+
+/**
+ * @brief Fills the metadata the qualifiers need. Types come from the
+ * listings of the glob when they are enough, the rest from statx(), over a
+ * thread pool once there are more than a batch of paths.
+ */
+static void load_metadata(const glob_qual_t *q, qual_meta_t *metas,
+                          size_t n) {
+  if (q->mask == 0)
+    return;
+
+  qual_meta_t **todo = NULL;
+  for (size_t i = 0; i < n; i++) {
+    qual_meta_t *m = &metas[i];
+    uint8_t dt = glob_cached_type(m->path);
+    // a followed symlink has the type of its target
+    if (dt != DT_UNKNOWN && !(q->follow && dt == DT_LNK))
+      m->type = DTTOIF(dt);
+    m->need_stat = (q->mask & ~(unsigned)STATX_TYPE) != 0 || m->type == 0;
+    if (m->need_stat)
+      arrpush(todo, m);
+  }
+
+  size_t ntodo = (size_t)arrlen(todo);
+  if (ntodo <= QUAL_STAT_BATCH) {
+    stat_batch_t b = {todo, ntodo, q->mask, q->follow};
+    stat_batch_task(&b);
+    arrfree(todo);
+    return;
+  }
+
+  size_t nbatches = (ntodo + QUAL_STAT_BATCH - 1) / QUAL_STAT_BATCH;
+  stat_batch_t *batches = xmalloc(nbatches * sizeof(stat_batch_t));
+  thread_pool_t *pool =
+      thread_pool_new(thread_pool_default_size(QUAL_MAX_THREADS));
+  for (size_t i = 0; i < nbatches; i++) {
+    size_t start = i * QUAL_STAT_BATCH;
+    size_t count = ntodo - start < QUAL_STAT_BATCH ? ntodo - start
+                                                   : QUAL_STAT_BATCH;
+    batches[i] = (stat_batch_t){todo + start, count, q->mask, q->follow};
+    thread_pool_submit(pool, stat_batch_task, &batches[i]);
+  }
+  thread_pool_free(pool);
+  pr_debug("glob qualifier: %zu statx calls in %zu batches", ntodo,
+           nbatches);
+  free(batches);
+  arrfree(todo);
+}
+
+/* --- FILTERING --- */
+
+static int64_t stx_time(const qual_meta_t *m, char field) {
+  return field == 'm'   ? m->stx.stx_mtime.tv_sec
+         : field == 'a' ? m->stx.stx_atime.tv_sec
+                        : m->stx.stx_ctime.tv_sec;
+}
+
+static bool compare_amount(const qual_test_t *t, uint64_t value) {
+  return t->op == '+' ? value > t->n : t->op == '-' ? value < t->n
+                                                    : value == t->n;
+}
+
+static bool test_passes(const qual_test_t *t, const qual_meta_t *m,
+                        time_t now) {
+  bool ok;
+  switch (t->kind) {
+  case QUAL_TYPE:
+    ok = m->type == t->types[0] || (t->types[1] && m->type == t->types[1]);
+    break;
+  case QUAL_EXEC:
+    ok = m->type == S_IFREG &&
+         (m->stx.stx_mode & (S_IXUSR | S_IXGRP | S_IXOTH));
+    break;
+  case QUAL_SIZE:
+    // sizes are rounded up to the unit
+    ok = compare_amount(t, (m->stx.stx_size + t->unit - 1) / t->unit);
+    break;
+  case QUAL_TIME: {
+    int64_t age = (int64_t)now - stx_time(m, t->field);
+    ok = compare_amount(t, age > 0 ? (uint64_t)age / t->unit : 0);
+    break;
+  }
+  default:
+    ok = false;
+  }
+  return ok != t->negate;
+}
+
+/* --- SORTING --- */
+
+static int cmp_meta(const void *a, const void *b, void *arg) {
+  const qual_meta_t *ma = a;
+  const qual_meta_t *mb = b;
+  const glob_qual_t *q = arg;
+
+  for (int i = 0; i < arrlen(q->sorts); i++) {
+    int c = 0;
+    switch (q->sorts[i].key) {
+    case 'n':
+      c = strcmp(ma->path, mb->path);
+      break;
+    case 'L':
+      c = (ma->stx.stx_size > mb->stx.stx_size) -
+          (ma->stx.stx_size < mb->stx.stx_size);
+      break;
+    case 'm':
+    case 'a':
+    case 'c': {
+      // youngest first
+      const struct statx_timestamp *ta =
+          q->sorts[i].key == 'm'   ? &ma->stx.stx_mtime
+          : q->sorts[i].key == 'a' ? &ma->stx.stx_atime
+                                   : &ma->stx.stx_ctime;
+      const struct statx_timestamp *tb =
+          q->sorts[i].key == 'm'   ? &mb->stx.stx_mtime
+          : q->sorts[i].key == 'a' ? &mb->stx.stx_atime
+                                   : &mb->stx.stx_ctime;
+      c = (tb->tv_sec > ta->tv_sec) - (tb->tv_sec < ta->tv_sec);
+      if (c == 0)
+        c = (tb->tv_nsec > ta->tv_nsec) - (tb->tv_nsec < ta->tv_nsec);
+      break;
+    }
+    default:
+      break;
+    }
+    if (c != 0)
+      return q->sorts[i].reverse ? -c : c;
+  }
+  return (ma->pos > mb->pos) - (ma->pos < mb->pos);
+}
+
+// resolves a 1-based subscript, negative ones count from the end
+static long long slice_index(long long i, size_t n) {
+  return i < 0 ? (long long)n + i : i - 1;
+}
+
+/* --- APPLY --- */
+
+size_t glob_qual_apply(const glob_qual_t *q, char ***matches, size_t first) {
+  size_t n = (size_t)arrlen(*matches) - first;
+  if (n == 0)
+    return 0;
+
+  qual_meta_t *metas = xcalloc(n, sizeof(qual_meta_t));
+  for (size_t i = 0; i < n; i++)
+    metas[i] = (qual_meta_t){.path = (*matches)[first + i], .pos = i};
+  load_metadata(q, metas, n);
+
+  time_t now = time(NULL);
+  size_t kept = 0;
+  for (size_t i = 0; i < n; i++) {
+    bool keep = !metas[i].gone;
+    for (int t = 0; t < arrlen(q->tests) && keep; t++)
+      keep = test_passes(&q->tests[t], &metas[i], now);
+    if (keep)
+      metas[kept++] = metas[i];
+    else
+      free(metas[i].path);
+  }
+
+  if (arrlen(q->sorts) > 0 && q->sorts[0].key != 'N')
+    qsort_r(metas, kept, sizeof(qual_meta_t), cmp_meta, (void *)q);
+
+  size_t from = 0, to = kept;
+  if (q->has_slice) {
+    long long lo = slice_index(q->slice_from, kept);
+    long long hi = slice_index(q->slice_to, kept) + 1;
+    from = lo < 0 ? 0 : (size_t)lo;
+    to = hi < 0 ? 0 : (size_t)hi > kept ? kept : (size_t)hi;
+    if (from > to)
+      from = to;
+  }
+
+  for (size_t i = 0; i < kept; i++) {
+    if (i < from || i >= to)
+      free(metas[i].path);
+  }
+  for (size_t i = from; i < to; i++)
+    (*matches)[first + i - from] = metas[i].path;
+  arrsetlen(*matches, first + (to - from));
+  free(metas);
+  return to - from;
+}
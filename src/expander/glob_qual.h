@@ -0,0 +1,62 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __GLOB_QUAL_H__
+#define __GLOB_QUAL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Glob qualifiers, the zsh-style list between parentheses ending a pattern
+ * such as *(.) or *(om[1,10]). They filter the matches on their type, size
+ * or timestamps, then sort and slice them, without leaving the shell:
+ *
+ *   .  /  @  =  p  %  *   regular file, directory, symlink, socket, fifo,
+ *                         device, executable regular file
+ *   L[kmgtp][+-]n         size in bytes (or KiB, MiB, GiB, TiB, 512-byte
+ *                         blocks), rounded up to the unit
+ *   m a c[Mwdhms][+-]n    modified, accessed or changed n days (or months,
+ *                         weeks, days, hours, minutes, seconds) ago
+ *   o O[nLmacN]           sort by name, size or time (youngest first),
+ *                         reversed by O, N keeps the order of the walk
+ *   [i] [i,j]             keeps the i-th to j-th matches, from the end when
+ *                         negative
+ *   ^  -                  negates the next qualifiers, follows symlinks
+ *   N                     an empty result is not an error
+ *
+ * Qualifiers apply one after the other, a file is kept if it passes all of
+ * them. Types are taken from the directory listings the glob already read,
+ * the other metadata from statx() calls issued in batches over a thread
+ * pool, asking only for the fields the qualifiers use.
+ */
+
+typedef struct glob_qual_t glob_qual_t;
+
+/**
+ * @brief Compiles a qualifier list. Errors are reported on stderr.
+ * @param spec the text between the parentheses
+ * @return the qualifiers or NULL if the list is invalid
+ */
+glob_qual_t *glob_qual_parse(const char *spec, size_t len);
+
+void glob_qual_free(glob_qual_t *q);
+
+/**
+ * @brief Tells whether an empty result is accepted (the N qualifier).
+ */
+bool glob_qual_null_glob(const glob_qual_t *q);
+
+/**
+ * @brief Filters, sorts and slices the matches appended to an array since
+ * first. Dropped matches are freed.
+ * @param matches stb_ds array of heap strings
+ * @return number of matches left after first
+ */
+size_t glob_qual_apply(const glob_qual_t *q, char ***matches, size_t first);
+
+#endif // __GLOB_QUAL_H__
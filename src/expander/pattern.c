@@ -0,0 +1,484 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "expander/pattern.h"
+#include "shell/config.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <ctype.h>
+#include <string.h>
+
+// state sets up to this many words live on the stack
+#define PATTERN_STACK_WORDS 8
+
+typedef enum { ATOM_CHAR, ATOM_ANY, ATOM_STAR, ATOM_CLASS } atom_type_e;
+
+typedef struct {
+  atom_type_e type;
+  uint64_t set[4]; /**< Bytes accepted by the atom (not used by '*') */
+} atom_t;
+
+static inline void set_add(uint64_t set[4], unsigned c) {
+  set[c >> 6] |= 1ULL << (c & 63);
+}
+
+static inline bool set_has(const uint64_t set[4], unsigned c) {
+  return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+/* --- COMPILATION --- */
+
+static const struct {
+  const char *name;
+  int (*fn)(int);
+} named_classes[] = {
+    {"alnum", isalnum}, {"alpha", isalpha}, {"blank", isblank},
+    {"cntrl", iscntrl}, {"digit", isdigit}, {"graph", isgraph},
+    {"lower", islower}, {"print", isprint}, {"punct", ispunct},
+    {"space", isspace}, {"upper", isupper}, {"xdigit", isxdigit},
+};
+
+// adds a [:name:] class, false if the name is unknown
+static bool add_named_class(uint64_t set[4], const char *name, size_t len) {
+  for (size_t i = 0; i < sizeof(named_classes) / sizeof(named_classes[0]);
+       i++) {
+    if (strlen(named_classes[i].name) != len ||
+        strncmp(named_classes[i].name, name, len) != 0)
+      continue;
+    for (unsigned c = 1; c < 256; c++) {
+      if (named_classes[i].fn((int)c))
+        set_add(set, c);
+    }
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Parses a bracket expression into a set of bytes.
+ * @param p pattern right after the '['
+ * @return pointer after the closing ']' or NULL if the bracket is not closed
+ */
+static const char *parse_bracket(const char *p, uint64_t set[4]) {
+  bool negate = false;
+  if (*p == '!' || *p == '^') {
+    negate = true;
+    p++;
+  }
+
+  bool first = true;
+  // a ']' right after the opening bracket is a literal
+  while (*p && (first || *p != ']')) {
+    first = false;
+    if (p[0] == '[' && p[1] == ':') {
+      const char *end = strstr(p + 2, ":]");
+      if (end && add_named_class(set, p + 2, (size_t)(end - p - 2))) {
+        p = end + 2;
+        continue;
+      }
+    }
+
+    unsigned lo = (unsigned char)*p;
+    if (lo == '\\' && p[1])
+      lo = (unsigned char)*++p;
+    p++;
+
+    unsigned hi = lo;
+    if (*p == '-' && p[1] && p[1] != ']') {
+      p++;
+      hi = (unsigned char)*p;
+      if (hi == '\\' && p[1])
+        hi = (unsigned char)*++p;
+      p++;
+    }
+    for (unsigned c = lo; c <= hi; c++)
+      set_add(set, c);
+  }
+
+  if (*p != ']')
+    return NULL;
+  if (negate) {
+    for (int i = 0; i < 4; i++)
+      set[i] = ~set[i];
+  }
+  return p + 1;
+}
+
+static atom_t *parse_atoms(const char *p) {
+  atom_t *atoms = NULL;
+  while (*p) {
+    atom_t atom = {.type = ATOM_CHAR};
+    if (*p == '*') {
+      p++;
+      // consecutive stars are a single one, the NFA relies on it
+      if (arrlen(atoms) == 0 || arrlast(atoms).type != ATOM_STAR) {
+        atom.type = ATOM_STAR;
+        arrpush(atoms, atom);
+      }
+      continue;
+    }
+
+    if (*p == '?') {
+      atom.type = ATOM_ANY;
+      memset(atom.set, 0xff, sizeof(atom.set));
+      p++;
+    } else if (*p == '[') {
+      const char *end = parse_bracket(p + 1, atom.set);
+      if (end) {
+        atom.type = ATOM_CLASS;
+        p = end;
+      } else {
+        // unclosed bracket, '[' is a literal
+        set_add(atom.set, '[');
+        p++;
+      }
+    } else {
+      if (*p == '\\' && p[1])
+        p++;
+      set_add(atom.set, (unsigned char)*p);
+      p++;
+    }
+    arrpush(atoms, atom);
+  }
+  return atoms;
+}
+
+static char atom_char(const atom_t *atom) {
+  for (unsigned c = 0; c < 256; c++) {
+    if (set_has(atom->set, c))
+      return (char)c;
+  }
+  return '\0';
+}
+
+// recognizes "lit", "lit*", "*lit", "*lit*" and "*"
+static void detect_kind(pattern_t *pat, atom_t *atoms) {
+  size_t n = (size_t)arrlen(atoms);
+  size_t first = 0;
+  size_t last = n;
+  bool lead_star = n > 0 && atoms[0].type == ATOM_STAR;
+  bool trail_star = n > 0 && atoms[n - 1].type == ATOM_STAR;
+  if (lead_star)
+    first++;
+  if (trail_star && n > 1)
+    last--;
+
+  pat->kind = PATTERN_NFA;
+  for (size_t i = first; i < last; i++) {
+    if (atoms[i].type != ATOM_CHAR)
+      return;
+  }
+
+  pat->lit_len = last - first;
+  pat->lit = xmalloc(pat->lit_len + 1);
+  for (size_t i = first; i < last; i++)
+    pat->lit[i - first] = atom_char(&atoms[i]);
+  pat->lit[pat->lit_len] = '\0';
+
+  if (n == 1 && lead_star)
+    pat->kind = PATTERN_ANY;
+  else if (lead_star && trail_star)
+    pat->kind = PATTERN_CONTAINS;
+  else if (lead_star)
+    pat->kind = PATTERN_SUFFIX;
+  else if (trail_star)
+    pat->kind = PATTERN_PREFIX;
+  else
+    pat->kind = PATTERN_EXACT;
+}
+
+static void nfa_build(pattern_nfa_t *nfa, const atom_t *atoms, size_t n,
+                      bool reversed) {
+  nfa->nwords = (n + 1 + 63) / 64;
+  nfa->masks = xcalloc(256 * nfa->nwords, sizeof(uint64_t));
+  nfa->stars = xcalloc(nfa->nwords, sizeof(uint64_t));
+
+  for (size_t k = 0; k < n; k++) {
+    const atom_t *atom = &atoms[reversed ? n - 1 - k : k];
+    size_t w = k / 64;
+    uint64_t bit = 1ULL << (k % 64);
+    if (atom->type == ATOM_STAR) {
+      nfa->stars[w] |= bit;
+      continue;
+    }
+    for (unsigned c = 0; c < 256; c++) {
+      if (set_has(atom->set, c))
+        nfa->masks[c * nfa->nwords + w] |= bit;
+    }
+  }
+}
+
+pattern_t *pattern_compile(const char *src) {
+  pattern_t *pat = xcalloc(1, sizeof(pattern_t));
+  atom_t *atoms = parse_atoms(src);
+  pat->natoms = (size_t)arrlen(atoms);
+  pat->leading_dot = pat->natoms > 0 && atoms[0].type == ATOM_CHAR &&
+                     atom_char(&atoms[0]) == '.';
+
+  detect_kind(pat, atoms);
+  nfa_build(&pat->fwd, atoms, pat->natoms, false);
+  nfa_build(&pat->rev, atoms, pat->natoms, true);
+  arrfree(atoms);
+  return pat;
+}
+
+void pattern_free(pattern_t *pat) {
+  if (!pat)
+    return;
+  free(pat->lit);
+  free(pat->fwd.masks);
+  free(pat->fwd.stars);
+  free(pat->rev.masks);
+  free(pat->rev.stars);
+  free(pat);
+}
+
+/* --- CACHE --- */
+
+typedef struct {
+  pattern_t *pat;
+  uint64_t last_use;
+} pattern_cache_value_t;
+
+typedef struct {
+  char *key;
+  pattern_cache_value_t value;
+} pattern_cache_entry_t;
+
+static pattern_cache_entry_t *pattern_cache = NULL;
+static uint64_t pattern_clock = 0;
+
+static void evict_lru(void) {
+  int victim = 0;
+  for (int i = 1; i < shlen(pattern_cache); i++) {
+    if (pattern_cache[i].value.last_use <
+        pattern_cache[victim].value.last_use)
+      victim = i;
+  }
+  // the key is released by shdel(), look it up through a copy
+  char *key = xstrdup(pattern_cache[victim].key);
+  pattern_free(pattern_cache[victim].value.pat);
+  (void)shdel(pattern_cache, key);
+  free(key);
+}
+
+const pattern_t *pattern_get(const char *src) {
+  if (!pattern_cache)
+    sh_new_strdup(pattern_cache);
+
+  ptrdiff_t idx = shgeti(pattern_cache, src);
+  if (idx >= 0) {
+    pattern_cache[idx].value.last_use = ++pattern_clock;
+    return pattern_cache[idx].value.pat;
+  }
+
+  if (shlen(pattern_cache) >= PATTERN_CACHE_SIZE)
+    evict_lru();
+
+  pattern_cache_value_t value = {.pat = pattern_compile(src),
+                                 .last_use = ++pattern_clock};
+  shput(pattern_cache, src, value);
+  return value.pat;
+}
+
+void pattern_cache_free(void) {
+  for (int i = 0; i < shlen(pattern_cache); i++)
+    pattern_free(pattern_cache[i].value.pat);
+  shfree(pattern_cache);
+  pattern_cache = NULL;
+}
+
+/* --- NFA SIMULATION --- */
+
+// a '*' also matches the empty string: the state after it is reached too
+static void nfa_closure(const pattern_nfa_t *nfa, uint64_t *st) {
+  uint64_t carry = 0;
+  for (size_t w = 0; w < nfa->nwords; w++) {
+    uint64_t at_star = st[w] & nfa->stars[w];
+    st[w] |= (at_star << 1) | carry;
+    carry = at_star >> 63;
+  }
+}
+
+static void nfa_start(const pattern_nfa_t *nfa, uint64_t *st) {
+  memset(st, 0, nfa->nwords * sizeof(uint64_t));
+  st[0] = 1;
+  nfa_closure(nfa, st);
+}
+
+// shift-and transition on one byte, false once no state is alive
+static bool nfa_step(const pattern_nfa_t *nfa, const uint64_t *cur,
+                     uint64_t *next, unsigned char c) {
+  const uint64_t *mask = nfa->masks + (size_t)c * nfa->nwords;
+  uint64_t carry = 0;
+  uint64_t alive = 0;
+  for (size_t w = 0; w < nfa->nwords; w++) {
+    uint64_t moved = cur[w] & mask[w];
+    next[w] = (moved << 1) | carry | (cur[w] & nfa->stars[w]);
+    carry = moved >> 63;
+    alive |= next[w];
+  }
+  nfa_closure(nfa, next);
+  return alive != 0;
+}
+
+static inline bool nfa_accepts(const pattern_t *pat, const uint64_t *st) {
+  return (st[pat->natoms / 64] >> (pat->natoms % 64)) & 1;
+}
+
+/**
+ * @brief Runs the automaton over s (backwards for the reversed one) and
+ * reports the shortest or longest accepted prefix.
+ */
+static bool nfa_prefix(const pattern_t *pat, const pattern_nfa_t *nfa,
+                       const char *s, size_t len, bool reversed, bool longest,
+                       size_t *match_len) {
+  uint64_t stack_buf[2 * PATTERN_STACK_WORDS];
+  uint64_t *buf = nfa->nwords <= PATTERN_STACK_WORDS
+                      ? stack_buf
+                      : xmalloc(2 * nfa->nwords * sizeof(uint64_t));
+  uint64_t *cur = buf;
+  uint64_t *next = buf + nfa->nwords;
+
+  bool found = false;
+  nfa_start(nfa, cur);
+  for (size_t i = 0;; i++) {
+    if (nfa_accepts(pat, cur)) {
+      found = true;
+      *match_len = i;
+      if (!longest)
+        break;
+    }
+    if (i == len)
+      break;
+
+    unsigned char c = (unsigned char)(reversed ? s[len - 1 - i] : s[i]);
+    if (!nfa_step(nfa, cur, next, c))
+      break;
+    uint64_t *tmp = cur;
+    cur = next;
+    next = tmp;
+  }
+
+  if (buf != stack_buf)
+    free(buf);
+  return found;
+}
+
+/* --- MATCHING --- */
+
+bool pattern_match(const pattern_t *pat, const char *s, size_t len) {
+  switch (pat->kind) {
+  case PATTERN_ANY:
+    return true;
+  case PATTERN_EXACT:
+    return len == pat->lit_len && memcmp(s, pat->lit, len) == 0;
+  case PATTERN_PREFIX:
+    return len >= pat->lit_len && memcmp(s, pat->lit, pat->lit_len) == 0;
+  case PATTERN_SUFFIX:
+    return len >= pat->lit_len &&
+           memcmp(s + len - pat->lit_len, pat->lit, pat->lit_len) == 0;
+  case PATTERN_CONTAINS:
+    return memmem(s, len, pat->lit, pat->lit_len) != NULL;
+  case PATTERN_NFA:
+    break;
+  }
+
+  // only the longest prefix can be the whole string
+  size_t match_len;
+  return nfa_prefix(pat, &pat->fwd, s, len, false, true, &match_len) &&
+         match_len == len;
+}
+
+bool pattern_match_prefix(const pattern_t *pat, const char *s, size_t len,
+                          bool longest, size_t *match_len) {
+  return nfa_prefix(pat, &pat->fwd, s, len, false, longest, match_len);
+}
+
+bool pattern_match_suffix(const pattern_t *pat, const char *s, size_t len,
+                          bool longest, size_t *match_len) {
+  return nfa_prefix(pat, &pat->rev, s, len, true, longest, match_len);
+}
+
+#define NO_START SIZE_MAX
+
+bool pattern_search(const pattern_t *pat, const char *s, size_t len,
+                    size_t *start, size_t *end) {
+  if (pat->kind == PATTERN_EXACT) {
+    const char *hit = memmem(s, len, pat->lit, pat->lit_len);
+    if (!hit)
+      return false;
+    *start = (size_t)(hit - s);
+    *end = *start + pat->lit_len;
+    return true;
+  }
+
+  // starts[i] is the leftmost start of the threads in state i
+  const pattern_nfa_t *nfa = &pat->fwd;
+  size_t n = pat->natoms;
+  size_t *cur = xmalloc(2 * (n + 1) * sizeof(size_t));
+  size_t *next = cur + n + 1;
+  size_t *buf = cur;
+  for (size_t i = 0; i <= n; i++)
+    cur[i] = NO_START;
+
+  size_t best_start = NO_START;
+  size_t best_end = 0;
+  for (size_t pos = 0;; pos++) {
+    // a new thread starts at each position until a match is found, later
+    // starts cannot be leftmost
+    if (best_start == NO_START && cur[0] == NO_START)
+      cur[0] = pos;
+    for (size_t i = 0; i < n; i++) {
+      if ((nfa->stars[i / 64] >> (i % 64)) & 1 && cur[i] < cur[i + 1])
+        cur[i + 1] = cur[i];
+    }
+
+    if (cur[n] != NO_START &&
+        (best_start == NO_START || cur[n] < best_start ||
+         (cur[n] == best_start && pos > best_end))) {
+      best_start = cur[n];
+      best_end = pos;
+    }
+    if (pos == len)
+      break;
+
+    const uint64_t *mask = nfa->masks + (size_t)(unsigned char)s[pos] *
+                                            nfa->nwords;
+    bool alive = false;
+    for (size_t i = 0; i <= n; i++)
+      next[i] = NO_START;
+    for (size_t i = 0; i < n; i++) {
+      if (cur[i] == NO_START ||
+          (best_start != NO_START && cur[i] > best_start))
+        continue;
+      size_t to = (nfa->stars[i / 64] >> (i % 64)) & 1 ? i
+                  : (mask[i / 64] >> (i % 64)) & 1    ? i + 1
+                                                      : NO_START;
+      if (to == NO_START)
+        continue;
+      if (cur[i] < next[to])
+        next[to] = cur[i];
+      alive = true;
+    }
+
+    size_t *tmp = cur;
+    cur = next;
+    next = tmp;
+    if (!alive && best_start != NO_START)
+      break;
+  }
+
+  free(buf);
+  if (best_start == NO_START)
+    return false;
+  *start = best_start;
+  *end = best_end;
+  return true;
+}
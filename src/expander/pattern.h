@@ -0,0 +1,110 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __PATTERN_H__
+#define __PATTERN_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compiled glob patterns, shared by filename expansion, 'case' and the
+ * ${var#pat} family of parameter expansions.
+ *
+ * Patterns made of a literal with at most a leading and a trailing '*' are
+ * matched with plain string comparisons. Anything else runs a bit-parallel
+ * NFA (one bit per pattern position, shift-and transitions): matching is
+ * linear in the length of the subject whatever the pattern, there is no
+ * backtracking.
+ */
+
+typedef enum {
+  PATTERN_EXACT,    /**< "lit" */
+  PATTERN_PREFIX,   /**< "lit*" */
+  PATTERN_SUFFIX,   /**< "*lit" */
+  PATTERN_CONTAINS, /**< "*lit*" */
+  PATTERN_ANY,      /**< "*" */
+  PATTERN_NFA,
+} pattern_kind_e;
+
+/**
+ * @brief Position automaton of a pattern. Bit i of a state set means the
+ * first i atoms were matched, bit natoms is the accepting state.
+ */
+typedef struct {
+  size_t nwords;   /**< 64-bit words per state set */
+  uint64_t *masks; /**< nwords per byte value: atoms accepting that byte */
+  uint64_t *stars; /**< atoms that are a '*' (self loop) */
+} pattern_nfa_t;
+
+typedef struct {
+  pattern_kind_e kind;
+  char *lit; /**< Literal of the fast kinds, unescaped */
+  size_t lit_len;
+  size_t natoms;
+  bool leading_dot;  /**< The pattern starts with a literal '.' */
+  pattern_nfa_t fwd; /**< Automaton of the pattern */
+  pattern_nfa_t rev; /**< Automaton of the reversed pattern (suffixes) */
+} pattern_t;
+
+/**
+ * @brief Compiles a pattern.
+ * Supports '*', '?', bracket expressions ('!' or '^' negation, ranges,
+ * [:class:]) and backslash escapes. An unclosed '[' is a literal.
+ * @return heap-allocated pattern, to be released with pattern_free()
+ */
+pattern_t *pattern_compile(const char *src);
+
+void pattern_free(pattern_t *pat);
+
+/**
+ * @brief Returns the compiled form of a pattern through a small LRU cache
+ * keyed by the pattern string.
+ * @note The pattern is owned by the cache and stays valid until the next call.
+ * Not thread-safe, the cache is only used from the main thread.
+ */
+const pattern_t *pattern_get(const char *src);
+
+/**
+ * @brief Drops every cached pattern.
+ */
+void pattern_cache_free(void);
+
+/**
+ * @brief Tells whether the whole subject matches the pattern.
+ */
+bool pattern_match(const pattern_t *pat, const char *s, size_t len);
+
+/**
+ * @brief Finds the shortest or longest prefix of s matching the pattern.
+ * @param match_len set to the length of the matching prefix
+ * @return false if no prefix matches
+ */
+bool pattern_match_prefix(const pattern_t *pat, const char *s, size_t len,
+                          bool longest, size_t *match_len);
+
+/**
+ * @brief Finds the shortest or longest suffix of s matching the pattern.
+ * @param match_len set to the length of the matching suffix
+ * @return false if no suffix matches
+ */
+bool pattern_match_suffix(const pattern_t *pat, const char *s, size_t len,
+                          bool longest, size_t *match_len);
+
+/**
+ * @brief Finds the leftmost-longest match of the pattern in s.
+ * Every start position is tracked at once (one thread per NFA state keeping
+ * its leftmost start), s is read a single time.
+ * @param start set to the offset of the match
+ * @param end set to the offset right after the match
+ * @return false if the pattern matches nowhere
+ */
+bool pattern_search(const pattern_t *pat, const char *s, size_t len,
+                    size_t *start, size_t *end);
+
+#endif // __PATTERN_H__
@@ -5,8 +5,73 @@
  * This file is licensed under the GNU General Public License v3 or later.
  * See <https://www.gnu.org/licenses/> for details.
  */
+#define _DEFAULT_SOURCE
+
 #include "pipeline.h"
 
+/**
+ * @brief What the expansion of a word depends on, collected by the passes
+ * to decide whether the result can be memoized.
+ */
+typedef struct {
+  var_dep_t *deps;
+  bool cacheable;
+  bool has_dir; /**< The word was globbed in dir */
+  char *dir;
+  struct stat dir_st;
+} expand_deps_t;
+
+static void add_var_dep(expand_deps_t *d, const char *name) {
+  for (int i = 0; i < arrlen(d->deps); i++) {
+    if (strcmp(d->deps[i].name, name) == 0)
+      return;
+  }
+  var_dep_t dep = {.name = xstrdup(name), .gen = shell_state_getenv_gen(name)};
+  arrpush(d->deps, dep);
+}
+
+static void free_deps(expand_deps_t *d) {
+  for (int i = 0; i < arrlen(d->deps); i++)
+    free(d->deps[i].name);
+  arrfree(d->deps);
+  free(d->dir);
+}
+
+/**
+ * @brief Records the directory a glob pattern is matched in.
+ * Only patterns whose magic characters are all in the last component are
+ * memoized: their result only depends on the content of a single directory.
+ * A '**' walks a whole tree and is never memoized.
+ */
+static void add_glob_dep(expand_deps_t *d, const char *pattern) {
+  // fields of a split word may be globbed in several directories
+  if (d->has_dir) {
+    d->cacheable = false;
+    return;
+  }
+
+  const char *slash = strrchr(pattern, '/');
+  size_t dir_len = slash ? (size_t)(slash - pattern) : 0;
+  if (strcspn(pattern, "*?[\\") < dir_len || strstr(pattern, "**")) {
+    d->cacheable = false;
+    return;
+  }
+
+  char *dir = slash ? (dir_len ? xstrdup_n(pattern, dir_len) : xstrdup("/"))
+                    : xstrdup(".");
+  struct stat st;
+  // a directory modified during the current second may be modified again
+  // without its mtime changing, its listing cannot be trusted yet
+  if (stat(dir, &st) == -1 || st.st_mtim.tv_sec >= time(NULL)) {
+    free(dir);
+    d->cacheable = false;
+    return;
+  }
+  d->has_dir = true;
+  d->dir = dir;
+  d->dir_st = st;
+}
+
 static char *expand_special_one(char sigil) {
   shell_state_t *sh = shell_state_get();
   char buf[32];
@@ -56,14 +121,90 @@ static char *expand_params_in_string(word_part_t in_part) {
   return in_part.value;
 }
 
-static void pass_expand_params(word_part_t *in_parts) {
+// $$ never changes, other special parameters change without any assignment
+// and are never memoized
+static void add_param_dep(expand_deps_t *d, const char *name) {
+  if (isalpha((unsigned char)*name) || *name == '_')
+    add_var_dep(d, name);
+  else if (strcmp(name, "$") != 0)
+    d->cacheable = false;
+}
+
+static char *expand_param_op(const char *body, expand_deps_t *d);
+static char *expand_operand(const char *src, size_t len, bool pattern,
+                            expand_deps_t *d);
+
+/**
+ * @brief Evaluates an arithmetic expression. Parameters and substitutions it
+ * holds are expanded first, an expression without any is compiled from its
+ * text as is so that its compiled form is found in the cache.
+ */
+static bool eval_arith(const char *expr, expand_deps_t *d, long long *value) {
+  // arithmetic may assign variables, its result is never memoized
+  d->cacheable = false;
+  if (!strpbrk(expr, "$`\"'\\"))
+    return arith_eval_str(expr, value);
+
+  char *text = expand_operand(expr, strlen(expr), false, d);
+  if (!text)
+    return false;
+  bool ok = arith_eval_str(text, value);
+  free(text);
+  return ok;
+}
+
+// command and process substitutions run in the same pass so that they see
+// the parameters on their left expanded, and the other way around
+static int pass_expand_params(word_part_t *in_parts, expand_deps_t *d) {
   for (int i = 0; i < arrlen(in_parts); i++) {
     word_part_t *wp = &in_parts[i];
+    if (wp->type == WORD_CMDSUB) {
+      bool invalid = false;
+      char *value = cmdsub_run(wp->value, &invalid);
+      if (invalid)
+        return -1;
+      d->cacheable = false;
+      wp->value = value;
+      wp->type = WORD_LITERAL;
+      continue;
+    }
+    if (wp->type == WORD_PROCSUB_IN || wp->type == WORD_PROCSUB_OUT) {
+      bool invalid = false;
+      char *path =
+          procsub_start(wp->value, wp->type == WORD_PROCSUB_OUT, &invalid);
+      if (invalid)
+        return -1;
+      d->cacheable = false;
+      wp->value = path;
+      wp->type = WORD_LITERAL;
+      continue;
+    }
+    if (wp->type == WORD_ARITH) {
+      long long value;
+      if (!eval_arith(wp->value, d, &value))
+        return -1;
+      char buf[24];
+      snprintf(buf, sizeof(buf), "%lld", value);
+      wp->value = xstrdup(buf);
+      wp->type = WORD_LITERAL;
+      continue;
+    }
+    if (wp->type == WORD_PARAM) {
+      char *value = expand_param_op(wp->value, d);
+      if (!value)
+        return -1;
+      wp->value = value;
+      wp->type = WORD_LITERAL;
+      continue;
+    }
     if (wp->type != WORD_VARIABLE)
       continue;
+
+    add_param_dep(d, wp->value);
     wp->value = expand_params_in_string(*wp);
     wp->type = WORD_LITERAL;
   }
+  return 0;
 }
 
 static char *expand_tilde_str(const char *s) {
@@ -71,22 +212,30 @@ static char *expand_tilde_str(const char *s) {
   size_t user_len = strlen(user);
 
   if (user_len == 0) {
-    return xstrdup(getenv("HOME"));
-  } else {
-    if (user_len > 256)
-      return NULL;
-    struct passwd *pw = getpwnam(user);
-    if (!pw || !pw->pw_dir)
-      return NULL;
-    return xstrdup(pw->pw_dir);
+    // the shell's HOME, the passwd entry only when it was unset
+    const char *home = shell_state_getenv("HOME");
+    if (home)
+      return xstrdup(home);
+    return passwd_cache_home(shell_state_get_identity()->username);
   }
+
+  if (user_len > 256)
+    return NULL;
+  if (shell_state_get()->flags.user_prefetch)
+    passwd_cache_prefetch();
+  return passwd_cache_home(user);
 }
 
-static int pass_expand_tilde(word_part_t *in_parts) {
+static int pass_expand_tilde(word_part_t *in_parts, expand_deps_t *d) {
   for (int i = 0; i < arrlen(in_parts); i++) {
     word_part_t *wp = &in_parts[i];
     if (wp->type != WORD_TILDE)
       continue;
+    if (wp->value[1] == '\0')
+      add_var_dep(d, "HOME");
+    else
+      d->cacheable = false;
+
     char *expanded = expand_tilde_str(wp->value);
     if (!expanded) {
       nsh_msg("user not found for '%s'\n", wp->value);
@@ -98,6 +247,28 @@ static int pass_expand_tilde(word_part_t *in_parts) {
   return 0;
 }
 
+/**
+ * @brief Shallow copy of a word used as scratch space by the expansion passes.
+ * Passes replace part values in the copy only, the AST keeps its
+ * pre-expansion form so that it can be expanded again (cached ASTs).
+ */
+static word_part_t *copy_word_parts(word_part_t *parts) {
+  word_part_t *copy = NULL;
+  arrsetlen(copy, arrlen(parts));
+  for (int i = 0; i < arrlen(parts); i++)
+    copy[i] = parts[i];
+  return copy;
+}
+
+// free the values allocated by the passes and the scratch array
+static void free_word_parts_copy(word_part_t *orig, word_part_t *copy) {
+  for (int i = 0; i < arrlen(copy); i++) {
+    if (copy[i].value != orig[i].value)
+      free(copy[i].value);
+  }
+  arrfree(copy);
+}
+
 static char *build_str_from_parts(word_part_t *parts) {
   size_t total_len = 0;
   for (int i = 0; i < arrlen(parts); i++)
@@ -112,68 +283,788 @@ static char *build_str_from_parts(word_part_t *parts) {
   return buf;
 }
 
-static char **pass_glob(word_part_t *in_parts) {
-  char **out = NULL;
-  glob_t g = {0};
+/**
+ * @brief Builds a pattern from an expanded word, quoted and expanded parts
+ * are matched literally.
+ * @param raw parts to use as pattern text as well (may be NULL)
+ */
+static char *build_pattern_from_parts(word_part_t *parts, bool *raw) {
+  char *pattern = NULL;
+  for (int i = 0; i < arrlen(parts); i++) {
+    bool as_is = parts[i].type == WORD_GLOB || (raw && raw[i]);
+    char *escaped = as_is ? parts[i].value : glob_escape(parts[i].value);
+    size_t len = strlen(escaped);
+    size_t off = (size_t)arrlen(pattern);
+    arrsetlen(pattern, off + len);
+    memcpy(pattern + off, escaped, len);
+    if (escaped != parts[i].value)
+      free(escaped);
+  }
+  arrpush(pattern, '\0');
+  return pattern;
+}
 
-  char *pattern = build_str_from_parts(in_parts);
-  int rc = glob(pattern, 0, NULL, &g);
-  if (rc == GLOB_NOMATCH || g.gl_pathc == 0) {
-    nsh_msg("no matches found for pattern '%s'\n", pattern);
-    free(pattern);
-    globfree(&g);
-    arrfree(out);
-    return NULL;
+/* --- PARAMETER OPERATIONS --- */
+
+/**
+ * @brief Expands a word used as a pattern ('case' and parameter operations).
+ * Quoted parts match literally while the values of unquoted parameters keep
+ * their magic characters.
+ * @return heap-allocated pattern or NULL if the expansion failed
+ */
+static char *expand_pattern_word(word_part_t *word, expand_deps_t *d) {
+  bool *raw = NULL;
+  for (int i = 0; i < arrlen(word); i++)
+    arrpush(raw, word[i].quote == QUOTE_NONE &&
+                     (word[i].type == WORD_VARIABLE ||
+                      word[i].type == WORD_PARAM ||
+                      word[i].type == WORD_CMDSUB ||
+                      word[i].type == WORD_ARITH));
+
+  word_part_t *parts = copy_word_parts(word);
+  char *out = NULL;
+  if (pass_expand_params(parts, d) == 0 && pass_expand_tilde(parts, d) == 0) {
+    char *pattern = build_pattern_from_parts(parts, raw);
+    out = xstrdup(pattern);
+    arrfree(pattern);
+  }
+  free_word_parts_copy(word, parts);
+  arrfree(raw);
+  return out;
+}
+
+/**
+ * @brief Expands the operand of a parameter operation (default value,
+ * pattern or replacement).
+ * @param pattern the operand is a pattern, see expand_pattern_word()
+ * @return heap-allocated string or NULL if the expansion failed
+ */
+static char *expand_operand(const char *src, size_t len, bool pattern,
+                            expand_deps_t *d) {
+  word_part_t *word = lexer_word_parts(src, len);
+
+  char *out = NULL;
+  if (pattern) {
+    out = expand_pattern_word(word, d);
   } else {
-    for (size_t j = 0; j < g.gl_pathc; j++)
-      arrpush(out, xstrdup(g.gl_pathv[j]));
+    word_part_t *parts = copy_word_parts(word);
+    if (pass_expand_params(parts, d) == 0 && pass_expand_tilde(parts, d) == 0)
+      out = build_str_from_parts(parts);
+    free_word_parts_copy(word, parts);
   }
-  free(pattern);
-  globfree(&g);
+
+  for (int i = 0; i < arrlen(word); i++)
+    free(word[i].value);
+  arrfree(word);
   return out;
 }
 
-char **expand_argv_parts(word_part_t **argv_parts, bool *invalid) {
-  char **argv = NULL;
-  for (int i = 0; i < arrlen(argv_parts); i++) {
-    word_part_t *parts = argv_parts[i];
+// offset of the first unquoted and unescaped c in s, or its length
+static size_t find_unquoted(const char *s, char c) {
+  quote_context_e quote = QUOTE_NONE;
+  size_t i = 0;
+  for (; s[i]; i++) {
+    if (quote == QUOTE_SINGLE) {
+      if (s[i] == '\'')
+        quote = QUOTE_NONE;
+    } else if (s[i] == '\\' && s[i + 1]) {
+      i++;
+    } else if (s[i] == '"') {
+      quote = quote == QUOTE_DOUBLE ? QUOTE_NONE : QUOTE_DOUBLE;
+    } else if (s[i] == '\'' && quote == QUOTE_NONE) {
+      quote = QUOTE_SINGLE;
+    } else if (s[i] == c && quote == QUOTE_NONE) {
+      break;
+    }
+  }
+  return i;
+}
 
-    pass_expand_params(parts);
-    if (pass_expand_tilde(parts) != 0) {
-      *invalid = true;
-      arrfree(argv);
-      return NULL;
+static void append_str(char **out, const char *s, size_t len) {
+  size_t off = (size_t)arrlen(*out);
+  arrsetlen(*out, off + len);
+  memcpy(*out + off, s, len);
+}
+
+/**
+ * @brief ${name/pat/rep} and its variants.
+ * @param mode '/' first match, 'g' every match, '#' anchored at the start,
+ * '%' anchored at the end
+ */
+static char *substitute(const pattern_t *pat, const char *value,
+                        const char *rep, char mode) {
+  size_t len = strlen(value);
+  size_t rep_len = strlen(rep);
+  size_t m;
+  char *out = NULL;
+
+  if (mode == '#' || mode == '%') {
+    bool found = mode == '#'
+                     ? pattern_match_prefix(pat, value, len, true, &m)
+                     : pattern_match_suffix(pat, value, len, true, &m);
+    if (!found)
+      return xstrdup(value);
+    if (mode == '#') {
+      append_str(&out, rep, rep_len);
+      append_str(&out, value + m, len - m);
+    } else {
+      append_str(&out, value, len - m);
+      append_str(&out, rep, rep_len);
+    }
+  } else {
+    size_t pos = 0;
+    size_t start, end;
+    // an empty match replaces nothing
+    while (pos < len && pattern_search(pat, value + pos, len - pos, &start,
+                                       &end) &&
+           end > start) {
+      append_str(&out, value + pos, start);
+      append_str(&out, rep, rep_len);
+      pos += end;
+      if (mode != 'g')
+        break;
+    }
+    append_str(&out, value + pos, len - pos);
+  }
+
+  arrpush(out, '\0');
+  char *result = xstrdup(out);
+  arrfree(out);
+  return result;
+}
+
+static char *param_value(const char *name, bool *is_set) {
+  if (!isalpha((unsigned char)*name) && *name != '_') {
+    *is_set = true;
+    return expand_special_one(*name);
+  }
+  char *value = shell_state_getenv(name);
+  *is_set = value != NULL;
+  return xstrdup(value ? value : "");
+}
+
+/**
+ * @brief Expands the body of a ${...} with an operator: ${#name},
+ * ${name:-word} and the other default value forms, ${name#pat},
+ * ${name%pat} (doubled for the longest match) and ${name/pat/rep}.
+ * Operands are only expanded when they are used.
+ * @return heap-allocated value or NULL on error (already reported)
+ */
+static char *expand_param_op(const char *body, expand_deps_t *d) {
+  const char *p = body;
+  bool length = p[0] == '#' && p[1] != '\0';
+  if (length)
+    p++;
+
+  size_t name_len = 0;
+  if (*p && strchr("?$!-", *p)) {
+    name_len = 1;
+  } else if (isalpha((unsigned char)*p) || *p == '_') {
+    while (isalnum((unsigned char)p[name_len]) || p[name_len] == '_')
+      name_len++;
+  }
+  const char *op = p + name_len;
+  if (name_len == 0 || (length && *op != '\0')) {
+    nsh_msg("${%s}: bad substitution\n", body);
+    return NULL;
+  }
+
+  char *name = xstrdup_n(p, name_len);
+  add_param_dep(d, name);
+  bool is_set;
+  char *value = param_value(name, &is_set);
+  char *result = NULL;
+
+  if (length) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%zu", strlen(value));
+    result = xstrdup(buf);
+    goto out;
+  }
+  if (*op == '\0') {
+    result = value;
+    value = NULL;
+    goto out;
+  }
+
+  // ':' makes an empty value count as unset
+  bool colon = *op == ':';
+  if (colon)
+    op++;
+  bool unset = !is_set || (colon && *value == '\0');
+
+  switch (*op) {
+  case '-':
+  case '=':
+  case '?':
+    if (!unset) {
+      result = value;
+      value = NULL;
+      goto out;
     }
+    result = expand_operand(op + 1, strlen(op + 1), false, d);
+    if (!result || *op == '-')
+      goto out;
 
-    if (arrlen(parts) == 1 && parts[0].type == WORD_LITERAL) {
-      arrpush(argv, xstrdup(parts[0].value));
+    if (*op == '?') {
+      nsh_msg("%s: %s\n", name,
+              *result ? result : "parameter null or not set");
+    } else if (isalpha((unsigned char)*name) || *name == '_') {
+      shell_state_setenv(name, result);
+      d->cacheable = false;
+      goto out;
     } else {
-      char **argv_entry = pass_glob(parts);
-      if (!argv_entry) {
-        *invalid = true;
-        arrfree(argv);
-        return NULL;
-      }
+      nsh_msg("$%s: cannot assign in this way\n", name);
+    }
+    free(result);
+    result = NULL;
+    goto out;
+  case '+':
+    result = unset ? xstrdup("")
+                   : expand_operand(op + 1, strlen(op + 1), false, d);
+    goto out;
+  default:
+    if (colon) {
+      nsh_msg("${%s}: bad substitution\n", body);
+      goto out;
+    }
+    break;
+  }
+
+  if (*op == '#' || *op == '%') {
+    bool longest = op[1] == op[0];
+    const char *src = op + 1 + longest;
+    char *pattern = expand_operand(src, strlen(src), true, d);
+    if (!pattern)
+      goto out;
+
+    size_t len = strlen(value);
+    size_t m;
+    const pattern_t *pat = pattern_get(pattern);
+    if (*op == '#' && pattern_match_prefix(pat, value, len, longest, &m))
+      result = xstrdup(value + m);
+    else if (*op == '%' && pattern_match_suffix(pat, value, len, longest, &m))
+      result = xstrdup_n(value, len - m);
+    else
+      result = xstrdup(value);
+    free(pattern);
+    goto out;
+  }
+
+  if (*op == '/') {
+    char mode = '/';
+    op++;
+    if (*op == '/' || *op == '#' || *op == '%') {
+      mode = *op == '/' ? 'g' : *op;
+      op++;
+    }
+    size_t pat_len = find_unquoted(op, '/');
+    const char *rep_src = op[pat_len] ? op + pat_len + 1 : op + pat_len;
+
+    // both operands are expanded before the pattern is looked up, they may
+    // use the pattern cache themselves
+    char *pattern = expand_operand(op, pat_len, true, d);
+    char *rep = pattern ? expand_operand(rep_src, strlen(rep_src), false, d)
+                        : NULL;
+    if (rep && *pattern == '\0' && mode != '#' && mode != '%') {
+      result = value;
+      value = NULL;
+    } else if (rep) {
+      result = substitute(pattern_get(pattern), value, rep, mode);
+    }
+    free(pattern);
+    free(rep);
+    goto out;
+  }
+
+  nsh_msg("${%s}: bad substitution\n", body);
+
+out:
+  free(name);
+  free(value);
+  return result;
+}
 
-      for (int j = 0; j < arrlen(argv_entry); j++) {
-        arrpush(argv, xstrdup(argv_entry[j]));
-        free(argv_entry[j]);
+/* --- FIELD SPLITTING --- */
+
+typedef struct {
+  bool delim[256]; /**< Bytes of IFS */
+  bool white[256]; /**< IFS whitespace: runs of them count as one delimiter */
+  bool blanks;     /**< IFS is the default " \t\n" */
+} ifs_t;
+
+static void ifs_init(ifs_t *ifs, const char *value) {
+  memset(ifs, 0, sizeof(*ifs));
+  if (!value)
+    value = IFS_DEFAULT;
+  for (const char *c = value; *c; c++) {
+    unsigned char b = (unsigned char)*c;
+    ifs->delim[b] = true;
+    ifs->white[b] = b == ' ' || b == '\t' || b == '\n';
+  }
+  ifs->blanks = strcmp(value, IFS_DEFAULT) == 0;
+}
+
+#ifdef __SSE2__
+// first offset >= i whose byte is (or, if !blank, is not) a default IFS byte
+static size_t scan_blanks_sse2(const char *s, size_t i, size_t n,
+                               bool blank) {
+  const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i nl = _mm_set1_epi8('\n');
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+        _mm_cmpeq_epi8(v, nl));
+    unsigned mask = (unsigned)_mm_movemask_epi8(m);
+    if (!blank)
+      mask = ~mask & 0xffff;
+    if (mask)
+      return i + (size_t)__builtin_ctz(mask);
+  }
+  return i;
+}
+#endif
+
+/**
+ * @brief Returns the first offset >= i of s whose byte is in (or not in) the
+ * class, or n. The default IFS is searched 16 bytes at a time.
+ */
+static size_t ifs_scan(const ifs_t *ifs, const bool *class, const char *s,
+                       size_t i, size_t n, bool in) {
+#ifdef __SSE2__
+  // with the default IFS both classes are the three blanks
+  if (ifs->blanks)
+    i = scan_blanks_sse2(s, i, n, in);
+#else
+  (void)ifs;
+#endif
+  while (i < n && class[(unsigned char)s[i]] != in)
+    i++;
+  return i;
+}
+
+/**
+ * @brief Fields of a word, their parts stored back to back so that splitting
+ * a value into many fields does not allocate for each of them.
+ */
+typedef struct {
+  word_part_t *parts;
+  int *ends;    /**< End offset of each field in parts */
+  bool started; /**< The current field has content (maybe empty quotes) */
+} split_t;
+
+static void split_add(split_t *sp, word_part_t part) {
+  arrpush(sp->parts, part);
+  sp->started = true;
+}
+
+// hard delimiters (non-whitespace IFS) end a field even if it is empty
+static void split_end(split_t *sp, bool hard) {
+  if (sp->started || hard)
+    arrpush(sp->ends, (int)arrlen(sp->parts));
+  sp->started = false;
+}
+
+/**
+ * @brief Splits a value in place: delimiters following a piece are
+ * overwritten with a NUL and pieces point into the value.
+ */
+static void split_value(split_t *sp, const ifs_t *ifs, char *s) {
+  size_t n = strlen(s);
+  size_t i = 0;
+  while (i < n) {
+    size_t end = ifs_scan(ifs, ifs->delim, s, i, n, true);
+    if (end > i)
+      split_add(sp, (word_part_t){.type = WORD_LITERAL,
+                                  .quote = QUOTE_NONE,
+                                  .value = s + i});
+    if (end == n)
+      break;
+
+    // whitespace around a single non-whitespace delimiter is one delimiter
+    size_t j = ifs_scan(ifs, ifs->white, s, end, n, false);
+    bool hard = j < n && ifs->delim[(unsigned char)s[j]];
+    if (hard)
+      j = ifs_scan(ifs, ifs->white, s, j + 1, n, false);
+    s[end] = '\0';
+    split_end(sp, hard);
+    i = j;
+  }
+}
+
+/**
+ * @brief Splits the results of unquoted parameter expansions and command
+ * substitutions on IFS.
+ * @param orig the word before expansion, splittable parts were variables or
+ * substitutions
+ * @param parts the expanded parts, split values are modified in place
+ */
+static void pass_split(word_part_t *orig, word_part_t *parts, split_t *sp,
+                       expand_deps_t *d) {
+  ifs_t ifs;
+  bool ifs_ready = false;
+  for (int i = 0; i < arrlen(parts); i++) {
+    word_part_t *wp = &parts[i];
+    bool split = orig[i].quote == QUOTE_NONE &&
+                 (orig[i].type == WORD_VARIABLE ||
+                  orig[i].type == WORD_PARAM ||
+                  orig[i].type == WORD_CMDSUB ||
+                  orig[i].type == WORD_ARITH) &&
+                 wp->value != orig[i].value;
+    if (!split) {
+      // an unquoted empty part cannot make a field on its own
+      if (*wp->value || wp->quote != QUOTE_NONE)
+        split_add(sp, *wp);
+      continue;
+    }
+
+    if (!ifs_ready) {
+      add_var_dep(d, "IFS");
+      ifs_init(&ifs, shell_state_getenv("IFS"));
+      ifs_ready = true;
+    }
+    split_value(sp, &ifs, wp->value);
+  }
+  split_end(sp, false);
+}
+
+// matches are appended directly to fields
+static int pass_glob(word_part_t *in_parts, char ***fields,
+                     expand_deps_t *d) {
+  // trailing qualifiers are set aside while the pattern is built
+  glob_qual_t *qual = NULL;
+  int nparts = (int)arrlen(in_parts);
+  if (in_parts[nparts - 1].type == WORD_GLOB_QUAL) {
+    const char *spec = in_parts[nparts - 1].value;
+    qual = glob_qual_parse(spec + 1, strlen(spec) - 2);
+    if (!qual)
+      return -1;
+    // the matches depend on metadata no dependency tracks
+    d->cacheable = false;
+    arrsetlen(in_parts, nparts - 1);
+  }
+
+  char *pattern = build_pattern_from_parts(in_parts, NULL);
+  int flags = shell_state_get()->flags.glob_prune ? GLOB_NATIVE_PRUNE : 0;
+  size_t first = (size_t)arrlen(*fields);
+  ssize_t n = glob_expand(pattern, flags, fields);
+  if (n > 0 && qual)
+    n = (ssize_t)glob_qual_apply(qual, fields, first);
+
+  int ret = 0;
+  if (n == -1) {
+    nsh_msg("%s", "glob interrupted\n");
+    ret = -1;
+  } else if (n == 0 && !(qual && glob_qual_null_glob(qual))) {
+    char *word = build_str_from_parts(in_parts);
+    nsh_msg("no matches found for pattern '%s'\n", word);
+    free(word);
+    ret = -1;
+  } else if (!qual) {
+    add_glob_dep(d, pattern);
+  }
+
+  arrfree(pattern);
+  glob_qual_free(qual);
+  return ret;
+}
+
+// only unquoted glob characters make a word a pattern
+static bool has_glob_part(word_part_t *parts) {
+  for (int i = 0; i < arrlen(parts); i++) {
+    if (parts[i].type == WORD_GLOB)
+      return true;
+  }
+  return false;
+}
+
+static void free_argv(char **argv) {
+  for (int i = 0; i < arrlen(argv); i++)
+    free(argv[i]);
+  arrfree(argv);
+}
+
+bool expand_memo_is_fresh(word_memo_t *memo) {
+  if (!memo || !memo->valid)
+    return false;
+
+  for (int i = 0; i < arrlen(memo->deps); i++) {
+    if (shell_state_getenv_gen(memo->deps[i].name) != memo->deps[i].gen)
+      return false;
+  }
+
+  if (memo->has_dir) {
+    struct stat st;
+    if (stat(memo->dir, &st) == -1 || st.st_dev != memo->dir_dev ||
+        st.st_ino != memo->dir_ino ||
+        st.st_mtim.tv_sec != memo->dir_mtime.tv_sec ||
+        st.st_mtim.tv_nsec != memo->dir_mtime.tv_nsec)
+      return false;
+  }
+  return true;
+}
+
+// the memo takes ownership of the collected dependencies
+static void memo_store(word_memo_t *memo, expand_deps_t *d, char **fields,
+                       int nfields) {
+  parser_free_word_memo(memo);
+  if (!d->cacheable)
+    return;
+
+  for (int i = 0; i < nfields; i++)
+    arrpush(memo->fields, xstrdup(fields[i]));
+  memo->deps = d->deps;
+  d->deps = NULL;
+  if (d->has_dir) {
+    memo->has_dir = true;
+    memo->dir = d->dir;
+    memo->dir_dev = d->dir_st.st_dev;
+    memo->dir_ino = d->dir_st.st_ino;
+    memo->dir_mtime = d->dir_st.st_mtim;
+    d->dir = NULL;
+  }
+  memo->valid = true;
+}
+
+/**
+ * @brief Expands a single word into its fields.
+ * @return stb_ds array of fields or NULL on error (invalid is set)
+ */
+static char **expand_word(word_part_t *word, word_memo_t *memo,
+                          bool *invalid) {
+  char **fields = NULL;
+  if (expand_memo_is_fresh(memo)) {
+    for (int i = 0; i < arrlen(memo->fields); i++)
+      arrpush(fields, xstrdup(memo->fields[i]));
+    return fields;
+  }
+
+  expand_deps_t d = {.cacheable = memo != NULL};
+  word_part_t *parts = copy_word_parts(word);
+
+  if (pass_expand_params(parts, &d) != 0 ||
+      pass_expand_tilde(parts, &d) != 0) {
+    *invalid = true;
+    goto out;
+  }
+
+  split_t sp = {0};
+  pass_split(word, parts, &sp, &d);
+
+  // every field is globbed on its own, through a reused scratch word
+  word_part_t *field = NULL;
+  int start = 0;
+  for (int i = 0; i < arrlen(sp.ends) && !*invalid; i++) {
+    arrsetlen(field, sp.ends[i] - start);
+    for (int j = start; j < sp.ends[i]; j++)
+      field[j - start] = sp.parts[j];
+    start = sp.ends[i];
+
+    if (!has_glob_part(field))
+      arrpush(fields, build_str_from_parts(field));
+    else if (pass_glob(field, &fields, &d) != 0)
+      *invalid = true;
+  }
+  arrfree(field);
+  arrfree(sp.parts);
+  arrfree(sp.ends);
+  if (*invalid)
+    goto out;
+
+  if (memo)
+    memo_store(memo, &d, fields, (int)arrlen(fields));
+
+out:
+  if (*invalid && memo)
+    parser_free_word_memo(memo);
+  free_word_parts_copy(word, parts);
+  free_deps(&d);
+  return fields;
+}
+
+char **expand_word_fields(word_part_t *word, word_memo_t *memo,
+                          bool *invalid) {
+  return expand_word(word, memo, invalid);
+}
+
+/**
+ * @brief Strings of an argument vector packed back to back in one buffer.
+ * The buffer may move while it grows, strings are located by their offset.
+ */
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t cap;
+  size_t *offs;
+} argv_buf_t;
+
+static char *argv_buf_reserve(argv_buf_t *a, size_t len) {
+  if (a->len + len + 1 > a->cap) {
+    size_t cap = a->cap ? a->cap * 2 : 256;
+    while (cap < a->len + len + 1)
+      cap *= 2;
+    a->buf = xrealloc(a->buf, cap);
+    a->cap = cap;
+  }
+  arrpush(a->offs, a->len);
+  char *dst = a->buf + a->len;
+  dst[len] = '\0';
+  a->len += len + 1;
+  return dst;
+}
+
+static void argv_buf_push(argv_buf_t *a, const char *s) {
+  size_t len = strlen(s);
+  memcpy(argv_buf_reserve(a, len), s, len);
+}
+
+/**
+ * @brief Appends the fields of a word holding braces. The words of the
+ * expansion are generated one at a time, those made of literals only are
+ * written straight into the buffer.
+ */
+static void expand_brace_word(word_part_t *word, argv_buf_t *a,
+                              bool *invalid) {
+  brace_iter_t *it = brace_iter_new(word);
+  if (brace_iter_count(it) > BRACE_MAX_WORDS) {
+    nsh_msg("%s", "brace expansion too large\n");
+    *invalid = true;
+    brace_iter_free(it);
+    return;
+  }
+
+  word_part_t *gen;
+  while (!*invalid && (gen = brace_iter_next(it)) != NULL) {
+    size_t len = 0;
+    bool literal = true;
+    bool empty = true;
+    for (int i = 0; i < arrlen(gen) && literal; i++) {
+      literal = gen[i].type == WORD_LITERAL;
+      len += strlen(gen[i].value);
+      empty &= gen[i].quote == QUOTE_NONE && !*gen[i].value;
+    }
+
+    if (literal) {
+      // like unquoted expansions, an empty word yields no field
+      if (empty)
+        continue;
+      char *dst = argv_buf_reserve(a, len);
+      for (int i = 0; i < arrlen(gen); i++) {
+        size_t n = strlen(gen[i].value);
+        memcpy(dst, gen[i].value, n);
+        dst += n;
       }
-      arrfree(argv_entry);
+      continue;
+    }
+
+    char **fields = expand_word(gen, NULL, invalid);
+    for (int i = 0; i < arrlen(fields); i++)
+      argv_buf_push(a, fields[i]);
+    free_argv(fields);
+  }
+  brace_iter_free(it);
+}
+
+// a word that may expand to any number of fields, unquoted variables being
+// split on IFS
+static bool word_spreads(word_part_t *word) {
+  for (int i = 0; i < arrlen(word); i++) {
+    if (word[i].quote == QUOTE_NONE &&
+        (word[i].type == WORD_GLOB || word[i].type == WORD_BRACE ||
+         word[i].type == WORD_CMDSUB || word[i].type == WORD_VARIABLE ||
+         word[i].type == WORD_PARAM))
+      return true;
+  }
+  return false;
+}
+
+char **expand_argv_parts(word_part_t **argv_parts, word_memo_t *memos,
+                         char **arena, size_t *spread, size_t *spread_end,
+                         bool *invalid) {
+  argv_buf_t a = {0};
+  *spread = *spread_end = 0;
+  bool in_run = false;
+  for (int i = 0; i < arrlen(argv_parts) && !*invalid; i++) {
+    size_t first = (size_t)arrlen(a.offs);
+    if (brace_has_expansion(argv_parts[i])) {
+      expand_brace_word(argv_parts[i], &a, invalid);
+    } else {
+      // a word may expand to no field at all
+      char **fields = expand_word(argv_parts[i], memos ? &memos[i] : NULL,
+                                  invalid);
+      for (int j = 0; j < arrlen(fields) && !*invalid; j++)
+        argv_buf_push(&a, fields[j]);
+      free_argv(fields);
     }
+
+    // a literal word ends the run, a later spreading word starts another
+    bool spreads = word_spreads(argv_parts[i]);
+    if (spreads && !in_run)
+      *spread = first;
+    if (spreads)
+      *spread_end = (size_t)arrlen(a.offs);
+    in_run = spreads;
   }
+
+  if (*invalid) {
+    free(a.buf);
+    arrfree(a.offs);
+    *arena = NULL;
+    return NULL;
+  }
+
+  // the buffer does not move anymore
+  char **argv = NULL;
+  arrsetlen(argv, arrlen(a.offs));
+  for (int i = 0; i < arrlen(a.offs); i++)
+    argv[i] = a.buf + a.offs[i];
   arrpushnc(argv, NULL);
+  arrfree(a.offs);
+  *arena = a.buf;
   return argv;
 }
 
 char *expand_redirection_target(word_part_t *redir_target_parts,
-                                bool *invalid) {
-  pass_expand_params(redir_target_parts);
-  if (pass_expand_tilde(redir_target_parts) != 0) {
+                                word_memo_t *memo, bool *invalid) {
+  return expand_word_str(redir_target_parts, memo, invalid);
+}
+
+char *expand_pattern(word_part_t *parts, bool *invalid) {
+  expand_deps_t d = {.cacheable = false};
+  char *pattern = expand_pattern_word(parts, &d);
+  free_deps(&d);
+  if (!pattern)
     *invalid = true;
+  return pattern;
+}
+
+char *expand_word_str(word_part_t *word, word_memo_t *memo, bool *invalid) {
+  if (expand_memo_is_fresh(memo))
+    return xstrdup(memo->fields[0]);
+
+  expand_deps_t d = {.cacheable = memo != NULL};
+  word_part_t *parts = copy_word_parts(word);
+  if (pass_expand_params(parts, &d) != 0 ||
+      pass_expand_tilde(parts, &d) != 0) {
+    *invalid = true;
+    free_word_parts_copy(word, parts);
+    free_deps(&d);
     return NULL;
   }
 
-  char *final_str = build_str_from_parts(redir_target_parts);
+  char *final_str = build_str_from_parts(parts);
+  if (memo)
+    memo_store(memo, &d, &final_str, 1);
+  free_word_parts_copy(word, parts);
+  free_deps(&d);
   return final_str;
-}
\ No newline at end of file
+}
+
+bool expand_arith(const char *expr, long long *value) {
+  expand_deps_t d = {.cacheable = false};
+  bool ok = eval_arith(expr, &d, value);
+  free_deps(&d);
+  return ok;
+}
@@ -9,18 +9,84 @@
 #define __NOVASH_EXPANDER_PIPELINE_H__
 
 #include <ctype.h>
-#include <glob.h>
 #include <pwd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+#include "expander/arith.h"
+#include "expander/brace.h"
+#include "expander/cmdsub.h"
+#include "expander/procsub.h"
+#include "expander/glob.h"
+#include "expander/glob_qual.h"
+#include "expander/pattern.h"
 #include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "shell/passwd_cache.h"
 #include "shell/state.h"
 #include "utils/collections.h"
 #include "utils/system/memory.h"
 
-char **expand_argv_parts(word_part_t **argv_parts, bool *invalid);
-char *expand_redirection_target(word_part_t *redir_target_parts, bool *invalid);
+/**
+ * @brief Tells whether a memoized expansion can be reused: every referenced
+ * variable kept its generation and the globbed directory, if any, kept its
+ * identity and mtime.
+ */
+bool expand_memo_is_fresh(word_memo_t *memo);
+
+/**
+ * @brief Expands the words of a command into an argument vector.
+ * The strings are packed in a single buffer, in order, so that large brace
+ * and glob expansions cost one allocation and the size of an argument is the
+ * distance to the next one.
+ * @param memos memo of each word, updated as words are expanded (may be NULL)
+ * @param arena set to the buffer holding the strings, to be freed instead of
+ * the strings themselves
+ * @param spread set to the index of the first field of the last run of words
+ * holding globs, brace expansions, command substitutions or unquoted
+ * variables, 0 if there is none
+ * @param spread_end set to the index following the last field of that run
+ */
+char **expand_argv_parts(word_part_t **argv_parts, word_memo_t *memos,
+                         char **arena, size_t *spread, size_t *spread_end,
+                         bool *invalid);
+
+/**
+ * @brief Expands a single word into its fields. Brace expansions are not
+ * performed, see brace.h to enumerate them.
+ * @param memo memo of the word, updated by the expansion (may be NULL)
+ * @return stb_ds array of heap-allocated fields (may be empty)
+ */
+char **expand_word_fields(word_part_t *word, word_memo_t *memo,
+                          bool *invalid);
+char *expand_redirection_target(word_part_t *redir_target_parts,
+                                word_memo_t *memo, bool *invalid);
+
+/**
+ * @brief Expands a word into a single string, without globbing (redirection
+ * targets, word of a case command).
+ * @param memo memo of the word, updated by the expansion (may be NULL)
+ */
+char *expand_word_str(word_part_t *parts, word_memo_t *memo, bool *invalid);
+
+/**
+ * @brief Expands a word used as a pattern. Quoted parts are escaped to match
+ * literally, the values of unquoted parameters keep their magic characters.
+ * @return heap-allocated pattern or NULL on error (invalid is set)
+ */
+char *expand_pattern(word_part_t *parts, bool *invalid);
+
+/**
+ * @brief Evaluates the expression of an arithmetic command, after expanding
+ * the parameters and command substitutions it holds.
+ * @return false if the expansion or the evaluation failed (error reported)
+ */
+bool expand_arith(const char *expr, long long *value);
 
 #endif // __NOVASH_EXPANDER_PIPELINE_H__
\ No newline at end of file
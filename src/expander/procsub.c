@@ -0,0 +1,102 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "expander/procsub.h"
+// executor.h sets _DEFAULT_SOURCE before any system header
+#include "executor/executor.h"
+#include "executor/jobs.h"
+#include "expander/cmdsub.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+static int *open_fds = NULL; /**< Ends kept by the shell, oldest first */
+
+// the forked shell only appears in the job table, to be reaped by pid
+static void register_job(pid_t pid, const char *body) {
+  job_t *job = jobs_new_job();
+  process_t *proc = xcalloc(1, sizeof(process_t));
+  proc->pid = pid;
+  proc->state = PROCESS_RUNNING;
+  proc->parent_job = job;
+  jobs_add_process_to_job(job, proc);
+
+  job->command = xstrdup(body);
+  job->pgid = pid;
+  job->is_procsub = true;
+  job->live_processes = 1;
+  jobs_add_job(job);
+}
+
+char *procsub_start(const char *body, bool output, bool *invalid) {
+  bool transient = false;
+  ast_node_t *ast = cmdsub_parse(body, &transient, invalid);
+  if (*invalid)
+    return NULL;
+
+  int fds[2];
+  if (pipe(fds) == -1) {
+    nsh_msg("process substitution: %s\n", strerror(errno));
+    if (transient)
+      parser_free_ast(ast);
+    *invalid = true;
+    return NULL;
+  }
+  // the command gets the write end of <(...) and the read end of >(...)
+  int outer = output ? fds[1] : fds[0];
+  int inner = output ? fds[0] : fds[1];
+  fflush(NULL);
+
+  pid_t pid = xfork();
+  if (pid == 0) {
+    /* CHILD: a subshell in its own group, away from the terminal */
+    xsetpgid(0, 0, true);
+    shell_state_t *sh_state = shell_state_get();
+    sh_state->flags.interactive = false;
+    sh_state->flags.job_control = false;
+
+    // the other substitutions of the command must see EOF without it
+    close(outer);
+    for (int i = 0; i < arrlen(open_fds); i++)
+      close(open_fds[i]);
+    xdup2(inner, output ? STDIN_FILENO : STDOUT_FILENO, true);
+    close(inner);
+    int st = exec_node(ast);
+    fflush(NULL);
+    _exit(st < 0 ? 0 : st & 0xff);
+  }
+
+  // set on both sides, whichever runs first
+  setpgid(pid, pid);
+  close(inner);
+  if (transient)
+    parser_free_ast(ast);
+  register_job(pid, body);
+  pr_debug("procsub: pid %d on fd %d", pid, outer);
+
+  arrpush(open_fds, outer);
+  char path[32];
+  snprintf(path, sizeof(path), "/dev/fd/%d", outer);
+  return xstrdup(path);
+}
+
+size_t procsub_mark(void) { return (size_t)arrlen(open_fds); }
+
+void procsub_close_from(size_t mark) {
+  if ((size_t)arrlen(open_fds) <= mark)
+    return;
+  for (size_t i = mark; i < (size_t)arrlen(open_fds); i++)
+    close(open_fds[i]);
+  arrsetlen(open_fds, mark);
+  if (mark == 0)
+    arrfree(open_fds);
+}
@@ -0,0 +1,47 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __PROCSUB_H__
+#define __PROCSUB_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Process substitution: <(...) and >(...).
+ *
+ * The body runs in a forked shell connected to a pipe, and the word expands
+ * to the /dev/fd path of the end kept by the shell, which the command
+ * inherits. Nothing is written to disk, so 'diff <(sort a) <(sort b)' streams
+ * both sides. The forked shells are registered in the job table, where the
+ * SIGCHLD handling reaps them without any notification.
+ *
+ * The ends kept by the shell stay open until the command using them has been
+ * launched: callers take a mark with procsub_mark() before expanding a command
+ * and release what was opened since with procsub_close_from() once it ran.
+ */
+
+/**
+ * @brief Starts a process substitution.
+ * @param body the command text between the parentheses
+ * @param output true for >(...), whose body reads what the command writes
+ * @param invalid set when the body has a syntax error or could not start
+ * @return heap-allocated /dev/fd path, NULL when invalid is set
+ */
+char *procsub_start(const char *body, bool output, bool *invalid);
+
+/**
+ * @brief Number of descriptors currently kept open for substitutions.
+ */
+size_t procsub_mark(void);
+
+/**
+ * @brief Closes the descriptors opened since a mark.
+ */
+void procsub_close_from(size_t mark);
+
+#endif // __PROCSUB_H__
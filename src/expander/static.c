@@ -0,0 +1,93 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "builtin/builtin.h"
+#include "expander.h"
+
+static bool word_is_literal(word_part_t *parts) {
+  for (int i = 0; i < arrlen(parts); i++) {
+    if (parts[i].type != WORD_LITERAL)
+      return false;
+  }
+  return true;
+}
+
+static char *literal_word_str(word_part_t *parts) {
+  if (arrlen(parts) == 1)
+    return xstrdup(parts[0].value);
+
+  size_t len = 0;
+  for (int i = 0; i < arrlen(parts); i++)
+    len += strlen(parts[i].value);
+
+  char *s = xmalloc(len + 1);
+  size_t off = 0;
+  for (int i = 0; i < arrlen(parts); i++) {
+    size_t part_len = strlen(parts[i].value);
+    memcpy(s + off, parts[i].value, part_len);
+    off += part_len;
+  }
+  s[off] = '\0';
+  return s;
+}
+
+static void static_pass_cmd(cmd_node_t *cmd) {
+  for (int i = 0; i < arrlen(cmd->argv_parts); i++) {
+    if (!word_is_literal(cmd->argv_parts[i]))
+      return;
+  }
+  for (int i = 0; i < arrlen(cmd->redir); i++) {
+    if (!word_is_literal(cmd->redir[i].target_parts))
+      return;
+  }
+
+  for (int i = 0; i < arrlen(cmd->argv_parts); i++)
+    arrpush(cmd->argv, literal_word_str(cmd->argv_parts[i]));
+  arrpushnc(cmd->argv, NULL);
+
+  for (int i = 0; i < arrlen(cmd->redir); i++)
+    cmd->redir[i].target = literal_word_str(cmd->redir[i].target_parts);
+
+  // builtins never change once registered, the executable path depends on
+  // PATH and is resolved on first execution
+  if (arrlen(cmd->argv) > 0)
+    cmd->builtin = builtin_get_function(cmd->argv[0]);
+  cmd->is_static = true;
+}
+
+void expander_static_pass(ast_node_t *node) {
+  if (!node)
+    return;
+
+  switch (node->type) {
+  case NODE_CMD:
+    if (!node->cmd.is_static)
+      static_pass_cmd(&node->cmd);
+    break;
+  case NODE_PIPELINE:
+    for (int i = 0; i < arrlen(node->pipe.nodes); i++)
+      expander_static_pass(node->pipe.nodes[i]);
+    break;
+  case NODE_CONDITIONAL:
+    expander_static_pass(node->cond.left);
+    expander_static_pass(node->cond.right);
+    break;
+  case NODE_SEQUENCE:
+    for (int i = 0; i < arrlen(node->seq.nodes); i++)
+      expander_static_pass(node->seq.nodes[i]);
+    break;
+  case NODE_CASE:
+    for (int i = 0; i < arrlen(node->case_stmt.items); i++)
+      expander_static_pass(node->case_stmt.items[i].body);
+    break;
+  case NODE_FOR:
+    expander_static_pass(node->for_stmt.body);
+    break;
+  case NODE_ARITH:
+    break;
+  }
+}
@@ -7,6 +7,8 @@
  */
 
 #include "history.h"
+#include "history_index.h"
+#include "parser/parser.h"
 
 static char *get_history_path() {
   char *hist_file_path = shell_state_getenv("HISTFILE");
@@ -27,8 +29,53 @@ void history_init() {
   hist->start = 0;
 }
 
+/**
+ * @brief Writes a command to the file. The file holds a command per line: the
+ * newlines of a multi-line command are written with a backslash before them,
+ * which tells the line goes on.
+ */
+static void write_entry(FILE *out, time_t ts, const char *cmd) {
+  fprintf(out, "%ld;", ts);
+  for (const char *p = cmd; *p; p++) {
+    if (*p == '\n')
+      fputc('\\', out);
+    fputc(*p, out);
+  }
+  fputc('\n', out);
+}
+
+/**
+ * @brief Reads a command written by write_entry(), gathering the lines it
+ * spans into line.
+ * @return false at the end of the file
+ */
+static bool read_entry(FILE *in, char **line, size_t *cap) {
+  ssize_t len = getline(line, cap, in);
+  if (len < 0)
+    return false;
+
+  char *next = NULL;
+  size_t next_cap = 0;
+  ssize_t next_len;
+  while (len >= 2 && (*line)[len - 1] == '\n' && (*line)[len - 2] == '\\' &&
+         (next_len = getline(&next, &next_cap, in)) >= 0) {
+    // the backslash is dropped, the newline kept
+    len--;
+    if ((size_t)(len + next_len) + 1 > *cap) {
+      *cap = (size_t)(len + next_len) + 1;
+      *line = xrealloc(*line, *cap);
+    }
+    (*line)[len - 1] = '\n';
+    memcpy(*line + len, next, (size_t)next_len + 1);
+    len += next_len;
+  }
+  free(next);
+  return true;
+}
+
 void history_load() {
-  char line[1024];
+  char *line = NULL;
+  size_t cap = 0;
 
   shell_state_t *ss = shell_state_get();
   history_t *hist = ss->hist;
@@ -42,15 +89,17 @@ void history_load() {
   // Rewind to the start of the file before reading.
   rewind(hist->fp);
 
-  while (fgets(line, sizeof(line), hist->fp)) {
-    // Find separator ';'. Expected format: #<timestamp>;<command>\n
+  while (read_entry(hist->fp, &line, &cap)) {
+    // Find separator ';'. Expected format: [#]<timestamp>;<command>\n
     char *sep = strchr(line, ';');
     if (!sep)
       continue;
     *sep = '\0';
-    time_t ts = atol(line + 2);
+    time_t ts = atol(line[0] == '#' ? line + 1 : line);
     char *cmd = sep + 1;
-    cmd[strcspn(cmd, "\n")] = 0;
+    size_t cmd_len = strlen(cmd);
+    if (cmd_len > 0 && cmd[cmd_len - 1] == '\n')
+      cmd[cmd_len - 1] = '\0';
 
     // --- Circular Buffer Logic ---
     if (hist->cmd_count < HIST_SIZE) {
@@ -58,29 +107,29 @@ void history_load() {
 
       hist->cmd_list[hist->cmd_count] = xstrdup(cmd);
       add_history(cmd);
+      history_index_add(cmd, ts);
       hist->timestamps[hist->cmd_count] = ts;
       hist->cmd_count++;
     } else {
       // Buffer full: overwrite the oldest element at 'start'.
+      history_index_forget(hist->cmd_list[hist->start]);
       free(hist->cmd_list[hist->start]); // Free old string before overwrite.
 
       hist->cmd_list[hist->start] = xstrdup(cmd);
+      history_index_add(cmd, ts);
       hist->timestamps[hist->start] = ts;
 
       // Advance the start pointer (circularly).
       hist->start = (hist->start + 1) % HIST_SIZE;
     }
   }
+  free(line);
 }
 
-void history_save_command(const char *cmd) {
-  if (!cmd || !*cmd)
-    return;
-
-  time_t now = time(NULL);
+// stores a command, owned by the buffer from then on, in the in-memory
+// buffer and prints it for the file
+static void store_command(history_t *hist, char *cmd, time_t now, FILE *out) {
   size_t idx;
-  shell_state_t *sh_state = shell_state_get();
-  history_t *hist = sh_state->hist;
 
   // Determine the storage index (idx).
   if (hist->cmd_count < HIST_SIZE) {
@@ -88,21 +137,63 @@ void history_save_command(const char *cmd) {
   } else {
     // Buffer full: reuse the oldest slot (hist->start).
     idx = hist->start;
+    history_index_forget(hist->cmd_list[idx]);
     free(hist->cmd_list[idx]);
     hist->start = (hist->start + 1) % HIST_SIZE;
   }
 
   // Store the new command in the in-memory buffer.
-  hist->cmd_list[idx] = xstrdup(cmd);
+  hist->cmd_list[idx] = cmd;
   hist->timestamps[idx] = now;
   add_history(cmd);
+  history_index_add(cmd, now);
+  write_entry(out, now, cmd);
+}
+
+void history_save_command(const char *cmd) {
+  if (!cmd || !*cmd)
+    return;
 
-  // Write command to the physical file.
-  fprintf(hist->fp, "%ld;%s\n", now, cmd);
+  time_t now = time(NULL);
+  shell_state_t *sh_state = shell_state_get();
+  history_t *hist = sh_state->hist;
+
+  // The commands of a pasted block are saved one by one, gathered in memory
+  // for a single write. A here-document or a compound command spanning
+  // several lines stays a single command.
+  char *text = NULL;
+  size_t size = 0;
+  FILE *out = open_memstream(&text, &size);
+  if (!out)
+    out = hist->fp;
+  size_t len = strlen(cmd);
+  for (size_t pos = 0; pos < len;) {
+    size_t end = parser_next_boundary(cmd, len, pos);
+    size_t stop = end;
+    while (stop > pos && cmd[stop - 1] == '\n')
+      stop--;
+    if (strspn(cmd + pos, " \t") < stop - pos)
+      store_command(hist, xstrdup_n(cmd + pos, stop - pos), now, out);
+    pos = end;
+  }
+  if (out != hist->fp) {
+    fclose(out);
+    fwrite(text, 1, size, hist->fp);
+    free(text);
+  }
   // Ensure the data is immediately written to disk.
   fflush(hist->fp);
 }
 
+size_t history_count(void) { return shell_state_get()->hist->cmd_count; }
+
+const char *history_at(size_t i) {
+  history_t *hist = shell_state_get()->hist;
+  if (i >= hist->cmd_count)
+    return NULL;
+  return hist->cmd_list[(hist->start + i) % HIST_SIZE];
+}
+
 void history_trim() {
   shell_state_t *ss = shell_state_get();
   history_t *hist = ss->hist;
@@ -125,8 +216,7 @@ void history_trim() {
   for (unsigned i = hist->start; i < hist_end; i++) {
     // Circular traversal using modulo arithmetic.
     index = i % HIST_SIZE;
-    fprintf(hist_write_fp, "%ld;%s\n", hist->timestamps[index],
-            hist->cmd_list[index]);
+    write_entry(hist_write_fp, hist->timestamps[index], hist->cmd_list[index]);
   }
   fclose(hist_write_fp);
 }
@@ -145,4 +235,5 @@ void history_free() {
   free(hist->cmd_list);
   free(hist->timestamps);
   free(hist);
+  history_index_free();
 }
\ No newline at end of file
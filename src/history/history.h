@@ -51,11 +51,25 @@ void history_load();
 /**
  * @brief Adds a new command to the history buffer and immediately saves it to
  * the HISTFILE. Handles timestamping and internal buffer rotation (circular
- * buffer logic).
+ * buffer logic). A pasted block is split at its top-level statement
+ * boundaries and each command is saved on its own, with a single write to
+ * the file; a here-document or a compound command is kept whole.
  * @param cmd The command string to save.
  */
 void history_save_command(const char *cmd);
 
+/**
+ * @brief Number of commands held in memory.
+ */
+size_t history_count(void);
+
+/**
+ * @brief Returns a command of the in-memory history.
+ * @param i index from the oldest command (0) to the newest (count - 1)
+ * @return the command, owned by the history, or NULL if i is out of range
+ */
+const char *history_at(size_t i);
+
 /**
  * @brief Trims the physical history file (HISTFILE) to ensure it doesn't exceed
  * the maximum allowed size (HISTORY_MAX_SIZE).
@@ -0,0 +1,353 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "history_index.h"
+#include "shell/config.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NO_ID UINT32_MAX
+
+/**
+ * @brief A distinct command of the history.
+ */
+typedef struct {
+  char *cmd;      /**< Heap string, also the key of the set */
+  time_t last;    /**< Last use */
+  uint32_t count; /**< Occurrences in the history */
+} entry_t;
+
+/**
+ * @brief Node of the radix trie, the commands end on the nodes holding
+ * an entry.
+ */
+typedef struct {
+  char *label;    /**< Heap string, bytes from the parent, "" for the root */
+  uint32_t *kids; /**< stb_ds array sorted by the first byte of the labels */
+  uint32_t entry; /**< Command ending here, or NO_ID */
+  uint32_t best[HISTORY_INDEX_BEST]; /**< Best of the subtree, first first */
+} node_t;
+
+typedef struct {
+  char *key;
+  uint32_t value;
+} command_id_t;
+
+static struct {
+  entry_t *entries;       /**< stb_ds array */
+  uint32_t *free_entries; /**< stb_ds array, slots of removed entries */
+  node_t *nodes;          /**< stb_ds array, the root first */
+  uint32_t *free_nodes;   /**< stb_ds array, slots of removed nodes */
+  command_id_t *ids;      /**< Set of the commands, keys owned by entries */
+} hi;
+
+/* --- RANKING --- */
+
+static int64_t frecency(uint32_t id) {
+  const entry_t *e = &hi.entries[id];
+  int64_t doublings = 0;
+  for (uint32_t c = e->count; c > 1; c >>= 1)
+    doublings++;
+  return (int64_t)e->last + doublings * HISTORY_FRECENCY_STEP;
+}
+
+// tells whether entry a ranks before entry b, NO_ID ranking last
+static bool better(uint32_t a, uint32_t b) {
+  if (a == NO_ID || b == NO_ID)
+    return b == NO_ID && a != NO_ID;
+  int64_t fa = frecency(a), fb = frecency(b);
+  return fa != fb ? fa > fb : a > b;
+}
+
+// puts an entry at its rank in a best list, which it may already be part of
+static void offer(uint32_t *best, uint32_t id) {
+  size_t i = 0;
+  while (i < HISTORY_INDEX_BEST && best[i] != id)
+    i++;
+  if (i < HISTORY_INDEX_BEST) {
+    memmove(best + i, best + i + 1,
+            (HISTORY_INDEX_BEST - 1 - i) * sizeof(*best));
+    best[HISTORY_INDEX_BEST - 1] = NO_ID;
+  }
+
+  size_t pos = 0;
+  while (pos < HISTORY_INDEX_BEST && !better(id, best[pos]))
+    pos++;
+  if (pos == HISTORY_INDEX_BEST)
+    return;
+  memmove(best + pos + 1, best + pos,
+          (HISTORY_INDEX_BEST - 1 - pos) * sizeof(*best));
+  best[pos] = id;
+}
+
+// ranks a node again from its own command and the best lists of its kids
+static void rank_node(uint32_t node) {
+  node_t *n = &hi.nodes[node];
+  for (size_t i = 0; i < HISTORY_INDEX_BEST; i++)
+    n->best[i] = NO_ID;
+  if (n->entry != NO_ID)
+    offer(n->best, n->entry);
+  for (int k = 0; k < arrlen(n->kids); k++) {
+    const uint32_t *kid_best = hi.nodes[n->kids[k]].best;
+    for (size_t i = 0; i < HISTORY_INDEX_BEST && kid_best[i] != NO_ID; i++)
+      offer(n->best, kid_best[i]);
+  }
+}
+
+/* --- TRIE --- */
+
+static uint32_t new_node(const char *label, size_t len) {
+  node_t n = {.label = xstrdup_n(label, len), .entry = NO_ID};
+  for (size_t i = 0; i < HISTORY_INDEX_BEST; i++)
+    n.best[i] = NO_ID;
+  if (arrlen(hi.free_nodes) > 0) {
+    uint32_t id = arrpop(hi.free_nodes);
+    hi.nodes[id] = n;
+    return id;
+  }
+  arrpush(hi.nodes, n);
+  return (uint32_t)(arrlen(hi.nodes) - 1);
+}
+
+static void free_node(uint32_t node) {
+  free(hi.nodes[node].label);
+  arrfree(hi.nodes[node].kids);
+  hi.nodes[node].label = NULL;
+  arrpush(hi.free_nodes, node);
+}
+
+/**
+ * @brief Finds the kid of a node whose label starts with a byte.
+ * @param pos set to the index of the kid, or where it would be inserted
+ * @return the kid, NO_ID if there is none
+ */
+static uint32_t find_kid(uint32_t node, unsigned char c, size_t *pos) {
+  const uint32_t *kids = hi.nodes[node].kids;
+  size_t lo = 0, end = (size_t)arrlen(kids);
+  while (lo < end) {
+    size_t mid = (lo + end) / 2;
+    unsigned char k = (unsigned char)hi.nodes[kids[mid]].label[0];
+    if (k == c) {
+      *pos = mid;
+      return kids[mid];
+    }
+    if (k < c)
+      lo = mid + 1;
+    else
+      end = mid;
+  }
+  *pos = lo;
+  return NO_ID;
+}
+
+static void add_kid(uint32_t node, size_t pos, uint32_t kid) {
+  arrpush(hi.nodes[node].kids, kid);
+  uint32_t *kids = hi.nodes[node].kids;
+  size_t count = (size_t)arrlen(kids);
+  memmove(kids + pos + 1, kids + pos, (count - 1 - pos) * sizeof(*kids));
+  kids[pos] = kid;
+}
+
+/**
+ * @brief Walks the trie along a command, splitting the labels and adding
+ * the nodes it needs.
+ * @param path stb_ds array receiving the nodes walked, the root first
+ * @return the node where the command ends
+ */
+static uint32_t insert_path(const char *cmd, uint32_t **path) {
+  if (!hi.nodes)
+    new_node("", 0);
+  uint32_t node = 0;
+  arrpush(*path, node);
+  for (const char *p = cmd; *p;) {
+    size_t pos;
+    uint32_t kid = find_kid(node, (unsigned char)*p, &pos);
+    if (kid == NO_ID) {
+      kid = new_node(p, strlen(p));
+      add_kid(node, pos, kid);
+      arrpush(*path, kid);
+      return kid;
+    }
+
+    const char *label = hi.nodes[kid].label;
+    size_t m = 0;
+    while (label[m] && label[m] == p[m])
+      m++;
+    if (label[m]) {
+      // the command leaves the label: its common part becomes a node
+      uint32_t mid = new_node(label, m);
+      node_t *k = &hi.nodes[kid];
+      char *rest = xstrdup(label + m);
+      free(k->label);
+      k->label = rest;
+      memcpy(hi.nodes[mid].best, k->best, sizeof(k->best));
+      arrpush(hi.nodes[mid].kids, kid);
+      hi.nodes[node].kids[pos] = mid;
+      kid = mid;
+    }
+    node = kid;
+    p += m;
+    arrpush(*path, node);
+  }
+  return node;
+}
+
+// a node holding no command and a single kid takes the place of that kid
+static void merge_with_kid(uint32_t node) {
+  node_t *n = &hi.nodes[node];
+  uint32_t kid = n->kids[0];
+  node_t *k = &hi.nodes[kid];
+
+  size_t nlen = strlen(n->label), klen = strlen(k->label);
+  char *label = xmalloc(nlen + klen + 1);
+  memcpy(label, n->label, nlen);
+  memcpy(label + nlen, k->label, klen + 1);
+  free(n->label);
+  n->label = label;
+
+  arrfree(n->kids);
+  n->kids = k->kids;
+  k->kids = NULL;
+  n->entry = k->entry;
+  memcpy(n->best, k->best, sizeof(n->best));
+  free_node(kid);
+}
+
+/**
+ * @brief Removes the nodes left useless at the end of a path whose last
+ * node no longer holds a command. The removed nodes are set to NO_ID.
+ */
+static void prune(uint32_t *path) {
+  size_t d = (size_t)arrlen(path) - 1;
+  if (d == 0)
+    return;
+  uint32_t node = path[d];
+  if (arrlen(hi.nodes[node].kids) == 0) {
+    uint32_t parent = path[d - 1];
+    size_t pos;
+    find_kid(parent, (unsigned char)hi.nodes[node].label[0], &pos);
+    arrdel(hi.nodes[parent].kids, pos);
+    free_node(node);
+    path[d] = NO_ID;
+    node = parent;
+    if (--d == 0 || hi.nodes[node].entry != NO_ID)
+      return;
+  }
+  if (arrlen(hi.nodes[node].kids) == 1)
+    merge_with_kid(node);
+}
+
+/* --- ENTRIES --- */
+
+static uint32_t new_entry(const char *cmd, time_t when) {
+  entry_t e = {.cmd = xstrdup(cmd), .last = when, .count = 1};
+  uint32_t id;
+  if (arrlen(hi.free_entries) > 0) {
+    id = arrpop(hi.free_entries);
+    hi.entries[id] = e;
+  } else {
+    arrpush(hi.entries, e);
+    id = (uint32_t)(arrlen(hi.entries) - 1);
+  }
+  shput(hi.ids, hi.entries[id].cmd, id);
+  return id;
+}
+
+static void drop_entry(uint32_t id) {
+  (void)shdel(hi.ids, hi.entries[id].cmd);
+  free(hi.entries[id].cmd);
+  hi.entries[id].cmd = NULL;
+  arrpush(hi.free_entries, id);
+}
+
+/* --- API --- */
+
+void history_index_add(const char *cmd, time_t when) {
+  // a suggestion ends the line being typed, it never spans several lines
+  if (!cmd || !*cmd || strchr(cmd, '\n'))
+    return;
+  uint32_t *path = NULL;
+  uint32_t node = insert_path(cmd, &path);
+  uint32_t id = hi.nodes[node].entry;
+  if (id == NO_ID) {
+    id = new_entry(cmd, when);
+    hi.nodes[node].entry = id;
+  } else {
+    entry_t *e = &hi.entries[id];
+    e->count++;
+    if (when > e->last)
+      e->last = when;
+  }
+
+  // the frecency only grew, the entry can only move up the best lists
+  for (int i = 0; i < arrlen(path); i++)
+    offer(hi.nodes[path[i]].best, id);
+  arrfree(path);
+}
+
+void history_index_forget(const char *cmd) {
+  if (!cmd || shgeti(hi.ids, cmd) < 0)
+    return;
+  uint32_t *path = NULL;
+  uint32_t node = insert_path(cmd, &path);
+  uint32_t id = hi.nodes[node].entry;
+  if (--hi.entries[id].count == 0) {
+    hi.nodes[node].entry = NO_ID;
+    prune(path);
+    drop_entry(id);
+  }
+
+  // the frecency went down: the best lists are ranked again from the kids
+  for (size_t i = (size_t)arrlen(path); i-- > 0;) {
+    if (path[i] != NO_ID)
+      rank_node(path[i]);
+  }
+  arrfree(path);
+}
+
+const char *history_index_suggest(const char *prefix, size_t len) {
+  if (len == 0 || !hi.nodes)
+    return NULL;
+  uint32_t node = 0;
+  for (size_t i = 0; i < len;) {
+    size_t pos;
+    node = find_kid(node, (unsigned char)prefix[i], &pos);
+    if (node == NO_ID)
+      return NULL;
+    for (const char *l = hi.nodes[node].label; *l && i < len; l++, i++) {
+      if (*l != prefix[i])
+        return NULL;
+    }
+  }
+
+  // every command below starts with the prefix, only itself is not longer
+  const uint32_t *best = hi.nodes[node].best;
+  for (size_t i = 0; i < HISTORY_INDEX_BEST && best[i] != NO_ID; i++) {
+    if (hi.entries[best[i]].cmd[len])
+      return hi.entries[best[i]].cmd;
+  }
+  return NULL;
+}
+
+size_t history_index_size(void) { return (size_t)shlen(hi.ids); }
+
+void history_index_free(void) {
+  for (int i = 0; i < arrlen(hi.nodes); i++) {
+    free(hi.nodes[i].label);
+    arrfree(hi.nodes[i].kids);
+  }
+  for (int i = 0; i < arrlen(hi.entries); i++)
+    free(hi.entries[i].cmd);
+  arrfree(hi.nodes);
+  arrfree(hi.free_nodes);
+  arrfree(hi.entries);
+  arrfree(hi.free_entries);
+  shfree(hi.ids);
+}
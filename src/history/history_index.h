@@ -0,0 +1,58 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __HISTORY_INDEX_H__
+#define __HISTORY_INDEX_H__
+
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * Index of the history commands for the autosuggestions of the line editor.
+ *
+ * The distinct commands are kept once (a hash set from the command to its
+ * entry) with their number of occurrences and the time of their last use.
+ * Their frecency is that time plus HISTORY_FRECENCY_STEP seconds for every
+ * doubling of the occurrences: it does not depend on the current time, so
+ * the rankings stay valid as time passes.
+ *
+ * The commands are the leaves of a radix trie whose nodes keep the
+ * HISTORY_INDEX_BEST commands of their subtree with the highest frecency: a
+ * suggestion walks the prefix and takes the best command of the node it
+ * ends on. The history updates the index one command at a time as commands
+ * enter and leave its ring.
+ */
+
+/**
+ * @brief Records a use of a command. Commands spanning several lines are not
+ * indexed.
+ * @param when time of the use
+ */
+void history_index_add(const char *cmd, time_t when);
+
+/**
+ * @brief Drops an occurrence of a command, which leaves the index with its
+ * last occurrence.
+ */
+void history_index_forget(const char *cmd);
+
+/**
+ * @brief Finds the command with the highest frecency that starts with a
+ * prefix and is longer than it.
+ * @return the command, owned by the index and valid until it changes, or
+ * NULL if there is none
+ */
+const char *history_index_suggest(const char *prefix, size_t len);
+
+/**
+ * @brief Number of distinct commands indexed.
+ */
+size_t history_index_size(void);
+
+void history_index_free(void);
+
+#endif // __HISTORY_INDEX_H__
@@ -13,6 +13,10 @@ lexer_t *lexer_new() {
   lex->input = NULL;
   lex->pos = 0;
   lex->length = 0;
+  lex->tok_start = 0;
+  lex->tok_prev_end = 0;
+  lex->heredoc_end = 0;
+  lex->heredoc_eof = false;
   return lex;
 }
 
@@ -23,6 +27,23 @@ void lexer_init(lexer_t *lex, char *input) {
   lex->input = xstrdup(input);
   lex->pos = 0;
   lex->length = strlen(input);
+  lex->tok_start = 0;
+  lex->tok_prev_end = 0;
+  lex->heredoc_end = 0;
+  lex->heredoc_eof = false;
+}
+
+void lexer_init_n(lexer_t *lex, const char *input, size_t len) {
+  if (lex->input)
+    free(lex->input);
+
+  lex->input = xstrdup_n(input, len);
+  lex->pos = 0;
+  lex->length = len;
+  lex->tok_start = 0;
+  lex->tok_prev_end = 0;
+  lex->heredoc_end = 0;
+  lex->heredoc_eof = false;
 }
 
 void lexer_free(lexer_t *lex) {
@@ -73,7 +94,8 @@ static inline bool ismetachar(char c) {
 }
 
 #define is_meta_char(c)                                                        \
-  ((c) == '|' || (c) == '&' || (c) == ';' || (c) == '<' || (c) == '>')
+  ((c) == '|' || (c) == '&' || (c) == ';' || (c) == '<' || (c) == '>' ||     \
+   (c) == '(' || (c) == ')')
 #define is_glob_char(c) ((c) == '*' || (c) == '?' || (c) == '[')
 #define is_expansion_char(c)                                                   \
   ((c) == '$' || (c) == '*' || (c) == '?' || is_glob_char(c))
@@ -82,9 +104,56 @@ static inline bool ismetachar(char c) {
 #define is_word_char(c)                                                        \
   (!isspace(c) && !is_meta_char(c) && !is_expansion_char(c))
 
+// <(...) and >(...) are words, not redirections
+static inline bool is_procsub_start(lexer_t *lex) {
+  char c = peek(lex);
+  return (c == '<' || c == '>') && lex->pos + 1 < lex->length &&
+         lex->input[lex->pos + 1] == '(';
+}
+
+/**
+ * @brief Length of a glob qualifier list starting at the current '(', such
+ * as (.) or (om[1,10]), including its parentheses. It must end the word.
+ * @return the length or 0 if the text is not a qualifier list
+ */
+static size_t glob_qual_len(lexer_t *lex) {
+  size_t i = lex->pos + 1;
+  while (i < lex->length && lex->input[i] != ')') {
+    char c = lex->input[i];
+    if (isspace((unsigned char)c) || is_meta_char(c) || strchr("'\"$`\\", c))
+      return 0;
+    i++;
+  }
+  if (i >= lex->length || i == lex->pos + 1)
+    return 0;
+
+  char next = i + 1 < lex->length ? lex->input[i + 1] : '\0';
+  if (next != '\0' && !isspace((unsigned char)next) &&
+      (!is_meta_char(next) || next == '('))
+    return 0;
+  return i + 1 - lex->pos;
+}
+
+static bool parts_have_glob(word_part_t *parts) {
+  for (int i = 0; i < arrlen(parts); i++) {
+    if (parts[i].type == WORD_GLOB)
+      return true;
+  }
+  return false;
+}
+
+// newlines are not skipped as they separate commands
 static inline void skip_whitespaces(lexer_t *lex) {
   char c;
-  while ((c = peek(lex)) != '\0' && isspace(c)) {
+  while ((c = peek(lex)) != '\0' && isspace(c) && c != '\n') {
+    advance(lex);
+  }
+}
+
+// comments run from an unquoted '#' at the start of a word to the end of line
+static inline void skip_comment(lexer_t *lex) {
+  char c;
+  while ((c = peek(lex)) != '\0' && c != '\n') {
     advance(lex);
   }
 }
@@ -126,6 +195,48 @@ static char handle_escape(lexer_t *lex) {
   }
 }
 
+/**
+ * @brief Length of the brace expansion starting at the current '{', 0 if it
+ * is not one. The braces must be matched within the word and hold an
+ * unquoted ',' at their level or a '..' (sequences are validated by the
+ * expander, which keeps invalid ones literal).
+ */
+static size_t brace_expansion_len(lexer_t *lex) {
+  const char *s = &lex->input[lex->pos];
+  size_t n = lex->length - lex->pos;
+  quote_context_e quote = QUOTE_NONE;
+  int depth = 0;
+  bool comma = false;
+
+  for (size_t i = 0; i < n; i++) {
+    char c = s[i];
+    if (quote == QUOTE_SINGLE) {
+      if (c == '\'')
+        quote = QUOTE_NONE;
+    } else if (c == '\\') {
+      i++;
+    } else if (c == '"') {
+      quote = quote == QUOTE_DOUBLE ? QUOTE_NONE : QUOTE_DOUBLE;
+    } else if (quote == QUOTE_DOUBLE) {
+      continue;
+    } else if (c == '\'') {
+      quote = QUOTE_SINGLE;
+    } else if (isspace((unsigned char)c) || is_meta_char(c)) {
+      return 0;
+    } else if (c == '{') {
+      depth++;
+    } else if (c == '}' && --depth == 0) {
+      bool seq = false;
+      for (size_t k = 1; k + 1 < i && !seq; k++)
+        seq = s[k] == '.' && s[k + 1] == '.';
+      return comma || seq ? i + 1 : 0;
+    } else if (c == ',' && depth == 1) {
+      comma = true;
+    }
+  }
+  return 0;
+}
+
 static char *handle_literal(lexer_t *lex, quote_context_e quote_ctx) {
   size_t buf_cap = 64;
   size_t buf_len = 0;
@@ -137,11 +248,14 @@ static char *handle_literal(lexer_t *lex, quote_context_e quote_ctx) {
       break;
 
     if (quote_ctx == QUOTE_NONE) {
-      if (!is_word_char(c) || c == '\'' || c == '\"')
+      if (!is_word_char(c) || c == '\'' || c == '\"' || c == '`')
+        break;
+      if (c == '{' && brace_expansion_len(lex) > 0)
         break;
     } else if (quote_ctx == QUOTE_SINGLE && c == '\'') {
       break;
-    } else if (quote_ctx == QUOTE_DOUBLE && (c == '\"' || c == '$')) {
+    } else if (quote_ctx == QUOTE_DOUBLE &&
+               (c == '\"' || c == '$' || c == '`')) {
       break;
     }
 
@@ -165,50 +279,197 @@ static char *handle_literal(lexer_t *lex, quote_context_e quote_ctx) {
   return (buf_len > 0) ? buf : NULL;
 }
 
-static char *handle_variable_word_part(lexer_t *lex) {
-  advance(lex); // skip '$'
+static inline bool is_param_name(const char *s, size_t len) {
+  if (len == 1 && is_special_parameter_char(*s))
+    return true;
+  if (len == 0 || !(isalpha((unsigned char)*s) || *s == '_'))
+    return false;
+  for (size_t i = 1; i < len; i++) {
+    if (!isalnum((unsigned char)s[i]) && s[i] != '_')
+      return false;
+  }
+  return true;
+}
+
+/**
+ * The body of ${...} is kept whole, up to the matching unquoted '}', and is
+ * parsed by the expander. Plain names are simple variables.
+ */
+static char *handle_brace_word_part(lexer_t *lex, word_part_type_e *type) {
+  advance(lex); // skip '{'
+  size_t start = lex->pos;
+  quote_context_e quote = QUOTE_NONE;
+  int depth = 1;
+  char c;
+
+  while ((c = peek(lex)) != '\0') {
+    if (quote == QUOTE_SINGLE) {
+      if (c == '\'')
+        quote = QUOTE_NONE;
+    } else if (c == '\\') {
+      advance(lex);
+    } else if (c == '"') {
+      quote = quote == QUOTE_DOUBLE ? QUOTE_NONE : QUOTE_DOUBLE;
+    } else if (c == '\'' && quote == QUOTE_NONE) {
+      quote = QUOTE_SINGLE;
+    } else if (quote == QUOTE_NONE && c == '{') {
+      depth++;
+    } else if (quote == QUOTE_NONE && c == '}' && --depth == 0) {
+      break;
+    }
+    advance(lex);
+  }
+
+  size_t len = lex->pos - start;
+  if (c == '}')
+    advance(lex);
+  else
+    pr_err("lexer: unmatched '{' in variable name\n");
+
+  // check for the case of '${}'
+  if (len == 0)
+    return "";
+
+  *type = is_param_name(&lex->input[start], len) ? WORD_VARIABLE : WORD_PARAM;
+  return xstrdup_n(&lex->input[start], len);
+}
+
+/**
+ * The body of $(...) runs up to the matching ')', parentheses of nested
+ * substitutions and quoted ones aside. It is parsed when the word is expanded.
+ */
+static char *handle_cmdsub_word_part(lexer_t *lex) {
+  advance(lex); // skip '('
   size_t start = lex->pos;
-  bool has_curly = false;
-  if (peek(lex) == '{') {
-    has_curly = true;
+  quote_context_e quote = QUOTE_NONE;
+  int depth = 1;
+  char c;
+
+  while ((c = peek(lex)) != '\0') {
+    if (quote == QUOTE_SINGLE) {
+      if (c == '\'')
+        quote = QUOTE_NONE;
+    } else if (c == '\\') {
+      advance(lex);
+    } else if (c == '"') {
+      quote = quote == QUOTE_DOUBLE ? QUOTE_NONE : QUOTE_DOUBLE;
+    } else if (c == '\'' && quote == QUOTE_NONE) {
+      quote = QUOTE_SINGLE;
+    } else if (quote == QUOTE_NONE && c == '(') {
+      depth++;
+    } else if (quote == QUOTE_NONE && c == ')' && --depth == 0) {
+      break;
+    }
     advance(lex);
   }
 
-  if (is_special_parameter_char(peek(lex))) {
+  size_t len = lex->pos - start;
+  if (c == ')')
     advance(lex);
-    if (has_curly) {
-      if (peek(lex) == '}')
-        advance(lex);
+  else
+    pr_err("%s", "lexer: unmatched '(' in command substitution\n");
+  return xstrdup_n(&lex->input[start], len);
+}
 
-      else
-        pr_err("lexer: unmatched '{' in variable name\n");
+/**
+ * @brief Length of the arithmetic expression starting at the current "((",
+ * up to and including the "))" closing it. 0 if the parentheses do not pair
+ * that way, as in "((a) | (b))" which nests a subshell.
+ */
+static size_t arith_len(lexer_t *lex) {
+  const char *s = &lex->input[lex->pos];
+  size_t n = lex->length - lex->pos;
+  if (n < 4 || s[0] != '(' || s[1] != '(')
+    return 0;
+
+  quote_context_e quote = QUOTE_NONE;
+  int depth = 0;
+  for (size_t i = 0; i < n; i++) {
+    char c = s[i];
+    if (quote == QUOTE_SINGLE) {
+      if (c == '\'')
+        quote = QUOTE_NONE;
+    } else if (c == '\\') {
+      i++;
+    } else if (c == '"') {
+      quote = quote == QUOTE_DOUBLE ? QUOTE_NONE : QUOTE_DOUBLE;
+    } else if (quote == QUOTE_DOUBLE) {
+      continue;
+    } else if (c == '\'') {
+      quote = QUOTE_SINGLE;
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')' && --depth == 1) {
+      // the inner parenthesis is closed, the outer one must follow
+      return i + 1 < n && s[i + 1] == ')' ? i + 2 : 0;
     }
-    return xstrdup_n(&lex->input[start] + has_curly, 1);
   }
+  return 0;
+}
 
-  while (isalnum(peek(lex)) || peek(lex) == '_') {
+/**
+ * The body of `...` runs up to the next unescaped '`'. A backslash only
+ * escapes '$', '`' and itself, other backslashes are kept for the parser.
+ */
+static char *handle_backquote_word_part(lexer_t *lex) {
+  advance(lex); // skip '`'
+  char *body = NULL;
+  char c;
+  while ((c = peek(lex)) != '\0' && c != '`') {
     advance(lex);
+    if (c == '\\' && strchr("$`\\", peek(lex)) && peek(lex) != '\0')
+      c = advance(lex);
+    arrpush(body, c);
   }
 
-  if (has_curly) {
-    if (peek(lex) == '}')
-      advance(lex);
+  if (c == '`')
+    advance(lex);
+  else
+    pr_err("%s", "lexer: unmatched '`' in command substitution\n");
+  arrpush(body, '\0');
+  char *s = xstrdup(body);
+  arrfree(body);
+  return s;
+}
 
-    else
-      pr_err("lexer: unmatched '{' in variable name\n");
+static char *handle_variable_word_part(lexer_t *lex, word_part_type_e *type) {
+  advance(lex); // skip '$'
+  *type = WORD_VARIABLE;
+  if (peek(lex) == '{')
+    return handle_brace_word_part(lex, type);
+  size_t arith = arith_len(lex);
+  if (arith > 0) {
+    *type = WORD_ARITH;
+    char *expr = xstrdup_n(&lex->input[lex->pos + 2], arith - 4);
+    lex->pos += arith;
+    // $(()) is 0, empty parts are dropped
+    if (*expr == '\0') {
+      free(expr);
+      expr = xstrdup("0");
+    }
+    return expr;
+  }
+  if (peek(lex) == '(') {
+    *type = WORD_CMDSUB;
+    return handle_cmdsub_word_part(lex);
   }
 
-  size_t len = lex->pos - start - 2 * has_curly;
-  // just a '$' considered as literal
-  if (len == 0) {
+  size_t start = lex->pos;
+  if (is_special_parameter_char(peek(lex))) {
+    advance(lex);
+    return xstrdup_n(&lex->input[start], 1);
+  }
 
-    // check for the case of '${}'
-    if (has_curly)
-      return "";
-    return NULL;
+  while (isalnum(peek(lex)) || peek(lex) == '_') {
+    advance(lex);
   }
 
-  return xstrdup_n(&lex->input[start] + has_curly, len);
+  // just a '$' considered as literal
+  size_t len = lex->pos - start;
+  if (len == 0)
+    return NULL;
+
+  return xstrdup_n(&lex->input[start], len);
 }
 
 static char *handle_tilde_word_part(lexer_t *lex) {
@@ -257,21 +518,39 @@ static word_part_t lex_next_word_part(lexer_t *lex,
     return (word_part_t){0};
   }
 
+  // Handle process substitutions, the body is run by the expander
+  if (*quote_ctx == QUOTE_NONE && is_procsub_start(lex)) {
+    advance(lex); // skip '<' or '>'
+    char *body = handle_cmdsub_word_part(lex);
+    return (word_part_t){c == '<' ? WORD_PROCSUB_IN : WORD_PROCSUB_OUT,
+                         QUOTE_NONE, body};
+  }
+
   // Handle variable expansion
   if (c == '$' && (*quote_ctx == QUOTE_NONE || *quote_ctx == QUOTE_DOUBLE)) {
-    char *varname = handle_variable_word_part(lex);
+    word_part_type_e type;
+    char *varname = handle_variable_word_part(lex, &type);
 
     if (!varname) {
       return (word_part_t){WORD_LITERAL, *quote_ctx, xstrdup("$")};
     }
 
-    // ignore ${} case
+    // ignore ${} and $() cases
+    if (*varname == '\0' && type == WORD_CMDSUB) {
+      free(varname);
+      return (word_part_t){0};
+    }
     if (*varname == '\0') {
       // varname is stack allocated here (no free needed)
       return (word_part_t){0};
     }
 
-    return (word_part_t){WORD_VARIABLE, *quote_ctx, varname};
+    return (word_part_t){type, *quote_ctx, varname};
+  }
+
+  if (c == '`' && *quote_ctx != QUOTE_SINGLE) {
+    char *body = handle_backquote_word_part(lex);
+    return (word_part_t){WORD_CMDSUB, *quote_ctx, body};
   }
 
   // Handle tilde expansion
@@ -280,8 +559,17 @@ static word_part_t lex_next_word_part(lexer_t *lex,
     return (word_part_t){WORD_TILDE, *quote_ctx, tilde};
   }
 
+  // Handle brace expansions, the body is expanded by the expander
+  if (c == '{' && *quote_ctx == QUOTE_NONE) {
+    size_t len = brace_expansion_len(lex);
+    if (len > 0) {
+      char *body = xstrdup_n(&lex->input[lex->pos + 1], len - 2);
+      lex->pos += len;
+      return (word_part_t){WORD_BRACE, QUOTE_NONE, body};
+    }
+  }
+
   // Handle globbing characters
-  // Future note: could be improved to handle [a-z] and {brace} patterns
   if (is_glob_char(c) && *quote_ctx == QUOTE_NONE) {
     char *glob = handle_glob_word_part(lex);
     return (word_part_t){WORD_GLOB, *quote_ctx, glob};
@@ -301,12 +589,26 @@ static token_t handle_word_token(lexer_t *lex) {
     if (c == '\0')
       break;
 
-    if (quote_ctx == QUOTE_NONE && (isspace(c) || is_meta_char(c)))
+    // qualifiers of a pattern, the expander filters the matches with them
+    if (quote_ctx == QUOTE_NONE && c == '(' && parts_have_glob(parts)) {
+      size_t len = glob_qual_len(lex);
+      if (len > 0) {
+        arrput(parts, ((word_part_t){WORD_GLOB_QUAL, QUOTE_NONE,
+                                     xstrdup_n(&lex->input[lex->pos], len)}));
+        lex->pos += len;
+        continue;
+      }
+    }
+
+    if (quote_ctx == QUOTE_NONE && (isspace(c) || is_meta_char(c)) &&
+        !is_procsub_start(lex))
       break;
 
     word_part_t part = lex_next_word_part(lex, &quote_ctx);
     if (part.value && strlen(part.value) > 0)
       arrput(parts, part);
+    else
+      free(part.value);
   }
 
   char *raw_value =
@@ -317,8 +619,15 @@ static token_t handle_word_token(lexer_t *lex) {
 
 token_t lexer_next_token(lexer_t *lex) {
 
+  lex->tok_prev_end = lex->pos;
   skip_whitespaces(lex);
   char c = peek(lex);
+  if (c == '#') {
+    skip_comment(lex);
+    c = peek(lex);
+  }
+  lex->tok_start = lex->pos;
+
   switch (c) {
   case '|': {
     advance(lex);
@@ -337,6 +646,8 @@ token_t lexer_next_token(lexer_t *lex) {
       return (token_t){TOK_BG, NULL, NULL};
   }
   case '>': {
+    if (is_procsub_start(lex))
+      return handle_word_token(lex);
     advance(lex);
     if (peek(lex) == '>') {
       advance(lex);
@@ -345,13 +656,53 @@ token_t lexer_next_token(lexer_t *lex) {
       return (token_t){TOK_REDIR_OUT, NULL, NULL};
   }
   case '<': {
+    if (is_procsub_start(lex))
+      return handle_word_token(lex);
     advance(lex);
-    return (token_t){TOK_REDIR_IN, NULL, NULL};
+    if (peek(lex) != '<')
+      return (token_t){TOK_REDIR_IN, NULL, NULL};
+    advance(lex);
+    if (peek(lex) == '<') {
+      advance(lex);
+      return (token_t){TOK_HERESTRING, NULL, NULL};
+    }
+    if (peek(lex) == '-') {
+      advance(lex);
+      return (token_t){TOK_HEREDOC_STRIP, NULL, NULL};
+    }
+    return (token_t){TOK_HEREDOC, NULL, NULL};
   }
   case ';': {
     advance(lex);
+    if (peek(lex) == ';') {
+      advance(lex);
+      return (token_t){TOK_DSEMI, NULL, NULL};
+    }
     return (token_t){TOK_SEMI, NULL, NULL};
   }
+  case '(': {
+    size_t arith = arith_len(lex);
+    if (arith > 0) {
+      char *expr = xstrdup_n(&lex->input[lex->pos + 2], arith - 4);
+      lex->pos += arith;
+      return (token_t){TOK_ARITH, expr, NULL};
+    }
+    advance(lex);
+    return (token_t){TOK_LPAREN, NULL, NULL};
+  }
+  case ')': {
+    advance(lex);
+    return (token_t){TOK_RPAREN, NULL, NULL};
+  }
+  case '\n': {
+    advance(lex);
+    // the bodies of the here-documents of this line follow it
+    if (lex->heredoc_end > 0) {
+      lex->pos = lex->heredoc_end;
+      lex->heredoc_end = 0;
+    }
+    return (token_t){TOK_NEWLINE, NULL, NULL};
+  }
   case '\0': {
     advance(lex);
     return (token_t){TOK_EOF, NULL, NULL};
@@ -368,6 +719,125 @@ token_t lexer_next_token(lexer_t *lex) {
   }
 }
 
+word_part_t *lexer_word_parts(const char *s, size_t len) {
+  lexer_t lex = {0};
+  lexer_init_n(&lex, s, len);
+
+  word_part_t *parts = NULL;
+  quote_context_e quote_ctx = QUOTE_NONE;
+  char c;
+  while ((c = peek(&lex)) != '\0') {
+    if (quote_ctx == QUOTE_NONE && (isspace(c) || is_meta_char(c))) {
+      word_part_t lit = {WORD_LITERAL, QUOTE_NONE, xstrdup_n(&c, 1)};
+      arrput(parts, lit);
+      advance(&lex);
+      continue;
+    }
+
+    word_part_t part = lex_next_word_part(&lex, &quote_ctx);
+    if (part.value && strlen(part.value) > 0)
+      arrput(parts, part);
+    else
+      free(part.value);
+  }
+
+  free(lex.input);
+  return parts;
+}
+
+char *lexer_read_heredoc(lexer_t *lex, const char *delim, bool strip_tabs) {
+  size_t pos = lex->heredoc_end;
+  if (pos == 0) {
+    const char *nl =
+        memchr(&lex->input[lex->pos], '\n', lex->length - lex->pos);
+    pos = nl ? (size_t)(nl - lex->input) + 1 : lex->length;
+  }
+
+  size_t delim_len = strlen(delim);
+  char *body = NULL;
+  bool found = false;
+  while (pos < lex->length && !found) {
+    const char *line = &lex->input[pos];
+    const char *nl = memchr(line, '\n', lex->length - pos);
+    size_t len = nl ? (size_t)(nl - line) : lex->length - pos;
+    pos += nl ? len + 1 : len;
+
+    while (strip_tabs && len > 0 && *line == '\t') {
+      line++;
+      len--;
+    }
+    found = len == delim_len && memcmp(line, delim, len) == 0;
+    if (!found) {
+      size_t off = (size_t)arrlen(body);
+      arrsetlen(body, off + len + 1);
+      memcpy(body + off, line, len);
+      body[off + len] = '\n';
+    }
+  }
+
+  lex->heredoc_end = pos;
+  if (!found)
+    lex->heredoc_eof = true;
+  char *s = xstrdup_n(body ? body : "", (size_t)arrlen(body));
+  arrfree(body);
+  return s;
+}
+
+word_part_t *lexer_heredoc_parts(const char *s, size_t len) {
+  lexer_t lex = {0};
+  lexer_init_n(&lex, s, len);
+
+  word_part_t *parts = NULL;
+  char *lit = NULL;
+  char c;
+  while ((c = peek(&lex)) != '\0') {
+    if (c == '\\' && lex.pos + 1 < lex.length &&
+        strchr("$`\\\n", lex.input[lex.pos + 1])) {
+      advance(&lex);
+      c = advance(&lex);
+      if (c != '\n')
+        arrpush(lit, c);
+      continue;
+    }
+    if (c != '$' && c != '`') {
+      arrpush(lit, advance(&lex));
+      continue;
+    }
+
+    word_part_type_e type = WORD_CMDSUB;
+    char *value = c == '$' ? handle_variable_word_part(&lex, &type)
+                           : handle_backquote_word_part(&lex);
+    if (!value) {
+      arrpush(lit, '$');
+      continue;
+    }
+    // ${} is a static string, $() an allocated one
+    if (*value == '\0') {
+      if (type == WORD_CMDSUB)
+        free(value);
+      continue;
+    }
+
+    if (arrlen(lit) > 0) {
+      word_part_t part = {WORD_LITERAL, QUOTE_DOUBLE,
+                          xstrdup_n(lit, (size_t)arrlen(lit))};
+      arrput(parts, part);
+      arrdeln(lit, 0, (size_t)arrlen(lit));
+    }
+    word_part_t part = {type, QUOTE_DOUBLE, value};
+    arrput(parts, part);
+  }
+
+  if (arrlen(lit) > 0) {
+    word_part_t part = {WORD_LITERAL, QUOTE_DOUBLE,
+                        xstrdup_n(lit, (size_t)arrlen(lit))};
+    arrput(parts, part);
+  }
+  arrfree(lit);
+  free(lex.input);
+  return parts;
+}
+
 size_t lexer_token_str(token_t tok, char *buf, size_t buf_sz) {
   char temp[1024] = {0};
   size_t offset = 0;
@@ -390,8 +860,25 @@ size_t lexer_token_str(token_t tok, char *buf, size_t buf_sz) {
     return (size_t)snprintf(buf, buf_sz, "[TOK_REDIR_IN]: <\n");
   case TOK_REDIR_OUT:
     return (size_t)snprintf(buf, buf_sz, "[TOK_REDIR_OUT]: >\n");
+  case TOK_HEREDOC:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_HEREDOC]: <<\n");
+  case TOK_HEREDOC_STRIP:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_HEREDOC_STRIP]: <<-\n");
+  case TOK_HERESTRING:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_HERESTRING]: <<<\n");
   case TOK_SEMI:
     return (size_t)snprintf(buf, buf_sz, "[TOK_SEMI]: ;\n");
+  case TOK_DSEMI:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_DSEMI]: ;;\n");
+  case TOK_LPAREN:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_LPAREN]: (\n");
+  case TOK_RPAREN:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_RPAREN]: )\n");
+  case TOK_NEWLINE:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_NEWLINE]\n");
+  case TOK_ARITH:
+    return (size_t)snprintf(buf, buf_sz, "[TOK_ARITH]: ((%s))\n",
+                            tok.raw_value ? tok.raw_value : "");
   default:
     break;
   }
@@ -447,6 +934,20 @@ const char *lexer_part_type_str(word_part_type_e type) {
     return "TILDE";
   case WORD_GLOB:
     return "GLOB";
+  case WORD_PARAM:
+    return "PARAM";
+  case WORD_BRACE:
+    return "BRACE";
+  case WORD_CMDSUB:
+    return "CMDSUB";
+  case WORD_ARITH:
+    return "ARITH";
+  case WORD_PROCSUB_IN:
+    return "PROCSUB_IN";
+  case WORD_PROCSUB_OUT:
+    return "PROCSUB_OUT";
+  case WORD_GLOB_QUAL:
+    return "GLOB_QUAL";
   default:
     return "UNKNOWN";
   }
@@ -29,6 +29,14 @@ typedef enum {
   TOK_REDIR_IN,
   TOK_REDIR_OUT,
   TOK_REDIR_APPEND,
+  TOK_HEREDOC,       /**< << */
+  TOK_HEREDOC_STRIP, /**< <<-, leading tabs are stripped from the body */
+  TOK_HERESTRING,    /**< <<< */
+  TOK_LPAREN,
+  TOK_RPAREN,
+  TOK_DSEMI,
+  TOK_ARITH, /**< ((...)), raw_value is the expression */
+  TOK_NEWLINE,
   TOK_EOF,
 } token_type_e;
 
@@ -36,7 +44,14 @@ typedef enum {
   WORD_LITERAL,
   WORD_VARIABLE,
   WORD_TILDE,
-  WORD_GLOB
+  WORD_GLOB,
+  WORD_PARAM, /**< ${...} with an operator, value is the text between braces */
+  WORD_BRACE, /**< {a,b} or {x..y}, value is the text between braces */
+  WORD_CMDSUB, /**< $(...) or `...`, value is the command to run */
+  WORD_ARITH,  /**< $((...)), value is the expression */
+  WORD_PROCSUB_IN,  /**< <(...), value is the command whose output is read */
+  WORD_PROCSUB_OUT, /**< >(...), value is the command reading its input */
+  WORD_GLOB_QUAL    /**< (...) qualifiers ending a pattern, parentheses kept */
 } word_part_type_e;
 
 typedef enum { QUOTE_NONE, QUOTE_SINGLE, QUOTE_DOUBLE } quote_context_e;
@@ -63,6 +78,11 @@ typedef struct {
   char *input;
   size_t pos;
   size_t length;
+  size_t tok_start;    /**< offset of the last token returned */
+  size_t tok_prev_end; /**< offset right after the token before it */
+  size_t heredoc_end;  /**< offset right after the here-document bodies read
+                          on the current line, 0 if none was read */
+  bool heredoc_eof;    /**< a here-document body ran to the end of input */
 } lexer_t;
 
 /**
@@ -77,6 +97,14 @@ lexer_t *lexer_new();
  */
 void lexer_init(lexer_t *lex, char *input);
 
+/**
+ * init the lexer on the first len bytes of input
+ * @param lex the lexer
+ * @param input the input, does not need to be NUL-terminated
+ * @param len number of bytes to lex
+ */
+void lexer_init_n(lexer_t *lex, const char *input, size_t len);
+
 /**
  * free the lexer and its resources
  * @param lex pointer to the lexer to free
@@ -96,6 +124,37 @@ void lexer_free_token(token_t *tok);
  */
 token_t lexer_next_token(lexer_t *lex);
 
+/**
+ * lex a whole string as the parts of a single word, blanks and operators are
+ * literal characters (operands of parameter expansions)
+ * @param s the string, does not need to be NUL-terminated
+ * @param len number of bytes to lex
+ * @return stb_ds array of parts, owned by the caller
+ */
+word_part_t *lexer_word_parts(const char *s, size_t len);
+
+/**
+ * read the body of a here-document, from the line following the current one
+ * (or following the previous body on the same line) up to the delimiter line.
+ * The lexer skips the body when it reaches the end of the current line.
+ * @param lex pointer to the lexer, right after the delimiter word
+ * @param delim the delimiter, quotes removed
+ * @param strip_tabs strip the leading tabs of every line (<<-)
+ * @return the body, each line ending with a newline, owned by the caller
+ * @note sets lex->heredoc_eof if the input ends before the delimiter
+ */
+char *lexer_read_heredoc(lexer_t *lex, const char *delim, bool strip_tabs);
+
+/**
+ * lex the body of a here-document whose delimiter is unquoted: it undergoes
+ * parameter, command and arithmetic expansions and a backslash only escapes
+ * '$', '`', '\' and newline, everything else is literal
+ * @param s the body, does not need to be NUL-terminated
+ * @param len length of the body
+ * @return stb_ds array of parts, owned by the caller
+ */
+word_part_t *lexer_heredoc_parts(const char *s, size_t len);
+
 /**
  * print the token type and value for debugging
  * @param tok the token to print
@@ -9,12 +9,20 @@
 #include "shell/shell.h"
 #include "utils/log.h"
 
-int main() {
-  if (shell_init(false) != 0) {
+int main(int argc, char *argv[]) {
+  // a script is run non-interactively, no need to warn about the TTY
+  bool run_script = argc > 1;
+  if (shell_init(run_script) != 0) {
     return EXIT_FAILURE;
   }
 
-  int exit_code = shell_loop();
+  int exit_code;
+  if (run_script) {
+    exit_code = shell_run_script(argv[1]);
+  } else {
+    shell_source_rc();
+    exit_code = shell_loop();
+  }
   shell_cleanup();
 
   return exit_code;
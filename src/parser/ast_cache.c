@@ -0,0 +1,114 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#include "ast_cache.h"
+#include "utils/utils.h"
+
+ast_cache_t *ast_cache_new(size_t capacity) {
+  ast_cache_t *cache = xcalloc(1, sizeof(ast_cache_t));
+  cache->capacity = capacity > 0 ? capacity : 1;
+  // other fields are zeroed by xcalloc
+  return cache;
+}
+
+static void unlink_entry(ast_cache_t *cache, ast_cache_entry_t *entry) {
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->head = entry->next;
+
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->tail = entry->prev;
+
+  entry->prev = NULL;
+  entry->next = NULL;
+}
+
+static void push_front(ast_cache_t *cache, ast_cache_entry_t *entry) {
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if (cache->head)
+    cache->head->prev = entry;
+  cache->head = entry;
+  if (!cache->tail)
+    cache->tail = entry;
+}
+
+static void free_entry(ast_cache_entry_t *entry) {
+  parser_free_ast(entry->ast);
+  free(entry->line);
+  free(entry);
+}
+
+static void remove_entry(ast_cache_t *cache, ast_cache_entry_t *entry) {
+  unlink_entry(cache, entry);
+  (void)hmdel(cache->index, entry->hash);
+  cache->count--;
+  free_entry(entry);
+}
+
+ast_node_t *ast_cache_lookup(ast_cache_t *cache, const char *line) {
+  uint64_t hash = hash_fnv1a(line, strlen(line));
+  ast_cache_entry_t *entry = hmget(cache->index, hash);
+
+  // the line is compared as well to rule out hash collisions
+  if (!entry || strcmp(entry->line, line) != 0) {
+    cache->misses++;
+    return NULL;
+  }
+
+  cache->hits++;
+  if (entry != cache->head) {
+    unlink_entry(cache, entry);
+    push_front(cache, entry);
+  }
+  return entry->ast;
+}
+
+void ast_cache_insert(ast_cache_t *cache, const char *line, ast_node_t *ast) {
+  if (!ast)
+    return;
+
+  uint64_t hash = hash_fnv1a(line, strlen(line));
+
+  // a colliding (or identical) line is replaced by the new one
+  ast_cache_entry_t *old = hmget(cache->index, hash);
+  if (old) {
+    if (old->ast == ast)
+      return;
+    remove_entry(cache, old);
+  }
+
+  if (cache->count >= cache->capacity)
+    remove_entry(cache, cache->tail);
+
+  ast_cache_entry_t *entry = xcalloc(1, sizeof(ast_cache_entry_t));
+  entry->hash = hash;
+  entry->line = xstrdup(line);
+  entry->ast = ast;
+
+  hmput(cache->index, hash, entry);
+  push_front(cache, entry);
+  cache->count++;
+}
+
+void ast_cache_free(ast_cache_t *cache) {
+  if (!cache)
+    return;
+
+  ast_cache_entry_t *entry = cache->head;
+  while (entry) {
+    ast_cache_entry_t *next = entry->next;
+    free_entry(entry);
+    entry = next;
+  }
+  hmfree(cache->index);
+  free(cache);
+}
@@ -0,0 +1,84 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __AST_CACHE_H__
+#define __AST_CACHE_H__
+
+#include "parser/parser.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Entry of the AST cache. Entries are chained in a doubly-linked list
+ * ordered from the most recently used (head) to the least recently used
+ * (tail).
+ * @note line and ast are owned by the entry.
+ */
+typedef struct ast_cache_entry_t {
+  uint64_t hash;
+  char *line;      /**< Input line the AST was parsed from */
+  ast_node_t *ast; /**< Pre-expansion AST */
+  struct ast_cache_entry_t *prev;
+  struct ast_cache_entry_t *next;
+} ast_cache_entry_t;
+
+/* Hash table slot mapping a line hash to its entry */
+typedef struct {
+  uint64_t key;
+  ast_cache_entry_t *value;
+} ast_cache_slot_t;
+
+/**
+ * @brief LRU cache of parsed command lines.
+ * Lookups are keyed by a hash of the input line, the line itself is kept to
+ * tell collisions apart.
+ */
+typedef struct {
+  ast_cache_slot_t *index;
+  ast_cache_entry_t *head;
+  ast_cache_entry_t *tail;
+  size_t count;
+  size_t capacity;
+  size_t hits;
+  size_t misses;
+} ast_cache_t;
+
+/**
+ * @brief Creates an empty cache holding at most capacity ASTs.
+ * @param capacity maximum number of entries (at least 1)
+ * @return pointer to the new cache
+ */
+ast_cache_t *ast_cache_new(size_t capacity);
+
+/**
+ * @brief Looks up the AST parsed from line and marks it as most recently used.
+ * @param cache the cache
+ * @param line the raw input line
+ * @return the cached AST (still owned by the cache) or NULL on a miss
+ */
+ast_node_t *ast_cache_lookup(ast_cache_t *cache, const char *line);
+
+/**
+ * @brief Stores the AST parsed from line, evicting the least recently used
+ * entry when the cache is full.
+ * @param cache the cache
+ * @param line the raw input line (duplicated)
+ * @param ast the AST, ownership is transferred to the cache
+ * @note evicted ASTs are freed, callers must not keep references to them
+ * across insertions.
+ */
+void ast_cache_insert(ast_cache_t *cache, const char *line, ast_node_t *ast);
+
+/**
+ * @brief Frees every cached AST and the cache itself.
+ * @param cache the cache
+ */
+void ast_cache_free(ast_cache_t *cache);
+
+#endif // __AST_CACHE_H__
@@ -0,0 +1,309 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#include "ast_serial.h"
+
+// deeper trees are rejected rather than risking a stack overflow
+#define AST_SERIAL_MAX_DEPTH 1024
+
+/* --- ENCODING --- */
+
+static void put_bytes(uint8_t **buf, const void *data, size_t len) {
+  size_t off = (size_t)arrlen(*buf);
+  arrsetlen(*buf, off + len);
+  memcpy(*buf + off, data, len);
+}
+
+static void put_u8(uint8_t **buf, uint8_t v) { arrpush(*buf, v); }
+
+static void put_u32(uint8_t **buf, uint32_t v) {
+  put_bytes(buf, &v, sizeof(v));
+}
+
+static void put_str(uint8_t **buf, const char *s) {
+  uint32_t len = s ? (uint32_t)strlen(s) : 0;
+  put_u32(buf, len);
+  put_bytes(buf, s, len);
+}
+
+static void put_word(uint8_t **buf, word_part_t *parts) {
+  put_u32(buf, (uint32_t)arrlen(parts));
+  for (int i = 0; i < arrlen(parts); i++) {
+    put_u8(buf, (uint8_t)parts[i].type);
+    put_u8(buf, (uint8_t)parts[i].quote);
+    put_str(buf, parts[i].value);
+  }
+}
+
+static void put_node(uint8_t **buf, ast_node_t *node) {
+  // the parser never leaves a child out, a tree missing one is written with
+  // an invalid type so that it is rejected when read back
+  if (!node) {
+    put_u8(buf, UINT8_MAX);
+    return;
+  }
+  put_u8(buf, (uint8_t)node->type);
+
+  switch (node->type) {
+  case NODE_CMD: {
+    cmd_node_t *cmd = &node->cmd;
+    put_u8(buf, cmd->is_bg);
+    put_str(buf, cmd->raw_str);
+    put_u32(buf, (uint32_t)arrlen(cmd->argv_parts));
+    for (int i = 0; i < arrlen(cmd->argv_parts); i++)
+      put_word(buf, cmd->argv_parts[i]);
+
+    put_u32(buf, (uint32_t)arrlen(cmd->redir));
+    for (int i = 0; i < arrlen(cmd->redir); i++) {
+      put_u32(buf, (uint32_t)cmd->redir[i].fd);
+      put_u8(buf, (uint8_t)cmd->redir[i].type);
+      put_word(buf, cmd->redir[i].target_parts);
+    }
+    break;
+  }
+  case NODE_PIPELINE:
+    put_u32(buf, (uint32_t)arrlen(node->pipe.nodes));
+    for (int i = 0; i < arrlen(node->pipe.nodes); i++)
+      put_node(buf, node->pipe.nodes[i]);
+    break;
+  case NODE_CONDITIONAL:
+    put_u8(buf, (uint8_t)node->cond.op);
+    put_node(buf, node->cond.left);
+    put_node(buf, node->cond.right);
+    break;
+  case NODE_SEQUENCE:
+    put_u32(buf, (uint32_t)arrlen(node->seq.nodes));
+    for (int i = 0; i < arrlen(node->seq.nodes); i++)
+      put_node(buf, node->seq.nodes[i]);
+    break;
+  case NODE_CASE:
+    put_word(buf, node->case_stmt.word);
+    put_u32(buf, (uint32_t)arrlen(node->case_stmt.items));
+    for (int i = 0; i < arrlen(node->case_stmt.items); i++) {
+      case_item_t *item = &node->case_stmt.items[i];
+      put_u32(buf, (uint32_t)arrlen(item->patterns));
+      for (int j = 0; j < arrlen(item->patterns); j++)
+        put_word(buf, item->patterns[j]);
+      put_u8(buf, item->body != NULL);
+      if (item->body)
+        put_node(buf, item->body);
+    }
+    break;
+  case NODE_FOR:
+    put_str(buf, node->for_stmt.var);
+    put_u32(buf, (uint32_t)arrlen(node->for_stmt.words));
+    for (int i = 0; i < arrlen(node->for_stmt.words); i++)
+      put_word(buf, node->for_stmt.words[i]);
+    put_u8(buf, node->for_stmt.body != NULL);
+    if (node->for_stmt.body)
+      put_node(buf, node->for_stmt.body);
+    break;
+  case NODE_ARITH:
+    put_str(buf, node->arith.expr);
+    break;
+  }
+}
+
+uint8_t *ast_serialize(ast_node_t *node, size_t *len) {
+  uint8_t *buf = NULL;
+  put_u8(&buf, node != NULL);
+  if (node)
+    put_node(&buf, node);
+
+  // hand out a plain heap buffer rather than a stb_ds array
+  *len = (size_t)arrlen(buf);
+  uint8_t *out = xmalloc(*len);
+  memcpy(out, buf, *len);
+  arrfree(buf);
+  return out;
+}
+
+/* --- DECODING --- */
+
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool ok;
+} reader_t;
+
+static bool get_bytes(reader_t *r, void *out, size_t len) {
+  if (!r->ok || (size_t)(r->end - r->p) < len) {
+    r->ok = false;
+    return false;
+  }
+  memcpy(out, r->p, len);
+  r->p += len;
+  return true;
+}
+
+static uint8_t get_u8(reader_t *r) {
+  uint8_t v = 0;
+  get_bytes(r, &v, sizeof(v));
+  return v;
+}
+
+static uint32_t get_u32(reader_t *r) {
+  uint32_t v = 0;
+  get_bytes(r, &v, sizeof(v));
+  return v;
+}
+
+// counts are checked against the remaining bytes to reject absurd values
+// before allocating anything
+static uint32_t get_count(reader_t *r) {
+  uint32_t n = get_u32(r);
+  if ((size_t)(r->end - r->p) < n) {
+    r->ok = false;
+    return 0;
+  }
+  return n;
+}
+
+static char *get_str(reader_t *r) {
+  uint32_t len = get_count(r);
+  if (!r->ok)
+    return NULL;
+  char *s = xstrdup_n((const char *)r->p, len);
+  r->p += len;
+  return s;
+}
+
+static word_part_t *get_word(reader_t *r) {
+  word_part_t *parts = NULL;
+  uint32_t n = get_count(r);
+  for (uint32_t i = 0; i < n && r->ok; i++) {
+    word_part_t part = {0};
+    uint8_t type = get_u8(r);
+    uint8_t quote = get_u8(r);
+    if (type > WORD_GLOB_QUAL || quote > QUOTE_DOUBLE)
+      r->ok = false;
+    part.type = (word_part_type_e)type;
+    part.quote = (quote_context_e)quote;
+    part.value = get_str(r);
+    if (!r->ok) {
+      free(part.value);
+      break;
+    }
+    arrpush(parts, part);
+  }
+  return parts;
+}
+
+static ast_node_t *get_node(reader_t *r, int depth) {
+  if (depth > AST_SERIAL_MAX_DEPTH) {
+    r->ok = false;
+    return NULL;
+  }
+
+  uint8_t type = get_u8(r);
+  if (!r->ok || type > NODE_ARITH) {
+    r->ok = false;
+    return NULL;
+  }
+
+  ast_node_t *node = xcalloc(1, sizeof(ast_node_t));
+  node->type = (ast_node_type_e)type;
+
+  switch (node->type) {
+  case NODE_CMD: {
+    cmd_node_t *cmd = &node->cmd;
+    cmd->is_bg = get_u8(r) != 0;
+    cmd->raw_str = get_str(r);
+
+    uint32_t argc = get_count(r);
+    for (uint32_t i = 0; i < argc && r->ok; i++)
+      arrpush(cmd->argv_parts, get_word(r));
+
+    uint32_t nredir = get_count(r);
+    for (uint32_t i = 0; i < nredir && r->ok; i++) {
+      redirection_t redir = {0};
+      redir.fd = (int)get_u32(r);
+      uint8_t redir_type = get_u8(r);
+      if (redir_type >= REDIR_NONE)
+        r->ok = false;
+      redir.type = (redirection_e)redir_type;
+      redir.target_parts = get_word(r);
+      arrpush(cmd->redir, redir);
+    }
+    break;
+  }
+  case NODE_PIPELINE: {
+    uint32_t n = get_count(r);
+    for (uint32_t i = 0; i < n && r->ok; i++) {
+      ast_node_t *child = get_node(r, depth + 1);
+      if (child)
+        arrpush(node->pipe.nodes, child);
+    }
+    break;
+  }
+  case NODE_CONDITIONAL:
+    node->cond.op = get_u8(r) == COND_OR ? COND_OR : COND_AND;
+    node->cond.left = get_node(r, depth + 1);
+    node->cond.right = get_node(r, depth + 1);
+    break;
+  case NODE_SEQUENCE: {
+    uint32_t n = get_count(r);
+    for (uint32_t i = 0; i < n && r->ok; i++) {
+      ast_node_t *child = get_node(r, depth + 1);
+      if (child)
+        arrpush(node->seq.nodes, child);
+    }
+    break;
+  }
+  case NODE_CASE: {
+    node->case_stmt.word = get_word(r);
+    uint32_t n = get_count(r);
+    for (uint32_t i = 0; i < n && r->ok; i++) {
+      case_item_t item = {0};
+      uint32_t npatterns = get_count(r);
+      for (uint32_t j = 0; j < npatterns && r->ok; j++)
+        arrpush(item.patterns, get_word(r));
+      if (get_u8(r))
+        item.body = get_node(r, depth + 1);
+      arrpush(node->case_stmt.items, item);
+    }
+    break;
+  }
+  case NODE_FOR: {
+    node->for_stmt.var = get_str(r);
+    uint32_t n = get_count(r);
+    for (uint32_t i = 0; i < n && r->ok; i++)
+      arrpush(node->for_stmt.words, get_word(r));
+    if (get_u8(r))
+      node->for_stmt.body = get_node(r, depth + 1);
+    break;
+  }
+  case NODE_ARITH:
+    node->arith.expr = get_str(r);
+    break;
+  }
+
+  if (!r->ok) {
+    parser_free_ast(node);
+    return NULL;
+  }
+  return node;
+}
+
+ast_node_t *ast_deserialize(const uint8_t *buf, size_t len, bool *ok) {
+  reader_t r = {.p = buf, .end = buf + len, .ok = true};
+
+  ast_node_t *root = NULL;
+  if (get_u8(&r))
+    root = get_node(&r, 0);
+
+  // trailing garbage means the data was not produced by ast_serialize()
+  if (r.ok && r.p != r.end) {
+    r.ok = false;
+    parser_free_ast(root);
+    root = NULL;
+  }
+
+  *ok = r.ok;
+  return root;
+}
@@ -0,0 +1,44 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __AST_SERIAL_H__
+#define __AST_SERIAL_H__
+
+#include "parser/parser.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compact binary form of a pre-expansion AST, used to cache parsed scripts
+ * on disk. Integers are stored in host byte order: caches are local to the
+ * machine and a foreign byte order is rejected by the magic number check of
+ * the cache header.
+ *
+ * Bump AST_SERIAL_VERSION whenever the encoding of a node changes.
+ */
+#define AST_SERIAL_VERSION 8
+
+/**
+ * @brief Serializes the AST.
+ * @param node root of the AST (may be NULL for an empty script)
+ * @param len set to the size of the returned buffer
+ * @return heap-allocated buffer holding the encoded tree
+ */
+uint8_t *ast_serialize(ast_node_t *node, size_t *len);
+
+/**
+ * @brief Rebuilds an AST from its serialized form.
+ * Every read is bounds-checked so that truncated or corrupted data is
+ * rejected instead of trusted.
+ * @param buf the encoded tree
+ * @param len size of buf
+ * @param ok set to false if the data is invalid
+ * @return the rebuilt AST, NULL for an empty script or invalid data
+ */
+ast_node_t *ast_deserialize(const uint8_t *buf, size_t len, bool *ok);
+
+#endif // __AST_SERIAL_H__
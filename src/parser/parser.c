@@ -7,16 +7,21 @@
  */
 
 #include "parser.h"
-
-static token_t g_tok = {.type = TOK_EOF, .raw_value = NULL, .parts = NULL};
+#include <ctype.h>
 
 /**
  * @brief Simple wrapper to get the next token from the lexer
- * @param lex pointer to the lexer
+ * @param p pointer to the parser context
  */
-static inline void next_token(lexer_t *lex) {
-  lexer_free_token(&g_tok);
-  g_tok = lexer_next_token(lex);
+static inline void next_token(parser_t *p) {
+  lexer_free_token(&p->tok);
+  p->tok = lexer_next_token(p->lex);
+}
+
+// newlines are allowed after '|', '&&' and '||' and around commands
+static inline void skip_newlines(parser_t *p) {
+  while (p->tok.type == TOK_NEWLINE)
+    next_token(p);
 }
 
 static word_part_t *duplicate_word_parts(word_part_t *parts) {
@@ -41,45 +46,97 @@ static word_part_t *duplicate_word_parts(word_part_t *parts) {
  * Duplicates each argument string into argv_buf, resizing it as needed.
  * The array is NULL-terminated for exec-family functions.
  *
- * @param lex            lexer instance.
+ * @param p              parser context.
  * @return Number of parsed arguments (excluding NULL).
  */
-static word_part_t **parse_arguments(lexer_t *lex) {
+static word_part_t **parse_arguments(parser_t *p) {
   word_part_t **argv_parts = NULL;
 
-  while (g_tok.type == TOK_WORD) {
-    arrpush(argv_parts, duplicate_word_parts(g_tok.parts));
-    next_token(lex);
+  while (p->tok.type == TOK_WORD) {
+    arrpush(argv_parts, duplicate_word_parts(p->tok.parts));
+    next_token(p);
   }
 
   return argv_parts;
 }
 
+/**
+ * @brief Reads the body of the here-document delimited by the current word.
+ * The body is expanded like a double-quoted word, unless a part of the
+ * delimiter is quoted: it is then kept literal.
+ */
+static word_part_t *parse_heredoc_body(parser_t *p, bool strip_tabs) {
+  token_t *tok = &p->tok;
+  bool quoted = strpbrk(tok->raw_value, "'\"\\") != NULL;
+
+  // the delimiter is the word with its quotes removed, a word holding
+  // expansions stands for itself
+  bool literal = arrlen(tok->parts) > 0;
+  for (int i = 0; i < arrlen(tok->parts); i++)
+    literal &= tok->parts[i].type == WORD_LITERAL;
+
+  char *delim = NULL;
+  if (literal) {
+    for (int i = 0; i < arrlen(tok->parts); i++) {
+      size_t len = strlen(tok->parts[i].value);
+      memcpy(arraddnptr(delim, len), tok->parts[i].value, len);
+    }
+  } else {
+    size_t len = strlen(tok->raw_value);
+    memcpy(arraddnptr(delim, len), tok->raw_value, len);
+  }
+  arrpush(delim, '\0');
+
+  char *body = lexer_read_heredoc(p->lex, delim, strip_tabs);
+  arrfree(delim);
+  if (*body == '\0') {
+    free(body);
+    return NULL;
+  }
+
+  word_part_t *parts = NULL;
+  if (quoted) {
+    word_part_t part = {WORD_LITERAL, QUOTE_SINGLE, body};
+    arrput(parts, part);
+  } else {
+    parts = lexer_heredoc_parts(body, strlen(body));
+    free(body);
+  }
+  return parts;
+}
+
+static void syntax_error(parser_t *p, const char *msg) {
+  fprintf(stderr, "Syntax error: %s\n", msg);
+  p->error = true;
+}
+
 /**
  * @brief brief Parse I/O redirections (e.g., <, >, >>, 2>) from the lexer.
  * Fills redir_buf with redirection entries, resizing as needed.
  * Each target filename is duplicated for later use.
  *
- * @param lex              lexer instance.
- * @throw exit the program if the redirection is malformed
- * @return Number of parsed redirections.
+ * @param p                parser context.
+ * @return Parsed redirections, p->error is set if one is malformed.
  */
-static redirection_t *parse_redirection(lexer_t *lex) {
+static redirection_t *parse_redirection(parser_t *p) {
   redirection_t *redir = NULL;
 
   // parse redirections that should appear as : [FD] REDIR_TYPE FILENAME
-  while (g_tok.type == TOK_FD || g_tok.type == TOK_REDIR_IN ||
-         g_tok.type == TOK_REDIR_OUT || g_tok.type == TOK_REDIR_APPEND) {
+  while (p->tok.type == TOK_FD || p->tok.type == TOK_REDIR_IN ||
+         p->tok.type == TOK_REDIR_OUT || p->tok.type == TOK_REDIR_APPEND ||
+         p->tok.type == TOK_HEREDOC || p->tok.type == TOK_HEREDOC_STRIP ||
+         p->tok.type == TOK_HERESTRING) {
     redirection_t r = {0};
+    bool strip_tabs = false;
 
-    if (g_tok.type == TOK_FD) {
+    if (p->tok.type == TOK_FD) {
       // no need to check for errors here as lexer would have handled it
-      r.fd = (int)strtol(g_tok.raw_value, NULL, 10);
-      next_token(lex);
+      r.fd = (int)strtol(p->tok.raw_value, NULL, 10);
+      next_token(p);
     }
 
     // determine redirection type and set default fd if not specified
-    switch (g_tok.type) {
+    switch (p->tok.type) {
     case TOK_REDIR_IN:
       r.type = REDIR_IN;
       break;
@@ -95,82 +152,291 @@ static redirection_t *parse_redirection(lexer_t *lex) {
         r.fd = 1;
       break;
     }
+    case TOK_HEREDOC_STRIP:
+      strip_tabs = true;
+      r.type = REDIR_HEREDOC;
+      break;
+    case TOK_HEREDOC:
+      r.type = REDIR_HEREDOC;
+      break;
+    case TOK_HERESTRING:
+      r.type = REDIR_HERESTRING;
+      break;
     default:
-      fprintf(stderr, "Unexpected token type %d in redirection\n", g_tok.type);
-      exit(EXIT_FAILURE);
+      // parsing may run on a worker thread, an error must not exit
+      syntax_error(p, "expected a redirection after a file descriptor");
+      return redir;
     }
 
-    next_token(lex);
+    next_token(p);
 
-    if (g_tok.type != TOK_WORD) {
-      fprintf(stderr, "Expected filename after redirection\n");
-      exit(EXIT_FAILURE);
+    if (p->tok.type != TOK_WORD) {
+      syntax_error(p, "expected filename after redirection");
+      return redir;
     }
 
-    // same reason as argv, need to xxstrdup
-    r.target_parts = duplicate_word_parts(g_tok.parts);
+    // the body of a here-document replaces its delimiter, it must be read
+    // before the lexer moves past the delimiter
+    if (r.type == REDIR_HEREDOC)
+      r.target_parts = parse_heredoc_body(p, strip_tabs);
+    else // same reason as argv, need to xxstrdup
+      r.target_parts = duplicate_word_parts(p->tok.parts);
     arrpush(redir, r);
-    next_token(lex);
+    next_token(p);
   }
   return redir;
 }
 
+// keywords are only recognized unquoted, where a command name is expected
+static inline bool is_keyword(parser_t *p, const char *kw) {
+  return p->tok.type == TOK_WORD && strcmp(p->tok.raw_value, kw) == 0;
+}
+
+/**
+ * @brief What ends a list besides the end of the input.
+ */
+typedef enum {
+  LIST_TOP,  /**< Nothing, the list is the whole input */
+  LIST_CASE, /**< ';;' or 'esac', body of a case clause */
+  LIST_DO    /**< 'done', body of a loop */
+} list_ctx_e;
+
+static ast_node_t *parse_list(parser_t *p, list_ctx_e ctx);
+
+/**
+ * @brief Parse 'case word in [(]pattern [| pattern]...) list ;; ... esac'.
+ * The ';;' of the last clause is optional.
+ * @param p pointer to the parser context
+ * @return pointer to the case node or NULL on a syntax error
+ */
+static ast_node_t *parse_case(parser_t *p) {
+  next_token(p); // skip 'case'
+  if (p->tok.type != TOK_WORD) {
+    syntax_error(p, "expected a word after 'case'");
+    return NULL;
+  }
+
+  ast_node_t *node = xcalloc(1, sizeof(ast_node_t));
+  node->type = NODE_CASE;
+  node->case_stmt.word = duplicate_word_parts(p->tok.parts);
+  next_token(p);
+  skip_newlines(p);
+
+  if (!is_keyword(p, "in")) {
+    syntax_error(p, "expected 'in' after the word of 'case'");
+    goto fail;
+  }
+  next_token(p);
+  skip_newlines(p);
+
+  while (!is_keyword(p, "esac")) {
+    if (p->tok.type == TOK_LPAREN)
+      next_token(p);
+
+    case_item_t item = {0};
+    arrpush(node->case_stmt.items, item);
+    case_item_t *it = &arrlast(node->case_stmt.items);
+    do {
+      if (arrlen(it->patterns) > 0)
+        next_token(p); // skip '|'
+      if (p->tok.type != TOK_WORD) {
+        syntax_error(p, "expected a pattern in 'case'");
+        goto fail;
+      }
+      arrpush(it->patterns, duplicate_word_parts(p->tok.parts));
+      next_token(p);
+    } while (p->tok.type == TOK_PIPE);
+
+    if (p->tok.type != TOK_RPAREN) {
+      syntax_error(p, "expected ')' after a pattern of 'case'");
+      goto fail;
+    }
+    next_token(p);
+
+    it->body = parse_list(p, LIST_CASE);
+    if (p->error)
+      goto fail;
+    if (p->tok.type == TOK_DSEMI) {
+      next_token(p);
+      skip_newlines(p);
+    } else if (!is_keyword(p, "esac")) {
+      syntax_error(p, "expected ';;' or 'esac' in 'case'");
+      goto fail;
+    }
+  }
+
+  next_token(p); // skip 'esac'
+  return node;
+
+fail:
+  parser_free_ast(node);
+  return NULL;
+}
+
+static bool is_name(const char *s) {
+  if (!isalpha((unsigned char)*s) && *s != '_')
+    return false;
+  while (*++s) {
+    if (!isalnum((unsigned char)*s) && *s != '_')
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Parse 'for name [in word...] ; do list ; done'. Without 'in' the
+ * loop runs over nothing, positional parameters do not exist.
+ * @param p pointer to the parser context
+ * @return pointer to the for node or NULL on a syntax error
+ */
+static ast_node_t *parse_for(parser_t *p) {
+  next_token(p); // skip 'for'
+  if (p->tok.type != TOK_WORD || arrlen(p->tok.parts) != 1 ||
+      p->tok.parts[0].type != WORD_LITERAL ||
+      p->tok.parts[0].quote != QUOTE_NONE || !is_name(p->tok.raw_value)) {
+    syntax_error(p, "expected a variable name after 'for'");
+    return NULL;
+  }
+
+  ast_node_t *node = xcalloc(1, sizeof(ast_node_t));
+  node->type = NODE_FOR;
+  node->for_stmt.var = xstrdup(p->tok.raw_value);
+  next_token(p);
+  skip_newlines(p);
+
+  if (is_keyword(p, "in")) {
+    next_token(p);
+    while (p->tok.type == TOK_WORD) {
+      arrpush(node->for_stmt.words, duplicate_word_parts(p->tok.parts));
+      next_token(p);
+    }
+  }
+  if (p->tok.type == TOK_SEMI)
+    next_token(p);
+  skip_newlines(p);
+
+  if (!is_keyword(p, "do")) {
+    syntax_error(p, "expected 'do' in 'for'");
+    goto fail;
+  }
+  next_token(p);
+
+  node->for_stmt.body = parse_list(p, LIST_DO);
+  if (p->error)
+    goto fail;
+  if (!is_keyword(p, "done")) {
+    syntax_error(p, "expected 'done' to close 'for'");
+    goto fail;
+  }
+  next_token(p); // skip 'done'
+  return node;
+
+fail:
+  parser_free_ast(node);
+  return NULL;
+}
+
+/**
+ * @brief Parse '(( expression ))', the lexer already isolated the expression.
+ * @param p pointer to the parser context
+ * @return pointer to the arithmetic node
+ */
+static ast_node_t *parse_arith(parser_t *p) {
+  ast_node_t *node = xcalloc(1, sizeof(ast_node_t));
+  node->type = NODE_ARITH;
+  node->arith.expr = xstrdup(p->tok.raw_value);
+  next_token(p);
+  return node;
+}
+
 /**
  * @brief Parse a simple command from the lexer
- * @param lex pointer to the lexer
+ * @param p pointer to the parser context
  * @return pointer to the parsed AST node representing the command
  */
-static ast_node_t *parse_command(lexer_t *lex) {
+static ast_node_t *parse_command(parser_t *p) {
+  if (p->tok.type == TOK_ARITH)
+    return parse_arith(p);
   // safety check
-  if (g_tok.type != TOK_WORD)
+  if (p->tok.type != TOK_WORD)
     return NULL;
 
-  size_t start = lex->pos;
-  word_part_t **argv_parts = parse_arguments(lex);
-  redirection_t *redir = parse_redirection(lex);
+  if (is_keyword(p, "case"))
+    return parse_case(p);
+  if (is_keyword(p, "for"))
+    return parse_for(p);
 
-  char *raw_str = xmalloc(lex->pos - start + 1);
-  strncpy(raw_str, &lex->input[start], lex->pos - start);
-  raw_str[lex->pos - start] = '\0';
+  // the command spans from its first word to the token that ends it
+  lexer_t *lex = p->lex;
+  size_t start = lex->tok_start;
+  word_part_t **argv_parts = parse_arguments(p);
+  redirection_t *redir = parse_redirection(p);
 
-  bool is_bg = g_tok.type == TOK_BG;
+  size_t end = lex->tok_prev_end;
+  char *raw_str = xstrdup_n(&lex->input[start], end - start);
 
-  ast_node_t *ast_node = xmalloc(sizeof(ast_node_t));
+  bool is_bg = p->tok.type == TOK_BG;
+
+  ast_node_t *ast_node = xcalloc(1, sizeof(ast_node_t));
   ast_node->type = NODE_CMD;
   ast_node->cmd = (cmd_node_t){.argv_parts = argv_parts,
                                .argv = NULL,
                                .redir = redir,
                                .raw_str = raw_str,
                                .is_bg = is_bg};
-
+  if (p->error) {
+    parser_free_ast(ast_node);
+    return NULL;
+  }
   return ast_node;
 }
 
 /**
  * @brief Parse a pipeline of commands connected by '|'.
- * @param lex pointer to the lexer
+ * @param p pointer to the parser context
  * @return pointer to the parsed AST node representing the pipeline
  */
-static ast_node_t *parse_pipeline(lexer_t *lex) {
+static ast_node_t *parse_pipeline(parser_t *p) {
 
-  ast_node_t *first_command = parse_command(lex);
-  ast_node_t *node = xmalloc(sizeof(ast_node_t));
+  ast_node_t *first_command = parse_command(p);
+  if (!first_command) {
+    // any other token ends the list, the caller reports it
+    if (!p->error && p->tok.type == TOK_PIPE)
+      syntax_error(p, "expected command before '|'");
+    return NULL;
+  }
+  ast_node_t *node = xcalloc(1, sizeof(ast_node_t));
   node->type = NODE_PIPELINE;
   node->pipe.nodes = NULL;
   arrpush(node->pipe.nodes, first_command);
 
   // Loop to handle multiple piped commands (e.g., cmd1 | cmd2 | cmd3)
-  while (g_tok.type == TOK_PIPE) {
-    next_token(lex);
-    ast_node_t *next_command = parse_command(lex);
+  while (p->tok.type == TOK_PIPE) {
+    next_token(p);
+    skip_newlines(p);
+    ast_node_t *next_command = parse_command(p);
     if (!next_command) {
-      fprintf(stderr, "Syntax error: expected command after '|'\n");
+      if (p->error) {
+        parser_free_ast(node);
+        return NULL;
+      }
+      syntax_error(p, "expected command after '|'");
       parser_free_ast(node);
-      exit(EXIT_FAILURE);
+      return NULL;
     }
     arrpush(node->pipe.nodes, next_command);
   }
 
+  // only simple commands are forked as pipeline stages
+  for (int i = 0; i < arrlen(node->pipe.nodes) && arrlen(node->pipe.nodes) > 1;
+       i++) {
+    if (node->pipe.nodes[i] && node->pipe.nodes[i]->type != NODE_CMD) {
+      syntax_error(p, "compound commands cannot be used in a pipeline");
+      parser_free_ast(node);
+      return NULL;
+    }
+  }
+
   if (arrlen(node->pipe.nodes) == 1) {
     // single command, no pipeline needed
     ast_node_t *single_cmd = node->pipe.nodes[0];
@@ -185,18 +451,26 @@ static ast_node_t *parse_pipeline(lexer_t *lex) {
 /**
  * @brief Parse a conditional command (&& or ||) using the lexer to determine
  * the operator.
- * @param lex pointer to the lexer
+ * @param p pointer to the parser context
  * @return pointer to the parsed AST node representing the conditional command
  */
-static ast_node_t *parse_conditional(lexer_t *lex) {
-  ast_node_t *left = parse_pipeline(lex);
+static ast_node_t *parse_conditional(parser_t *p) {
+  ast_node_t *left = parse_pipeline(p);
 
   // Loop to handle multiple conditionals (e.g., cmd1 && cmd2 || cmd3)
-  while (g_tok.type == TOK_AND || g_tok.type == TOK_OR) {
-    cond_op_e op = g_tok.type == TOK_AND ? COND_AND : COND_OR;
-    next_token(lex);
-    ast_node_t *right = parse_pipeline(lex);
-    ast_node_t *node = xmalloc(sizeof(ast_node_t));
+  while (left && (p->tok.type == TOK_AND || p->tok.type == TOK_OR)) {
+    cond_op_e op = p->tok.type == TOK_AND ? COND_AND : COND_OR;
+    next_token(p);
+    skip_newlines(p);
+    ast_node_t *right = parse_pipeline(p);
+    if (!right) {
+      if (!p->error)
+        syntax_error(p, op == COND_AND ? "expected command after '&&'"
+                                       : "expected command after '||'");
+      parser_free_ast(left);
+      return NULL;
+    }
+    ast_node_t *node = xcalloc(1, sizeof(ast_node_t));
     node->type = NODE_CONDITIONAL;
     node->cond.left = left;
     node->cond.right = right;
@@ -206,38 +480,106 @@ static ast_node_t *parse_conditional(lexer_t *lex) {
   return left;
 }
 
-ast_node_t *parser_create_ast(lexer_t *lex) {
-  next_token(lex);
+/**
+ * @brief Parse a list of conditionals separated by ';', '&' or newlines.
+ * @param p pointer to the parser context
+ * @param ctx compound command the list belongs to, which tells the tokens
+ * ending it
+ * @return pointer to the sequence node or NULL if the list is empty
+ */
+static ast_node_t *parse_list(parser_t *p, list_ctx_e ctx) {
+  ast_node_t *seq_node = NULL;
+  bool in_case = ctx == LIST_CASE;
+
+  while (1) {
+    skip_newlines(p);
+    if (p->tok.type == TOK_EOF ||
+        (in_case && (p->tok.type == TOK_DSEMI || is_keyword(p, "esac"))) ||
+        (ctx == LIST_DO && is_keyword(p, "done")))
+      break;
 
-  if (g_tok.type == TOK_EOF) {
-    // g_tok.value is empty no need to free memory
+    ast_node_t *next_command = parse_conditional(p);
+    if (next_command == NULL)
+      break;
+
+    if (!seq_node) {
+      seq_node = xcalloc(1, sizeof(ast_node_t));
+      seq_node->type = NODE_SEQUENCE;
+    }
+    arrpush(seq_node->seq.nodes, next_command);
+
+    // consume any number of consecutive separators (; & or newlines), e.g.
+    // "&;" or ";;" or "&;&" (';;' only ends a case clause)
+    while (p->tok.type == TOK_SEMI || p->tok.type == TOK_BG ||
+           p->tok.type == TOK_NEWLINE ||
+           (!in_case && p->tok.type == TOK_DSEMI)) {
+      next_token(p);
+    }
+  }
+  return seq_node;
+}
+
+ast_node_t *parser_parse(parser_t *p) {
+  next_token(p);
+  skip_newlines(p);
+
+  if (p->tok.type == TOK_EOF) {
+    // p->tok.value is empty no need to free memory
     return NULL;
   }
 
-  ast_node_t *root_node = xmalloc(sizeof(ast_node_t));
-  // Initial allocation for dynamic array of sequence nodes
-  root_node->type = NODE_SEQUENCE;
-  root_node->seq.nodes = NULL;
+  ast_node_t *root_node = parse_list(p, LIST_TOP);
+  if (!p->error && p->tok.type != TOK_EOF) {
+    char buf[128];
+    lexer_token_str(p->tok, buf, sizeof(buf));
+    buf[strcspn(buf, "\n")] = '\0';
+    fprintf(stderr, "Syntax error: unexpected token %s\n", buf);
+    p->error = true;
+  }
 
-  // using do-while to ensure at least the first node is added
-  do {
-    ast_node_t *next_command = parse_conditional(lex);
-    if (next_command == NULL) {
-      break;
-    }
+  // nothing of an invalid input is executed
+  if (p->error) {
+    parser_free_ast(root_node);
+    root_node = NULL;
+  }
 
-    arrpush(root_node->seq.nodes, next_command);
+  lexer_free_token(&p->tok);
+  return root_node;
+}
 
-    // consume any number of consecutive separators (; or &), e.g. "&;" or ";;"
-    // or "&;&"
-    while (g_tok.type == TOK_SEMI || g_tok.type == TOK_BG) {
-      next_token(lex);
-    }
-  } while (g_tok.type != TOK_EOF);
+ast_node_t *parser_create_ast(lexer_t *lex) {
+  parser_t p = {.lex = lex,
+                .tok = {.type = TOK_EOF, .raw_value = NULL, .parts = NULL}};
+  return parser_parse(&p);
+}
 
-  lexer_free_token(&g_tok);
+void parser_free_word_parts(word_part_t *parts) {
+  for (int i = 0; i < arrlen(parts); i++)
+    free(parts[i].value);
+  arrfree(parts);
+}
 
-  return root_node;
+void parser_free_argv(cmd_node_t *cmd) {
+  if (cmd->argv_arena) {
+    free(cmd->argv_arena);
+  } else {
+    for (int i = 0; i < arrlen(cmd->argv); i++)
+      free(cmd->argv[i]);
+  }
+  arrfree(cmd->argv);
+  cmd->argv = NULL;
+  cmd->argv_arena = NULL;
+}
+
+void parser_free_word_memo(word_memo_t *memo) {
+  for (int i = 0; i < arrlen(memo->fields); i++)
+    free(memo->fields[i]);
+  arrfree(memo->fields);
+  for (int i = 0; i < arrlen(memo->deps); i++)
+    free(memo->deps[i].name);
+  arrfree(memo->deps);
+  free(memo->dir);
+  *memo = (word_memo_t){0};
 }
 
 void parser_free_ast(ast_node_t *node) {
@@ -257,16 +599,18 @@ void parser_free_ast(ast_node_t *node) {
     }
     arrfree(cmd.argv_parts);
 
-    for (int i = 0; i < arrlen(cmd.argv); i++) {
-      free(cmd.argv[i]);
-    }
-    arrfree(cmd.argv);
+    for (int i = 0; i < arrlen(cmd.argv_memo); i++)
+      parser_free_word_memo(&cmd.argv_memo[i]);
+    arrfree(cmd.argv_memo);
+
+    parser_free_argv(&cmd);
 
     for (int i = 0; i < arrlen(cmd.redir); i++) {
       for (int j = 0; j < arrlen(cmd.redir[i].target_parts); j++) {
         free(cmd.redir[i].target_parts[j].value);
       }
       arrfree(cmd.redir[i].target_parts);
+      parser_free_word_memo(&cmd.redir[i].target_memo);
 
       if (cmd.redir[i].target) {
         free(cmd.redir[i].target);
@@ -274,6 +618,7 @@ void parser_free_ast(ast_node_t *node) {
     }
     arrfree(cmd.redir);
     free(cmd.raw_str);
+    free(cmd.exec_path);
     break;
   }
   case NODE_PIPELINE:
@@ -294,6 +639,34 @@ void parser_free_ast(ast_node_t *node) {
     }
     arrfree(node->seq.nodes);
     break;
+  case NODE_CASE: {
+    case_node_t *c = &node->case_stmt;
+    parser_free_word_parts(c->word);
+    parser_free_word_memo(&c->word_memo);
+    for (int i = 0; i < arrlen(c->items); i++) {
+      for (int j = 0; j < arrlen(c->items[i].patterns); j++)
+        parser_free_word_parts(c->items[i].patterns[j]);
+      arrfree(c->items[i].patterns);
+      parser_free_ast(c->items[i].body);
+    }
+    arrfree(c->items);
+    break;
+  }
+  case NODE_FOR: {
+    for_node_t *f = &node->for_stmt;
+    free(f->var);
+    for (int i = 0; i < arrlen(f->words); i++)
+      parser_free_word_parts(f->words[i]);
+    arrfree(f->words);
+    for (int i = 0; i < arrlen(f->memos); i++)
+      parser_free_word_memo(&f->memos[i]);
+    arrfree(f->memos);
+    parser_free_ast(f->body);
+    break;
+  }
+  case NODE_ARITH:
+    free(node->arith.expr);
+    break;
   default:
     return;
   }
@@ -356,7 +729,9 @@ static void rec_ast(ast_node_t *node, int indent, char ***lines) {
         const char *redir_op = (r.type == REDIR_IN)       ? "<"
                                : (r.type == REDIR_OUT)    ? ">"
                                : (r.type == REDIR_APPEND) ? ">>"
-                                                          : "?";
+                               : (r.type == REDIR_HEREDOC)    ? "<<"
+                               : (r.type == REDIR_HERESTRING) ? "<<<"
+                                                              : "?";
         if (r.target) {
           snprintf(buf, sizeof(buf), "%*s[%d%s %s]", indent + 2, "", r.fd,
                    redir_op, r.target);
@@ -409,6 +784,52 @@ static void rec_ast(ast_node_t *node, int indent, char ***lines) {
     for (int i = 0; i < arrlen(node->seq.nodes); i++)
       rec_ast(node->seq.nodes[i], indent + 2, lines);
     break;
+
+  case NODE_CASE: {
+    char part_buf[512] = {0};
+    for (int j = 0; j < arrlen(node->case_stmt.word); j++) {
+      char *tmp = raw_part_to_str(&node->case_stmt.word[j]);
+      strncat(part_buf, tmp, sizeof(part_buf) - strlen(part_buf) - 1);
+      free(tmp);
+    }
+    snprintf(buf, sizeof(buf), "%*sCASE %s", indent, "", part_buf);
+    arrpush(*lines, xstrdup(buf));
+
+    for (int i = 0; i < arrlen(node->case_stmt.items); i++) {
+      case_item_t *item = &node->case_stmt.items[i];
+      part_buf[0] = '\0';
+      for (int k = 0; k < arrlen(item->patterns); k++) {
+        for (int j = 0; j < arrlen(item->patterns[k]); j++) {
+          char *tmp = raw_part_to_str(&item->patterns[k][j]);
+          strncat(part_buf, tmp, sizeof(part_buf) - strlen(part_buf) - 1);
+          free(tmp);
+        }
+      }
+      snprintf(buf, sizeof(buf), "%*sPATTERN %s", indent + 2, "", part_buf);
+      arrpush(*lines, xstrdup(buf));
+      rec_ast(item->body, indent + 4, lines);
+    }
+  } break;
+
+  case NODE_FOR: {
+    char part_buf[512] = {0};
+    for (int k = 0; k < arrlen(node->for_stmt.words); k++) {
+      for (int j = 0; j < arrlen(node->for_stmt.words[k]); j++) {
+        char *tmp = raw_part_to_str(&node->for_stmt.words[k][j]);
+        strncat(part_buf, tmp, sizeof(part_buf) - strlen(part_buf) - 1);
+        free(tmp);
+      }
+    }
+    snprintf(buf, sizeof(buf), "%*sFOR %s IN %s", indent, "",
+             node->for_stmt.var, part_buf);
+    arrpush(*lines, xstrdup(buf));
+    rec_ast(node->for_stmt.body, indent + 2, lines);
+  } break;
+
+  case NODE_ARITH:
+    snprintf(buf, sizeof(buf), "%*sARITH %s", indent, "", node->arith.expr);
+    arrpush(*lines, xstrdup(buf));
+    break;
   }
 }
 
@@ -423,9 +844,7 @@ char *parser_ast_str(ast_node_t *node, int indent) {
   for (int i = 0; i < arrlen(lines); i++)
     total_len += strlen(lines[i]) + 1;
 
-  char *out = malloc(total_len + 1);
-  if (!out)
-    exit(EXIT_FAILURE);
+  char *out = xmalloc(total_len + 1);
   out[0] = '\0';
 
   for (int i = 0; i < arrlen(lines); i++) {
@@ -12,8 +12,44 @@
 #include "utils/collections.h"
 #include "utils/log.h"
 #include "utils/system/memory.h"
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
 
-typedef enum { REDIR_IN, REDIR_OUT, REDIR_APPEND, REDIR_NONE } redirection_e;
+typedef enum {
+  REDIR_IN,
+  REDIR_OUT,
+  REDIR_APPEND,
+  REDIR_HEREDOC,    /**< <<, <<-: target holds the body */
+  REDIR_HERESTRING, /**< <<<: the body is target and a newline */
+  REDIR_NONE
+} redirection_e;
+
+/**
+ * @brief Variable a memoized expansion depends on, with the generation it had
+ * when the expansion was computed.
+ */
+typedef struct {
+  char *name;
+  uint64_t gen;
+} var_dep_t;
+
+/**
+ * @brief Memoized expansion of a word, reused as long as the variables it
+ * references keep their generation and, for globs, as long as the searched
+ * directory keeps its identity and mtime.
+ * @note fields, deps and their names are owned by the memo.
+ */
+typedef struct {
+  bool valid;
+  char **fields;   /**< Expanded fields of the word */
+  var_dep_t *deps; /**< Referenced variables */
+  bool has_dir;    /**< The word was globbed in dir */
+  char *dir;
+  dev_t dir_dev;
+  ino_t dir_ino;
+  struct timespec dir_mtime;
+} word_memo_t;
 
 /**
  * Structure representing a redirection in a command.
@@ -25,6 +61,7 @@ typedef struct {
   redirection_e type;
   word_part_t *target_parts;
   char *target;
+  word_memo_t target_memo;
 } redirection_t;
 
 /**
@@ -36,11 +73,26 @@ typedef struct {
  */
 typedef struct {
   word_part_t **argv_parts;
+  word_memo_t *argv_memo; /**< Memoized expansion of each word of argv_parts,
+                             allocated by the expander */
   char **argv; /**<  Argument vector (command and its arguments,
                   NULL-terminated). */
+  char *argv_arena; /**< Buffer holding the strings of argv when they were
+                       packed by the expander, NULL if allocated one by one */
+  size_t argv_spread; /**< Index in argv of the arguments that a batch splits
+                         (see expand_argv_parts()), 0 if none */
+  size_t argv_spread_end; /**< End of the arguments that a batch splits, the
+                             ones after it are repeated in every chunk */
   redirection_t *redir;
   char *raw_str; /**<  Original command string for reference. */
   bool is_bg;    /**<  Indicates if the command will run in the background. */
+
+  /* Set by expander_static_pass() for commands made of literal words only:
+   * argv and redirection targets are built once and never expanded again. */
+  bool is_static;
+  int (*builtin)(int argc, char *argv[]); /**< Resolved builtin, if any */
+  char *exec_path;        /**< Resolved executable path, filled lazily */
+  uint64_t exec_path_gen; /**< Command hash generation of exec_path */
 } cmd_node_t;
 
 /**
@@ -71,6 +123,46 @@ typedef struct {
   struct ast_node_t **nodes;
 } seq_node_t;
 
+/**
+ * @brief One 'pattern | pattern) list ;;' clause of a case command.
+ */
+typedef struct {
+  word_part_t **patterns;
+  struct ast_node_t *body; /**< Sequence run on a match, NULL if empty */
+} case_item_t;
+
+/**
+ * @brief AST node representing 'case word in ... esac'. The word and the
+ * patterns are expanded when the command runs, the first clause with a
+ * matching pattern is executed.
+ */
+typedef struct {
+  word_part_t *word;
+  word_memo_t word_memo; /**< Memoized expansion of word */
+  case_item_t *items;
+} case_node_t;
+
+/**
+ * @brief AST node representing 'for name in words; do list; done'. The words
+ * are expanded when the loop runs, brace expansions being enumerated lazily
+ * rather than materialized.
+ */
+typedef struct {
+  char *var;
+  word_part_t **words;
+  word_memo_t *memos;      /**< Memoized expansion of each word, allocated
+                              by the executor */
+  struct ast_node_t *body; /**< Sequence run for each field, NULL if empty */
+} for_node_t;
+
+/**
+ * @brief AST node representing '(( expression ))'. The expression is compiled
+ * through the arithmetic cache when the command runs.
+ */
+typedef struct {
+  char *expr;
+} arith_cmd_node_t;
+
 /**
  * @brief Enumeration of AST node types to distinguish ast_node_t variants.
  */
@@ -78,13 +170,16 @@ typedef enum {
   NODE_CMD,
   NODE_PIPELINE,
   NODE_CONDITIONAL,
-  NODE_SEQUENCE
+  NODE_SEQUENCE,
+  NODE_CASE,
+  NODE_FOR,
+  NODE_ARITH
 } ast_node_type_e;
 
 /**
  * @brief Abstract Syntax Tree (AST) node structure.
- * Represents different types of nodes: command, pipeline, conditional, and
- * sequence.
+ * Represents different types of nodes: command, pipeline, conditional,
+ * sequence, case, for and arithmetic command.
  */
 typedef struct ast_node_t {
   ast_node_type_e type;
@@ -93,19 +188,66 @@ typedef struct ast_node_t {
     pipe_node_t pipe;
     cond_node_t cond;
     seq_node_t seq;
+    case_node_t case_stmt;
+    for_node_t for_stmt;
+    arith_cmd_node_t arith;
   };
   bool invalid; /**< Indicates if the node is invalid due to a parsing error */
 } ast_node_t;
 
+/**
+ * @brief Parser context. Holds the lexer and the current lookahead token so
+ * that several parsers can run concurrently on different inputs.
+ */
+typedef struct {
+  lexer_t *lex;
+  token_t tok; /**< Current token, owned by the parser */
+  bool error;  /**< Set on a syntax error, the partial tree is discarded */
+} parser_t;
+
 /**
  * @brief Parses the input tokens into an Abstract Syntax Tree (AST)
  * representing a sequence of commands. Recursively calls other parsing
  * functions according to the grammar.
+ * @param p Pointer to the parser context.
+ * @return Pointer to the root AST node representing the sequence.
+ */
+ast_node_t *parser_parse(parser_t *p);
+
+/**
+ * @brief Convenience wrapper around parser_parse() using a temporary parser
+ * context on the given lexer.
  * @param lex Pointer to the lexer.
  * @return Pointer to the root AST node representing the sequence.
  */
 ast_node_t *parser_create_ast(lexer_t *lex);
 
+/**
+ * @brief Parses a whole script. Large scripts are split at top-level
+ * statement boundaries and the chunks are parsed on a thread pool, the
+ * resulting sequences are stitched back together in order.
+ * @param script The script source.
+ * @param len Length of the script in bytes.
+ * @param error Set to whether the script has a syntax error, may be NULL.
+ * @return Pointer to the root sequence node or NULL for an empty script or
+ * a syntax error.
+ */
+ast_node_t *parser_parse_script(const char *script, size_t len, bool *error);
+
+/**
+ * @brief Returns the offset right after the first top-level statement
+ * boundary at or after from, or len if there is none.
+ * A boundary is an unquoted, unescaped newline outside of a comment that does
+ * not follow an operator expecting a continuation ('|', '||', '&&') and is
+ * not inside a 'case ... esac', a 'for ... done' or a command or process
+ * substitution.
+ * Here-document bodies are part of the statement of their operator.
+ * @param s The script source.
+ * @param len Length of the script in bytes.
+ * @param from Offset of a previous boundary, or 0.
+ */
+size_t parser_next_boundary(const char *s, size_t len, size_t from);
+
 /**
  * @brief Frees the memory allocated for the AST.
  * Recursively frees all child nodes and associated resources.
@@ -114,6 +256,24 @@ ast_node_t *parser_create_ast(lexer_t *lex);
  */
 void parser_free_ast(ast_node_t *node);
 
+/**
+ * @brief Frees the parts of a word and their values.
+ * @param parts stb_ds array of parts (may be NULL)
+ */
+void parser_free_word_parts(word_part_t *parts);
+
+/**
+ * @brief Frees the argument vector of a command, whether its strings live in
+ * the arena or were allocated one by one, and resets both.
+ */
+void parser_free_argv(cmd_node_t *cmd);
+
+/**
+ * @brief Releases the content of a word memo and marks it invalid.
+ * @param memo Pointer to the memo, the structure itself is not freed.
+ */
+void parser_free_word_memo(word_memo_t *memo);
+
 /**
  * @brief Prints the AST in a human-readable format for debugging purposes.
  * @param node Pointer to the root AST node.
@@ -0,0 +1,330 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#include "parser.h"
+#include "utils/thread_pool.h"
+
+// scripts smaller than this are parsed serially
+#define PARSER_PARALLEL_MIN_SIZE (64 * 1024)
+// minimal size of a chunk handed to a worker
+#define PARSER_CHUNK_SIZE (16 * 1024)
+#define PARSER_MAX_THREADS 8
+
+typedef struct {
+  const char *src;
+  size_t len;
+  ast_node_t *ast;
+  bool error; /**< The chunk has a syntax error */
+} parse_chunk_t;
+
+typedef struct {
+  size_t start; /**< Offset of the delimiter word */
+  size_t len;
+  bool strip_tabs;
+} heredoc_delim_t;
+
+/**
+ * @brief Reads the delimiter word of a here-document, starting at i right
+ * after '<<' or '<<-'.
+ * @return offset right after the word
+ */
+static size_t scan_heredoc_delim(const char *s, size_t len, size_t i,
+                                 heredoc_delim_t *d) {
+  while (i < len && (s[i] == ' ' || s[i] == '\t'))
+    i++;
+  d->start = i;
+  while (i < len && !strchr(" \t\r\n;&|()<>", s[i]))
+    i++;
+  d->len = i - d->start;
+  return i;
+}
+
+// compares a line to a delimiter word whose quotes are not removed yet
+static bool heredoc_delim_matches(const char *s, const heredoc_delim_t *d,
+                                  const char *line, size_t line_len) {
+  size_t k = 0;
+  for (size_t j = d->start; j < d->start + d->len; j++) {
+    if (s[j] == '\'' || s[j] == '"' || s[j] == '\\')
+      continue;
+    if (k == line_len || line[k++] != s[j])
+      return false;
+  }
+  return k == line_len;
+}
+
+/**
+ * @brief Skips the bodies of the pending here-documents, starting at the
+ * line right after the one holding their operators.
+ * @return offset of the line following the last body
+ */
+static size_t skip_heredoc_bodies(const char *s, size_t len, size_t pos,
+                                  const heredoc_delim_t *delims) {
+  for (int k = 0; k < arrlen(delims); k++) {
+    while (pos < len) {
+      const char *line = s + pos;
+      const char *nl = memchr(line, '\n', len - pos);
+      size_t line_len = nl ? (size_t)(nl - line) : len - pos;
+      pos += nl ? line_len + 1 : line_len;
+      while (delims[k].strip_tabs && line_len > 0 && *line == '\t') {
+        line++;
+        line_len--;
+      }
+      if (heredoc_delim_matches(s, &delims[k], line, line_len))
+        break;
+    }
+  }
+  return pos;
+}
+
+size_t parser_next_boundary(const char *s, size_t len, size_t from) {
+  quote_context_e quote = QUOTE_NONE;
+  bool word_start = true;
+  bool pending_op = false;
+  bool cmd_pos = true; /**< The next word is a command name (or keyword) */
+  int case_depth = 0;
+  int for_depth = 0;
+  int subst_depth = 0; /**< Nesting of $(...), <(...) and >(...) */
+  bool in_backquote = false;
+  heredoc_delim_t *heredocs = NULL; /**< Bodies starting at the next line */
+
+  // the scan restarts at a previous boundary so the state is always clean
+  for (size_t i = from; i < len; i++) {
+    char c = s[i];
+
+    if (quote == QUOTE_SINGLE) {
+      if (c == '\'')
+        quote = QUOTE_NONE;
+      continue;
+    }
+
+    if (c == '\\') {
+      // escaped character, including an escaped newline (line continuation)
+      i++;
+      word_start = false;
+      pending_op = false;
+      cmd_pos = false;
+      continue;
+    }
+
+    if (quote == QUOTE_DOUBLE) {
+      if (c == '"')
+        quote = QUOTE_NONE;
+      continue;
+    }
+
+    // keywords only count where a command name is expected
+    if (word_start && cmd_pos && isalpha((unsigned char)c)) {
+      size_t end = i;
+      while (end < len && isalpha((unsigned char)s[end]))
+        end++;
+      bool delimited = end == len || strchr(" \t\r\n;&|()", s[end]);
+      if (delimited && end - i == 4 && strncmp(s + i, "case", 4) == 0)
+        case_depth++;
+      else if (delimited && end - i == 4 && strncmp(s + i, "esac", 4) == 0 &&
+               case_depth > 0)
+        case_depth--;
+      else if (delimited && end - i == 3 && strncmp(s + i, "for", 3) == 0)
+        for_depth++;
+      else if (delimited && end - i == 4 && strncmp(s + i, "done", 4) == 0 &&
+               for_depth > 0)
+        for_depth--;
+
+      // the body of a loop starts with a command
+      if (delimited && end - i == 2 && strncmp(s + i, "do", 2) == 0) {
+        i = end - 1;
+        word_start = false;
+        pending_op = false;
+        continue;
+      }
+    }
+
+    switch (c) {
+    case '\n':
+      if (arrlen(heredocs) > 0) {
+        i = skip_heredoc_bodies(s, len, i + 1, heredocs) - 1;
+        arrdeln(heredocs, 0, (size_t)arrlen(heredocs));
+      }
+      if (!pending_op && case_depth == 0 && for_depth == 0 &&
+          subst_depth == 0 && !in_backquote) {
+        arrfree(heredocs);
+        return i + 1;
+      }
+      word_start = true;
+      cmd_pos = true;
+      break;
+    case ' ':
+    case '\t':
+    case '\r':
+      word_start = true;
+      break;
+    case '#':
+      if (word_start) {
+        while (i + 1 < len && s[i + 1] != '\n')
+          i++;
+        break;
+      }
+      word_start = false;
+      pending_op = false;
+      cmd_pos = false;
+      break;
+    case '|':
+      pending_op = true;
+      word_start = true;
+      cmd_pos = true;
+      break;
+    case '&':
+      // a single '&' puts the command in background and ends the statement
+      pending_op =
+          (i + 1 < len && s[i + 1] == '&') || (i > 0 && s[i - 1] == '&');
+      word_start = true;
+      cmd_pos = true;
+      break;
+    case '(':
+    case ')':
+      if (c == '(' && i > 0 && strchr("$<>", s[i - 1]))
+        subst_depth++;
+      else if (c == ')' && subst_depth > 0)
+        subst_depth--;
+      pending_op = false;
+      word_start = true;
+      cmd_pos = true;
+      break;
+    case '`':
+      in_backquote = !in_backquote;
+      word_start = !in_backquote;
+      pending_op = false;
+      cmd_pos = in_backquote;
+      break;
+    case ';':
+      pending_op = false;
+      word_start = true;
+      cmd_pos = true;
+      break;
+    case '<':
+      if (i + 2 < len && s[i + 1] == '<' && s[i + 2] != '<') {
+        heredoc_delim_t d = {.strip_tabs = s[i + 2] == '-'};
+        i = scan_heredoc_delim(s, len, i + (d.strip_tabs ? 3 : 2), &d) - 1;
+        arrpush(heredocs, d);
+      } else if (i + 2 < len && s[i + 1] == '<') {
+        i += 2; // here-string
+      }
+      pending_op = false;
+      word_start = true;
+      break;
+    case '>':
+      pending_op = false;
+      word_start = true;
+      break;
+    case '\'':
+    case '"':
+      quote = (c == '\'') ? QUOTE_SINGLE : QUOTE_DOUBLE;
+      word_start = false;
+      pending_op = false;
+      cmd_pos = false;
+      break;
+    default:
+      word_start = false;
+      pending_op = false;
+      cmd_pos = false;
+      break;
+    }
+  }
+  arrfree(heredocs);
+  return len;
+}
+
+static void parse_chunk_task(void *arg) {
+  parse_chunk_t *chunk = arg;
+  lexer_t *lex = lexer_new();
+  lexer_init_n(lex, chunk->src, chunk->len);
+
+  parser_t p = {.lex = lex,
+                .tok = {.type = TOK_EOF, .raw_value = NULL, .parts = NULL}};
+  chunk->ast = parser_parse(&p);
+  chunk->error = p.error;
+  lexer_free(lex);
+}
+
+static ast_node_t *parse_serial(const char *script, size_t len,
+                                bool *error) {
+  parse_chunk_t chunk = {.src = script, .len = len, .ast = NULL};
+  parse_chunk_task(&chunk);
+  *error = chunk.error;
+  return chunk.ast;
+}
+
+ast_node_t *parser_parse_script(const char *script, size_t len, bool *error) {
+  bool ignored;
+  if (!error)
+    error = &ignored;
+  *error = false;
+
+  size_t nthreads = thread_pool_default_size(PARSER_MAX_THREADS);
+  if (len < PARSER_PARALLEL_MIN_SIZE || nthreads < 2)
+    return parse_serial(script, len, error);
+
+  // aim for a few chunks per worker to balance uneven statements
+  size_t target = len / (nthreads * 4);
+  if (target < PARSER_CHUNK_SIZE)
+    target = PARSER_CHUNK_SIZE;
+
+  parse_chunk_t *chunks = NULL;
+  size_t start = 0;
+  while (start < len) {
+    size_t end = parser_next_boundary(script, len, start);
+    // extend the chunk statement by statement until it is large enough
+    while (end < len && end - start < target)
+      end = parser_next_boundary(script, len, end);
+
+    arrpush(chunks, ((parse_chunk_t){.src = script + start,
+                                     .len = end - start,
+                                     .ast = NULL}));
+    start = end;
+  }
+
+  if (arrlen(chunks) == 1) {
+    arrfree(chunks);
+    return parse_serial(script, len, error);
+  }
+
+  thread_pool_t *pool = thread_pool_new(nthreads);
+  for (int i = 0; i < arrlen(chunks); i++)
+    thread_pool_submit(pool, parse_chunk_task, &chunks[i]);
+  thread_pool_free(pool);
+
+  // a syntax error anywhere runs nothing, as in the serial parse
+  for (int i = 0; i < arrlen(chunks); i++) {
+    if (chunks[i].error) {
+      for (int j = 0; j < arrlen(chunks); j++)
+        parser_free_ast(chunks[j].ast);
+      arrfree(chunks);
+      *error = true;
+      return NULL;
+    }
+  }
+
+  // stitch the chunk sequences back together in order
+  ast_node_t *root_node = NULL;
+  for (int i = 0; i < arrlen(chunks); i++) {
+    ast_node_t *chunk_ast = chunks[i].ast;
+    if (!chunk_ast)
+      continue;
+
+    if (!root_node) {
+      root_node = chunk_ast;
+      continue;
+    }
+
+    for (int j = 0; j < arrlen(chunk_ast->seq.nodes); j++)
+      arrpush(root_node->seq.nodes, chunk_ast->seq.nodes[j]);
+    arrfree(chunk_ast->seq.nodes);
+    free(chunk_ast);
+  }
+  arrfree(chunks);
+  return root_node;
+}
@@ -0,0 +1,286 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _DEFAULT_SOURCE
+
+#include "command_index.h"
+#include "builtin/builtin.h"
+#include "executor/command_hash.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct {
+  unsigned char c;
+  uint32_t node;
+} trie_edge_t;
+
+/**
+ * @brief Node of the trie, nodes are never freed until a rebuild: a removed
+ * name only leaves nodes without words.
+ */
+typedef struct {
+  trie_edge_t *edges; /**< stb_ds array sorted by character */
+  uint32_t refs;      /**< Sources (directories, builtins) of this name */
+  uint32_t words;     /**< Names indexed in this subtree */
+} trie_node_t;
+
+/**
+ * @brief A PATH directory and the executables it held when last listed.
+ */
+typedef struct {
+  char *path;
+  struct timespec mtime;
+  bool exists;
+  char **names; /**< stb_ds array, sorted */
+} path_dir_t;
+
+static struct {
+  trie_node_t *nodes; /**< stb_ds array, the root first */
+  path_dir_t *dirs;   /**< stb_ds array */
+  uint64_t hash_gen;
+  bool built;
+} idx;
+
+/* --- TRIE --- */
+
+static uint32_t new_node(void) {
+  arrpush(idx.nodes, ((trie_node_t){0}));
+  return (uint32_t)(arrlen(idx.nodes) - 1);
+}
+
+// child of a node for a character, created if asked for
+static uint32_t child(uint32_t node, unsigned char c, bool create) {
+  trie_edge_t *edges = idx.nodes[node].edges;
+  size_t lo = 0, hi = (size_t)arrlen(edges);
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (edges[mid].c == c)
+      return edges[mid].node;
+    if (edges[mid].c < c)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (!create)
+    return 0;
+
+  trie_edge_t edge = {.c = c, .node = new_node()}; // may move the nodes
+  arrpush(idx.nodes[node].edges, edge);
+  edges = idx.nodes[node].edges;
+  size_t count = (size_t)arrlen(edges);
+  memmove(edges + lo + 1, edges + lo, (count - 1 - lo) * sizeof(*edges));
+  edges[lo] = edge;
+  return edge.node;
+}
+
+static void trie_insert(const char *name) {
+  // the node counts only change once the name is known to be new
+  uint32_t node = 0;
+  for (const char *p = name; *p; p++)
+    node = child(node, (unsigned char)*p, true);
+  if (idx.nodes[node].refs++ > 0)
+    return;
+
+  node = 0;
+  idx.nodes[0].words++;
+  for (const char *p = name; *p; p++) {
+    node = child(node, (unsigned char)*p, false);
+    idx.nodes[node].words++;
+  }
+}
+
+static void trie_remove(const char *name) {
+  uint32_t node = 0;
+  for (const char *p = name; *p; p++) {
+    node = child(node, (unsigned char)*p, false);
+    if (node == 0)
+      return;
+  }
+  if (idx.nodes[node].refs == 0 || --idx.nodes[node].refs > 0)
+    return;
+
+  node = 0;
+  idx.nodes[0].words--;
+  for (const char *p = name; *p; p++) {
+    node = child(node, (unsigned char)*p, false);
+    idx.nodes[node].words--;
+  }
+}
+
+// appends the names below a node, buf holding the prefix leading to it
+static void trie_collect(uint32_t node, char **buf, char ***out) {
+  if (idx.nodes[node].refs > 0) {
+    arrpush(*buf, '\0');
+    arrpush(*out, xstrdup(*buf));
+    (void)arrpop(*buf);
+  }
+  for (int i = 0; i < arrlen(idx.nodes[node].edges); i++) {
+    trie_edge_t e = idx.nodes[node].edges[i];
+    if (idx.nodes[e.node].words == 0)
+      continue;
+    arrpush(*buf, (char)e.c);
+    trie_collect(e.node, buf, out);
+    (void)arrpop(*buf);
+  }
+}
+
+/* --- PATH DIRECTORIES --- */
+
+static int cmp_names(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// the executables of a directory, sorted, as is_in_path() would find them
+static char **list_executables(const char *path) {
+  char **names = NULL;
+  DIR *dir = opendir(path);
+  if (!dir)
+    return NULL;
+
+  int dfd = dirfd(dir);
+  struct dirent *ent;
+  while ((ent = readdir(dir)) != NULL) {
+    if (ent->d_name[0] == '.' &&
+        (!ent->d_name[1] || (ent->d_name[1] == '.' && !ent->d_name[2])))
+      continue;
+    if (ent->d_type == DT_DIR)
+      continue;
+    struct stat st;
+    if (fstatat(dfd, ent->d_name, &st, 0) == 0 && S_ISREG(st.st_mode) &&
+        (st.st_mode & S_IXUSR))
+      arrpush(names, xstrdup(ent->d_name));
+  }
+  closedir(dir);
+  if (names)
+    qsort(names, (size_t)arrlen(names), sizeof(char *), cmp_names);
+  return names;
+}
+
+static void free_names(char **names) {
+  for (int i = 0; i < arrlen(names); i++)
+    free(names[i]);
+  arrfree(names);
+}
+
+/**
+ * @brief Lists a directory again and updates the trie with the names that
+ * appeared or disappeared since its previous listing.
+ */
+static void rescan_dir(path_dir_t *dir) {
+  char **names = dir->exists ? list_executables(dir->path) : NULL;
+  size_t i = 0, j = 0, n_old = (size_t)arrlen(dir->names);
+  size_t n_new = (size_t)arrlen(names);
+  while (i < n_old || j < n_new) {
+    int cmp = i == n_old   ? 1
+              : j == n_new ? -1
+                           : strcmp(dir->names[i], names[j]);
+    if (cmp < 0)
+      trie_remove(dir->names[i++]);
+    else if (cmp > 0)
+      trie_insert(names[j++]);
+    else
+      i++, j++;
+  }
+  free_names(dir->names);
+  dir->names = names;
+}
+
+static bool stat_dir(path_dir_t *dir) {
+  struct stat st;
+  bool exists = stat(dir->path, &st) == 0 && S_ISDIR(st.st_mode);
+  struct timespec mtime = exists ? st.st_mtim : (struct timespec){0};
+  bool changed = exists != dir->exists || mtime.tv_sec != dir->mtime.tv_sec ||
+                 mtime.tv_nsec != dir->mtime.tv_nsec;
+  dir->exists = exists;
+  dir->mtime = mtime;
+  return changed;
+}
+
+static void clear_index(void) {
+  for (int i = 0; i < arrlen(idx.nodes); i++)
+    arrfree(idx.nodes[i].edges);
+  arrfree(idx.nodes);
+  for (int i = 0; i < arrlen(idx.dirs); i++) {
+    free(idx.dirs[i].path);
+    free_names(idx.dirs[i].names);
+  }
+  arrfree(idx.dirs);
+  idx.built = false;
+}
+
+static void build_index(void) {
+  clear_index();
+  new_node();
+  for (size_t i = 0; i < builtin_count(); i++)
+    trie_insert(builtin_name_at(i));
+
+  const char *path = shell_state_getenv("PATH");
+  char *copy = xstrdup(path ? path : "");
+  char *p = copy, *entry;
+  while ((entry = strsep(&p, ":")) != NULL) {
+    bool dup = !*entry;
+    for (int i = 0; i < arrlen(idx.dirs) && !dup; i++)
+      dup = strcmp(idx.dirs[i].path, entry) == 0;
+    if (dup)
+      continue;
+    arrpush(idx.dirs, ((path_dir_t){.path = xstrdup(entry)}));
+    stat_dir(&arrlast(idx.dirs));
+    rescan_dir(&arrlast(idx.dirs));
+  }
+  free(copy);
+  idx.built = true;
+}
+
+static void refresh(void) {
+  uint64_t gen = command_hash_generation();
+  if (!idx.built || gen != idx.hash_gen) {
+    idx.hash_gen = gen;
+    build_index();
+    return;
+  }
+  for (int i = 0; i < arrlen(idx.dirs); i++) {
+    if (stat_dir(&idx.dirs[i]))
+      rescan_dir(&idx.dirs[i]);
+  }
+}
+
+/* --- API --- */
+
+char **command_index_complete(const char *prefix) {
+  refresh();
+  uint32_t node = 0;
+  for (const char *p = prefix; *p; p++) {
+    node = child(node, (unsigned char)*p, false);
+    if (node == 0)
+      return NULL;
+  }
+  if (idx.nodes[node].words == 0)
+    return NULL;
+
+  char **out = NULL;
+  char *buf = NULL;
+  size_t len = strlen(prefix);
+  if (len) {
+    arrsetlen(buf, len);
+    memcpy(buf, prefix, len);
+  }
+  trie_collect(node, &buf, &out);
+  arrfree(buf);
+  return out;
+}
+
+size_t command_index_size(void) {
+  refresh();
+  return idx.nodes[0].words;
+}
+
+void command_index_free(void) { clear_index(); }
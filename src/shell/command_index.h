@@ -0,0 +1,37 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __COMMAND_INDEX_H__
+#define __COMMAND_INDEX_H__
+
+#include <stddef.h>
+
+/*
+ * Index of the command names that can be completed: the executables of the
+ * PATH directories and the builtins, in a prefix trie.
+ *
+ * It is built on the first completion. Every later completion stats the PATH
+ * directories and lists again only those whose mtime changed, inserting and
+ * removing the names that differ from their previous listing. A change of
+ * PATH or 'hash -r' (a new command hash generation) rebuilds it.
+ */
+
+/**
+ * @brief Lists the command names starting with a prefix.
+ * @return stb_ds array of heap strings in byte order, to be freed by the
+ * caller, NULL when nothing matches
+ */
+char **command_index_complete(const char *prefix);
+
+/**
+ * @brief Number of distinct names indexed, after refreshing the index.
+ */
+size_t command_index_size(void);
+
+void command_index_free(void);
+
+#endif // __COMMAND_INDEX_H__
@@ -0,0 +1,173 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#include "completion.h"
+#include "shell/command_index.h"
+#include "shell/dir_index.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <readline/readline.h>
+#include <readline/tilde.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static char **matches; /**< stb_ds array of the matches not yet returned */
+static size_t next_match;
+
+static void drop_matches(void) {
+  for (size_t i = next_match; i < (size_t)arrlen(matches); i++)
+    free(matches[i]);
+  arrfree(matches);
+  next_match = 0;
+}
+
+// hands the prepared matches to readline, which takes ownership of them
+static char *list_generator(const char *text, int state) {
+  (void)text;
+  (void)state;
+  if (next_match < (size_t)arrlen(matches))
+    return matches[next_match++];
+  drop_matches();
+  return NULL;
+}
+
+static char **offer(char **names, const char *text) {
+  drop_matches();
+  matches = names;
+  return rl_completion_matches(text, list_generator);
+}
+
+// the word at start is a command name: it begins the line or follows an
+// operator
+static bool is_command_position(const char *line, int start) {
+  int i = start - 1;
+  while (i >= 0 && (line[i] == ' ' || line[i] == '\t'))
+    i--;
+  return i < 0 || strchr("|;&(", line[i]) != NULL;
+}
+
+// lists the names found so far in a directory still being read, without
+// inserting anything: the next TAB completes from the whole listing
+static void show_partial(char **names, const char *text) {
+  size_t n = (size_t)arrlen(names);
+  if (n == 0) {
+    rl_ding();
+    return;
+  }
+  char **list = xmalloc((n + 1) * sizeof(char *));
+  list[0] = (char *)text;
+  int width = 0;
+  for (size_t i = 0; i < n; i++) {
+    list[i + 1] = names[i];
+    int len = (int)strlen(names[i]);
+    width = len > width ? len : width;
+  }
+  rl_display_match_list(list, (int)n, width);
+  rl_forced_update_display();
+  free(list);
+}
+
+// variables and ~user are not looked up in the directory index
+static bool is_file_word(const char *text) {
+  return text[0] != '$' && (text[0] != '~' || strchr(text, '/'));
+}
+
+// the names of the files starting with text, which keep its directory as
+// it was typed
+static char **list_files(const char *text, bool *complete) {
+  const char *slash = strrchr(text, '/');
+  size_t dir_len = slash ? (size_t)(slash - text) + 1 : 0;
+  char *dir = slash ? xstrdup_n(text, dir_len) : xstrdup(".");
+  if (dir[0] == '~') {
+    char *expanded = tilde_expand(dir);
+    free(dir);
+    dir = expanded;
+  }
+  const char *base = text + dir_len;
+  const char *hidden = rl_variable_value("match-hidden-files");
+  char **names = dir_index_complete(
+      dir, base, base[0] == '.' || !hidden || strcmp(hidden, "off") != 0,
+      complete);
+  free(dir);
+
+  for (int i = 0; i < arrlen(names) && dir_len > 0; i++) {
+    size_t len = strlen(names[i]);
+    char *full = xmalloc(dir_len + len + 1);
+    memcpy(full, text, dir_len);
+    memcpy(full + dir_len, names[i], len + 1);
+    free(names[i]);
+    names[i] = full;
+  }
+  return names;
+}
+
+static char **complete_file(const char *text) {
+  if (!is_file_word(text))
+    return NULL;
+  rl_attempted_completion_over = 1;
+  rl_filename_completion_desired = 1;
+
+  bool complete;
+  char **names = list_files(text, &complete);
+  if (!complete) {
+    show_partial(names, text);
+    for (int i = 0; i < arrlen(names); i++)
+      free(names[i]);
+    arrfree(names);
+    return NULL;
+  }
+  return offer(names, text);
+}
+
+static char **attempt_completion(const char *text, int start, int end) {
+  (void)end;
+  if (!strchr(text, '/') && is_command_position(rl_line_buffer, start)) {
+    char **names = command_index_complete(text);
+    if (names) {
+      rl_attempted_completion_over = 1;
+      return offer(names, text);
+    }
+  }
+  return complete_file(text);
+}
+
+void completion_init(void) {
+  rl_attempted_completion_function = attempt_completion;
+}
+
+char **completion_complete(const char *line, size_t len, size_t *start,
+                           bool *complete) {
+  // the word goes back to a blank or an operator
+  size_t i = len;
+  while (i > 0 && !strchr(" \t\n|;&()<>", line[i - 1]))
+    i--;
+  *start = i;
+  *complete = true;
+
+  char *text = xstrdup_n(line + i, len - i);
+  char **names = NULL;
+  if (!strchr(text, '/') && is_command_position(line, (int)i))
+    names = command_index_complete(text);
+  if (!names && is_file_word(text)) {
+    names = list_files(text, complete);
+    // a single directory is completed with its slash, as readline does
+    struct stat st;
+    char *path = arrlen(names) == 1 ? tilde_expand(names[0]) : NULL;
+    if (*complete && path && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+      size_t n = strlen(names[0]);
+      names[0] = xrealloc(names[0], n + 2);
+      memcpy(names[0] + n, "/", 2);
+    }
+    free(path);
+  }
+  free(text);
+  return names;
+}
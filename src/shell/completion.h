@@ -0,0 +1,41 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __COMPLETION_H__
+#define __COMPLETION_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Completion at the prompt. The first word of a command is completed from
+ * the command index (shell/command_index.h) instead of readline scanning the
+ * PATH directories on each TAB. File names come from the directory index
+ * (shell/dir_index.h): a huge directory is read in the background and its
+ * sorted listing is reused by the next TABs. Variables and ~user keep
+ * readline's own completion.
+ */
+
+/**
+ * @brief Installs the completion function of readline.
+ */
+void completion_init(void);
+
+/**
+ * @brief Completes the word before the cursor, for the native line editor.
+ * @param line the line up to the cursor, not NUL-terminated
+ * @param len length of line
+ * @param start set to the offset of the word completed
+ * @param complete set to false when the names come from a directory still
+ * being read: they are only to be listed
+ * @return stb_ds array of heap strings in byte order that may replace the
+ * word, a single directory ending with '/', NULL if none
+ */
+char **completion_complete(const char *line, size_t len, size_t *start,
+                           bool *complete);
+
+#endif // __COMPLETION_H__
@@ -12,5 +12,25 @@
 #define COMMAND_NOT_FOUND_EXIT_CODE 127
 #define JOB_STOPPED_EXIT_CODE 146
 #define HIST_FILENAME ".nsh_history"
+#define RC_FILENAME ".nshrc"
+#define AST_CACHE_SIZE 128
+#define GLOB_DIR_CACHE_SIZE 32
+#define PATTERN_CACHE_SIZE 64
+#define PASSWD_CACHE_TTL 300    // seconds
+#define PASSWD_CACHE_NEG_TTL 30 // seconds
+#define COMMAND_HASH_NEG_TTL 5  // seconds, for the highlighting only
+#define CMDSUB_CACHE_SIZE 256 // parsed command substitution bodies
+#define IFS_DEFAULT " \t\n"
+#define BRACE_MAX_WORDS (1 << 22) // words a brace expansion may add to argv
+#define ARITH_CACHE_SIZE 64 // compiled arithmetic expressions
+#define ARITH_MAX_DEPTH 32  // variables evaluated as nested expressions
+#define BATCH_ARG_HEADROOM 2048 // bytes of ARG_MAX left unused, as xargs does
+#define BATCH_MAX_PARALLEL 256  // invocations a batch may run at once
+#define PS2 "> " // prompt of the lines holding here-document bodies
+#define HIGHLIGHT_BUDGET_NS 1000000 // highlighting time per keystroke
+#define DIR_INDEX_CACHE_SIZE 8 // directory listings kept for completion
+#define DIR_INDEX_WAIT_MS 20   // completion wait before partial results
+#define HISTORY_INDEX_BEST 4 // suggestions ranked per history trie node
+#define HISTORY_FRECENCY_STEP 86400 // seconds, worth of a doubled use count
 
 #endif // __CONFIG_H__
\ No newline at end of file
@@ -0,0 +1,303 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "dir_index.h"
+#include "shell/config.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// names read by the listing thread before the prompt can see them
+#define DIR_INDEX_BATCH 1024
+
+/**
+ * @brief Names of a directory, stored back to back.
+ */
+typedef struct {
+  char *pool;     /**< stb_ds array of NUL-terminated names */
+  uint32_t *offs; /**< stb_ds array, offsets of the names in pool */
+  struct timespec mtime; /**< mtime of the directory when it was read */
+  bool complete;  /**< offs holds every name, sorted */
+  uint64_t used;  /**< Last completion that used it, for eviction */
+} listing_t;
+
+typedef struct {
+  char *key;
+  listing_t value;
+} listing_entry_t;
+
+static listing_entry_t *cache = NULL;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t scan_cond = PTHREAD_COND_INITIALIZER;
+static uint64_t use_clock = 0;
+
+static pthread_t scan_thread;
+static bool scan_started = false;
+static atomic_bool scan_cancel = false;
+static char *scan_dir = NULL; /**< Directory being read, under cache_lock */
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+/* --- FORK SAFETY --- */
+
+// the listing thread does not survive a fork, the lock must not be held by
+// it at that moment
+static void atfork_prepare(void) { pthread_mutex_lock(&cache_lock); }
+static void atfork_release(void) { pthread_mutex_unlock(&cache_lock); }
+
+static void register_atfork(void) {
+  pthread_atfork(atfork_prepare, atfork_release, atfork_release);
+}
+
+/* --- LISTINGS --- */
+
+static void listing_clear(listing_t *l) {
+  arrfree(l->pool);
+  arrfree(l->offs);
+  l->complete = false;
+}
+
+static void append_name(char **pool, uint32_t **offs, const char *name) {
+  size_t len = strlen(name) + 1, off = (size_t)arrlen(*pool);
+  arrsetlen(*pool, off + len);
+  memcpy(*pool + off, name, len);
+  arrpush(*offs, (uint32_t)off);
+}
+
+static int cmp_offs(const void *a, const void *b, void *pool) {
+  return strcmp((char *)pool + *(const uint32_t *)a,
+                (char *)pool + *(const uint32_t *)b);
+}
+
+// must be called with cache_lock held, by the thread reading dir
+static listing_t *scanned_listing(const char *dir) {
+  if (!scan_dir || strcmp(scan_dir, dir) != 0)
+    return NULL;
+  listing_entry_t *e = shgetp_null(cache, dir);
+  return e ? &e->value : NULL;
+}
+
+// makes a batch of names visible to the completions waiting for them
+static void publish(const char *dir, const char *pool, const uint32_t *offs,
+                    size_t from) {
+  pthread_mutex_lock(&cache_lock);
+  listing_t *l = scanned_listing(dir);
+  for (size_t i = from; l && i < (size_t)arrlen(offs); i++)
+    append_name(&l->pool, &l->offs, pool + offs[i]);
+  pthread_mutex_unlock(&cache_lock);
+}
+
+static void *scan_worker(void *arg) {
+  char *dir = arg;
+  char *pool = NULL;
+  uint32_t *offs = NULL;
+  size_t published = 0;
+
+  DIR *d = opendir(dir);
+  struct dirent *ent;
+  while (d && !atomic_load(&scan_cancel) && (ent = readdir(d)) != NULL) {
+    const char *n = ent->d_name;
+    if (n[0] == '.' && (!n[1] || (n[1] == '.' && !n[2])))
+      continue;
+    append_name(&pool, &offs, n);
+    if ((size_t)arrlen(offs) - published == DIR_INDEX_BATCH) {
+      publish(dir, pool, offs, published);
+      published = (size_t)arrlen(offs);
+    }
+  }
+  if (d)
+    closedir(d);
+
+  // sorted outside of the lock, then swapped with the partial listing
+  bool cancelled = atomic_load(&scan_cancel);
+  if (!cancelled && offs)
+    qsort_r(offs, (size_t)arrlen(offs), sizeof(uint32_t), cmp_offs, pool);
+
+  pthread_mutex_lock(&cache_lock);
+  listing_t *l = scanned_listing(dir);
+  if (l && !cancelled) {
+    listing_clear(l);
+    l->pool = pool;
+    l->offs = offs;
+    l->complete = true;
+    pool = NULL;
+    offs = NULL;
+  }
+  free(scan_dir);
+  scan_dir = NULL;
+  pthread_cond_broadcast(&scan_cond);
+  pthread_mutex_unlock(&cache_lock);
+
+  pr_debug("dir index: %s read%s", dir, cancelled ? ", cancelled" : "");
+  arrfree(pool);
+  arrfree(offs);
+  free(dir);
+  return NULL;
+}
+
+// must be called with cache_lock held, drops the least recently used
+// listing when the cache is full
+static listing_t *reset_listing(const char *dir) {
+  if (!cache)
+    sh_new_strdup(cache);
+  listing_entry_t *e = shgetp_null(cache, dir);
+  if (!e && shlen(cache) >= DIR_INDEX_CACHE_SIZE) {
+    ptrdiff_t oldest = 0;
+    for (ptrdiff_t i = 1; i < shlen(cache); i++) {
+      if (cache[i].value.used < cache[oldest].value.used)
+        oldest = i;
+    }
+    listing_clear(&cache[oldest].value);
+    (void)shdel(cache, cache[oldest].key);
+  }
+  if (!e) {
+    shput(cache, dir, ((listing_t){0}));
+    e = shgetp_null(cache, dir);
+  }
+  listing_clear(&e->value);
+  return &e->value;
+}
+
+static void start_scan(const char *dir, struct timespec mtime) {
+  dir_index_cancel();
+
+  pthread_mutex_lock(&cache_lock);
+  reset_listing(dir)->mtime = mtime;
+  scan_dir = xstrdup(dir);
+  pthread_mutex_unlock(&cache_lock);
+
+  atomic_store(&scan_cancel, false);
+  char *arg = xstrdup(dir);
+  if (pthread_create(&scan_thread, NULL, scan_worker, arg) != 0) {
+    pr_err("%s", "dir index: cannot start thread");
+    free(arg);
+    pthread_mutex_lock(&cache_lock);
+    free(scan_dir);
+    scan_dir = NULL;
+    pthread_mutex_unlock(&cache_lock);
+    return;
+  }
+  scan_started = true;
+}
+
+/* --- LOOKUP --- */
+
+static bool wanted(const char *name, bool hidden) {
+  return hidden || name[0] != '.';
+}
+
+static int cmp_names(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// must be called with cache_lock held
+static char **collect(const listing_t *l, const char *prefix, bool hidden) {
+  char **out = NULL;
+  size_t plen = strlen(prefix), n = (size_t)arrlen(l->offs);
+  if (!l->complete) {
+    for (size_t i = 0; i < n; i++) {
+      const char *name = l->pool + l->offs[i];
+      if (strncmp(name, prefix, plen) == 0 && wanted(name, hidden))
+        arrpush(out, xstrdup(name));
+    }
+    if (out)
+      qsort(out, (size_t)arrlen(out), sizeof(char *), cmp_names);
+    return out;
+  }
+
+  // the names starting with the prefix are a range of the sorted listing
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (strcmp(l->pool + l->offs[mid], prefix) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (; lo < n && strncmp(l->pool + l->offs[lo], prefix, plen) == 0; lo++) {
+    const char *name = l->pool + l->offs[lo];
+    if (wanted(name, hidden))
+      arrpush(out, xstrdup(name));
+  }
+  return out;
+}
+
+char **dir_index_complete(const char *path, const char *prefix, bool hidden,
+                          bool *complete) {
+  pthread_once(&atfork_once, register_atfork);
+  *complete = true;
+  // listings are kept under the absolute path, "." changes with cd
+  struct stat st;
+  char *dir = realpath(path, NULL);
+  if (!dir || stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+    free(dir);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&cache_lock);
+  listing_entry_t *e = cache ? shgetp_null(cache, dir) : NULL;
+  bool scanning = scan_dir && strcmp(scan_dir, dir) == 0;
+  bool fresh = e && e->value.complete &&
+               e->value.mtime.tv_sec == st.st_mtim.tv_sec &&
+               e->value.mtime.tv_nsec == st.st_mtim.tv_nsec;
+  if (!fresh && !scanning) {
+    pthread_mutex_unlock(&cache_lock);
+    start_scan(dir, st.st_mtim);
+    pthread_mutex_lock(&cache_lock);
+  }
+
+  // a small directory is read before the deadline and completed in full
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_nsec += DIR_INDEX_WAIT_MS * 1000000L;
+  deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+  deadline.tv_nsec %= 1000000000L;
+  e = shgetp_null(cache, dir);
+  while (e && !e->value.complete && scan_dir &&
+         strcmp(scan_dir, dir) == 0 &&
+         pthread_cond_timedwait(&scan_cond, &cache_lock, &deadline) == 0)
+    e = shgetp_null(cache, dir);
+
+  char **out = NULL;
+  if (e) {
+    e->value.used = ++use_clock;
+    *complete = e->value.complete;
+    out = collect(&e->value, prefix, hidden);
+  }
+  pthread_mutex_unlock(&cache_lock);
+  free(dir);
+  return out;
+}
+
+/* --- MAINTENANCE --- */
+
+void dir_index_cancel(void) {
+  if (!scan_started)
+    return;
+  atomic_store(&scan_cancel, true);
+  pthread_join(scan_thread, NULL);
+  scan_started = false;
+}
+
+void dir_index_free(void) {
+  dir_index_cancel();
+  pthread_mutex_lock(&cache_lock);
+  for (ptrdiff_t i = 0; i < shlen(cache); i++)
+    listing_clear(&cache[i].value);
+  shfree(cache);
+  cache = NULL;
+  pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,43 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __DIR_INDEX_H__
+#define __DIR_INDEX_H__
+
+#include <stdbool.h>
+
+/*
+ * Sorted listings of the directories where file names are completed.
+ *
+ * A directory is read by a background thread, never by the prompt: the
+ * completion waits DIR_INDEX_WAIT_MS at most and otherwise answers with the
+ * names read so far. Finished listings are kept (DIR_INDEX_CACHE_SIZE
+ * directories) and reused until the mtime of their directory changes: the
+ * names with a prefix are then found by a binary search. Completing in
+ * another directory cancels a listing still in progress, as does typing a
+ * key other than TAB; the next TAB starts it again.
+ */
+
+/**
+ * @brief Lists the names of a directory starting with a prefix.
+ * @param path the directory, "." for the current one
+ * @param hidden names starting with a dot match an empty prefix
+ * @param complete set to false when the directory is still being read and
+ * only part of its names were looked at
+ * @return stb_ds array of heap strings in byte order, NULL if none matches
+ */
+char **dir_index_complete(const char *path, const char *prefix, bool hidden,
+                          bool *complete);
+
+/**
+ * @brief Stops the listing in progress, if any.
+ */
+void dir_index_cancel(void);
+
+void dir_index_free(void);
+
+#endif // __DIR_INDEX_H__
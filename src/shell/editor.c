@@ -0,0 +1,935 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _GNU_SOURCE
+
+#include "editor.h"
+#include "completion.h"
+#include "highlight.h"
+#include "history/history.h"
+#include "history/history_index.h"
+#include "shell/dir_index.h"
+#include "shell/state.h"
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#define ESC "\x1b"
+#define KEY_CTRL(c) ((c) & 0x1f)
+#define ARR_CLEAR(a)                                                           \
+  do {                                                                         \
+    if (a)                                                                     \
+      arrdeln((a), 0, (size_t)arrlen(a));                                      \
+  } while (0)
+#define EDITOR_DEFAULT_COLS 80
+// an escape sequence longer than this is dropped
+#define EDITOR_SEQ_MAX 16
+// bracketed paste: the terminal surrounds pasted text with these
+#define PASTE_MODE_ON ESC "[?2004h"
+#define PASTE_MODE_OFF ESC "[?2004l"
+#define PASTE_START ESC "[200~"
+#define PASTE_END ESC "[201~"
+
+/**
+ * @brief A character as displayed: its bytes in the line, combining
+ * characters included, the columns it takes and its highlighting.
+ */
+typedef struct {
+  size_t off;
+  uint8_t len;
+  uint8_t width;
+  uint8_t style;
+} cell_t;
+
+static struct {
+  bool active;
+  int in_fd;
+  int out_fd;
+  bool raw;
+  struct termios saved_tmodes;
+  size_t cols;
+
+  char *prompt; /**< Prompt as written, without the \001 \002 markers */
+  size_t prompt_width;
+
+  char *line; /**< stb_ds array, not NUL-terminated */
+  size_t cursor;
+  char *hint; /**< stb_ds array, suggested end of the line */
+  char *text; /**< stb_ds array, the line followed by the hint */
+
+  // what the terminal shows
+  char *shown;        /**< stb_ds array, bytes of the displayed line */
+  cell_t *shown_cells; /**< stb_ds array */
+  size_t term_pos;    /**< Cursor position in columns from the prompt start */
+
+  char *out;     /**< stb_ds array, output of the current key(s) */
+  char *pending; /**< stb_ds array, bytes read but not handled yet */
+
+  char *carry; /**< stb_ds array, pasted text left for the next line */
+  char *kill;  /**< stb_ds array, last killed text */
+  size_t hist_pos;
+  char *saved_line; /**< The new line while the history is browsed */
+} ed = {.in_fd = -1, .out_fd = -1};
+
+/* --- UTF-8 AND WIDTHS --- */
+
+static size_t utf8_len(unsigned char c) {
+  if (c < 0x80)
+    return 1;
+  if ((c & 0xe0) == 0xc0)
+    return 2;
+  if ((c & 0xf0) == 0xe0)
+    return 3;
+  if ((c & 0xf8) == 0xf0)
+    return 4;
+  return 1; // stray continuation or invalid byte
+}
+
+// decodes the character at s, an invalid sequence is a single byte
+static size_t utf8_decode(const char *s, size_t avail, uint32_t *cp) {
+  const unsigned char *u = (const unsigned char *)s;
+  size_t len = utf8_len(u[0]);
+  if (len == 1 || len > avail) {
+    *cp = u[0];
+    return 1;
+  }
+  uint32_t v = u[0] & (0x7f >> len);
+  for (size_t i = 1; i < len; i++) {
+    if ((u[i] & 0xc0) != 0x80) {
+      *cp = u[0];
+      return 1;
+    }
+    v = (v << 6) | (u[i] & 0x3f);
+  }
+  *cp = v;
+  return len;
+}
+
+static int char_width(uint32_t cp) {
+  if (cp < 0x20 || cp == 0x7f)
+    return 2; // shown as ^X
+  if (cp < 0x7f)
+    return 1;
+  int w = wcwidth((wchar_t)cp);
+  return w < 0 ? 1 : w;
+}
+
+/**
+ * @brief Splits a line into cells. Zero-width characters join the cell of
+ * the character they follow.
+ * @param styles style of each byte, or NULL
+ */
+static cell_t *line_cells(const char *s, size_t len, const uint8_t *styles,
+                          cell_t *cells) {
+  ARR_CLEAR(cells);
+  for (size_t i = 0; i < len;) {
+    uint32_t cp;
+    size_t n = utf8_decode(s + i, len - i, &cp);
+    int w = char_width(cp);
+    if (w == 0 && arrlen(cells) > 0)
+      arrlast(cells).len += (uint8_t)n;
+    else
+      arrpush(cells, ((cell_t){.off = i,
+                               .len = (uint8_t)n,
+                               .width = (uint8_t)w,
+                               .style = styles ? styles[i] : HL_DEFAULT}));
+    i += n;
+  }
+  return cells;
+}
+
+// width of a prompt: markers, escape sequences and all but its last row
+// take no room
+static size_t prompt_width(const char *p) {
+  size_t width = 0;
+  bool hidden = false;
+  for (size_t i = 0; p[i];) {
+    if (p[i] == '\001' || p[i] == '\002') {
+      hidden = p[i++] == '\001';
+      continue;
+    }
+    if (hidden) {
+      i++;
+      continue;
+    }
+    if (p[i] == '\n') {
+      width = 0;
+      i++;
+      continue;
+    }
+    if (p[i] == '\x1b' && p[i + 1] == '[') {
+      for (i += 2; p[i] && !(p[i] >= 0x40 && p[i] <= 0x7e); i++)
+        ;
+      if (p[i])
+        i++;
+      continue;
+    }
+    uint32_t cp;
+    i += utf8_decode(p + i, strlen(p + i), &cp);
+    width += (size_t)char_width(cp);
+  }
+  return width;
+}
+
+/* --- OUTPUT --- */
+
+static void out_str(const char *s, size_t len) {
+  size_t off = (size_t)arrlen(ed.out);
+  arrsetlen(ed.out, off + len);
+  memcpy(ed.out + off, s, len);
+}
+
+// cursor movement of n rows or columns in a direction (A, B, C or D)
+static void out_move(size_t n, char dir) {
+  char buf[32];
+  int len = snprintf(buf, sizeof(buf), ESC "[%zu%c", n, dir);
+  out_str(buf, (size_t)len);
+}
+
+static void flush_output(void) {
+  size_t len = (size_t)arrlen(ed.out);
+  for (size_t off = 0; off < len;) {
+    ssize_t w = write(ed.out_fd, ed.out + off, len - off);
+    if (w == -1 && errno == EINTR)
+      continue;
+    if (w <= 0)
+      break;
+    off += (size_t)w;
+  }
+  ARR_CLEAR(ed.out);
+}
+
+static void out_cell(const char *s, const cell_t *c) {
+  unsigned char b = (unsigned char)s[c->off];
+  if (b < 0x20 || b == 0x7f) {
+    char caret[2] = {'^', (char)(b == 0x7f ? '?' : b + '@')};
+    out_str(caret, 2);
+  } else {
+    out_str(s + c->off, c->len);
+  }
+}
+
+/**
+ * @brief Moves the terminal cursor to a position, in columns from the start
+ * of the prompt, with relative moves only.
+ */
+static void move_to(size_t pos) {
+  size_t row = ed.term_pos / ed.cols, col = ed.term_pos % ed.cols;
+  size_t to_row = pos / ed.cols, to_col = pos % ed.cols;
+  if (to_row < row)
+    out_move(row - to_row, 'A');
+  else if (to_row > row)
+    out_move(to_row - row, 'B');
+  if (to_col == 0 && col != 0)
+    out_str("\r", 1);
+  else if (to_col > col)
+    out_move(to_col - col, 'C');
+  else if (to_col < col)
+    out_move(col - to_col, 'D');
+  ed.term_pos = pos;
+}
+
+static bool cells_equal(const cell_t *a, const char *as, const cell_t *b,
+                        const char *bs) {
+  return a->len == b->len && a->width == b->width && a->style == b->style &&
+         memcmp(as + a->off, bs + b->off, a->len) == 0;
+}
+
+// the history command with the highest frecency that extends the line, when
+// the cursor is at its end and no history entry is displayed
+static void update_hint(void) {
+  ARR_CLEAR(ed.hint);
+  size_t len = (size_t)arrlen(ed.line);
+  if (!shell_state_get()->flags.autosuggest || len == 0 || ed.cursor != len ||
+      ed.hist_pos != history_count())
+    return;
+  const char *cmd = history_index_suggest(ed.line, len);
+  if (!cmd)
+    return;
+  // only the first line of a multi-line command
+  size_t n = strcspn(cmd + len, "\n");
+  if (n == 0)
+    return;
+  arrsetlen(ed.hint, n);
+  memcpy(ed.hint, cmd + len, n);
+}
+
+/**
+ * @brief Brings the screen in line with the edited line: only the cells from
+ * the first one that changed are written, then the cursor is placed.
+ * @param suggest display the history suggestion after the line
+ */
+static void refresh(bool suggest) {
+  size_t len = (size_t)arrlen(ed.line);
+  if (suggest)
+    update_hint();
+  else
+    ARR_CLEAR(ed.hint);
+  size_t hlen = (size_t)arrlen(ed.hint);
+  ARR_CLEAR(ed.text);
+  arrsetlen(ed.text, len + hlen);
+  if (len)
+    memcpy(ed.text, ed.line, len);
+  if (hlen)
+    memcpy(ed.text + len, ed.hint, hlen);
+
+  const uint8_t *styles = NULL;
+  if (shell_state_get()->flags.highlight && len > 0)
+    styles = highlight_line(ed.line, len);
+  cell_t *cells = line_cells(ed.text, len, styles, NULL);
+  if (hlen > 0) {
+    cell_t *hint = line_cells(ed.hint, hlen, NULL, NULL);
+    for (int i = 0; i < arrlen(hint); i++) {
+      hint[i].off += len;
+      hint[i].style = HL_SUGGESTION;
+      arrpush(cells, hint[i]);
+    }
+    arrfree(hint);
+  }
+  size_t ncells = (size_t)arrlen(cells);
+  size_t nshown = (size_t)arrlen(ed.shown_cells);
+
+  size_t first = 0, pos = ed.prompt_width;
+  while (first < ncells && first < nshown &&
+         cells_equal(&cells[first], ed.text, &ed.shown_cells[first],
+                     ed.shown)) {
+    pos += cells[first].width;
+    first++;
+  }
+
+  size_t old_end = ed.prompt_width, cursor_pos = ed.prompt_width;
+  for (size_t i = 0; i < nshown; i++)
+    old_end += ed.shown_cells[i].width;
+
+  size_t end = pos;
+  if (first < ncells || first < nshown) {
+    move_to(pos);
+    uint8_t style = HL_DEFAULT;
+    for (size_t i = first; i < ncells; i++) {
+      if (cells[i].style != style) {
+        style = cells[i].style;
+        const char *sgr = highlight_sgr(style);
+        out_str(sgr, strlen(sgr));
+      }
+      out_cell(ed.text, &cells[i]);
+      end += cells[i].width;
+    }
+    if (style != HL_DEFAULT)
+      out_str(ESC "[0m", 4);
+    ed.term_pos = end;
+    // a full last row leaves the cursor on it until something is written
+    if (end > pos && end % ed.cols == 0)
+      out_str("\r\n", 2);
+    if (end < old_end)
+      out_str(ESC "[J", 3);
+  }
+
+  for (size_t i = 0; i < ncells && cells[i].off < ed.cursor; i++)
+    cursor_pos += cells[i].width;
+  move_to(cursor_pos);
+
+  arrfree(ed.shown_cells);
+  ed.shown_cells = cells;
+  ARR_CLEAR(ed.shown);
+  arrsetlen(ed.shown, len + hlen);
+  memcpy(ed.shown, ed.text, len + hlen);
+}
+
+// writes the prompt, nothing of the line is displayed yet
+static void show_prompt(void) {
+  out_str(ed.prompt, strlen(ed.prompt));
+  ed.term_pos = ed.prompt_width;
+  if (ed.prompt_width > 0 && ed.prompt_width % ed.cols == 0)
+    out_str("\r\n", 2);
+  ARR_CLEAR(ed.shown_cells);
+  ARR_CLEAR(ed.shown);
+}
+
+// the prompt is written again from the start of the row, with the line
+static void redraw_all(void) {
+  out_str("\r", 1);
+  show_prompt();
+  refresh(true);
+}
+
+/* --- TERMINAL --- */
+
+static void update_cols(void) {
+  struct winsize ws;
+  ed.cols = ioctl(ed.out_fd, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0
+                ? ws.ws_col
+                : EDITOR_DEFAULT_COLS;
+}
+
+static void raw_mode(void) {
+  if (!isatty(ed.in_fd) || tcgetattr(ed.in_fd, &ed.saved_tmodes) == -1)
+    return;
+  struct termios raw = ed.saved_tmodes;
+  // keys such as Ctrl-C are read as bytes, output processing stays on
+  raw.c_iflag &= ~(tcflag_t)(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+  raw.c_lflag &= ~(tcflag_t)(ECHO | ICANON | IEXTEN | ISIG);
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  ed.raw = tcsetattr(ed.in_fd, TCSADRAIN, &raw) == 0;
+  if (ed.raw)
+    out_str(PASTE_MODE_ON, strlen(PASTE_MODE_ON));
+}
+
+static void restore_mode(void) {
+  if (ed.raw) {
+    out_str(PASTE_MODE_OFF, strlen(PASTE_MODE_OFF));
+    flush_output();
+    tcsetattr(ed.in_fd, TCSADRAIN, &ed.saved_tmodes);
+  }
+  ed.raw = false;
+}
+
+/* --- EDITING --- */
+
+static void set_line(const char *s) {
+  size_t len = s ? strlen(s) : 0;
+  ARR_CLEAR(ed.line);
+  arrsetlen(ed.line, len);
+  if (len)
+    memcpy(ed.line, s, len);
+  ed.cursor = len;
+}
+
+static void insert(const char *s, size_t n) {
+  size_t len = (size_t)arrlen(ed.line);
+  arrsetlen(ed.line, len + n);
+  memmove(ed.line + ed.cursor + n, ed.line + ed.cursor, len - ed.cursor);
+  memcpy(ed.line + ed.cursor, s, n);
+  ed.cursor += n;
+}
+
+// byte offset of the character before or after the cursor
+static size_t prev_char(size_t pos) {
+  if (pos == 0)
+    return 0;
+  cell_t *cells = line_cells(ed.line, (size_t)arrlen(ed.line), NULL, NULL);
+  size_t prev = 0;
+  for (int i = 0; i < arrlen(cells) && cells[i].off < pos; i++)
+    prev = cells[i].off;
+  arrfree(cells);
+  return prev;
+}
+
+static size_t next_char(size_t pos) {
+  size_t len = (size_t)arrlen(ed.line);
+  if (pos >= len)
+    return len;
+  uint32_t cp;
+  pos += utf8_decode(ed.line + pos, len - pos, &cp);
+  // combining characters go with the one they follow
+  while (pos < len) {
+    size_t n = utf8_decode(ed.line + pos, len - pos, &cp);
+    if (char_width(cp) != 0)
+      break;
+    pos += n;
+  }
+  return pos;
+}
+
+static bool is_word_byte(char c) {
+  return isalnum((unsigned char)c) || (unsigned char)c >= 0x80 || c == '_';
+}
+
+static size_t prev_word(size_t pos) {
+  while (pos > 0 && !is_word_byte(ed.line[pos - 1]))
+    pos--;
+  while (pos > 0 && is_word_byte(ed.line[pos - 1]))
+    pos--;
+  return pos;
+}
+
+static size_t next_word(size_t pos) {
+  size_t len = (size_t)arrlen(ed.line);
+  while (pos < len && !is_word_byte(ed.line[pos]))
+    pos++;
+  while (pos < len && is_word_byte(ed.line[pos]))
+    pos++;
+  return pos;
+}
+
+// removes [from, to) from the line, keeping it in the kill buffer
+static void kill_range(size_t from, size_t to, bool keep) {
+  if (to <= from)
+    return;
+  if (keep) {
+    ARR_CLEAR(ed.kill);
+    arrsetlen(ed.kill, to - from);
+    memcpy(ed.kill, ed.line + from, to - from);
+  }
+  arrdeln(ed.line, from, to - from);
+  ed.cursor = from;
+}
+
+static void history_move(bool older) {
+  size_t count = history_count();
+  if (older ? ed.hist_pos == 0 : ed.hist_pos >= count)
+    return;
+
+  if (ed.hist_pos == count) {
+    arrpush(ed.line, '\0');
+    free(ed.saved_line);
+    ed.saved_line = xstrdup(ed.line);
+    (void)arrpop(ed.line);
+  }
+  ed.hist_pos += older ? (size_t)-1 : 1;
+  set_line(ed.hist_pos == count ? ed.saved_line : history_at(ed.hist_pos));
+}
+
+static void transpose(void) {
+  size_t len = (size_t)arrlen(ed.line);
+  if (len < 2 || ed.cursor == 0)
+    return;
+  // at the end of the line, the two last characters are swapped
+  size_t b = ed.cursor == len ? prev_char(len) : ed.cursor;
+  size_t a = prev_char(b), end = next_char(b);
+  size_t alen = b - a, blen = end - b;
+  char tmp[16];
+  if (alen + blen > sizeof(tmp))
+    return;
+  memcpy(tmp, ed.line + b, blen);
+  memcpy(tmp + blen, ed.line + a, alen);
+  memcpy(ed.line + a, tmp, alen + blen);
+  ed.cursor = end;
+}
+
+// moves the suggestion into the line, or its next word only
+static bool accept_hint(bool word) {
+  size_t n = (size_t)arrlen(ed.hint);
+  if (n == 0 || ed.cursor != (size_t)arrlen(ed.line))
+    return false;
+  if (word) {
+    size_t end = 0;
+    while (end < n && !is_word_byte(ed.hint[end]))
+      end++;
+    while (end < n && is_word_byte(ed.hint[end]))
+      end++;
+    n = end;
+  }
+  insert(ed.hint, n);
+  return true;
+}
+
+/* --- KEYS --- */
+
+// leaves the cursor on the row below the line
+static void finish_line(const char *mark) {
+  refresh(false);
+  size_t end = ed.prompt_width;
+  for (int i = 0; i < arrlen(ed.shown_cells); i++)
+    end += ed.shown_cells[i].width;
+  move_to(end);
+  out_str(mark, strlen(mark));
+  out_str("\r\n", 2);
+}
+
+// lists the names below the line, in columns, and writes the prompt again
+static void list_names(char **names) {
+  finish_line("");
+  size_t n = (size_t)arrlen(names), width = 0;
+  for (size_t i = 0; i < n; i++) {
+    size_t len = strlen(names[i]);
+    width = len > width ? len : width;
+  }
+  width += 2;
+  size_t per_row = ed.cols / width ? ed.cols / width : 1;
+  for (size_t i = 0; i < n; i++) {
+    size_t len = strlen(names[i]);
+    out_str(names[i], len);
+    if ((i + 1) % per_row == 0 || i + 1 == n)
+      out_str("\r\n", 2);
+    else
+      for (; len < width; len++)
+        out_str(" ", 1);
+  }
+  show_prompt();
+}
+
+/**
+ * @brief Completes the word before the cursor. A single match replaces it,
+ * followed by a space unless it is a directory; several matches insert their
+ * common prefix, or are listed below the line when it adds nothing. The
+ * names found so far in a directory still being read are only listed.
+ */
+static void complete_word(void) {
+  size_t start;
+  bool complete;
+  char **names = completion_complete(ed.line, ed.cursor, &start, &complete);
+  size_t n = (size_t)arrlen(names);
+  if (n == 0) {
+    out_str("\a", 1);
+  } else {
+    size_t common = strlen(names[0]);
+    for (size_t i = 1; i < n; i++) {
+      size_t k = 0;
+      while (k < common && names[i][k] == names[0][k])
+        k++;
+      common = k;
+    }
+    if (!complete) {
+      list_names(names);
+    } else if (n == 1 || common > ed.cursor - start) {
+      kill_range(start, ed.cursor, false);
+      insert(names[0], common);
+      if (n == 1 && names[0][common - 1] != '/')
+        insert(" ", 1);
+    } else {
+      list_names(names);
+    }
+  }
+  for (size_t i = 0; i < n; i++)
+    free(names[i]);
+  arrfree(names);
+}
+
+static editor_status_e accept_line(void) {
+  finish_line("");
+  return EDITOR_LINE;
+}
+
+/**
+ * @brief Accepts the lines before the last newline of the line at once, the
+ * text after it is kept for the next line. The first line is displayed at
+ * the prompt and the others below it, with no prompt in between.
+ */
+static editor_status_e accept_block(size_t last_nl) {
+  size_t len = (size_t)arrlen(ed.line);
+  ARR_CLEAR(ed.carry);
+  if (len > last_nl + 1) {
+    arrsetlen(ed.carry, len - last_nl - 1);
+    memcpy(ed.carry, ed.line + last_nl + 1, len - last_nl - 1);
+  }
+
+  // the other lines, each after its newline
+  size_t first = (size_t)((char *)memchr(ed.line, '\n', len) - ed.line);
+  size_t more = last_nl - first;
+  char *rest = xstrdup_n(ed.line + first, more);
+  arrsetlen(ed.line, first);
+  ed.cursor = first;
+  finish_line("");
+  if (more > 0) {
+    out_str(rest + 1, more - 1);
+    out_str("\r\n", 2);
+  }
+  insert(rest, more);
+  free(rest);
+  return EDITOR_LINE;
+}
+
+/**
+ * @brief Handles a bracketed paste: its text is inserted as is, except for
+ * its newlines which accept the lines they end, all at once.
+ * @return the number of bytes used, 0 if the paste is not complete yet
+ */
+static size_t handle_paste(const char *s, size_t n, editor_status_e *st) {
+  size_t open = strlen(PASTE_START), close = strlen(PASTE_END);
+  const char *end = memmem(s + open, n - open, PASTE_END, close);
+  if (!end)
+    return 0;
+
+  // terminals send the newlines of a paste as carriage returns
+  for (const char *p = s + open; p < end; p++) {
+    if (*p == '\n' && p > s + open && p[-1] == '\r')
+      continue;
+    insert(*p == '\r' ? "\n" : p, 1);
+  }
+  const char *nl = memrchr(ed.line, '\n', (size_t)arrlen(ed.line));
+  if (nl)
+    *st = accept_block((size_t)(nl - ed.line));
+  return (size_t)(end - s) + close;
+}
+
+static editor_status_e handle_control(unsigned char c) {
+  size_t len = (size_t)arrlen(ed.line);
+  switch (c) {
+  case '\r':
+  case '\n':
+    return accept_line();
+  case KEY_CTRL('A'):
+    ed.cursor = 0;
+    break;
+  case KEY_CTRL('E'):
+    if (!accept_hint(false))
+      ed.cursor = len;
+    break;
+  case KEY_CTRL('B'):
+    ed.cursor = prev_char(ed.cursor);
+    break;
+  case KEY_CTRL('F'):
+    if (!accept_hint(false))
+      ed.cursor = next_char(ed.cursor);
+    break;
+  case KEY_CTRL('D'):
+    if (len == 0)
+      return EDITOR_EOF;
+    kill_range(ed.cursor, next_char(ed.cursor), false);
+    break;
+  case KEY_CTRL('H'):
+  case 0x7f:
+    kill_range(prev_char(ed.cursor), ed.cursor, false);
+    break;
+  case KEY_CTRL('K'):
+    kill_range(ed.cursor, len, true);
+    break;
+  case KEY_CTRL('U'):
+    kill_range(0, ed.cursor, true);
+    break;
+  case KEY_CTRL('W'):
+    // words are separated by blanks here, as in readline
+    {
+      size_t from = ed.cursor;
+      while (from > 0 && isspace((unsigned char)ed.line[from - 1]))
+        from--;
+      while (from > 0 && !isspace((unsigned char)ed.line[from - 1]))
+        from--;
+      kill_range(from, ed.cursor, true);
+    }
+    break;
+  case KEY_CTRL('Y'):
+    if (arrlen(ed.kill) > 0)
+      insert(ed.kill, (size_t)arrlen(ed.kill));
+    break;
+  case KEY_CTRL('T'):
+    transpose();
+    break;
+  case KEY_CTRL('P'):
+    history_move(true);
+    break;
+  case KEY_CTRL('N'):
+    history_move(false);
+    break;
+  case KEY_CTRL('L'):
+    out_str(ESC "[H" ESC "[2J", 7);
+    redraw_all();
+    break;
+  case KEY_CTRL('C'):
+    editor_cancel();
+    break;
+  case '\t':
+    complete_word();
+    break;
+  default:
+    break; // Ctrl-Z, Ctrl-R... are not bound
+  }
+  return EDITOR_MORE;
+}
+
+static void handle_meta(char c) {
+  switch (c) {
+  case 'b':
+    ed.cursor = prev_word(ed.cursor);
+    break;
+  case 'f':
+    if (!accept_hint(true))
+      ed.cursor = next_word(ed.cursor);
+    break;
+  case 'd':
+    kill_range(ed.cursor, next_word(ed.cursor), true);
+    break;
+  case 0x7f:
+  case KEY_CTRL('H'):
+    kill_range(prev_word(ed.cursor), ed.cursor, true);
+    break;
+  case '<':
+    while (ed.hist_pos > 0)
+      history_move(true);
+    break;
+  case '>':
+    while (ed.hist_pos < history_count())
+      history_move(false);
+    break;
+  default:
+    break;
+  }
+}
+
+// CSI and SS3 sequences of the cursor keys and of the editing keypad
+static void handle_sequence(const char *seq, size_t len) {
+  char final = seq[len - 1];
+  bool ctrl = len >= 4 && seq[len - 2] == '5' && seq[len - 3] == ';';
+  switch (final) {
+  case 'A':
+    history_move(true);
+    break;
+  case 'B':
+    history_move(false);
+    break;
+  case 'C':
+    if (!accept_hint(ctrl))
+      ed.cursor = ctrl ? next_word(ed.cursor) : next_char(ed.cursor);
+    break;
+  case 'D':
+    ed.cursor = ctrl ? prev_word(ed.cursor) : prev_char(ed.cursor);
+    break;
+  case 'H':
+    ed.cursor = 0;
+    break;
+  case 'F':
+    if (!accept_hint(false))
+      ed.cursor = (size_t)arrlen(ed.line);
+    break;
+  case '~':
+    if (seq[2] == '1' || seq[2] == '7')
+      ed.cursor = 0;
+    else if ((seq[2] == '4' || seq[2] == '8') && !accept_hint(false))
+      ed.cursor = (size_t)arrlen(ed.line);
+    else if (seq[2] == '3')
+      kill_range(ed.cursor, next_char(ed.cursor), false);
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief Handles the key at the start of the pending bytes.
+ * @return the number of bytes used, 0 if the key is not complete yet
+ */
+static size_t handle_key(const char *s, size_t n, editor_status_e *st) {
+  unsigned char c = (unsigned char)s[0];
+  // a key other than TAB gives up on the directory listing TAB started
+  if (c != '\t')
+    dir_index_cancel();
+  size_t open = strlen(PASTE_START);
+  if (n >= open && memcmp(s, PASTE_START, open) == 0)
+    return handle_paste(s, n, st);
+  if (c == 0x1b) {
+    if (n < 2 || (n < open && memcmp(s, PASTE_START, n) == 0))
+      return 0;
+    if (s[1] == '[' || s[1] == 'O') {
+      size_t i = 2;
+      while (i < n && !((unsigned char)s[i] >= 0x40 &&
+                        (unsigned char)s[i] <= 0x7e && (s[1] == 'O' ||
+                                                        s[i] != '[')))
+        i++;
+      if (i == n)
+        return n >= EDITOR_SEQ_MAX ? n : 0;
+      handle_sequence(s, i + 1);
+      return i + 1;
+    }
+    handle_meta(s[1]);
+    return 2;
+  }
+  if (c < 0x20 || c == 0x7f) {
+    *st = handle_control(c);
+    return 1;
+  }
+
+  size_t len = utf8_len(c);
+  if (len > n)
+    return 0;
+  insert(s, len);
+  return len;
+}
+
+/* --- API --- */
+
+void editor_begin(const char *prompt, int in_fd, int out_fd) {
+  ed.active = true;
+  ed.in_fd = in_fd;
+  ed.out_fd = out_fd;
+  update_cols();
+  raw_mode();
+
+  free(ed.prompt);
+  ed.prompt = xmalloc(strlen(prompt) + 1);
+  size_t j = 0;
+  for (size_t i = 0; prompt[i]; i++) {
+    if (prompt[i] != '\001' && prompt[i] != '\002')
+      ed.prompt[j++] = prompt[i];
+  }
+  ed.prompt[j] = '\0';
+  ed.prompt_width = prompt_width(prompt);
+
+  set_line(NULL);
+  if (arrlen(ed.carry) > 0) {
+    insert(ed.carry, (size_t)arrlen(ed.carry));
+    ARR_CLEAR(ed.carry);
+  }
+  ed.hist_pos = history_count();
+  highlight_reset();
+  show_prompt();
+  flush_output();
+}
+
+editor_status_e editor_feed(const char *bytes, size_t len) {
+  if (len > 0) {
+    size_t off = (size_t)arrlen(ed.pending);
+    arrsetlen(ed.pending, off + len);
+    memcpy(ed.pending + off, bytes, len);
+  }
+
+  // keys read at once, as in a paste, are displayed once; the bytes after
+  // an accepted line are kept for the next one
+  editor_status_e st = EDITOR_MORE;
+  size_t used = 0, n;
+  while (st == EDITOR_MORE && used < (size_t)arrlen(ed.pending) &&
+         (n = handle_key(ed.pending + used, (size_t)arrlen(ed.pending) - used,
+                         &st)) > 0)
+    used += n;
+  if (used > 0)
+    arrdeln(ed.pending, 0, used);
+
+  if (st == EDITOR_MORE)
+    refresh(true);
+  flush_output();
+  return st;
+}
+
+char *editor_take_line(void) {
+  char *line = xstrdup_n(ed.line ? ed.line : "", (size_t)arrlen(ed.line));
+  editor_end();
+  return line;
+}
+
+void editor_cancel(void) {
+  finish_line("^C");
+  set_line(NULL);
+  ed.hist_pos = history_count();
+  show_prompt();
+  flush_output();
+  shell_state_get_last_exec()->exit_status = 128 + SIGINT;
+}
+
+void editor_redraw(void) {
+  redraw_all();
+  flush_output();
+}
+
+void editor_resize(void) {
+  // the lines are wrapped again by the terminal, the whole line is redrawn
+  // from the row of the prompt
+  size_t row = ed.term_pos / ed.cols;
+  if (row > 0)
+    out_move(row, 'A');
+  out_str("\r" ESC "[J", 4);
+  update_cols();
+  redraw_all();
+  flush_output();
+}
+
+void editor_end(void) {
+  restore_mode();
+  ed.active = false;
+  free(ed.saved_line);
+  ed.saved_line = NULL;
+}
+
+bool editor_active(void) { return ed.active; }
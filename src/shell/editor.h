@@ -0,0 +1,94 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __EDITOR_H__
+#define __EDITOR_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Native line editor, an alternative to readline built with
+ * -DENABLE_LINE_EDITOR=ON and enabled with 'set -o lineedit'.
+ *
+ * It is fed the bytes read from the terminal by the input loop and supports
+ * the common emacs bindings, the history of the shell and UTF-8 text (wide
+ * and combining characters). The screen is redrawn by difference: the line
+ * is kept as cells (a character and its width) and a change only rewrites
+ * the cells from the first one that differs, with relative cursor moves.
+ * Every key produces at most one write(), typing at the end of the line
+ * writes the character alone.
+ *
+ * TAB completes command names from the command index and file names from
+ * the directory index (shell/completion.h): a single match is inserted,
+ * several insert their common prefix or are listed below the line.
+ *
+ * With the cursor at the end of the line, the history command with the best
+ * frecency that extends it is displayed dimmed after it: the right arrow,
+ * Ctrl-F, Ctrl-E and End accept it, Alt-f and Ctrl-right its next word.
+ *
+ * Bracketed paste is turned on while a line is edited at a terminal. A
+ * pasted block holding newlines is accepted at once, as a single line with
+ * its newlines, and displayed once below the prompt; the text after its
+ * last newline starts the next line.
+ */
+
+typedef enum {
+  EDITOR_MORE, /**< The line is still being edited */
+  EDITOR_LINE, /**< A line was accepted, see editor_take_line() */
+  EDITOR_EOF   /**< Ctrl-D on an empty line */
+} editor_status_e;
+
+/**
+ * @brief Starts editing a line: puts the terminal in raw mode (if in_fd is
+ * a terminal) and displays the prompt.
+ * @param prompt prompt, where bytes between \001 and \002 take no room
+ * @param in_fd terminal whose mode is changed
+ * @param out_fd where the line is displayed
+ */
+void editor_begin(const char *prompt, int in_fd, int out_fd);
+
+/**
+ * @brief Handles bytes typed at the terminal. Escape sequences and UTF-8
+ * characters may be split across calls.
+ */
+editor_status_e editor_feed(const char *bytes, size_t len);
+
+/**
+ * @brief Returns the accepted line and restores the terminal.
+ * @return heap-allocated line
+ */
+char *editor_take_line(void);
+
+/**
+ * @brief Drops the edited line and displays a fresh prompt below it, as for
+ * Ctrl-C.
+ */
+void editor_cancel(void);
+
+/**
+ * @brief Redraws the prompt and the line on a new row, after something else
+ * was printed.
+ */
+void editor_redraw(void);
+
+/**
+ * @brief Takes a new terminal width into account.
+ */
+void editor_resize(void);
+
+/**
+ * @brief Restores the terminal mode, when the line is abandoned.
+ */
+void editor_end(void);
+
+/**
+ * @brief Tells whether a line is being edited.
+ */
+bool editor_active(void);
+
+#endif // __EDITOR_H__
@@ -0,0 +1,346 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _DEFAULT_SOURCE
+
+#include "highlight.h"
+#include "builtin/builtin.h"
+#include "executor/command_hash.h"
+#include "utils/collections.h"
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// tokens scanned between two looks at the clock
+#define HIGHLIGHT_CLOCK_EVERY 64
+
+/**
+ * @brief What the next word of the line is, which decides its style.
+ */
+typedef enum {
+  CTX_COMMAND,    /**< A command name */
+  CTX_ARG,        /**< An argument */
+  CTX_REDIR_CMD,  /**< The target of a redirection before the command */
+  CTX_REDIR_ARG   /**< The target of a redirection after the command */
+} scan_ctx_e;
+
+/**
+ * @brief Start of a token and state of the scanner there, where a later scan
+ * can resume.
+ */
+typedef struct {
+  size_t off;
+  uint8_t ctx;
+} mark_t;
+
+static struct {
+  char *line;      /**< stb_ds array, the line last styled */
+  uint8_t *styles; /**< stb_ds array, a style per byte of the line */
+  mark_t *marks;   /**< stb_ds array, in increasing offsets */
+  size_t done;     /**< Bytes scanned, the rest is plain */
+  uint64_t hash_gen;
+  bool hash_gen_set;
+  struct timespec started;
+  size_t tokens;
+} hl;
+
+static const char *sgr[HL_STYLE_COUNT] = {
+    [HL_DEFAULT] = "\x1b[0m",      [HL_COMMAND] = "\x1b[0;32m",
+    [HL_BUILTIN] = "\x1b[0;36m",   [HL_UNKNOWN] = "\x1b[0;31m",
+    [HL_STRING] = "\x1b[0;33m",    [HL_VARIABLE] = "\x1b[0;35m",
+    [HL_GLOB] = "\x1b[0;34m",      [HL_REDIRECT] = "\x1b[0;1m",
+    [HL_OPERATOR] = "\x1b[0;1m",   [HL_COMMENT] = "\x1b[0;90m",
+    [HL_SUGGESTION] = "\x1b[0;2m",
+};
+
+// keywords of the parser, and the context of the word that follows them
+static const struct {
+  const char *word;
+  scan_ctx_e next;
+} keywords[] = {
+    {"case", CTX_ARG}, {"do", CTX_COMMAND},   {"done", CTX_ARG},
+    {"esac", CTX_ARG}, {"for", CTX_ARG},
+};
+
+static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\n'; }
+
+static bool is_operator(char c) { return c && strchr("|&;<>()", c); }
+
+static bool is_name_char(char c) {
+  return isalnum((unsigned char)c) || c == '_';
+}
+
+static void fill(size_t from, size_t to, uint8_t style) {
+  memset(hl.styles + from, style, to - from);
+}
+
+static bool over_budget(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long long ns = (now.tv_sec - hl.started.tv_sec) * 1000000000LL +
+                 (now.tv_nsec - hl.started.tv_nsec);
+  return ns > HIGHLIGHT_BUDGET_NS;
+}
+
+// end of the parenthesized text opening at i, or the end of the line
+static size_t match_paren(const char *s, size_t len, size_t i) {
+  int depth = 0;
+  for (; i < len; i++) {
+    if (s[i] == '\\') {
+      i++;
+    } else if (s[i] == '(') {
+      depth++;
+    } else if (s[i] == ')' && --depth == 0) {
+      return i + 1;
+    }
+  }
+  return len;
+}
+
+/**
+ * @brief Finds the end of the expansion starting at s[i], a '$' or a '`'.
+ */
+static size_t scan_expansion(const char *s, size_t len, size_t i) {
+  if (s[i] == '`') {
+    const char *end = memchr(s + i + 1, '`', len - i - 1);
+    return end ? (size_t)(end - s) + 1 : len;
+  }
+  if (i + 1 >= len)
+    return i + 1;
+
+  char c = s[i + 1];
+  if (c == '(')
+    return match_paren(s, len, i + 1);
+  if (c == '{') {
+    const char *end = memchr(s + i + 2, '}', len - i - 2);
+    return end ? (size_t)(end - s) + 1 : len;
+  }
+  if (isdigit((unsigned char)c) || (c && strchr("?$!#@*-", c)))
+    return i + 2;
+  size_t j = i + 1;
+  while (j < len && is_name_char(s[j]))
+    j++;
+  return j;
+}
+
+// styles a double-quoted string opening at i and returns its end
+static size_t scan_dquote(const char *s, size_t len, size_t i) {
+  size_t j = i + 1;
+  hl.styles[i] = HL_STRING;
+  while (j < len && s[j] != '"') {
+    if (s[j] == '$' || s[j] == '`') {
+      size_t end = scan_expansion(s, len, j);
+      fill(j, end, HL_VARIABLE);
+      j = end;
+    } else {
+      size_t n = s[j] == '\\' && j + 1 < len ? 2 : 1;
+      fill(j, j + n, HL_STRING);
+      j += n;
+    }
+  }
+  if (j < len)
+    hl.styles[j++] = HL_STRING;
+  return j;
+}
+
+static uint8_t command_style(const char *s, size_t len, scan_ctx_e *next) {
+  char *name = xstrdup_n(s, len);
+  uint8_t style;
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (strcmp(name, keywords[i].word) == 0) {
+      *next = keywords[i].next;
+      free(name);
+      return HL_BUILTIN;
+    }
+  }
+
+  if (builtin_is_builtin(name))
+    style = HL_BUILTIN;
+  else if (strchr(name, '/'))
+    style = access(name, X_OK) == 0 ? HL_COMMAND : HL_UNKNOWN;
+  else
+    style = command_hash_exists(name) ? HL_COMMAND : HL_UNKNOWN;
+  free(name);
+  return style;
+}
+
+/**
+ * @brief Styles the word starting at i. In command position, a word without
+ * quotes nor expansions is looked up.
+ * @return the end of the word
+ */
+static size_t scan_word(const char *s, size_t len, size_t i, scan_ctx_e *ctx) {
+  size_t start = i;
+  bool plain = true;
+  while (i < len && !is_blank(s[i]) && !is_operator(s[i])) {
+    char c = s[i];
+    size_t end = i + 1;
+    if (c == '\\') {
+      end = i + 2 < len ? i + 2 : len;
+      plain = false;
+    } else if (c == '\'') {
+      const char *q = memchr(s + i + 1, '\'', len - i - 1);
+      end = q ? (size_t)(q - s) + 1 : len;
+      fill(i, end, HL_STRING);
+      plain = false;
+    } else if (c == '"') {
+      end = scan_dquote(s, len, i);
+      plain = false;
+    } else if (c == '$' || c == '`') {
+      end = scan_expansion(s, len, i);
+      fill(i, end, HL_VARIABLE);
+      plain = false;
+    } else if (c == '*' || c == '?' || c == '[') {
+      hl.styles[i] = HL_GLOB;
+      plain = false;
+    }
+    i = end;
+  }
+
+  scan_ctx_e next = CTX_ARG;
+  if (*ctx == CTX_COMMAND && plain)
+    fill(start, i, command_style(s + start, i - start, &next));
+  else if (*ctx == CTX_REDIR_CMD)
+    next = CTX_COMMAND;
+  *ctx = next;
+  return i;
+}
+
+/**
+ * @brief Styles the operator or redirection starting at i.
+ * @return the end of the operator
+ */
+static size_t scan_operator(const char *s, size_t len, size_t i,
+                            scan_ctx_e *ctx) {
+  char c = s[i];
+  char n = i + 1 < len ? s[i + 1] : '\0';
+
+  if ((c == '<' || c == '>') && n == '(') {
+    // a process substitution is a word
+    size_t end = match_paren(s, len, i + 1);
+    fill(i, end, HL_VARIABLE);
+    if (*ctx == CTX_COMMAND)
+      *ctx = CTX_ARG;
+    return end;
+  }
+
+  if (c == '<' || c == '>' || (c == '&' && n == '>')) {
+    size_t end = i + 1;
+    while (end < len && end < i + 3 && s[end] && strchr("<>&-", s[end]))
+      end++;
+    fill(i, end, HL_REDIRECT);
+    *ctx = *ctx == CTX_COMMAND ? CTX_REDIR_CMD : CTX_REDIR_ARG;
+    return end;
+  }
+
+  size_t end = i + (n == c && c != '(' && c != ')' ? 2 : 1);
+  fill(i, end, HL_OPERATOR);
+  *ctx = c == ')' ? CTX_ARG : CTX_COMMAND;
+  return end;
+}
+
+/**
+ * @brief Scans from a token start until the end of the line or of the
+ * budget, recording the token starts.
+ * @return the offset where the scan stopped
+ */
+static size_t scan(const char *s, size_t len, size_t i, scan_ctx_e ctx) {
+  for (;;) {
+    for (; i < len && is_blank(s[i]); i++) {
+      if (s[i] == '\n')
+        ctx = CTX_COMMAND;
+    }
+    if (i >= len)
+      return len;
+
+    arrpush(hl.marks, ((mark_t){.off = i, .ctx = (uint8_t)ctx}));
+    if ((ctx == CTX_COMMAND || ++hl.tokens % HIGHLIGHT_CLOCK_EVERY == 0) &&
+        over_budget())
+      return i;
+
+    if (s[i] == '#') {
+      const char *nl = memchr(s + i, '\n', len - i);
+      size_t end = nl ? (size_t)(nl - s) : len;
+      fill(i, end, HL_COMMENT);
+      i = end;
+      continue;
+    }
+
+    // a file descriptor number before a redirection
+    size_t j = i;
+    while (j < len && isdigit((unsigned char)s[j]))
+      j++;
+    if (j > i && j < len && (s[j] == '<' || s[j] == '>')) {
+      fill(i, j, HL_REDIRECT);
+      i = scan_operator(s, len, j, &ctx);
+    } else if (is_operator(s[i])) {
+      i = scan_operator(s, len, i, &ctx);
+    } else {
+      i = scan_word(s, len, i, &ctx);
+    }
+  }
+}
+
+const uint8_t *highlight_line(const char *line, size_t len) {
+  uint64_t gen = command_hash_generation();
+  if (!hl.hash_gen_set || gen != hl.hash_gen)
+    highlight_reset();
+  hl.hash_gen = gen;
+  hl.hash_gen_set = true;
+
+  size_t old = (size_t)arrlen(hl.line), same = 0;
+  while (same < old && same < len && hl.line[same] == line[same])
+    same++;
+  if (same == len && old == len && hl.done == len)
+    return hl.styles;
+  if (same > hl.done)
+    same = hl.done;
+
+  // the tokens before the one holding the first change are kept
+  size_t m = (size_t)arrlen(hl.marks);
+  while (m > 0 && hl.marks[m - 1].off > same)
+    m--;
+  size_t from = 0;
+  scan_ctx_e ctx = CTX_COMMAND;
+  if (m > 0) {
+    m--;
+    from = hl.marks[m].off;
+    ctx = hl.marks[m].ctx;
+  }
+  arrsetlen(hl.marks, m);
+
+  arrsetlen(hl.line, len);
+  arrsetlen(hl.styles, len);
+  if (len == 0)
+    return hl.styles;
+  memcpy(hl.line, line, len);
+  fill(from, len, HL_DEFAULT);
+
+  clock_gettime(CLOCK_MONOTONIC, &hl.started);
+  hl.tokens = 0;
+  hl.done = scan(line, len, from, ctx);
+  return hl.styles;
+}
+
+const char *highlight_sgr(uint8_t style) {
+  return style < HL_STYLE_COUNT ? sgr[style] : sgr[HL_DEFAULT];
+}
+
+void highlight_reset(void) {
+  arrfree(hl.line);
+  arrfree(hl.marks);
+  hl.done = 0;
+}
+
+void highlight_free(void) {
+  arrfree(hl.line);
+  arrfree(hl.styles);
+  arrfree(hl.marks);
+  hl.done = 0;
+  hl.hash_gen_set = false;
+}
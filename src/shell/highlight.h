@@ -0,0 +1,60 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __HIGHLIGHT_H__
+#define __HIGHLIGHT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Syntax highlighting of the line being edited by the native line editor.
+ *
+ * A small scanner, separate from the lexer of the parser, gives a style to
+ * every byte. It remembers where each token of the previous line started
+ * and the state of the scanner there: after a keystroke only the tokens
+ * from the one holding the first changed byte are scanned again. Commands
+ * are looked up in the command hash table (command_hash_exists()), and a
+ * pass stops after HIGHLIGHT_BUDGET_NS: the rest of the line is left plain
+ * and is scanned on the next keystroke, from where this one stopped.
+ */
+
+typedef enum {
+  HL_DEFAULT,
+  HL_COMMAND,  /**< External command found in PATH */
+  HL_BUILTIN,  /**< Builtin or shell keyword */
+  HL_UNKNOWN,  /**< Command that cannot be found */
+  HL_STRING,   /**< Quoted text */
+  HL_VARIABLE, /**< $name, ${...}, $(...) and $((...)) */
+  HL_GLOB,     /**< Pattern characters: * ? [ */
+  HL_REDIRECT, /**< Redirection operators */
+  HL_OPERATOR, /**< | || && ; & ( ) */
+  HL_COMMENT,
+  HL_SUGGESTION, /**< History suggestion after the line */
+  HL_STYLE_COUNT
+} highlight_style_e;
+
+/**
+ * @brief Styles a line, reusing what was found for the previous one.
+ * @return one highlight_style_e per byte of the line, valid until the next
+ * call
+ */
+const uint8_t *highlight_line(const char *line, size_t len);
+
+/**
+ * @brief Returns the SGR escape sequence selecting a style.
+ */
+const char *highlight_sgr(uint8_t style);
+
+/**
+ * @brief Forgets the previous line, the next one is scanned in full.
+ */
+void highlight_reset(void);
+
+void highlight_free(void);
+
+#endif // __HIGHLIGHT_H__
@@ -0,0 +1,204 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#include "input.h"
+#include "shell/dir_index.h"
+#include "shell/signal.h"
+#include "utils/system/syscall.h"
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#ifdef NSH_LINE_EDITOR
+#include "shell/editor.h"
+#include "shell/highlight.h"
+#endif
+
+#define INPUT_READ_SIZE 4096
+
+static int sfd = -1;
+static sigset_t input_mask;
+
+static char *line_read;
+static bool line_done;
+static bool use_editor;
+
+static void on_line(char *line) {
+  line_read = line;
+  line_done = true;
+  // the prompt is not shown again until the next line is asked for
+  rl_callback_handler_remove();
+}
+
+/**
+ * @brief Handles the signals queued on the signalfd.
+ * @param editing a line is being edited, Ctrl-C and resizes apply to it
+ */
+static void drain_signals(bool editing) {
+  struct signalfd_siginfo si;
+  while (read(sfd, &si, sizeof(si)) == sizeof(si)) {
+    switch (si.ssi_signo) {
+    case SIGCHLD:
+      handle_sigchld_events();
+      break;
+    case SIGINT:
+      if (!editing)
+        break;
+#ifdef NSH_LINE_EDITOR
+      if (use_editor) {
+        editor_cancel();
+        break;
+      }
+#endif
+      handle_sigint_event();
+      break;
+    case SIGWINCH:
+      if (!editing)
+        break;
+#ifdef NSH_LINE_EDITOR
+      if (use_editor) {
+        editor_resize();
+        break;
+      }
+#endif
+      rl_resize_terminal();
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+#ifdef NSH_LINE_EDITOR
+// the terminal is in raw mode, Ctrl-C arrives as a key and not as SIGINT
+static void editor_read(void) {
+  char buf[INPUT_READ_SIZE];
+  ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+  if (n == -1 && (errno == EINTR || errno == EAGAIN))
+    return;
+
+  editor_status_e st = n > 0 ? editor_feed(buf, (size_t)n) : EDITOR_EOF;
+  if (st == EDITOR_MORE)
+    return;
+  if (st == EDITOR_LINE) {
+    line_read = editor_take_line();
+  } else {
+    editor_end();
+  }
+  line_done = true;
+}
+#endif
+
+static void start_line(const char *prompt) {
+  use_editor = false;
+#ifdef NSH_LINE_EDITOR
+  if (shell_state_get()->flags.line_edit && isatty(STDIN_FILENO)) {
+    use_editor = true;
+    fflush(stdout);
+    editor_begin(prompt, STDIN_FILENO, STDOUT_FILENO);
+    // keys typed after the previous line, as in a paste of several lines
+    editor_status_e st = editor_feed(NULL, 0);
+    if (st != EDITOR_MORE) {
+      line_read = st == EDITOR_LINE ? editor_take_line() : NULL;
+      if (st == EDITOR_EOF)
+        editor_end();
+      line_done = true;
+    }
+    return;
+  }
+#endif
+  rl_callback_handler_install(prompt, on_line);
+}
+
+static void stop_line(void) {
+#ifdef NSH_LINE_EDITOR
+  if (use_editor) {
+    editor_end();
+    return;
+  }
+#endif
+  rl_callback_handler_remove();
+}
+
+static void read_input(void) {
+#ifdef NSH_LINE_EDITOR
+  if (use_editor) {
+    editor_read();
+    return;
+  }
+#endif
+  rl_callback_read_char();
+  // a key other than TAB gives up on the directory listing TAB started
+  if (rl_last_func != rl_complete && rl_last_func != rl_possible_completions &&
+      rl_last_func != rl_menu_complete)
+    dir_index_cancel();
+}
+
+char *input_read_line(const char *prompt) {
+  if (sfd == -1) {
+    sigemptyset(&input_mask);
+    sigaddset(&input_mask, SIGCHLD);
+    sigaddset(&input_mask, SIGINT);
+    sigaddset(&input_mask, SIGWINCH);
+    // readline must not install handlers of its own, signals are read here
+    rl_catch_signals = 0;
+    rl_catch_sigwinch = 0;
+    // a pasted block is inserted whole and accepted as one input
+    rl_variable_bind("enable-bracketed-paste", "on");
+  }
+
+  sigset_t prev_mask;
+  xsigprocmask(SIG_BLOCK, &input_mask, &prev_mask);
+  if (sfd == -1)
+    sfd = xsignalfd(-1, &input_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+  line_read = NULL;
+  line_done = false;
+  start_line(prompt);
+
+  struct pollfd pfds[2] = {{.fd = STDIN_FILENO, .events = POLLIN},
+                           {.fd = sfd, .events = POLLIN}};
+  while (!line_done) {
+    if (poll(pfds, 2, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      perror("poll");
+      stop_line();
+      break;
+    }
+    // children are reaped before the input is read, a completed job is
+    // reported before the line that follows it runs
+    if (pfds[1].revents & POLLIN)
+      drain_signals(true);
+    if (!line_done && pfds[0].revents & (POLLIN | POLLHUP | POLLERR))
+      read_input();
+  }
+
+  // nothing blocked here may stay pending once the mask is restored
+  drain_signals(false);
+  xsigprocmask(SIG_SETMASK, &prev_mask, NULL);
+  return line_read;
+}
+
+void input_redisplay(void) {
+#ifdef NSH_LINE_EDITOR
+  if (editor_active()) {
+    editor_redraw();
+    return;
+  }
+#endif
+  rl_forced_update_display();
+}
+
+void input_cleanup(void) {
+  if (sfd != -1)
+    close(sfd);
+  sfd = -1;
+#ifdef NSH_LINE_EDITOR
+  highlight_free();
+#endif
+}
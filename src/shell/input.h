@@ -0,0 +1,46 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+/*
+ * Interactive line input. Readline runs in callback mode and the shell
+ * sleeps in poll() over stdin and a signalfd receiving SIGCHLD, SIGINT and
+ * SIGWINCH: an idle prompt uses no CPU, and a background job that changes
+ * state is reaped as soon as its SIGCHLD arrives instead of on readline's
+ * next idle timer.
+ *
+ * When the shell is built with the native line editor (shell/editor.h) and
+ * 'set -o lineedit' is on, lines typed at a terminal are edited by it
+ * instead of readline, in the same loop.
+ *
+ * Both use bracketed paste: a pasted block of several lines is returned as
+ * one input, which the shell parses once and runs without a prompt between
+ * its lines.
+ */
+
+/**
+ * @brief Reads a line at a prompt.
+ * Signals are only blocked while the line is read, children started once it
+ * is returned get the mask the shell had before.
+ * @return heap-allocated line without its newline, NULL at end of input
+ */
+char *input_read_line(const char *prompt);
+
+/**
+ * @brief Displays the prompt and the edited line again, after a message was
+ * printed while a line is read.
+ */
+void input_redisplay(void);
+
+/**
+ * @brief Releases the signalfd kept between lines.
+ */
+void input_cleanup(void);
+
+#endif // __INPUT_H__
@@ -0,0 +1,249 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#define _DEFAULT_SOURCE
+
+#include "shell/passwd_cache.h"
+#include "shell/config.h"
+#include "utils/collections.h"
+#include "utils/log.h"
+#include "utils/system/memory.h"
+#include <errno.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+static passwd_cache_entry_t *cache = NULL;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+// bumped by every flush so that a running prefetch drops what it read before
+static uint64_t flush_gen = 0;
+
+static pthread_t prefetch_thread;
+static bool prefetch_started = false;
+static atomic_bool prefetch_running = false;
+static atomic_bool prefetch_cancel = false;
+// start time and flush generation of the last prefetch
+static time_t prefetch_at = 0;
+static uint64_t prefetch_gen = UINT64_MAX;
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+static time_t now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/* --- FORK SAFETY --- */
+
+// the prefetch thread does not survive a fork, the lock must not be held by
+// it at that moment or the child would deadlock on its first lookup
+static void atfork_prepare(void) { pthread_mutex_lock(&cache_lock); }
+static void atfork_release(void) { pthread_mutex_unlock(&cache_lock); }
+
+static void register_atfork(void) {
+  pthread_atfork(atfork_prepare, atfork_release, atfork_release);
+}
+
+/* --- TABLE --- */
+
+// must be called with cache_lock held
+static void put_locked(const char *user, const char *home, time_t ttl,
+                       bool replace) {
+  if (!cache)
+    sh_new_strdup(cache);
+
+  // without replace, only fresh positive entries are kept
+  passwd_cache_entry_t *entry = shgetp_null(cache, user);
+  if (entry && !replace && entry->value.home &&
+      entry->value.expires > now_sec())
+    return;
+
+  passwd_cache_value_t value = {.home = home ? xstrdup(home) : NULL,
+                                .expires = now_sec() + ttl};
+  if (entry) {
+    free(entry->value.home);
+    entry->value = value;
+    return;
+  }
+  shput(cache, user, value);
+}
+
+static void free_table_locked(void) {
+  for (int i = 0; i < shlen(cache); i++)
+    free(cache[i].value.home);
+  shfree(cache);
+  cache = NULL;
+}
+
+/* --- LOOKUPS --- */
+
+/**
+ * @brief Queries the passwd database with the reentrant interface, the
+ * prefetch thread may be enumerating it at the same time.
+ * @return heap-allocated home directory, NULL if the user is unknown
+ */
+static char *lookup_home(const char *user) {
+  long size = sysconf(_SC_GETPW_R_SIZE_MAX);
+  size_t buf_len = size > 0 ? (size_t)size : 16384;
+
+  char *home = NULL;
+  for (;;) {
+    char *buf = xmalloc(buf_len);
+    struct passwd pw;
+    struct passwd *result = NULL;
+    int err = getpwnam_r(user, &pw, buf, buf_len, &result);
+    if (err == ERANGE && buf_len < (1 << 20)) {
+      free(buf);
+      buf_len *= 2;
+      continue;
+    }
+    if (result && result->pw_dir)
+      home = xstrdup(result->pw_dir);
+    free(buf);
+    return home;
+  }
+}
+
+char *passwd_cache_home(const char *user) {
+  if (!user || !*user)
+    return NULL;
+
+  pthread_mutex_lock(&cache_lock);
+  passwd_cache_entry_t *entry = cache ? shgetp_null(cache, user) : NULL;
+  if (entry && entry->value.expires > now_sec()) {
+    char *home = entry->value.home ? xstrdup(entry->value.home) : NULL;
+    pthread_mutex_unlock(&cache_lock);
+    return home;
+  }
+  pthread_mutex_unlock(&cache_lock);
+
+  // the lock is not held during the (possibly slow) NSS query
+  char *home = lookup_home(user);
+  pr_debug("passwd lookup for '%s': %s", user, home ? home : "unknown");
+
+  pthread_mutex_lock(&cache_lock);
+  put_locked(user, home,
+             home ? PASSWD_CACHE_TTL : PASSWD_CACHE_NEG_TTL, true);
+  pthread_mutex_unlock(&cache_lock);
+  return home;
+}
+
+void passwd_cache_insert(const char *user, const char *home) {
+  if (!user || !*user)
+    return;
+  pthread_mutex_lock(&cache_lock);
+  put_locked(user, home, home ? PASSWD_CACHE_TTL : PASSWD_CACHE_NEG_TTL,
+             true);
+  pthread_mutex_unlock(&cache_lock);
+}
+
+/* --- PREFETCH --- */
+
+typedef struct {
+  char *user;
+  char *home;
+} passwd_pair_t;
+
+static void *prefetch_worker(void *arg) {
+  (void)arg;
+
+  pthread_mutex_lock(&cache_lock);
+  uint64_t gen = flush_gen;
+  pthread_mutex_unlock(&cache_lock);
+
+  // getpwent() is not reentrant but this thread is its only user
+  passwd_pair_t *pairs = NULL;
+  setpwent();
+  struct passwd *pw;
+  while (!atomic_load(&prefetch_cancel) && (pw = getpwent()) != NULL) {
+    if (!pw->pw_name || !pw->pw_dir)
+      continue;
+    arrpush(pairs, ((passwd_pair_t){.user = xstrdup(pw->pw_name),
+                                    .home = xstrdup(pw->pw_dir)}));
+  }
+  endpwent();
+
+  // a single short critical section once the enumeration is over
+  pthread_mutex_lock(&cache_lock);
+  if (gen == flush_gen && !atomic_load(&prefetch_cancel)) {
+    for (int i = 0; i < arrlen(pairs); i++)
+      put_locked(pairs[i].user, pairs[i].home, PASSWD_CACHE_TTL, false);
+  }
+  pthread_mutex_unlock(&cache_lock);
+
+  pr_debug("passwd prefetch: %td users", arrlen(pairs));
+  for (int i = 0; i < arrlen(pairs); i++) {
+    free(pairs[i].user);
+    free(pairs[i].home);
+  }
+  arrfree(pairs);
+  atomic_store(&prefetch_running, false);
+  return NULL;
+}
+
+static void join_prefetch(void) {
+  if (!prefetch_started)
+    return;
+  pthread_join(prefetch_thread, NULL);
+  prefetch_started = false;
+}
+
+void passwd_cache_prefetch(void) {
+  pthread_once(&atfork_once, register_atfork);
+  if (atomic_load(&prefetch_running))
+    return;
+
+  // the previous prefetch is still fresh
+  pthread_mutex_lock(&cache_lock);
+  bool fresh = prefetch_gen == flush_gen &&
+               now_sec() - prefetch_at < PASSWD_CACHE_TTL;
+  uint64_t gen = flush_gen;
+  pthread_mutex_unlock(&cache_lock);
+  if (fresh)
+    return;
+
+  // reap the previous, finished, prefetch
+  join_prefetch();
+  atomic_store(&prefetch_cancel, false);
+  atomic_store(&prefetch_running, true);
+  if (pthread_create(&prefetch_thread, NULL, prefetch_worker, NULL) != 0) {
+    pr_err("%s", "passwd prefetch: cannot start thread");
+    atomic_store(&prefetch_running, false);
+    return;
+  }
+  prefetch_started = true;
+  prefetch_at = now_sec();
+  prefetch_gen = gen;
+}
+
+/* --- MAINTENANCE --- */
+
+void passwd_cache_flush(void) {
+  pthread_mutex_lock(&cache_lock);
+  free_table_locked();
+  flush_gen++;
+  pthread_mutex_unlock(&cache_lock);
+}
+
+size_t passwd_cache_size(void) {
+  pthread_mutex_lock(&cache_lock);
+  size_t n = (size_t)shlen(cache);
+  pthread_mutex_unlock(&cache_lock);
+  return n;
+}
+
+void passwd_cache_free(void) {
+  atomic_store(&prefetch_cancel, true);
+  join_prefetch();
+
+  pthread_mutex_lock(&cache_lock);
+  free_table_locked();
+  pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,70 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __PASSWD_CACHE_H__
+#define __PASSWD_CACHE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * User name to home directory cache in front of the passwd database.
+ *
+ * NSS lookups can be slow (LDAP, SSSD...), so answers are remembered for
+ * PASSWD_CACHE_TTL seconds. Unknown users are remembered as well, for
+ * PASSWD_CACHE_NEG_TTL seconds, so that a typo is not looked up again on
+ * every expansion. The cache is safe to use from several threads.
+ */
+
+typedef struct {
+  char *home;     /**< Home directory, NULL for an unknown user */
+  time_t expires; /**< CLOCK_MONOTONIC second after which it is stale */
+} passwd_cache_value_t;
+
+typedef struct {
+  char *key;
+  passwd_cache_value_t value;
+} passwd_cache_entry_t;
+
+/**
+ * @brief Returns the home directory of a user, from the cache when a fresh
+ * entry exists or from the passwd database otherwise.
+ * @return heap-allocated copy of the directory, NULL if the user is unknown
+ */
+char *passwd_cache_home(const char *user);
+
+/**
+ * @brief Records the home directory of a user obtained elsewhere (e.g. the
+ * shell's own entry read at startup).
+ */
+void passwd_cache_insert(const char *user, const char *home);
+
+/**
+ * @brief Starts filling the cache with the whole passwd database from a
+ * background thread. Does nothing if a prefetch is already running or if
+ * the last one is younger than PASSWD_CACHE_TTL and no flush happened since.
+ * Entries found by explicit lookups meanwhile are not overwritten.
+ */
+void passwd_cache_prefetch(void);
+
+/**
+ * @brief Forgets every entry, positive or negative.
+ */
+void passwd_cache_flush(void);
+
+/**
+ * @brief Number of entries currently cached (stale ones included).
+ */
+size_t passwd_cache_size(void);
+
+/**
+ * @brief Waits for a running prefetch and releases the cache.
+ */
+void passwd_cache_free(void);
+
+#endif // __PASSWD_CACHE_H__
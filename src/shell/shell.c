@@ -12,12 +12,7 @@
 #include <string.h>
 
 static lexer_t *lex;
-
-static int shell_event_hook() {
-  handle_sigchld_events();
-  // Placeholder for future event handling (e.g., signal processing)
-  return 0;
-}
+static ast_cache_t *ast_cache;
 
 int shell_init(bool ignore_tty_warn) {
   // Initialize shell state early so signal handlers can safely access it.
@@ -30,6 +25,7 @@ int shell_init(bool ignore_tty_warn) {
 
   // create lexer after state init
   lex = lexer_new();
+  ast_cache = ast_cache_new(AST_CACHE_SIZE);
   // Only try to take terminal control if stdin is a TTY
   if (sh_state->flags.interactive) {
     // Put shell in its own process group
@@ -53,17 +49,71 @@ int shell_init(bool ignore_tty_warn) {
 
   // Disable buffering for stdout. Ensures immediate output for status messages.
   setbuf(stdout, NULL);
-  rl_event_hook = shell_event_hook;
   using_history();
+  completion_init();
   return 0;
 }
 
 void shell_cleanup() {
   history_trim();
+  pr_info("ast cache: %zu hits, %zu misses", ast_cache->hits,
+          ast_cache->misses);
+  ast_cache_free(ast_cache);
+  command_hash_free();
+  glob_cache_free();
+  pattern_cache_free();
+  cmdsub_cache_free();
+  arith_cache_free();
+  passwd_cache_free();
+  input_cleanup();
+  command_index_free();
+  dir_index_free();
   lexer_free(lex);
   shell_state_free();
 }
 
+int shell_run_script(const char *path) { return source_run_file(path); }
+
+void shell_source_rc() {
+  const char *home = shell_state_getenv("HOME");
+  if (!home)
+    return;
+
+  char rc_path[PATH_MAX];
+  int len = snprintf(rc_path, sizeof(rc_path), "%s/%s", home, RC_FILENAME);
+  if (len <= 0 || len >= (int)sizeof(rc_path) || access(rc_path, R_OK) != 0)
+    return;
+
+  source_run_file(rc_path);
+}
+
+/**
+ * @brief Parses an interactive line. The bodies of the here-documents it
+ * opens are read from the following lines, appended to the input so that
+ * the history and the AST cache see the whole command.
+ */
+static ast_node_t *parse_interactive(char **input) {
+  lexer_init(lex, *input);
+  ast_node_t *ast_node = parser_create_ast(lex);
+
+  while (lex->heredoc_eof) {
+    char *line = input_read_line(PS2);
+    if (!line)
+      break;
+    size_t len = strlen(*input);
+    size_t line_len = strlen(line);
+    *input = xrealloc(*input, len + line_len + 2);
+    (*input)[len] = '\n';
+    memcpy(*input + len + 1, line, line_len + 1);
+    free(line);
+
+    parser_free_ast(ast_node);
+    lexer_init(lex, *input);
+    ast_node = parser_create_ast(lex);
+  }
+  return ast_node;
+}
+
 int shell_loop() {
   shell_state_t *sh_state = shell_state_get();
   char *input = NULL;
@@ -71,17 +121,11 @@ int shell_loop() {
 
   bool warning_exit = false;
   do {
-    errno = 0;
     prompt = prompt_build_ps1();
-    input = readline(prompt);
+    input = input_read_line(prompt);
     free(prompt);
 
     if (!input) {
-      if (errno == EINTR) {
-        // readline was interrupted by a signal, go back to loop immediately
-        continue;
-      }
-
       // EOF (Ctrl+D)
       if (sh_state->jobs.running_jobs_count > 0 && !warning_exit) {
         printf("you have running jobs\n");
@@ -94,23 +138,23 @@ int shell_loop() {
     }
 
     warning_exit = false;
-    lexer_init(lex, input);
 
-    ast_node_t *ast_node = parser_create_ast(lex);
+    // identical lines reuse their parsed form, only expansion and execution
+    // run again. The AST is owned by the cache.
+    ast_node_t *ast_node = ast_cache_lookup(ast_cache, input);
+    if (!ast_node) {
+      ast_node = parse_interactive(&input);
+      expander_static_pass(ast_node);
+      ast_cache_insert(ast_cache, input, ast_node);
+    }
 #if defined(LOG_LEVEL) && LOG_LEVEL >= LOG_LEVEL_DEBUG
     char *ast_str = parser_ast_str(ast_node, 0);
     pr_debug("Raw AST:\n%s", ast_str);
     free(ast_str);
 #endif
-    expander_expand_ast(ast_node);
-#if defined(LOG_LEVEL) && LOG_LEVEL >= LOG_LEVEL_DEBUG
-    ast_str = parser_ast_str(ast_node, 0);
-    pr_debug("Expanded AST:\n%s", ast_str);
-    free(ast_str);
-#endif
-    history_save_command(lex->input);
+    history_save_command(input);
+    // commands are expanded one by one as they are executed
     exec_node(ast_node);
-    parser_free_ast(ast_node);
     free(input);
   } while (!sh_state->should_exit);
 
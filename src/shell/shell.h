@@ -18,9 +18,16 @@
 #include "expander/expander.h"
 #include "history/history.h"
 #include "lexer/lexer.h"
+#include "parser/ast_cache.h"
 #include "parser/parser.h"
 #include "prompt/ps1.h"
+#include "shell/command_index.h"
+#include "shell/completion.h"
+#include "shell/dir_index.h"
+#include "shell/input.h"
+#include "shell/passwd_cache.h"
 #include "shell/signal.h"
+#include "shell/source.h"
 #include "shell/state.h"
 #include <errno.h>
 #include <fcntl.h>
@@ -29,6 +36,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -44,14 +52,28 @@ int shell_init(bool ignore_tty_warn);
 
 /**
  * @brief Executes the main Read-Eval-Print Loop (REPL) of the shell.
- * * This function handles user input via Readline, processes signal flags set
- * asynchronously, parses the command line, and executes the resulting AST.
+ * * This function reads user input through the event-driven input loop
+ * (see shell/input.h), parses the command line, and executes the resulting AST.
  * The loop continues until the 'exit' command is executed or the user confirms
  * exit while running background jobs.
  * * @return The final exit status of the shell process (0 on clean exit).
  */
 int shell_loop();
 
+/**
+ * @brief Runs a script file non-interactively.
+ * The whole file is parsed at once (in parallel for large scripts, or loaded
+ * from its on-disk cache) before its commands are executed in order.
+ * @param path Path of the script.
+ * @return Exit status of the last command, or 1 if the file cannot be read.
+ */
+int shell_run_script(const char *path);
+
+/**
+ * @brief Sources the startup file (~/.nshrc) if it exists.
+ */
+void shell_source_rc();
+
 /**
  * @brief Performs necessary cleanup before the shell terminates.
  * * This includes trimming and saving command history
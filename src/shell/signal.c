@@ -7,12 +7,18 @@
  */
 
 #include "signal.h"
+#include "shell/input.h"
 
 void handle_sigint_event() {
-  // Ensure the terminal is clean after interrupt in the readline context
+  // the edited line is dropped and a fresh prompt is shown below it
+  rl_echo_signal_char(SIGINT);
+  rl_free_line_state();
+  rl_callback_sigcleanup();
+  rl_crlf();
   rl_on_new_line();
   rl_replace_line("", 0);
-  rl_redisplay(); // Force prompt redisplay
+  rl_redisplay();
+  shell_state_get_last_exec()->exit_status = 128 + SIGINT;
 }
 
 void handle_sigchld_events() {
@@ -24,7 +30,7 @@ void handle_sigchld_events() {
 
     if (p == NULL) {
       fprintf(stderr, "reaper: unknown pid %d\n", (int)pid);
-      rl_forced_update_display();
+      input_redisplay();
       continue;
     }
     job_t *job = p->parent_job;
@@ -52,9 +58,11 @@ void handle_sigchld_events() {
       pr_warn("reaper: pid %d unknown status 0x%x", (int)pid, status);
     }
 
-    if (job->live_processes == 0 && job->is_background) {
+    if (job->live_processes == 0 && job->is_procsub) {
+      jobs_remove_job(job->pgid);
+    } else if (job->live_processes == 0 && job->is_background) {
       jobs_mark_job_completed(job);
-      rl_forced_update_display();
+      input_redisplay();
     }
   }
 
@@ -22,16 +22,16 @@
 #include <stdio.h>
 
 /**
- * @brief Synchronously handles the SIGINT signal event.
- * flag is set. Its main responsibility is to clean up the Readline interface
- * (clearing the current line and redisplaying the prompt) after a Ctrl+C.
+ * @brief Synchronously handles a SIGINT received at the prompt, read from
+ * the signalfd of the input loop. The line being edited is dropped and a
+ * fresh prompt is displayed, like after a Ctrl+C in bash.
  */
 void handle_sigint_event();
 
 /**
  * @brief Synchronously processes all pending SIGCHLD events.
- * * This function is called from the main shell loop when the sigchld_received
- * flag is set. It uses waitpid() in a non-blocking loop to clean up terminated
+ * * This function is called when a SIGCHLD is read from a signalfd, by the
+ * input loop at the prompt or while a foreground job runs. It uses waitpid() in a non-blocking loop to clean up terminated
  * or stopped child processes and updates the shell's job list and display.
  */
 void handle_sigchld_events();
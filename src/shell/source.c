@@ -0,0 +1,241 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#define _GNU_SOURCE
+
+#include "executor/executor.h"
+#include "expander/expander.h"
+#include "parser/ast_serial.h"
+#include "source.h"
+#include "utils/utils.h"
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Builds the cache path of a script, creating the cache directory if
+ * needed.
+ * @return heap-allocated path or NULL if no cache can be used
+ */
+static char *cache_path_for(const char *path) {
+  char real[PATH_MAX];
+  if (!realpath(path, real))
+    return NULL;
+
+  char dir[PATH_MAX];
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = shell_state_getenv("HOME");
+  if (xdg && *xdg) {
+    snprintf(dir, sizeof(dir), "%s", xdg);
+  } else if (home && *home) {
+    snprintf(dir, sizeof(dir), "%s/.cache", home);
+  } else {
+    return NULL;
+  }
+
+  if (mkdir(dir, 0700) == -1 && errno != EEXIST)
+    return NULL;
+  strncat(dir, "/nsh", sizeof(dir) - strlen(dir) - 1);
+  if (mkdir(dir, 0700) == -1 && errno != EEXIST)
+    return NULL;
+
+  char *cache_path = NULL;
+  if (asprintf(&cache_path, "%s/%016llx%s", dir,
+               (unsigned long long)hash_fnv1a(real, strlen(real)),
+               SCRIPT_CACHE_EXT) < 0)
+    return NULL;
+  return cache_path;
+}
+
+static bool same_mtime(const script_cache_header_t *hdr,
+                       const struct stat *st) {
+  return hdr->mtime_sec == (int64_t)st->st_mtim.tv_sec &&
+         hdr->mtime_nsec == (int64_t)st->st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Maps the script in memory.
+ * @return the mapping, NULL for an empty file or MAP_FAILED on error
+ */
+static char *map_script(int fd, const struct stat *st) {
+  if (st->st_size == 0)
+    return NULL;
+  return mmap(NULL, (size_t)st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+}
+
+/**
+ * @brief Tries to load the AST from the cache file.
+ * A cache whose mtime differs from the script is still used when the content
+ * hash matches, its header is then refreshed.
+ * @return true if the cache was valid and fresh
+ */
+static bool load_cache(const char *cache_path, int src_fd,
+                       const struct stat *src_st, ast_node_t **ast) {
+  int fd = open(cache_path, O_RDWR | O_CLOEXEC);
+  if (fd == -1)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(script_cache_header_t)) {
+    close(fd);
+    return false;
+  }
+
+  size_t map_len = (size_t)st.st_size;
+  uint8_t *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+
+  script_cache_header_t hdr;
+  memcpy(&hdr, map, sizeof(hdr));
+  const uint8_t *payload = map + sizeof(hdr);
+  bool valid = hdr.magic == SCRIPT_CACHE_MAGIC &&
+               hdr.version == AST_SERIAL_VERSION &&
+               hdr.payload_len == map_len - sizeof(hdr) &&
+               hdr.size == (uint64_t)src_st->st_size;
+
+  if (valid && !same_mtime(&hdr, src_st)) {
+    // touched file: compare the contents before trusting the cache
+    char *script = map_script(src_fd, src_st);
+    if (script == MAP_FAILED) {
+      valid = false;
+    } else {
+      valid = hash_fnv1a(script, hdr.size) == hdr.content_hash;
+      if (script)
+        munmap(script, hdr.size);
+    }
+
+    if (valid) {
+      hdr.mtime_sec = (int64_t)src_st->st_mtim.tv_sec;
+      hdr.mtime_nsec = (int64_t)src_st->st_mtim.tv_nsec;
+      if (pwrite(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+        pr_warn("source: cannot refresh cache header of %s", cache_path);
+    }
+  }
+
+  if (valid)
+    valid = hash_fnv1a(payload, hdr.payload_len) == hdr.payload_hash;
+
+  if (valid) {
+    *ast = ast_deserialize(payload, hdr.payload_len, &valid);
+    if (!valid)
+      pr_warn("source: corrupted cache %s, rebuilding it", cache_path);
+  }
+
+  munmap(map, map_len);
+  close(fd);
+  return valid;
+}
+
+// writes the cache to a temporary file renamed over the old one so that
+// concurrent shells never read a partially written cache
+static void store_cache(const char *cache_path, const struct stat *src_st,
+                        uint64_t content_hash, ast_node_t *ast) {
+  size_t payload_len;
+  uint8_t *payload = ast_serialize(ast, &payload_len);
+
+  script_cache_header_t hdr = {
+      .magic = SCRIPT_CACHE_MAGIC,
+      .version = AST_SERIAL_VERSION,
+      .mtime_sec = (int64_t)src_st->st_mtim.tv_sec,
+      .mtime_nsec = (int64_t)src_st->st_mtim.tv_nsec,
+      .size = (uint64_t)src_st->st_size,
+      .content_hash = content_hash,
+      .payload_hash = hash_fnv1a(payload, payload_len),
+      .payload_len = payload_len,
+  };
+
+  char *tmp_path = NULL;
+  if (asprintf(&tmp_path, "%s.%d.tmp", cache_path, (int)getpid()) < 0) {
+    free(payload);
+    return;
+  }
+
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd != -1) {
+    bool written = write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+                   write(fd, payload, payload_len) == (ssize_t)payload_len;
+    close(fd);
+    if (!written || rename(tmp_path, cache_path) == -1)
+      unlink(tmp_path);
+  }
+
+  free(tmp_path);
+  free(payload);
+}
+
+int source_load(const char *path, ast_node_t **ast) {
+  *ast = NULL;
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    nsh_msg("%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    nsh_msg("%s: %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  // an empty tree for a non-empty script comes from a failed parse cached
+  // by an older version, the script is parsed again
+  char *cache_path = cache_path_for(path);
+  if (cache_path && load_cache(cache_path, fd, &st, ast) &&
+      (*ast || st.st_size == 0)) {
+    pr_info("source: loaded %s from cache", path);
+    free(cache_path);
+    close(fd);
+    return 0;
+  }
+
+  char *script = map_script(fd, &st);
+  if (script == MAP_FAILED) {
+    nsh_msg("%s: %s\n", path, strerror(errno));
+    free(cache_path);
+    close(fd);
+    return -1;
+  }
+
+  size_t len = (size_t)st.st_size;
+  uint64_t content_hash = hash_fnv1a(script, len);
+  bool error = false;
+  if (script) {
+    *ast = parser_parse_script(script, len, &error);
+    munmap(script, len);
+  }
+  close(fd);
+
+  // a script that failed to parse is parsed again, and reported, next time
+  if (cache_path && *ast)
+    store_cache(cache_path, &st, content_hash, *ast);
+  free(cache_path);
+  if (error) {
+    nsh_msg("%s: syntax error\n", path);
+    return 2;
+  }
+  return 0;
+}
+
+int source_run_file(const char *path) {
+  ast_node_t *ast_node = NULL;
+  int err = source_load(path, &ast_node);
+  if (err != 0)
+    return err == 2 ? 2 : 1;
+
+  int status = 0;
+  if (ast_node) {
+    expander_static_pass(ast_node);
+    status = exec_node(ast_node);
+    parser_free_ast(ast_node);
+  }
+  return status;
+}
@@ -0,0 +1,55 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __SOURCE_H__
+#define __SOURCE_H__
+
+#include "parser/parser.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCRIPT_CACHE_MAGIC 0x4e534843u // "NSHC"
+#define SCRIPT_CACHE_EXT ".nshc"
+
+/**
+ * @brief Header of an on-disk script cache, followed by the serialized AST.
+ * The source mtime and size allow a cheap freshness check, the content hash
+ * lets a touched but unchanged file reuse its cache.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version; /**< AST_SERIAL_VERSION the payload was encoded with */
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint64_t size;         /**< size of the source file */
+  uint64_t content_hash; /**< hash of the source file */
+  uint64_t payload_hash; /**< hash of the serialized AST */
+  uint64_t payload_len;
+} script_cache_header_t;
+
+/**
+ * @brief Loads the AST of a script, from its on-disk cache when it is valid
+ * and fresh, otherwise by parsing the file and rebuilding the cache.
+ * Caches live in $XDG_CACHE_HOME/nsh (default ~/.cache/nsh), one file per
+ * script named after a hash of its absolute path.
+ * @param path path of the script
+ * @param ast set to the AST (NULL for an empty script or a syntax error)
+ * @return 0 on success, -1 if the script cannot be read, 2 on a syntax
+ * error
+ */
+int source_load(const char *path, ast_node_t **ast);
+
+/**
+ * @brief Loads a script with source_load() and executes it in the current
+ * shell.
+ * @param path path of the script
+ * @return exit status of the last command, 1 if the script cannot be read,
+ * 2 on a syntax error
+ */
+int source_run_file(const char *path);
+
+#endif // __SOURCE_H__
@@ -11,8 +11,13 @@
 #include "shell/state.h"
 #include "executor/jobs.h"
 #include "history/history.h"
+#include "shell/passwd_cache.h"
+#include <ctype.h>
+#include <errno.h>
 
 static shell_state_t *sh_state = NULL;
+// last generation handed out to a variable assignment, 0 means unset
+static uint64_t env_generation = 0;
 
 shell_state_t *shell_state_get() {
   if (sh_state == NULL) {
@@ -28,19 +33,19 @@ shell_state_t *shell_state_get() {
  * * HOME - absolute path to the current user's home.
  * * PATH - the colon-separated list of directories for executable searches
  * * SHELL - the absolute path to the Novash executable itself.
- * * HISTFILE - the absolute path to the file used for storing command history.
- * All keys and values are duplicated (xstrdup) before being stored in the
- * hashmap.
+ * * HISTFILE - the absolute path to the file used for storing command history,
+ *   taken from the environment when set there.
+ * All keys and values are duplicated by shell_state_setenv().
  */
 static void init_environment() {
   // --- HOME and PATH ---
   char *home_val = getenv("HOME");
   if (home_val) {
-    shput(sh_state->environment, xstrdup("HOME"), xstrdup(home_val));
+    shell_state_setenv("HOME", home_val);
   }
   char *path_val = getenv("PATH");
   if (path_val) {
-    shput(sh_state->environment, xstrdup("PATH"), xstrdup(path_val));
+    shell_state_setenv("PATH", path_val);
   }
 
   // --- SHELL ---
@@ -49,21 +54,138 @@ static void init_environment() {
 
   if (exe_len != -1) {
     exe_buf[exe_len] = '\0';
-    shput(sh_state->environment, xstrdup("SHELL"), xstrdup(exe_buf));
+    shell_state_setenv("SHELL", exe_buf);
   }
 
   // --- HISTFILE ---
+  // an inherited HISTFILE wins over the file of the working directory
+  char *hist_env = getenv("HISTFILE");
   char hist_file_buf[PATH_MAX];
-  int hist_file_len = snprintf(hist_file_buf, PATH_MAX, "%s/%s",
-                               sh_state->identity.cwd, HIST_FILENAME);
+  int hist_file_len =
+      hist_env && *hist_env
+          ? snprintf(hist_file_buf, PATH_MAX, "%s", hist_env)
+          : snprintf(hist_file_buf, PATH_MAX, "%s/%s", sh_state->identity.cwd,
+                     HIST_FILENAME);
 
   if (hist_file_len > 0 && hist_file_len < PATH_MAX) {
-    shput(sh_state->environment, xstrdup("HISTFILE"), xstrdup(hist_file_buf));
+    shell_state_setenv("HISTFILE", hist_file_buf);
   }
 }
 
+// rebuilds the string of a variable last assigned an integer
+static void sync_value(env_var_t *var) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%lld", var->ival);
+  free(var->value);
+  var->value = xstrdup(buf);
+  var->value_stale = false;
+}
+
+// copies the value of an exported variable to environ
+static void sync_exported(env_var_t *var) {
+  if (!var->exported)
+    return;
+  if (var->value_stale)
+    sync_value(var);
+  setenv(var->key, var->value, 1);
+}
+
 char *shell_state_getenv(const char *key) {
-  return shget(sh_state->environment, key);
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  if (!var)
+    return NULL;
+  if (var->value_stale)
+    sync_value(var);
+  return var->value;
+}
+
+uint64_t shell_state_getenv_gen(const char *key) {
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  return var ? var->gen : 0;
+}
+
+void shell_state_setenv(const char *key, const char *value) {
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  if (var) {
+    free(var->value);
+    var->value = xstrdup(value);
+    var->gen = ++env_generation;
+    var->has_int = false;
+    var->value_stale = false;
+    sync_exported(var);
+    return;
+  }
+
+  env_var_t new_var = {
+      .key = xstrdup(key), .value = xstrdup(value), .gen = ++env_generation};
+  shputs(sh_state->environment, new_var);
+}
+
+bool shell_state_getenv_int(const char *key, long long *out) {
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  if (!var)
+    return false;
+  if (var->has_int) {
+    *out = var->ival;
+    return true;
+  }
+
+  // only the decimal form is read here, 010 or 0x8 are arithmetic
+  const char *s = var->value;
+  while (*s == ' ' || *s == '\t' || *s == '\n')
+    s++;
+  const char *digits = *s == '-' ? s + 1 : s;
+  if (!isdigit((unsigned char)digits[0]) ||
+      (digits[0] == '0' && isdigit((unsigned char)digits[1])))
+    return false;
+  char *end = NULL;
+  errno = 0;
+  long long v = strtoll(s, &end, 10);
+  if (end == s || errno != 0)
+    return false;
+  while (*end == ' ' || *end == '\t' || *end == '\n')
+    end++;
+  if (*end != '\0')
+    return false;
+
+  var->has_int = true;
+  var->ival = v;
+  *out = v;
+  return true;
+}
+
+void shell_state_setenv_int(const char *key, long long value) {
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  if (!var) {
+    env_var_t new_var = {.key = xstrdup(key), .value = NULL};
+    shputs(sh_state->environment, new_var);
+    var = shgetp_null(sh_state->environment, key);
+  }
+  var->gen = ++env_generation;
+  var->has_int = true;
+  var->value_stale = true;
+  var->ival = value;
+  sync_exported(var);
+}
+
+void shell_state_export(const char *key) {
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  if (!var)
+    return;
+  var->exported = true;
+  sync_exported(var);
+}
+
+void shell_state_unsetenv(const char *key) {
+  env_var_t *var = shgetp_null(sh_state->environment, key);
+  if (!var)
+    return;
+
+  // the key is owned by the entry, keep it alive until the removal is done
+  char *owned_key = var->key;
+  free(var->value);
+  (void)shdel(sh_state->environment, key);
+  free(owned_key);
 }
 
 static void init_shell_identity() {
@@ -81,6 +203,8 @@ static void init_shell_identity() {
   if (pw) {
     strncpy(identity.username, pw->pw_name, sizeof(identity.username) - 1);
     identity.username[sizeof(identity.username) - 1] = '\0';
+    // spares a second NSS query for '~user' on ourselves
+    passwd_cache_insert(pw->pw_name, pw->pw_dir);
   }
 
   identity.uid = getuid();
@@ -119,6 +243,12 @@ void shell_state_init() {
   sh_state->flags.interactive = isatty(STDIN_FILENO);
   sh_state->flags.job_control = sh_state->flags.interactive;
   sh_state->flags.history_enabled = true;
+  sh_state->flags.glob_prune = true;
+  sh_state->flags.user_prefetch = false;
+  sh_state->flags.auto_batch = false;
+  sh_state->flags.line_edit = false;
+  sh_state->flags.highlight = true;
+  sh_state->flags.autosuggest = true;
 #if defined(LOG_LEVEL) && LOG_LEVEL >= LOG_LEVEL_DEBUG
   sh_state->flags.debug = true;
 #else
@@ -132,7 +262,8 @@ void shell_state_init() {
 
   init_shell_identity();
   init_environment();
-  sh_state->identity.argv0 = shell_state_getenv("SHELL");
+  char *shell_path = shell_state_getenv("SHELL");
+  sh_state->identity.argv0 = shell_path ? xstrdup(shell_path) : NULL;
 
   sh_state->hist = xmalloc(sizeof(history_t));
   history_init();
@@ -183,6 +314,10 @@ char *shell_state_get_flags(void) {
 bool shell_is_utf8_supported() { return sh_state->support_utf8; }
 
 void shell_regain_control() {
+  // without a terminal there is nothing to regain (e.g. input from a pipe)
+  if (!sh_state->flags.interactive)
+    return;
+
   // Regain control of the terminal
   xtcsetpgrp(STDIN_FILENO, getpgrp());
 
@@ -199,6 +334,7 @@ void shell_state_free() {
   shfree(sh_state->environment);
 
   free(sh_state->identity.cwd);
+  free(sh_state->identity.argv0);
   shell_reset_last_exec();
   history_free();
   jobs_free();
@@ -18,6 +18,7 @@
 #include <signal.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <termios.h>
 #include <time.h>
@@ -27,9 +28,25 @@
 typedef struct job_t job_t;
 typedef struct history_t history_t;
 
+/**
+ * @brief Shell variable. Every assignment stamps the variable with a new
+ * value of a global, strictly increasing generation counter so that cached
+ * expansions can tell whether a variable changed since they were computed.
+ *
+ * Variables used in arithmetic also keep their integer value, so that a loop
+ * counter is neither parsed back nor formatted on every iteration: the string
+ * is only rebuilt when something reads it.
+ *
+ * Exported variables are also kept in environ, for the commands run.
+ */
 typedef struct {
   char *key;
   char *value;
+  uint64_t gen;
+  bool has_int;       /**< ival holds the value of the variable */
+  bool value_stale;   /**< value must be rebuilt from ival before use */
+  bool exported;      /**< every assignment is copied to environ */
+  long long ival;
 } env_var_t;
 
 typedef struct {
@@ -47,6 +64,12 @@ typedef struct {
   bool job_control;
   bool history_enabled;
   bool debug;
+  bool glob_prune; /**< '**' skips hidden and VCS directories */
+  bool user_prefetch; /**< Fill the passwd cache in the background */
+  bool auto_batch;    /**< Split commands whose arguments exceed ARG_MAX */
+  bool line_edit;     /**< Edit lines with the native editor, not readline */
+  bool highlight;     /**< Highlight the syntax of the line being edited */
+  bool autosuggest;   /**< Suggest the end of the line from the history */
 } shell_flags_t;
 
 typedef struct {
@@ -109,6 +132,52 @@ shell_state_t *shell_state_get();
  */
 char *shell_state_getenv(const char *key);
 
+/**
+ * @brief Returns the generation of a variable.
+ * @param key The variable name.
+ * @return The generation of its last assignment, 0 if the variable is unset.
+ */
+uint64_t shell_state_getenv_gen(const char *key);
+
+/**
+ * @brief Sets a variable in the internal hashmap, bumping its generation.
+ * Both key and value are duplicated.
+ * @param key The variable name.
+ * @param value The new value.
+ */
+void shell_state_setenv(const char *key, const char *value);
+
+/**
+ * @brief Reads a variable holding an integer. The string is parsed once, the
+ * integer is then kept until the next assignment.
+ * @param key The variable name.
+ * @param out set to the value on success
+ * @return false if the variable is unset or is not a decimal integer
+ */
+bool shell_state_getenv_int(const char *key, long long *out);
+
+/**
+ * @brief Assigns an integer to a variable, bumping its generation. The string
+ * form of the value is only built when it is read, or right away when the
+ * variable is exported.
+ * @param key The variable name.
+ * @param value The new value.
+ */
+void shell_state_setenv_int(const char *key, long long value);
+
+/**
+ * @brief Marks a variable as exported and copies its value to environ, as
+ * later assignments will be. Does nothing if the variable is unset.
+ * @param key The variable name.
+ */
+void shell_state_export(const char *key);
+
+/**
+ * @brief Removes a variable from the internal hashmap.
+ * @param key The variable name.
+ */
+void shell_state_unsetenv(const char *key);
+
 shell_identity_t *shell_state_get_identity();
 shell_jobs_t *shell_state_get_jobs();
 shell_last_exec_t *shell_state_get_last_exec();
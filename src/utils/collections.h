@@ -8,6 +8,13 @@
 #ifndef COLLECTIONS_H
 #define COLLECTIONS_H
 
+// gcc < 13 does not provide the C23 typeof keyword in strict mode while stb_ds
+// relies on it for hash maps with non-string keys
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 13 &&              \
+    !defined(typeof)
+#define typeof __typeof__
+#endif
+
 #include "stb_ds.h"
 
 #endif // COLLECTIONS_H
@@ -0,0 +1,101 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+
+#include "thread_pool.h"
+#include <unistd.h>
+
+size_t thread_pool_default_size(size_t max) {
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t n = ncpu > 0 ? (size_t)ncpu : 1;
+  return n < max ? n : max;
+}
+
+static void *worker_main(void *arg) {
+  thread_pool_t *pool = arg;
+
+  pthread_mutex_lock(&pool->lock);
+  while (1) {
+    while (pool->queue_head == (size_t)arrlen(pool->queue) && !pool->stopping)
+      pthread_cond_wait(&pool->task_cond, &pool->lock);
+
+    if (pool->queue_head == (size_t)arrlen(pool->queue) && pool->stopping)
+      break;
+
+    thread_pool_task_t task = pool->queue[pool->queue_head++];
+    pthread_mutex_unlock(&pool->lock);
+
+    task.fn(task.arg);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->pending == 0) {
+      // every task ran, recycle the queue storage (arrsetlen(q, 0) warns
+      // with -Wtype-limits)
+      if (pool->queue)
+        stbds_header(pool->queue)->length = 0;
+      pool->queue_head = 0;
+      pthread_cond_broadcast(&pool->done_cond);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+thread_pool_t *thread_pool_new(size_t nthreads) {
+  thread_pool_t *pool = xcalloc(1, sizeof(thread_pool_t));
+  pool->nthreads = nthreads > 0 ? nthreads : 1;
+  pool->threads = xcalloc(pool->nthreads, sizeof(pthread_t));
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->task_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+
+  for (size_t i = 0; i < pool->nthreads; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+      perror("pthread_create failed");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return pool;
+}
+
+void thread_pool_submit(thread_pool_t *pool, thread_pool_task_fn fn,
+                        void *arg) {
+  pthread_mutex_lock(&pool->lock);
+  arrpush(pool->queue, ((thread_pool_task_t){.fn = fn, .arg = arg}));
+  pool->pending++;
+  pthread_cond_signal(&pool->task_cond);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_wait(thread_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0)
+    pthread_cond_wait(&pool->done_cond, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+  if (!pool)
+    return;
+
+  thread_pool_wait(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->task_cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < pool->nthreads; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->task_cond);
+  pthread_cond_destroy(&pool->done_cond);
+  arrfree(pool->queue);
+  free(pool->threads);
+  free(pool);
+}
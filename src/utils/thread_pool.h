@@ -0,0 +1,69 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include "utils/collections.h"
+#include "utils/system/memory.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Task function executed by a worker thread */
+typedef void (*thread_pool_task_fn)(void *arg);
+
+typedef struct {
+  thread_pool_task_fn fn;
+  void *arg;
+} thread_pool_task_t;
+
+/**
+ * @brief Fixed-size pool of worker threads consuming a FIFO of tasks.
+ * Pools are short-lived: they are created for a batch of work, waited on and
+ * freed so that no thread is left running while the shell forks.
+ */
+typedef struct {
+  pthread_t *threads;
+  size_t nthreads;
+  thread_pool_task_t *queue; /**< pending tasks (dynamic array) */
+  size_t queue_head;         /**< index of the next task to run */
+  size_t pending;            /**< queued or running tasks */
+  bool stopping;
+  pthread_mutex_t lock;
+  pthread_cond_t task_cond; /**< signaled when a task is queued */
+  pthread_cond_t done_cond; /**< signaled when pending drops to 0 */
+} thread_pool_t;
+
+/**
+ * @brief Number of workers to use by default, based on the online CPUs and
+ * capped to max.
+ */
+size_t thread_pool_default_size(size_t max);
+
+/**
+ * @brief Starts a pool of nthreads workers (at least 1).
+ */
+thread_pool_t *thread_pool_new(size_t nthreads);
+
+/**
+ * @brief Queues a task. Tasks may submit other tasks.
+ */
+void thread_pool_submit(thread_pool_t *pool, thread_pool_task_fn fn,
+                        void *arg);
+
+/**
+ * @brief Blocks until every submitted task has completed.
+ */
+void thread_pool_wait(thread_pool_t *pool);
+
+/**
+ * @brief Waits for the pending tasks, joins the workers and frees the pool.
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+#endif // __THREAD_POOL_H__
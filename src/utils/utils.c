@@ -46,4 +46,13 @@ char *is_in_path(char *cmd) {
   // Global failure: Free the duplicated PATH string
   free(_p);
   return NULL;
-}
\ No newline at end of file
+}
+uint64_t hash_fnv1a(const void *data, size_t len) {
+  const unsigned char *p = data;
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
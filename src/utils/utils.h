@@ -13,6 +13,7 @@
 
 #include "shell/state.h"
 #include "utils/system/memory.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <sys/stat.h>
 
@@ -26,4 +27,12 @@
  */
 char *is_in_path(char *cmd);
 
+/**
+ * @brief 64-bit FNV-1a hash of a memory region.
+ * @param data pointer to the bytes to hash
+ * @param len number of bytes
+ * @return the hash value
+ */
+uint64_t hash_fnv1a(const void *data, size_t len);
+
 #endif // __UTILS_H__
\ No newline at end of file
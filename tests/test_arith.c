@@ -0,0 +1,104 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "expander/arith.h"
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+#include <limits.h>
+
+static long long eval(const char *expr) {
+  long long value = 0;
+  cr_assert(arith_eval_str(expr, &value), "%s", expr);
+  return value;
+}
+
+Test(arith, operators_and_precedence) {
+  shell_init(true);
+  cr_assert_eq(eval("1 + 2 * 3"), 7);
+  cr_assert_eq(eval("(1 + 2) * 3"), 9);
+  cr_assert_eq(eval("2 ** 3 ** 2"), 512);
+  cr_assert_eq(eval("-2 ** 2"), 4);
+  cr_assert_eq(eval("7 / 2 + -7 % 3"), 2);
+  cr_assert_eq(eval("1 << 4 | 3 & 6 ^ 1"), 19);
+  cr_assert_eq(eval("!0 + ~0 + (3 >= 3) + (2 != 2)"), 1);
+  cr_assert_eq(eval("0 || 5 && 3"), 1);
+  cr_assert_eq(eval("1 ? 0 ? 4 : 5 : 6"), 5);
+  cr_assert_eq(eval("1, 2, 3"), 3);
+  cr_assert_eq(eval("0x1f + 010 + 2#101 + 36#z + 64#_"), 31 + 8 + 5 + 35 + 63);
+  cr_assert_eq(eval(""), 0);
+
+  // the arithmetic wraps around instead of overflowing
+  cr_assert_eq(eval("9223372036854775807 + 1"), LLONG_MIN);
+  cr_assert_eq(eval("(-9223372036854775807 - 1) / -1"), LLONG_MIN);
+  arith_cache_free();
+}
+
+Test(arith, constant_folding) {
+  long long value;
+  arith_t *a = arith_compile("(2 + 3) * 4 - (1 << 2)");
+  cr_assert(arith_is_const(a, &value));
+  cr_assert_eq(value, 16);
+  arith_free(a);
+
+  // a decided '&&' or '?:' drops the operand that never runs
+  a = arith_compile("0 && x++ || 1 ? 7 : (y = 2)");
+  cr_assert(arith_is_const(a, &value));
+  cr_assert_eq(value, 7);
+  arith_free(a);
+
+  a = arith_compile("x + 2 * 3");
+  cr_assert_not(arith_is_const(a, NULL));
+  arith_free(a);
+
+  // errors are not folded away, they are reported on every evaluation
+  a = arith_compile("1 / 0");
+  cr_assert_not(arith_is_const(a, NULL));
+  cr_assert_not(arith_eval(a, &value));
+  arith_free(a);
+}
+
+Test(arith, variables_keep_their_integer) {
+  shell_init(true);
+  shell_state_setenv("N", "41");
+  shell_state_unsetenv("UNSET");
+
+  cr_assert_eq(eval("N + 1 + UNSET"), 42);
+  cr_assert_eq(eval("N++"), 41);
+  cr_assert_eq(eval("++N"), 43);
+  cr_assert_eq(eval("N *= 2, N -= 6"), 80);
+
+  // the integer is kept as is, its string is only built when read
+  long long value;
+  cr_assert(shell_state_getenv_int("N", &value));
+  cr_assert_eq(value, 80);
+  uint64_t gen = shell_state_getenv_gen("N");
+  cr_assert_eq(eval("N += 0"), 80);
+  cr_assert_gt(shell_state_getenv_gen("N"), gen);
+  cr_assert_str_eq(shell_state_getenv("N"), "80");
+
+  // a string assignment drops the integer
+  shell_state_setenv("N", "010");
+  cr_assert_not(shell_state_getenv_int("N", &value));
+  cr_assert_eq(eval("N"), 8);
+
+  // other values are expressions themselves
+  shell_state_setenv("E", "N * 2 + 1");
+  cr_assert_eq(eval("E"), 17);
+  shell_state_setenv("E", "E");
+  cr_assert_not(arith_eval_str("E + 1", &value));
+  arith_cache_free();
+}
+
+Test(arith, errors) {
+  shell_init(true);
+  long long value;
+  const char *invalid[] = {"1 +", "(1", "1 2", "3 = 4", "08", "1 / 0",
+                           "2 ** -1", "5 % 0", "a ? b", "++1", "$x"};
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    cr_assert_not(arith_eval_str(invalid[i], &value), "%s", invalid[i]);
+  arith_cache_free();
+}
@@ -0,0 +1,79 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "expander/expander.h"
+#include "lexer/lexer.h"
+#include "parser/ast_cache.h"
+#include "parser/parser.h"
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+
+static ast_node_t *parse_input(const char *input) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)input);
+  ast_node_t *ast = parser_create_ast(lex);
+  lexer_free(lex);
+  return ast;
+}
+
+Test(ast_cache, hit_and_miss) {
+  ast_cache_t *cache = ast_cache_new(4);
+  const char *line = "echo hello | grep h";
+
+  cr_assert_null(ast_cache_lookup(cache, line));
+  ast_node_t *ast = parse_input(line);
+  ast_cache_insert(cache, line, ast);
+
+  cr_assert_eq(ast_cache_lookup(cache, line), ast);
+  cr_assert_eq(ast_cache_lookup(cache, line), ast);
+  cr_assert_null(ast_cache_lookup(cache, "echo hello"));
+
+  cr_assert_eq(cache->hits, 2);
+  cr_assert_eq(cache->misses, 2);
+  cr_assert_eq(cache->count, 1);
+  ast_cache_free(cache);
+}
+
+Test(ast_cache, lru_eviction) {
+  ast_cache_t *cache = ast_cache_new(2);
+
+  ast_cache_insert(cache, "cmd1", parse_input("cmd1"));
+  ast_cache_insert(cache, "cmd2", parse_input("cmd2"));
+
+  // cmd1 becomes the most recently used, cmd2 is evicted by cmd3
+  cr_assert_not_null(ast_cache_lookup(cache, "cmd1"));
+  ast_cache_insert(cache, "cmd3", parse_input("cmd3"));
+
+  cr_assert_eq(cache->count, 2);
+  cr_assert_not_null(ast_cache_lookup(cache, "cmd1"));
+  cr_assert_null(ast_cache_lookup(cache, "cmd2"));
+  cr_assert_not_null(ast_cache_lookup(cache, "cmd3"));
+  ast_cache_free(cache);
+}
+
+Test(ast_cache, expansion_keeps_ast) {
+  shell_init(true);
+  ast_cache_t *cache = ast_cache_new(4);
+  const char *line = "echo ~ $HOME";
+  ast_cache_insert(cache, line, parse_input(line));
+
+  // expanding twice must give the same result, the cached AST keeps its
+  // pre-expansion parts
+  for (int i = 0; i < 2; i++) {
+    ast_node_t *ast = ast_cache_lookup(cache, line);
+    cr_assert_not_null(ast);
+    expander_expand_ast(ast);
+
+    cmd_node_t cmd = ast->seq.nodes[0]->cmd;
+    cr_assert_eq(arrlen(cmd.argv), 3);
+    cr_assert_str_eq(cmd.argv[1], getenv("HOME"));
+    cr_assert_str_eq(cmd.argv[2], getenv("HOME"));
+    cr_assert_eq(cmd.argv_parts[1][0].type, WORD_TILDE);
+    cr_assert_eq(cmd.argv_parts[2][0].type, WORD_VARIABLE);
+  }
+  ast_cache_free(cache);
+}
@@ -0,0 +1,115 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "lexer/lexer.h"
+#include "parser/ast_serial.h"
+#include "parser/parser.h"
+#include "shell/shell.h"
+#include "shell/source.h"
+#include <criterion/criterion.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static ast_node_t *parse_input(const char *input) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)input);
+  ast_node_t *ast = parser_create_ast(lex);
+  lexer_free(lex);
+  return ast;
+}
+
+Test(ast_serial, round_trip) {
+  const char *input =
+      "echo \"$HOME\"'x' ~ *.c > out 2>> err | wc -l && ls || pwd; sleep 1 &\n"
+      "for i in a{b,c} {1..3}; do echo $i; done\n"
+      "(( n += 2 )) && echo $((n * 2))";
+  ast_node_t *ast = parse_input(input);
+
+  size_t len;
+  uint8_t *buf = ast_serialize(ast, &len);
+  bool ok;
+  ast_node_t *copy = ast_deserialize(buf, len, &ok);
+  cr_assert(ok);
+  cr_assert_not_null(copy);
+
+  // the rebuilt tree must serialize to the exact same bytes
+  size_t copy_len;
+  uint8_t *copy_buf = ast_serialize(copy, &copy_len);
+  cr_assert_eq(copy_len, len);
+  cr_assert_eq(memcmp(copy_buf, buf, len), 0);
+
+  free(copy_buf);
+  free(buf);
+  parser_free_ast(copy);
+  parser_free_ast(ast);
+}
+
+Test(ast_serial, rejects_corrupted_data) {
+  ast_node_t *ast = parse_input("cat file | grep foo > out");
+  size_t len;
+  uint8_t *buf = ast_serialize(ast, &len);
+  bool ok;
+
+  // every truncation must be detected
+  for (size_t i = 0; i < len; i++) {
+    cr_assert_null(ast_deserialize(buf, i, &ok));
+    cr_assert_not(ok);
+  }
+
+  // an absurd count must not be trusted
+  uint8_t *bad = malloc(len + 1);
+  memcpy(bad, buf, len);
+  bad[len] = 0;
+  cr_assert_null(ast_deserialize(bad, len + 1, &ok));
+  cr_assert_not(ok);
+  memset(bad + 2, 0xff, 4);
+  cr_assert_null(ast_deserialize(bad, len, &ok));
+  cr_assert_not(ok);
+
+  free(bad);
+  free(buf);
+  parser_free_ast(ast);
+
+  // a tree with a missing operand does not come back
+  ast_node_t cond = {.type = NODE_CONDITIONAL,
+                     .cond = {.op = COND_AND, .left = NULL, .right = NULL}};
+  buf = ast_serialize(&cond, &len);
+  cr_assert_null(ast_deserialize(buf, len, &ok));
+  cr_assert_not(ok);
+  free(buf);
+}
+
+Test(ast_serial, script_with_syntax_error_is_not_cached) {
+  shell_init(true);
+  char dir[] = "/tmp/nsh_source_XXXXXX";
+  cr_assert_not_null(mkdtemp(dir));
+  setenv("XDG_CACHE_HOME", dir, 1);
+
+  // the error is reported each time, nothing is left in the cache
+  const char *scripts[] = {"echo a\necho b >\n", "echo a &&\n",
+                           "echo x ||\n", "| echo hi\n"};
+  char path[PATH_MAX];
+  for (size_t i = 0; i < sizeof(scripts) / sizeof(*scripts); i++) {
+    snprintf(path, sizeof(path), "%s/bad%zu.sh", dir, i);
+    FILE *f = fopen(path, "w");
+    fputs(scripts[i], f);
+    fclose(f);
+    cr_assert_eq(source_run_file(path), 2, "%s", scripts[i]);
+    cr_assert_eq(source_run_file(path), 2, "%s", scripts[i]);
+  }
+  char cache_dir[PATH_MAX];
+  snprintf(cache_dir, sizeof(cache_dir), "%s/nsh", dir);
+  DIR *d = opendir(cache_dir);
+  cr_assert_not_null(d);
+  struct dirent *ent;
+  while ((ent = readdir(d)) != NULL)
+    cr_assert(ent->d_name[0] == '.', "cached %s", ent->d_name);
+  closedir(d);
+  unsetenv("XDG_CACHE_HOME");
+}
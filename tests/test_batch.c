@@ -0,0 +1,179 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "executor/batch.h"
+#include "executor/executor.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "shell/shell.h"
+#include "utils/collections.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// argv packed in a single buffer, the way the expander builds it
+static char **packed_argv(const char **args, size_t n, char **arena) {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++)
+    total += strlen(args[i]) + 1;
+  *arena = malloc(total);
+
+  char **argv = NULL;
+  size_t off = 0;
+  for (size_t i = 0; i < n; i++) {
+    memcpy(*arena + off, args[i], strlen(args[i]) + 1);
+    arrpush(argv, *arena + off);
+    off += strlen(args[i]) + 1;
+  }
+  return argv;
+}
+
+Test(batch, sizes_match_packed_and_unpacked) {
+  const char *args[] = {"rm", "-f", "a.o", "bb.o", "ccc.o"};
+  char *arena;
+  char **argv = packed_argv(args, 5, &arena);
+
+  size_t expected = 3 + 3 + 4 + 5 + 6 + 5 * sizeof(char *);
+  cr_assert_eq(batch_argv_size(argv, 0, 5, true), expected);
+  cr_assert_eq(batch_argv_size(argv, 0, 5, false), expected);
+  cr_assert_eq(batch_argv_size(argv, 2, 4, true), 4 + 5 + 2 * sizeof(char *));
+  arrfree(argv);
+  free(arena);
+}
+
+Test(batch, split_repeats_fixed_arguments) {
+  const char *args[] = {"rm", "-f", "a1", "a2", "a3", "a4", "a5"};
+  char *arena;
+  char **argv = packed_argv(args, 7, &arena);
+
+  // room for the fixed arguments, the NULL and two arguments of 3 bytes
+  size_t base = 3 + 3 + 3 * sizeof(char *);
+  size_t limit = base + 2 * (3 + sizeof(char *));
+  batch_chunk_t *chunks = batch_split(argv, 0, 2, 7, 7, true, limit);
+  cr_assert_eq(arrlen(chunks), 3);
+  cr_assert_eq(chunks[0].start, 2);
+  cr_assert_eq(chunks[0].end, 4);
+  cr_assert_eq(chunks[1].start, 4);
+  cr_assert_eq(chunks[1].end, 6);
+  cr_assert_eq(chunks[2].start, 6);
+  cr_assert_eq(chunks[2].end, 7);
+  arrfree(chunks);
+
+  // an argument larger than the limit still gets a chunk of its own
+  chunks = batch_split(argv, 0, 2, 7, 7, true, base);
+  cr_assert_eq(arrlen(chunks), 5);
+  arrfree(chunks);
+
+  // everything fits, or nothing to split
+  chunks = batch_split(argv, 0, 2, 7, 7, false, 1 << 20);
+  cr_assert_eq(arrlen(chunks), 1);
+  cr_assert_eq(chunks[0].end, 7);
+  arrfree(chunks);
+  chunks = batch_split(argv, 0, 7, 7, 7, true, 1 << 20);
+  cr_assert_eq(arrlen(chunks), 1);
+  cr_assert_eq(chunks[0].start, chunks[0].end);
+  arrfree(chunks);
+
+  arrfree(argv);
+  free(arena);
+}
+
+Test(batch, split_repeats_trailing_arguments) {
+  const char *args[] = {"cp", "a1", "a2", "a3", "a4", "dest/"};
+  char *arena;
+  char **argv = packed_argv(args, 6, &arena);
+
+  // the destination takes room in every chunk, leaving two arguments
+  size_t base = 3 + 6 + 3 * sizeof(char *);
+  size_t limit = base + 2 * (3 + sizeof(char *));
+  batch_chunk_t *chunks = batch_split(argv, 0, 1, 5, 6, true, limit);
+  cr_assert_eq(arrlen(chunks), 2);
+  cr_assert_eq(chunks[0].start, 1);
+  cr_assert_eq(chunks[0].end, 3);
+  cr_assert_eq(chunks[1].start, 3);
+  cr_assert_eq(chunks[1].end, 5);
+  arrfree(chunks);
+
+  arrfree(argv);
+  free(arena);
+}
+
+static int run_input(const char *input) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)input);
+  ast_node_t *ast = parser_create_ast(lex);
+  lexer_free(lex);
+
+  int status = exec_node(ast);
+  parser_free_ast(ast);
+  return status;
+}
+
+Test(batch, autobatch_splits_unquoted_variables) {
+  shell_init(true);
+  shell_state_unsetenv("IFS");
+  char *value = NULL;
+  char num[16];
+  for (int i = 1; i <= 10000; i++) {
+    int n = snprintf(num, sizeof(num), "%s%d", i > 1 ? " " : "", i);
+    for (int k = 0; k < n; k++)
+      arrpush(value, num[k]);
+  }
+  arrpush(value, '\0');
+  shell_state_setenv("Y", value);
+  arrfree(value);
+
+  // thirty words of ten thousand fields each are over ARG_MAX
+  char *input = NULL;
+  const char *head = "set -o autobatch; /bin/echo";
+  for (const char *c = head; *c; c++)
+    arrpush(input, *c);
+  for (int i = 0; i < 30; i++) {
+    for (const char *c = " $Y"; *c; c++)
+      arrpush(input, *c);
+  }
+  const char *tail = " end >/tmp/nsh_test_autobatch.out";
+  for (const char *c = tail; *c; c++)
+    arrpush(input, *c);
+  arrpush(input, '\0');
+  cr_assert_eq(run_input(input), 0);
+  arrfree(input);
+
+  FILE *f = fopen("/tmp/nsh_test_autobatch.out", "r");
+  cr_assert_not_null(f);
+  size_t lines = 0, words = 0;
+  int c;
+  while ((c = fgetc(f)) != EOF) {
+    lines += c == '\n';
+    words += c == ' ' || c == '\n';
+  }
+  fclose(f);
+  cr_assert_gt(lines, 1);
+  cr_assert_eq(words, 300000 + lines);
+  unlink("/tmp/nsh_test_autobatch.out");
+  shell_state_get()->flags.auto_batch = false;
+}
+
+Test(batch, options) {
+  char *argv[] = {"batch", "-j", "4", "--", "-cmd", "x"};
+  size_t skip;
+  int parallel;
+  cr_assert(batch_parse_options(argv, 6, &skip, &parallel));
+  cr_assert_eq(skip, 4);
+  cr_assert_eq(parallel, 4);
+
+  char *compact[] = {"batch", "-j2", "ls"};
+  cr_assert(batch_parse_options(compact, 3, &skip, &parallel));
+  cr_assert_eq(skip, 2);
+  cr_assert_eq(parallel, 2);
+
+  char *invalid[] = {"batch", "-j", "0", "ls"};
+  cr_assert_not(batch_parse_options(invalid, 4, &skip, &parallel));
+  char *missing[] = {"batch", "-j3"};
+  cr_assert_not(batch_parse_options(missing, 2, &skip, &parallel));
+}
@@ -0,0 +1,88 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "expander/brace.h"
+#include "utils/collections.h"
+#include <criterion/criterion.h>
+#include <stdint.h>
+#include <string.h>
+
+// joins the words of the expansion of input with spaces
+static char *expand(const char *input) {
+  word_part_t *word = lexer_word_parts(input, strlen(input));
+  brace_iter_t *it = brace_iter_new(word);
+
+  char *out = NULL;
+  word_part_t *gen;
+  while ((gen = brace_iter_next(it)) != NULL) {
+    if (arrlen(out) > 0)
+      arrpush(out, ' ');
+    for (int i = 0; i < arrlen(gen); i++) {
+      for (const char *c = gen[i].value; *c; c++)
+        arrpush(out, *c);
+    }
+  }
+  arrpush(out, '\0');
+
+  brace_iter_free(it);
+  for (int i = 0; i < arrlen(word); i++)
+    free(word[i].value);
+  arrfree(word);
+
+  char *s = strdup(out);
+  arrfree(out);
+  return s;
+}
+
+static void assert_expands(const char *input, const char *expected) {
+  char *s = expand(input);
+  cr_assert_str_eq(s, expected, "%s", input);
+  free(s);
+}
+
+Test(brace, lists) {
+  assert_expands("a{b,c,d}e", "abe ace ade");
+  assert_expands("{a,b}{1,2}", "a1 a2 b1 b2");
+  assert_expands("x{a,b{1,2},}y", "xay xb1y xb2y xy");
+  assert_expands("{'a,b',c}", "a,b c");
+}
+
+Test(brace, sequences) {
+  assert_expands("{1..5}", "1 2 3 4 5");
+  assert_expands("{5..1..2}", "5 3 1");
+  assert_expands("{1..10..-3}", "1 4 7 10");
+  assert_expands("{05..10..3}", "05 08");
+  assert_expands("{-2..2}", "-2 -1 0 1 2");
+  assert_expands("{a..e..2}", "a c e");
+  assert_expands("{z..x}", "z y x");
+  assert_expands("{1..2}{a..b}", "1a 1b 2a 2b");
+}
+
+Test(brace, invalid_kept_literal) {
+  assert_expands("{a..1}", "{a..1}");
+  assert_expands("{1..2..x}", "{1..2..x}");
+  assert_expands("a{1..2}{x..9}", "a1{x..9} a2{x..9}");
+}
+
+Test(brace, count_without_generating) {
+  word_part_t *word = lexer_word_parts("{1..1000000}{a,b{1..3}}", 23);
+  brace_iter_t *it = brace_iter_new(word);
+  cr_assert_eq(brace_iter_count(it), 4000000);
+  brace_iter_free(it);
+  for (int i = 0; i < arrlen(word); i++)
+    free(word[i].value);
+  arrfree(word);
+
+  const char *huge = "{0..9223372036854775807}{1,2}";
+  word = lexer_word_parts(huge, strlen(huge));
+  it = brace_iter_new(word);
+  cr_assert_eq(brace_iter_count(it), SIZE_MAX);
+  brace_iter_free(it);
+  for (int i = 0; i < arrlen(word); i++)
+    free(word[i].value);
+  arrfree(word);
+}
@@ -0,0 +1,170 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+
+static void make_file(const char *dir, const char *name, mode_t mode) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  close(open(path, O_CREAT | O_WRONLY, mode));
+}
+
+static void free_matches(char **names) {
+  for (int i = 0; i < arrlen(names); i++)
+    free(names[i]);
+  arrfree(names);
+}
+
+Test(completion, commands_from_path_and_builtins) {
+  shell_init(true);
+  char a[] = "/tmp/nsh_cmdidx_XXXXXX", b[] = "/tmp/nsh_cmdidx_XXXXXX";
+  cr_assert_not_null(mkdtemp(a));
+  cr_assert_not_null(mkdtemp(b));
+  make_file(a, "zqfoo", 0755);
+  make_file(a, "zqbar", 0755);
+  make_file(a, "zqdata", 0644); // not executable
+  make_file(b, "zqfoo", 0755);  // found twice, listed once
+  make_file(b, "zqfoobar", 0755);
+  char path[2 * PATH_MAX];
+  snprintf(path, sizeof(path), "%s:%s:%s", a, b, a);
+  shell_state_setenv("PATH", path);
+
+  char **names = command_index_complete("zq");
+  cr_assert_eq(arrlen(names), 3);
+  cr_assert_str_eq(names[0], "zqbar");
+  cr_assert_str_eq(names[1], "zqfoo");
+  cr_assert_str_eq(names[2], "zqfoobar");
+  free_matches(names);
+
+  names = command_index_complete("ech");
+  cr_assert_eq(arrlen(names), 1);
+  cr_assert_str_eq(names[0], "echo");
+  free_matches(names);
+  cr_assert_null(command_index_complete("zqx"));
+
+  // only the directory that changed is listed again
+  char victim[PATH_MAX];
+  snprintf(victim, sizeof(victim), "%s/zqfoobar", b);
+  cr_assert_eq(unlink(victim), 0);
+  make_file(a, "zqbaz", 0755);
+  names = command_index_complete("zqba");
+  cr_assert_eq(arrlen(names), 2);
+  cr_assert_str_eq(names[1], "zqbaz");
+  free_matches(names);
+  names = command_index_complete("zqfoo");
+  cr_assert_eq(arrlen(names), 1);
+  free_matches(names);
+
+  // a name provided by two directories stays until both lose it
+  snprintf(victim, sizeof(victim), "%s/zqfoo", a);
+  cr_assert_eq(unlink(victim), 0);
+  names = command_index_complete("zqfoo");
+  cr_assert_eq(arrlen(names), 1);
+  free_matches(names);
+
+  char cmd[2 * PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s %s", a, b);
+  cr_assert_eq(system(cmd), 0);
+  command_index_free();
+}
+
+Test(completion, path_change_rebuilds_the_index) {
+  shell_init(true);
+  char a[] = "/tmp/nsh_cmdidx_XXXXXX";
+  cr_assert_not_null(mkdtemp(a));
+  make_file(a, "zqonly", 0755);
+  shell_state_setenv("PATH", "/nonexistent");
+  size_t builtins = command_index_size();
+
+  shell_state_setenv("PATH", a);
+  cr_assert_eq(command_index_size(), builtins + 1);
+  shell_state_setenv("PATH", "/nonexistent");
+  cr_assert_eq(command_index_size(), builtins);
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", a);
+  cr_assert_eq(system(cmd), 0);
+  command_index_free();
+}
+
+Test(completion, directory_listing_is_cached_until_it_changes) {
+  shell_init(true);
+  char a[] = "/tmp/nsh_diridx_XXXXXX";
+  cr_assert_not_null(mkdtemp(a));
+  make_file(a, "foo.c", 0644);
+  make_file(a, "foo.h", 0644);
+  make_file(a, "bar.c", 0644);
+  make_file(a, ".foo", 0644);
+
+  bool complete;
+  char **names = dir_index_complete(a, "fo", false, &complete);
+  cr_assert(complete);
+  cr_assert_eq(arrlen(names), 2);
+  cr_assert_str_eq(names[0], "foo.c");
+  cr_assert_str_eq(names[1], "foo.h");
+  free_matches(names);
+
+  names = dir_index_complete(a, ".", true, &complete);
+  cr_assert_eq(arrlen(names), 1);
+  cr_assert_str_eq(names[0], ".foo");
+  free_matches(names);
+
+  // a new entry changes the mtime of the directory
+  make_file(a, "foo.o", 0644);
+  names = dir_index_complete(a, "foo.", false, &complete);
+  cr_assert_eq(arrlen(names), 3);
+  cr_assert_str_eq(names[2], "foo.o");
+  free_matches(names);
+  cr_assert_null(dir_index_complete(a, "zz", false, &complete));
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", a);
+  cr_assert_eq(system(cmd), 0);
+  dir_index_free();
+}
+
+Test(completion, large_directory_is_read_in_background) {
+  shell_init(true);
+  char a[] = "/tmp/nsh_diridx_XXXXXX";
+  cr_assert_not_null(mkdtemp(a));
+  char name[32];
+  for (int i = 0; i < 30000; i++) {
+    snprintf(name, sizeof(name), "f%05d", i);
+    make_file(a, name, 0644);
+  }
+
+  // a listing cancelled by a completion elsewhere is started again
+  bool complete = false;
+  free_matches(dir_index_complete(a, "f1", false, &complete));
+  cr_assert_null(dir_index_complete("/", "nsh_no_such", false, &complete));
+
+  // partial answers until the listing is over, then every name
+  complete = false;
+  char **names = NULL;
+  for (int tries = 0; !complete && tries < 1000; tries++) {
+    free_matches(names);
+    names = dir_index_complete(a, "f1", false, &complete);
+  }
+  cr_assert(complete);
+  cr_assert_eq(arrlen(names), 10000);
+  cr_assert_str_eq(names[0], "f10000");
+  cr_assert_str_eq(names[9999], "f19999");
+  free_matches(names);
+
+  // the listing stays cached while another directory is completed
+  cr_assert_null(dir_index_complete("/", "nsh_no_such", false, &complete));
+  names = dir_index_complete(a, "f29999", false, &complete);
+  cr_assert(complete);
+  cr_assert_eq(arrlen(names), 1);
+  free_matches(names);
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", a);
+  cr_assert_eq(system(cmd), 0);
+  dir_index_free();
+}
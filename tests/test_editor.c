@@ -0,0 +1,224 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifdef NSH_LINE_EDITOR
+
+#include "history/history_index.h"
+#include "shell/editor.h"
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+#include <fcntl.h>
+#include <locale.h>
+
+static int out_fds[2];
+
+// the editor writes to a pipe, its input is given by the tests
+static void start(const char *prompt) {
+  shell_init(true);
+  shell_state_get()->flags.highlight = false;
+  shell_state_get()->flags.autosuggest = false;
+  cr_assert_eq(pipe(out_fds), 0);
+  fcntl(out_fds[0], F_SETFL, O_NONBLOCK);
+  editor_begin(prompt, out_fds[1], out_fds[1]);
+}
+
+static char *drain_output(void) {
+  static char buf[4096];
+  ssize_t n = read(out_fds[0], buf, sizeof(buf) - 1);
+  buf[n > 0 ? n : 0] = '\0';
+  return buf;
+}
+
+static char *feed_line(const char *keys) {
+  cr_assert_eq(editor_feed(keys, strlen(keys)), EDITOR_LINE);
+  char *line = editor_take_line();
+  close(out_fds[0]);
+  close(out_fds[1]);
+  return line;
+}
+
+Test(editor, edits_with_emacs_keys) {
+  start("$ ");
+  // "world", Ctrl-A, "hello ", Ctrl-E, Ctrl-W, "there", left twice, Ctrl-T
+  // swapping the 'e' and 'r' before the cursor
+  char *line = feed_line("world\x01hello \x05\x17there\x1b[D\x1b[D\x14\r");
+  cr_assert_str_eq(line, "hello three");
+  free(line);
+}
+
+Test(editor, kills_and_yanks) {
+  start("$ ");
+  // Ctrl-U kills "abc ", Ctrl-E then Ctrl-Y yanks it at the end
+  char *line = feed_line("abc def\x1b" "b\x15\x05 \x19\r");
+  cr_assert_str_eq(line, "def abc ");
+  free(line);
+}
+
+Test(editor, keeps_utf8_characters_whole) {
+  start("$ ");
+  cr_assert_not_null(setlocale(LC_CTYPE, "C.UTF-8"));
+  // the backspace removes the whole 'é', and 'e' + combining accent
+  char *line = feed_line("caf\xc3\xa9\x7f" "e\xcc\x81!\x02\x02\x7f\r");
+  cr_assert_str_eq(line, "cae\xcc\x81!");
+  free(line);
+}
+
+Test(editor, browses_history) {
+  start("$ ");
+  shell_state_get()->hist->fp = fopen("/dev/null", "w");
+  history_save_command("echo first");
+  history_save_command("echo second");
+  editor_end();
+  editor_begin("$ ", out_fds[1], out_fds[1]);
+
+  // up twice, down once, then back to the line being typed
+  cr_assert_eq(editor_feed("new\x1b[A\x1b[A", 9), EDITOR_MORE);
+  cr_assert_eq(editor_feed("\x0e", 1), EDITOR_MORE);
+  char *line = feed_line("\x0e\r");
+  cr_assert_str_eq(line, "new");
+  free(line);
+}
+
+Test(editor, split_escape_sequence) {
+  start("$ ");
+  cr_assert_eq(editor_feed("ab\x1b", 3), EDITOR_MORE);
+  cr_assert_eq(editor_feed("[", 1), EDITOR_MORE);
+  char *line = feed_line("Dx\r");
+  cr_assert_str_eq(line, "axb");
+  free(line);
+}
+
+Test(editor, typing_at_end_writes_only_the_character) {
+  start("$ ");
+  drain_output();
+  cr_assert_eq(editor_feed("a", 1), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(), "a");
+  cr_assert_eq(editor_feed("b", 1), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(), "b");
+
+  // inserting before the end rewrites the tail and moves back over it
+  cr_assert_eq(editor_feed("\x01x", 2), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(), "\x1b[2Dxab\x1b[2D");
+  free(feed_line("\r"));
+}
+
+Test(editor, highlights_the_changed_cells) {
+  start("$ ");
+  shell_state_get()->flags.highlight = true;
+  drain_output();
+  cr_assert_eq(editor_feed("ech", 3), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(), "\x1b[0;31mech\x1b[0m");
+  // the word becomes a builtin and is written again in its new colour
+  cr_assert_eq(editor_feed("o", 1), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(), "\x1b[3D\x1b[0;36mecho\x1b[0m");
+  cr_assert_eq(editor_feed(" x", 2), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(), " x");
+  free(feed_line("\r"));
+}
+
+Test(editor, suggests_from_history) {
+  start("$ ");
+  shell_state_get()->flags.autosuggest = true;
+  history_index_add("git status --short", time(NULL));
+  drain_output();
+  // the rest of the command is shown after the cursor, then moved back over
+  cr_assert_eq(editor_feed("git s", 5), EDITOR_MORE);
+  cr_assert_str_eq(drain_output(),
+                   "git s\x1b[0;2mtatus --short\x1b[0m\x1b[13D");
+  // Alt-f takes its next word, the right arrow all of it
+  cr_assert_eq(editor_feed("\x1b" "f", 2), EDITOR_MORE);
+  char *line = feed_line("\x1b[C\r");
+  cr_assert_str_eq(line, "git status --short");
+  free(line);
+  history_index_forget("git status --short");
+}
+
+Test(editor, accepts_a_pasted_block_at_once) {
+  start("$ ");
+  // the paste is kept until its end arrives, carriage returns are newlines
+  cr_assert_eq(editor_feed("\x1b[200~echo a\recho b\r\nec", 23),
+               EDITOR_MORE);
+  cr_assert_eq(editor_feed("ho c\x1b[201~", 10), EDITOR_LINE);
+  char *block = editor_take_line();
+  cr_assert_str_eq(block, "echo a\necho b");
+  free(block);
+  close(out_fds[0]);
+  close(out_fds[1]);
+
+  // the text after the last newline starts the next line
+  start("$ ");
+  char *line = feed_line("\r");
+  cr_assert_str_eq(line, "echo c");
+  free(line);
+}
+
+Test(editor, completes_command_names) {
+  start("$ ");
+  char dir[] = "/tmp/nsh_edcomp_XXXXXX";
+  cr_assert_not_null(mkdtemp(dir));
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/zqfoo", dir);
+  close(open(path, O_CREAT | O_WRONLY, 0755));
+  snprintf(path, sizeof(path), "%s/zqfoobar", dir);
+  close(open(path, O_CREAT | O_WRONLY, 0755));
+  shell_state_setenv("PATH", dir);
+
+  // the common prefix, then the list as it adds nothing, then a single match
+  cr_assert_eq(editor_feed("zq\t", 3), EDITOR_MORE);
+  drain_output();
+  cr_assert_eq(editor_feed("\t", 1), EDITOR_MORE);
+  cr_assert_not_null(strstr(drain_output(), "zqfoo     zqfoobar\r\n$ zqfoo"));
+  char *line = feed_line("b\t| zqfoob\t\r");
+  cr_assert_str_eq(line, "zqfoobar | zqfoobar ");
+  free(line);
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+  cr_assert_eq(system(cmd), 0);
+}
+
+Test(editor, completes_file_names) {
+  start("$ ");
+  char dir[] = "/tmp/nsh_edcomp_XXXXXX";
+  cr_assert_not_null(mkdtemp(dir));
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/subdir", dir);
+  cr_assert_eq(mkdir(path, 0755), 0);
+  snprintf(path, sizeof(path), "%s/subdir/notes.txt", dir);
+  close(open(path, O_CREAT | O_WRONLY, 0644));
+
+  // a directory keeps the cursor after its slash, a file gets a space
+  char keys[PATH_MAX + 16];
+  snprintf(keys, sizeof(keys), "cat %s/su\tno\t\r", dir);
+  char *line = feed_line(keys);
+  char want[PATH_MAX + 16];
+  snprintf(want, sizeof(want), "cat %s/subdir/notes.txt ", dir);
+  cr_assert_str_eq(line, want);
+  free(line);
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+  cr_assert_eq(system(cmd), 0);
+}
+
+Test(editor, eof_on_empty_line) {
+  start("$ ");
+  cr_assert_eq(editor_feed("a\x7f\x04", 3), EDITOR_EOF);
+  editor_end();
+  cr_assert_not(editor_active());
+}
+
+Test(editor, keys_after_the_line_are_kept) {
+  start("$ ");
+  free(feed_line("one\rtwo"));
+  start("$ ");
+  char *line = feed_line("\r");
+  cr_assert_str_eq(line, "two");
+  free(line);
+}
+
+#endif
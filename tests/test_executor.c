@@ -0,0 +1,147 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "executor/executor.h"
+#include "expander/procsub.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+
+static int run_input(const char *input) {
+  shell_init(true);
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)input);
+  ast_node_t *ast = parser_create_ast(lex);
+  lexer_free(lex);
+
+  int status = exec_node(ast);
+  parser_free_ast(ast);
+  return status;
+}
+
+Test(executor, expansion_sees_previous_commands) {
+  run_input("export LAZY_A=one; export LAZY_B=$LAZY_A");
+  cr_assert_str_eq(shell_state_getenv("LAZY_B"), "one");
+}
+
+Test(executor, skipped_branch_not_expanded) {
+  // the right side would fail to expand if it were expanded
+  int status = run_input("unset LAZY_C || export /nonexistent_nsh/*");
+  cr_assert_eq(status, 0);
+
+  status = run_input("export /nonexistent_nsh/* && export LAZY_D=1");
+  cr_assert_neq(status, 0);
+  cr_assert_null(shell_state_getenv("LAZY_D"));
+}
+
+static char *read_file(const char *path) {
+  FILE *f = fopen(path, "r");
+  cr_assert_not_null(f);
+  char *buf = NULL;
+  int c;
+  while ((c = fgetc(f)) != EOF)
+    arrpush(buf, (char)c);
+  arrpush(buf, '\0');
+  fclose(f);
+  return buf;
+}
+
+Test(executor, exported_integers_reach_commands) {
+  const char *out = "/tmp/nsh_test_export.out";
+  run_input("export N=1; (( N++ )); let N+=2; : $(( N *= 2 )); "
+            "sh -c 'echo $N' >/tmp/nsh_test_export.out");
+  char *content = read_file(out);
+  cr_assert_str_eq(content, "8\n");
+  arrfree(content);
+  unlink(out);
+  unsetenv("N");
+}
+
+Test(executor, heredoc_and_herestring) {
+  const char *out = "/tmp/nsh_test_heredoc.out";
+  run_input("export HD=doc; cat <<EOF >/tmp/nsh_test_heredoc.out\n"
+            "here $HD $((1 + 1))\nEOF\n");
+  char *content = read_file(out);
+  cr_assert_str_eq(content, "here doc 2\n");
+  arrfree(content);
+
+  run_input("export HD=doc; cat <<< \"$HD  string\" "
+            ">/tmp/nsh_test_heredoc.out");
+  content = read_file(out);
+  cr_assert_str_eq(content, "doc  string\n");
+  arrfree(content);
+
+  // a body larger than a pipe buffer goes through a memfd
+  char *script = NULL;
+  const char *head = "cat <<EOF >/tmp/nsh_test_heredoc.out\n";
+  for (const char *c = head; *c; c++)
+    arrpush(script, *c);
+  for (int i = 0; i < 200000; i++)
+    arrpush(script, i % 64 == 63 ? '\n' : 'x');
+  for (const char *c = "\nEOF\n"; *c; c++)
+    arrpush(script, *c);
+  arrpush(script, '\0');
+  run_input(script);
+  content = read_file(out);
+  cr_assert_eq(strlen(content), 200001);
+  arrfree(content);
+  arrfree(script);
+  unlink(out);
+}
+
+Test(executor, process_substitution) {
+  const char *out = "/tmp/nsh_test_procsub.out";
+  run_input("cat <(echo one) - < <(echo two) >/tmp/nsh_test_procsub.out");
+  char *content = read_file(out);
+  cr_assert_str_eq(content, "one\ntwo\n");
+  arrfree(content);
+
+  // the shell keeps no end of a substitution once the command ran
+  cr_assert_eq(procsub_mark(), 0);
+  unlink(out);
+}
+
+Test(executor, batch_splits_oversized_argv) {
+  const char *out = "/tmp/nsh_test_batch.out";
+  // a few hundred thousand arguments are over ARG_MAX on any system
+  int status = run_input("batch -j 2 /bin/echo /nsh/batch/argument/{1..200000}"
+                         " >/tmp/nsh_test_batch.out");
+  cr_assert_eq(status, 0);
+  char *content = read_file(out);
+  // every argument is followed by a space or, for the last of a chunk, a
+  // newline
+  size_t lines = 0, words = 0;
+  for (char *c = content; *c; c++) {
+    lines += *c == '\n';
+    words += *c == ' ' || *c == '\n';
+  }
+  cr_assert_gt(lines, 1);
+  cr_assert_eq(words, 200000);
+  arrfree(content);
+  unlink(out);
+
+  // the words after the expansion end every invocation
+  status = run_input("batch /bin/echo /nsh/batch/argument/{1..200000} end"
+                     " >/tmp/nsh_test_batch.out");
+  cr_assert_eq(status, 0);
+  content = read_file(out);
+  lines = words = 0;
+  for (char *c = content; *c; c++) {
+    if (*c == '\n') {
+      cr_assert(c - content >= 4 && strncmp(c - 4, " end", 4) == 0);
+      lines++;
+    }
+    words += *c == ' ' || *c == '\n';
+  }
+  cr_assert_gt(lines, 1);
+  cr_assert_eq(words, 200000 + lines);
+  arrfree(content);
+  unlink(out);
+
+  cr_assert_eq(run_input("batch false a b"), 1);
+}
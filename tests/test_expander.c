@@ -11,6 +11,9 @@
 #include "shell/shell.h"
 #include <criterion/criterion.h>
 #include <criterion/redirect.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/stat.h>
 
 static ast_node_t *parse_input(const char *input) {
   // ensure shell is initialized for expansions
@@ -30,7 +33,8 @@ Test(expander, variable) {
   cr_assert_eq(ast->type, NODE_SEQUENCE);
   cr_assert_eq(arrlen(ast->seq.nodes), 1);
   cmd_node_t cmd = ast->seq.nodes[0]->cmd;
-  cr_assert_eq(arrlen(cmd.argv), 5);
+  // the unset variable expands to no field at all
+  cr_assert_eq(arrlen(cmd.argv), 4);
 }
 
 Test(expander, tilde) {
@@ -81,4 +85,358 @@ Test(expander, invalid_globbing) {
   cmd_node_t cmd = ast->seq.nodes[0]->cmd;
   cr_assert_eq(ast->invalid, true);
   cr_assert_eq(cmd.argv, NULL);
-}
\ No newline at end of file
+}
+Test(expander, static_pass) {
+  shell_init(true);
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "echo a\"b\"'c' > out | ls $HOME");
+  ast_node_t *ast = parser_create_ast(lex);
+  expander_static_pass(ast);
+
+  ast_node_t *pipe = ast->seq.nodes[0];
+  cmd_node_t *echo = &pipe->pipe.nodes[0]->cmd;
+  cmd_node_t *ls = &pipe->pipe.nodes[1]->cmd;
+  cr_assert(echo->is_static);
+  cr_assert_eq(arrlen(echo->argv), 2);
+  cr_assert_str_eq(echo->argv[1], "abc");
+  cr_assert_str_eq(echo->redir[0].target, "out");
+  cr_assert_eq(echo->builtin, builtin_get_function("echo"));
+  cr_assert_not(ls->is_static);
+
+  // static commands keep their argv across expansions
+  char **argv = echo->argv;
+  expander_expand_ast(ast);
+  cr_assert_eq(echo->argv, argv);
+  cr_assert_str_eq(ls->argv[1], getenv("HOME"));
+}
+
+Test(expander, memoized_variable) {
+  shell_init(true);
+  shell_state_setenv("FOO", "one");
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "echo $FOO ~");
+  ast_node_t *ast = parser_create_ast(lex);
+  cmd_node_t *cmd = &ast->seq.nodes[0]->cmd;
+
+  expander_expand_ast(ast);
+  char **argv = cmd->argv;
+  cr_assert_str_eq(argv[1], "one");
+
+  // nothing changed, the previous argv is kept
+  expander_expand_ast(ast);
+  cr_assert_eq(cmd->argv, argv);
+
+  shell_state_setenv("FOO", "two");
+  expander_expand_ast(ast);
+  cr_assert_str_eq(cmd->argv[1], "two");
+
+  shell_state_unsetenv("FOO");
+  expander_expand_ast(ast);
+  cr_assert_eq(arrlen(cmd->argv), 2);
+  cr_assert_str_eq(cmd->argv[1], getenv("HOME"));
+}
+
+Test(expander, glob_match) {
+  cr_assert(glob_match("*.log", "a.log"));
+  cr_assert_not(glob_match("*.log", "a.log.1"));
+  cr_assert_not(glob_match("*.log", ".hidden.log"));
+  cr_assert(glob_match(".*", ".hidden"));
+  cr_assert(glob_match("f?[0-9]*", "fx1"));
+  cr_assert_not(glob_match("[!a-c]*", "bar"));
+  cr_assert(glob_match("[]x]", "]"));
+  cr_assert(glob_match("a\\*", "a*"));
+  cr_assert_not(glob_match("a\\*", "ab"));
+  cr_assert(glob_match("*a*b*c", "xxaxbxbc"));
+}
+
+Test(expander, native_glob_matches_glob3) {
+  const char *patterns[] = {"src/*/*.c", "tests/*.c", "src/*/", "*"};
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    char **out = NULL;
+    size_t n = (size_t)glob_expand(patterns[i], 0, &out);
+
+    // glob(3) only appends the '/' of directory patterns with GLOB_MARK
+    size_t len = strlen(patterns[i]);
+    int flags = patterns[i][len - 1] == '/' ? GLOB_MARK : 0;
+    glob_t g = {0};
+    cr_assert_eq(glob(patterns[i], flags, NULL, &g), 0);
+    cr_assert_eq(n, g.gl_pathc);
+    for (size_t j = 0; j < n; j++) {
+      cr_assert_str_eq(out[j], g.gl_pathv[j]);
+      free(out[j]);
+    }
+    globfree(&g);
+    arrfree(out);
+  }
+  glob_cache_free();
+}
+
+Test(expander, globstar_walks_tree_and_prunes) {
+  char root[] = "/tmp/nsh_globstar_XXXXXX";
+  cr_assert_not_null(mkdtemp(root));
+
+  const char *dirs[] = {"a", "a/b", ".git", ".git/x", "d"};
+  const char *files[] = {"top.c", "a/x.c", "a/b/y.c", ".git/x/g.c", "d/w.h"};
+  char path[PATH_MAX];
+  for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+    snprintf(path, sizeof(path), "%s/%s", root, dirs[i]);
+    cr_assert_eq(mkdir(path, 0755), 0);
+  }
+  for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+    snprintf(path, sizeof(path), "%s/%s", root, files[i]);
+    close(open(path, O_CREAT | O_WRONLY, 0644));
+  }
+
+  const char *pruned[] = {"a/b/y.c", "a/x.c", "top.c"};
+  const char *unpruned[] = {".git/x/g.c", "a/b/y.c", "a/x.c", "top.c"};
+  char pattern[PATH_MAX];
+  snprintf(pattern, sizeof(pattern), "%s/**/*.c", root);
+  size_t root_len = strlen(root) + 1;
+
+  char **out = NULL;
+  cr_assert_eq(glob_expand(pattern, GLOB_NATIVE_PRUNE, &out), 3);
+  for (size_t i = 0; i < 3; i++)
+    cr_assert_str_eq(out[i] + root_len, pruned[i]);
+
+  cr_assert_eq(glob_expand(pattern, 0, &out), 4);
+  for (size_t i = 0; i < 4; i++)
+    cr_assert_str_eq(out[3 + i] + root_len, unpruned[i]);
+
+  for (int i = 0; i < arrlen(out); i++)
+    free(out[i]);
+  arrfree(out);
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+  cr_assert_eq(system(cmd), 0);
+}
+
+Test(expander, glob_qualifiers) {
+  char root[] = "/tmp/nsh_globqual_XXXXXX";
+  cr_assert_not_null(mkdtemp(root));
+  char path[PATH_MAX];
+  const char *files[] = {"old", "mid", "new"};
+  const size_t sizes[] = {3000, 10, 0};
+  for (size_t i = 0; i < 3; i++) {
+    snprintf(path, sizeof(path), "%s/%s", root, files[i]);
+    int fd = open(path, O_CREAT | O_WRONLY, 0644);
+    cr_assert_eq(ftruncate(fd, (off_t)sizes[i]), 0);
+    close(fd);
+    struct timespec times[2] = {{.tv_sec = 1000000 * (long)(i + 1)},
+                                {.tv_sec = 1000000 * (long)(i + 1)}};
+    cr_assert_eq(utimensat(AT_FDCWD, path, times, 0), 0);
+  }
+  snprintf(path, sizeof(path), "%s/dir", root);
+  cr_assert_eq(mkdir(path, 0755), 0);
+  snprintf(path, sizeof(path), "%s/link", root);
+  cr_assert_eq(symlink("dir", path), 0);
+
+  char cwd[PATH_MAX];
+  cr_assert_not_null(getcwd(cwd, sizeof(cwd)));
+  cr_assert_eq(chdir(root), 0);
+  ast_node_t *ast = parse_input(
+      "echo *(.); echo *(/); echo *(-/); echo *(^.); echo *(.om); "
+      "echo *(.Lk+1) *(.L-1); echo *(.oL[-2,-1]); echo x*(N); "
+      "echo *(.mw+1[1])");
+  const char *expected[][4] = {{"mid", "new", "old"},
+                               {"dir"},
+                               {"dir", "link"},
+                               {"dir", "link"},
+                               {"new", "mid", "old"},
+                               {"old", "new"},
+                               {"mid", "old"},
+                               {NULL},
+                               {"mid"}};
+  for (int i = 0; i < 9; i++) {
+    cmd_node_t *cmd = &ast->seq.nodes[i]->cmd;
+    int n = 0;
+    while (n < 4 && expected[i][n])
+      n++;
+    cr_assert_eq(arrlen(cmd->argv), n + 1, "command %d", i);
+    for (int j = 0; j < n; j++)
+      cr_assert_str_eq(cmd->argv[j + 1], expected[i][j]);
+  }
+  cr_assert_eq(chdir(cwd), 0);
+  parser_free_ast(ast);
+
+  char cmd[PATH_MAX + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+  cr_assert_eq(system(cmd), 0);
+}
+
+// parses and expands without resetting the shell state
+static ast_node_t *parse_expand(const char *input) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, (char *)input);
+  ast_node_t *ast = parser_create_ast(lex);
+  lexer_free(lex);
+  expander_expand_ast(ast);
+  return ast;
+}
+
+Test(expander, parameter_operations) {
+  shell_init(true);
+  shell_state_setenv("F", "archive.tar.gz");
+  shell_state_setenv("P", "*.gz");
+  shell_state_unsetenv("NOPE");
+
+  const char *input =
+      "${F#*.} ${F##*.} ${F%.*} ${F%%.*} ${#F} ${F/a/A} ${F//a/A} "
+      "${F/#arc/X} ${F/%gz/bz2} \"${NOPE:-d v}\" ${F:+set} ${F%\"$P\"} ${F%$P}";
+  const char *expected[] = {"tar.gz",         "gz",          "archive.tar",
+                            "archive",        "14",          "Archive.tar.gz",
+                            "Archive.tAr.gz", "Xhive.tar.gz", "archive.tar.bz2",
+                            "d v",            "set",         "archive.tar.gz",
+                            "archive.tar"};
+  ast_node_t *ast = parse_expand(input);
+  cmd_node_t cmd = ast->seq.nodes[0]->cmd;
+  cr_assert_eq(arrlen(cmd.argv),
+               sizeof(expected) / sizeof(expected[0]));
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    cr_assert_str_eq(cmd.argv[i], expected[i]);
+  parser_free_ast(ast);
+
+  ast = parse_expand("${NOPE:?unset} ${F:x}");
+  cr_assert(ast->invalid);
+  parser_free_ast(ast);
+}
+
+static void assert_fields(const char *input, const char **expected,
+                          size_t count) {
+  ast_node_t *ast = parse_expand(input);
+  cmd_node_t cmd = ast->seq.nodes[0]->cmd;
+  cr_assert_eq(arrlen(cmd.argv), count, "%s: %td fields", input,
+               arrlen(cmd.argv));
+  for (size_t i = 0; i < count; i++)
+    cr_assert_str_eq(cmd.argv[i], expected[i], "%s", input);
+  parser_free_ast(ast);
+}
+
+Test(expander, field_splitting) {
+  shell_init(true);
+  shell_state_setenv("X", " a  b\tc ");
+  shell_state_setenv("E", "");
+  shell_state_unsetenv("IFS");
+
+  const char *ws[] = {"cmd", "x", "a", "b", "c", "y", "", " a  b\tc "};
+  assert_fields("cmd x$X\"y\" $E \"$E\" \"$X\"", ws, 8);
+
+  // longer than a vector, delimiters on both sides of the boundaries
+  char long_value[256] = "";
+  for (int i = 0; i < 20; i++)
+    strcat(long_value, "word_    \t");
+  shell_state_setenv("L", long_value);
+  ast_node_t *ast = parse_expand("cmd $L");
+  cr_assert_eq(arrlen(ast->seq.nodes[0]->cmd.argv), 21);
+  parser_free_ast(ast);
+
+  shell_state_setenv("IFS", ": ");
+  shell_state_setenv("Y", ":a: :b  c:");
+  const char *colon[] = {"cmd", "", "a", "", "b", "c"};
+  assert_fields("cmd $Y", colon, 6);
+
+  // an empty IFS disables splitting
+  shell_state_setenv("IFS", "");
+  const char *none[] = {"cmd", " a  b\tc "};
+  assert_fields("cmd $X", none, 2);
+}
+
+Test(expander, brace_expansion) {
+  shell_init(true);
+  shell_state_setenv("X", "p q");
+
+  const char *expected[] = {"echo", "ab", "ac", "p", "q", "r",
+                            "{a..1}", "x1", "x2", "x3"};
+  ast_node_t *ast = parse_expand("echo a{b,c} {$X,r} {a..1} x{1..3}");
+  cmd_node_t *cmd = &ast->seq.nodes[0]->cmd;
+  cr_assert_eq(arrlen(cmd->argv), 10);
+  for (int i = 0; i < 10; i++)
+    cr_assert_str_eq(cmd->argv[i], expected[i]);
+
+  // every string lives in a single buffer, one after the other
+  cr_assert_not_null(cmd->argv_arena);
+  cr_assert_eq(cmd->argv[0], cmd->argv_arena);
+  for (int i = 1; i < 10; i++)
+    cr_assert_eq(cmd->argv[i], cmd->argv[i - 1] + strlen(cmd->argv[i - 1]) + 1);
+  parser_free_ast(ast);
+
+  // refused before anything is generated
+  ast = parse_expand("echo {1..1000}{1..1000}{1..1000}");
+  cr_assert(ast->invalid);
+  parser_free_ast(ast);
+}
+
+Test(expander, command_substitution) {
+  shell_init(true);
+  shell_state_unsetenv("IFS");
+
+  // pure builtins run in process, external commands in a subshell
+  const char *expected[] = {"cmd", "a", "b", "x y", "ext", "nested"};
+  assert_fields("cmd $(echo a b) \"$(echo x y)\" `printf 'ext\\n\\n'` "
+                "$(echo $(echo nested))",
+                expected, 6);
+  cr_assert_geq(cmdsub_cache_size(), 3);
+
+  // large outputs go past the capacity of a pipe
+  char path[] = "/tmp/nsh_cmdsub_XXXXXX";
+  int fd = mkstemp(path);
+  cr_assert_neq(fd, -1);
+  char line[] = "0123456789abcdef0123456789abcdef0123456789abcdef012345678\n";
+  for (int i = 0; i < 4096; i++)
+    cr_assert_eq(write(fd, line, sizeof(line) - 1), sizeof(line) - 1);
+  close(fd);
+
+  char input[128];
+  snprintf(input, sizeof(input), "cmd \"$(<%s)\" \"$(cat %s)\"", path, path);
+  ast_node_t *ast = parse_expand(input);
+  cmd_node_t *cmd = &ast->seq.nodes[0]->cmd;
+  cr_assert_eq(arrlen(cmd->argv), 3);
+  cr_assert_eq(strlen(cmd->argv[1]), 4096 * (sizeof(line) - 1) - 1);
+  cr_assert_str_eq(cmd->argv[1], cmd->argv[2]);
+  parser_free_ast(ast);
+  unlink(path);
+
+  // the status of the body is the one of the substitution
+  ast = parse_expand("cmd $(false)");
+  cr_assert_eq(shell_state_get_last_exec()->exit_status, 1);
+  parser_free_ast(ast);
+
+  ast = parse_expand("cmd $(case x)");
+  cr_assert(ast->invalid);
+  parser_free_ast(ast);
+
+  // an arithmetic assignment is local to the subshell
+  shell_state_setenv("i", "1");
+  const char *arith[] = {"cmd", "6", "1", "1"};
+  assert_fields("cmd $(echo $(( i += 5 ))) $(echo $(( i >= 1 ))) $i", arith,
+                4);
+  cr_assert_str_eq(shell_state_getenv("i"), "1");
+}
+
+Test(expander, arithmetic_expansion) {
+  shell_init(true);
+  shell_state_unsetenv("IFS");
+  shell_state_setenv("N", "4");
+  shell_state_setenv("OP", "*");
+
+  const char *expected[] = {"cmd", "13", "8", "-3", "x5y", "0", "4"};
+  assert_fields("cmd $((N * 3 + 1)) $(( N $OP 2 )) \"$((-3))\" "
+                "x$((N + 1))y $(( )) $((N++))",
+                expected, 7);
+  cr_assert_str_eq(shell_state_getenv("N"), "5");
+
+  // assignments run on every expansion, the word is never memoized
+  ast_node_t *ast = parse_expand("(( N += 10 ))");
+  cr_assert_eq(exec_node(ast), 0);
+  cr_assert_eq(exec_node(ast), 0);
+  cr_assert_str_eq(shell_state_getenv("N"), "25");
+  parser_free_ast(ast);
+
+  ast = parse_expand("(( N - 25 ))");
+  cr_assert_eq(exec_node(ast), 1);
+  parser_free_ast(ast);
+
+  ast = parse_expand("cmd $((1 / 0))");
+  cr_assert(ast->invalid);
+  parser_free_ast(ast);
+}
@@ -0,0 +1,80 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#ifdef NSH_LINE_EDITOR
+
+#include "shell/highlight.h"
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+
+static const uint8_t *styles_of(const char *line) {
+  return highlight_line(line, strlen(line));
+}
+
+Test(highlight, styles_each_kind_of_token) {
+  shell_init(true);
+  highlight_reset();
+  const char *line = "echo \"a$HOME\" 'q' *.c 2>out | nosuch_cmd_xyz # end";
+  const uint8_t *st = styles_of(line);
+
+  cr_assert_eq(st[0], HL_BUILTIN);
+  cr_assert_eq(st[5], HL_STRING);
+  cr_assert_eq(st[7], HL_VARIABLE);
+  cr_assert_eq(st[11], HL_VARIABLE);
+  cr_assert_eq(st[12], HL_STRING);
+  cr_assert_eq(st[14], HL_STRING);
+  cr_assert_eq(st[18], HL_GLOB);
+  cr_assert_eq(st[19], HL_DEFAULT);
+  cr_assert_eq(st[22], HL_REDIRECT);
+  cr_assert_eq(st[23], HL_REDIRECT);
+  cr_assert_eq(st[24], HL_DEFAULT);
+  cr_assert_eq(st[28], HL_OPERATOR);
+  cr_assert_eq(st[30], HL_UNKNOWN);
+  cr_assert_eq(st[46], HL_COMMENT);
+  highlight_free();
+}
+
+Test(highlight, incremental_matches_full_scan) {
+  shell_init(true);
+  const char *steps[] = {"l", "ls", "ls ", "ls -", "ls -l", "ls -l |",
+                         "ls -l | ech", "ls -l | echo \"x", "ls -l | echo"};
+  size_t n = sizeof(steps) / sizeof(steps[0]);
+  for (size_t i = 0; i < n; i++) {
+    size_t len = strlen(steps[i]);
+    uint8_t incremental[32];
+    memcpy(incremental, styles_of(steps[i]), len);
+    highlight_reset();
+    cr_assert_eq(memcmp(incremental, styles_of(steps[i]), len), 0, "%s",
+                 steps[i]);
+  }
+  highlight_free();
+}
+
+Test(highlight, long_line_is_finished_over_several_passes) {
+  shell_init(true);
+  highlight_reset();
+  size_t count = 200000, len = count * 5;
+  char *line = xmalloc(len + 1);
+  for (size_t i = 0; i < count; i++)
+    memcpy(line + i * 5, "echo;", 5);
+  line[len] = '\0';
+
+  const uint8_t *st = highlight_line(line, len);
+  cr_assert_eq(st[0], HL_BUILTIN);
+  cr_assert_eq(st[len - 5], HL_DEFAULT);
+  size_t passes = 1;
+  while (st[len - 5] == HL_DEFAULT && passes < 100000) {
+    st = highlight_line(line, len);
+    passes++;
+  }
+  cr_assert_eq(st[len - 5], HL_BUILTIN);
+  cr_assert_eq(st[len - 1], HL_OPERATOR);
+  free(line);
+  highlight_free();
+}
+
+#endif
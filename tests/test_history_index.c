@@ -0,0 +1,123 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "history/history_index.h"
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *suggest(const char *prefix) {
+  return history_index_suggest(prefix, strlen(prefix));
+}
+
+Test(history_index, ranks_by_frequency_and_recency) {
+  history_index_free();
+  time_t t = 1000000;
+  for (int i = 0; i < 4; i++)
+    history_index_add("make test", t);
+  history_index_add("make install", t + HISTORY_FRECENCY_STEP);
+  cr_assert_eq(history_index_size(), 2);
+
+  // four uses are worth two steps, more than a use one step later
+  cr_assert_str_eq(suggest("ma"), "make test");
+  cr_assert_str_eq(suggest("make i"), "make install");
+  cr_assert_null(suggest("make test"));
+  cr_assert_null(suggest("cmake"));
+
+  history_index_add("make install", t + 3 * HISTORY_FRECENCY_STEP);
+  cr_assert_str_eq(suggest("make"), "make install");
+  history_index_free();
+}
+
+Test(history_index, forgets_commands_leaving_the_history) {
+  history_index_free();
+  history_index_add("ls", 10);
+  history_index_add("ls -l", 20);
+  history_index_add("ls -la", 30);
+  history_index_add("ls -la", 40);
+  cr_assert_str_eq(suggest("l"), "ls -la");
+
+  // one occurrence out of two keeps the command, with a lower rank
+  history_index_forget("ls -la");
+  cr_assert_eq(history_index_size(), 3);
+  cr_assert_str_eq(suggest("ls"), "ls -la");
+  history_index_forget("ls -la");
+  cr_assert_eq(history_index_size(), 2);
+  cr_assert_str_eq(suggest("ls"), "ls -l");
+  cr_assert_null(suggest("ls -la"));
+
+  history_index_forget("ls");
+  cr_assert_str_eq(suggest("l"), "ls -l");
+  history_index_forget("ls -l");
+  cr_assert_eq(history_index_size(), 0);
+  cr_assert_null(suggest("l"));
+
+  // the trie is usable again once emptied
+  history_index_add("lsblk", 50);
+  cr_assert_str_eq(suggest("ls"), "lsblk");
+  history_index_free();
+}
+
+Test(history_index, suggests_quickly_among_a_million_commands) {
+  history_index_free();
+  char cmd[64];
+  for (int i = 0; i < 1000000; i++) {
+    snprintf(cmd, sizeof(cmd), "git commit -m 'change %d' --file f%d", i,
+             i % 977);
+    history_index_add(cmd, 1000 + i);
+  }
+  cr_assert_eq(history_index_size(), 1000000);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  const char *best = NULL;
+  for (int i = 0; i < 1000; i++)
+    best = suggest("git commit -m 'change 12");
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  long long ns = (end.tv_sec - start.tv_sec) * 1000000000LL +
+                 (end.tv_nsec - start.tv_nsec);
+  cr_assert_lt(ns / 1000, 1000000, "lookup took %lld ns", ns / 1000);
+  cr_assert_str_eq(best, "git commit -m 'change 129999' --file f58");
+  history_index_free();
+}
+
+Test(history_index, pasted_commands_are_saved_one_by_one) {
+  shell_init(true);
+  shell_state_t *sh = shell_state_get();
+  char path[] = "/tmp/nsh_history_XXXXXX";
+  int fd = mkstemp(path);
+  cr_assert_neq(fd, -1);
+  sh->hist->fp = fdopen(fd, "w+");
+
+  // a here-document body and a loop body are not commands of their own
+  history_save_command("echo pasted a\n\necho pasted b\n"
+                       "cat <<EOF\nrm -rf /tmp/rv/zzz\nEOF\n"
+                       "for f in a b\ndo\n  echo $f\ndone\n");
+  size_t count = history_count();
+  cr_assert_str_eq(history_at(count - 4), "echo pasted a");
+  cr_assert_str_eq(history_at(count - 3), "echo pasted b");
+  cr_assert_str_eq(history_at(count - 2), "cat <<EOF\nrm -rf /tmp/rv/zzz\nEOF");
+  cr_assert_str_eq(history_at(count - 1), "for f in a b\ndo\n  echo $f\ndone");
+  cr_assert_not_null(suggest("echo pasted "));
+  cr_assert_null(suggest("rm -rf"));
+  cr_assert_null(suggest("cat <<"));
+
+  // the commands come back whole from the file
+  fclose(sh->hist->fp);
+  history_free();
+  sh->hist = xmalloc(sizeof(history_t));
+  history_init();
+  shell_state_setenv("HISTFILE", path);
+  history_load();
+  cr_assert_eq(history_count(), 4);
+  cr_assert_str_eq(history_at(0), "echo pasted a");
+  cr_assert_str_eq(history_at(2), "cat <<EOF\nrm -rf /tmp/rv/zzz\nEOF");
+  cr_assert_str_eq(history_at(3), "for f in a b\ndo\n  echo $f\ndone");
+  unlink(path);
+}
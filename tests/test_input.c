@@ -0,0 +1,63 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "shell/shell.h"
+#include <criterion/criterion.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+// feeds text to the input loop through stdin
+static void feed_stdin(const char *text) {
+  int fds[2];
+  cr_assert_eq(pipe(fds), 0);
+  cr_assert_eq(write(fds[1], text, strlen(text)), (ssize_t)strlen(text));
+  close(fds[1]);
+  dup2(fds[0], STDIN_FILENO);
+  close(fds[0]);
+  rl_instream = stdin;
+}
+
+Test(input, reads_lines_until_eof) {
+  shell_init(true);
+  feed_stdin("echo one\necho two\n");
+
+  char *line = input_read_line("");
+  cr_assert_str_eq(line, "echo one");
+  free(line);
+  line = input_read_line("");
+  cr_assert_str_eq(line, "echo two");
+  free(line);
+  cr_assert_null(input_read_line(""));
+  input_cleanup();
+}
+
+Test(input, restores_signal_mask_and_reaps) {
+  shell_init(true);
+  // the SIGCHLD of the child stays pending until the input loop reads it
+  // from its signalfd
+  sigset_t chld, before, after, pending;
+  sigemptyset(&chld);
+  sigaddset(&chld, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &chld, &before);
+  pid_t pid = fork();
+  if (pid == 0)
+    _exit(0);
+  waitid(P_PID, (id_t)pid, NULL, WEXITED | WNOWAIT);
+  feed_stdin("true\n");
+
+  sigprocmask(SIG_SETMASK, NULL, &before);
+  char *line = input_read_line("");
+  free(line);
+  sigprocmask(SIG_SETMASK, NULL, &after);
+  sigpending(&pending);
+
+  cr_assert_eq(sigismember(&after, SIGCHLD), sigismember(&before, SIGCHLD));
+  cr_assert_eq(sigismember(&after, SIGINT), sigismember(&before, SIGINT));
+  cr_assert_not(sigismember(&pending, SIGCHLD));
+  cr_assert_eq(waitpid(pid, NULL, WNOHANG), -1);
+  input_cleanup();
+}
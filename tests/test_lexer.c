@@ -228,3 +228,263 @@ Test(lexer, fd_token) {
 
   lexer_free(lex);
 }
+
+Test(lexer, newline_and_comment) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "a # comment ; b\n\"x\ny\"\n");
+
+  token_t tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_WORD);
+  cr_assert_str_eq(tok.parts[0].value, "a");
+  lexer_free_token(&tok);
+
+  // the comment runs up to the newline
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_NEWLINE);
+
+  // quoted newlines belong to the word
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_WORD);
+  cr_assert_str_eq(tok.parts[0].value, "x\ny");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_NEWLINE);
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_EOF);
+
+  lexer_free(lex);
+}
+
+Test(lexer, param_word_part) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "${f%%.*} \"${x:-a b}\" ${#f} ( ;; )");
+  token_t tok;
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_PARAM);
+  cr_assert_str_eq(tok.parts[0].value, "f%%.*");
+  lexer_free_token(&tok);
+
+  // the body runs up to the matching '}', blanks included
+  tok = lexer_next_token(lex);
+  cr_assert_eq(arrlen(tok.parts), 1);
+  cr_assert_eq(tok.parts[0].type, WORD_PARAM);
+  cr_assert_eq(tok.parts[0].quote, QUOTE_DOUBLE);
+  cr_assert_str_eq(tok.parts[0].value, "x:-a b");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_PARAM);
+  cr_assert_str_eq(tok.parts[0].value, "#f");
+  lexer_free_token(&tok);
+
+  cr_assert_eq(lexer_next_token(lex).type, TOK_LPAREN);
+  cr_assert_eq(lexer_next_token(lex).type, TOK_DSEMI);
+  cr_assert_eq(lexer_next_token(lex).type, TOK_RPAREN);
+  lexer_free(lex);
+}
+
+Test(lexer, brace_word_part) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "a{b,c}d {1..3} {} {a b} '{x,y}'");
+  token_t tok;
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(arrlen(tok.parts), 3);
+  cr_assert_eq(tok.parts[1].type, WORD_BRACE);
+  cr_assert_str_eq(tok.parts[1].value, "b,c");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_BRACE);
+  cr_assert_str_eq(tok.parts[0].value, "1..3");
+  lexer_free_token(&tok);
+
+  // neither a list nor a sequence, or broken by a blank: plain text
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_LITERAL);
+  lexer_free_token(&tok);
+  tok = lexer_next_token(lex);
+  cr_assert_str_eq(tok.raw_value, "{a");
+  lexer_free_token(&tok);
+  tok = lexer_next_token(lex);
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_LITERAL);
+  cr_assert_eq(tok.parts[0].quote, QUOTE_SINGLE);
+  lexer_free_token(&tok);
+  lexer_free(lex);
+}
+
+Test(lexer, cmdsub_word_part) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "a$(echo \"b)\" $(c)) \"`echo \\`x\\``\" '$(no)'");
+  token_t tok;
+
+  // the body runs up to the matching ')', quotes and nesting included
+  tok = lexer_next_token(lex);
+  cr_assert_eq(arrlen(tok.parts), 2);
+  cr_assert_eq(tok.parts[1].type, WORD_CMDSUB);
+  cr_assert_str_eq(tok.parts[1].value, "echo \"b)\" $(c)");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_CMDSUB);
+  cr_assert_eq(tok.parts[0].quote, QUOTE_DOUBLE);
+  cr_assert_str_eq(tok.parts[0].value, "echo `x`");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_LITERAL);
+  lexer_free_token(&tok);
+  lexer_free(lex);
+}
+
+Test(lexer, arith_word_part_and_command) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "x$(( (1 + 2) * n ))y $((a) | (b)) ((i++)) ((a); (b))");
+  token_t tok;
+
+  // the inner parenthesis closes right before the outer one
+  tok = lexer_next_token(lex);
+  cr_assert_eq(arrlen(tok.parts), 3);
+  cr_assert_eq(tok.parts[1].type, WORD_ARITH);
+  cr_assert_str_eq(tok.parts[1].value, " (1 + 2) * n ");
+  lexer_free_token(&tok);
+
+  // otherwise it is a command substitution of a subshell
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_CMDSUB);
+  cr_assert_str_eq(tok.parts[0].value, "(a) | (b)");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_ARITH);
+  cr_assert_str_eq(tok.raw_value, "i++");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_LPAREN);
+  lexer_free(lex);
+}
+
+Test(lexer, heredoc_tokens_and_body) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "cat <<A <<-B <<<w; echo\nbody $x\nA\n\t\ttabs\n\tB\nnext");
+  token_t tok;
+
+  tok = lexer_next_token(lex);
+  lexer_free_token(&tok);
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_HEREDOC);
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_WORD);
+  lexer_free_token(&tok);
+
+  // the bodies follow the line, one after the other
+  char *body = lexer_read_heredoc(lex, "A", false);
+  cr_assert_str_eq(body, "body $x\n");
+  free(body);
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_HEREDOC_STRIP);
+  tok = lexer_next_token(lex);
+  lexer_free_token(&tok);
+  body = lexer_read_heredoc(lex, "B", true);
+  cr_assert_str_eq(body, "tabs\n");
+  free(body);
+  cr_assert_not(lex->heredoc_eof);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_HERESTRING);
+  for (int i = 0; i < 3; i++) {
+    tok = lexer_next_token(lex);
+    lexer_free_token(&tok);
+  }
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_NEWLINE);
+
+  // the lexer resumes after the bodies
+  tok = lexer_next_token(lex);
+  cr_assert_str_eq(tok.raw_value, "next");
+  lexer_free_token(&tok);
+
+  body = lexer_read_heredoc(lex, "C", false);
+  cr_assert(lex->heredoc_eof);
+  free(body);
+  lexer_free(lex);
+}
+
+Test(lexer, heredoc_body_parts) {
+  const char *body = "a 'q' \"$x\" \\$y \\z\\\n$((1 + 2))`cmd`\n";
+  word_part_t *parts = lexer_heredoc_parts(body, strlen(body));
+
+  cr_assert_eq(arrlen(parts), 6);
+  cr_assert_eq(parts[0].type, WORD_LITERAL);
+  cr_assert_str_eq(parts[0].value, "a 'q' \"");
+  cr_assert_eq(parts[1].type, WORD_VARIABLE);
+  cr_assert_eq(parts[1].quote, QUOTE_DOUBLE);
+  cr_assert_str_eq(parts[2].value, "\" $y \\z");
+  cr_assert_eq(parts[3].type, WORD_ARITH);
+  cr_assert_eq(parts[4].type, WORD_CMDSUB);
+  cr_assert_str_eq(parts[5].value, "\n");
+  for (int i = 0; i < arrlen(parts); i++)
+    free(parts[i].value);
+  arrfree(parts);
+}
+
+Test(lexer, procsub_word_part) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "diff <(sort a) x>(tee b) < <(ls)");
+  token_t tok;
+
+  tok = lexer_next_token(lex);
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_WORD);
+  cr_assert_eq(arrlen(tok.parts), 1);
+  cr_assert_eq(tok.parts[0].type, WORD_PROCSUB_IN);
+  cr_assert_str_eq(tok.parts[0].value, "sort a");
+  lexer_free_token(&tok);
+
+  // a substitution does not end the word it is part of
+  tok = lexer_next_token(lex);
+  cr_assert_eq(arrlen(tok.parts), 2);
+  cr_assert_eq(tok.parts[1].type, WORD_PROCSUB_OUT);
+  cr_assert_str_eq(tok.parts[1].value, "tee b");
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_REDIR_IN);
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.parts[0].type, WORD_PROCSUB_IN);
+  lexer_free_token(&tok);
+  lexer_free(lex);
+}
+
+Test(lexer, glob_qualifier_word_part) {
+  lexer_t *lex = lexer_new();
+  lexer_init(lex, "ls src/*.c(om[1,3]) a(.) *(a b)");
+  token_t tok;
+
+  tok = lexer_next_token(lex);
+  lexer_free_token(&tok);
+
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_WORD);
+  cr_assert_eq(arrlen(tok.parts), 4);
+  cr_assert_eq(tok.parts[3].type, WORD_GLOB_QUAL);
+  cr_assert_str_eq(tok.parts[3].value, "(om[1,3])");
+  lexer_free_token(&tok);
+
+  // only a pattern takes qualifiers, and they cannot hold blanks
+  tok = lexer_next_token(lex);
+  cr_assert_eq(arrlen(tok.parts), 1);
+  cr_assert_str_eq(tok.parts[0].value, "a");
+  lexer_free_token(&tok);
+  tok = lexer_next_token(lex);
+  cr_assert_eq(tok.type, TOK_LPAREN);
+  lexer_free(lex);
+}
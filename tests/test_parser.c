@@ -22,6 +22,14 @@ static ast_node_t *parse_input(const char *input) {
   return ast;
 }
 
+static ast_node_t *parse_input_n(const char *input, size_t len) {
+  lexer_t *lex = lexer_new();
+  lexer_init_n(lex, input, len);
+  ast_node_t *ast = parser_create_ast(lex);
+  lexer_free(lex);
+  return ast;
+}
+
 Test(parser, pipeline_with_redirection) {
   const char *input = "echo hello | grep h > out.txt";
   ast_node_t *ast = parse_input(input);
@@ -149,3 +157,232 @@ Test(parser, fd_redirections) {
   cr_assert_str_eq(redir2_target_parts[0].value, "err.log");
   parser_free_ast(ast);
 }
+
+Test(parser, newline_separators) {
+  const char *input = "# comment\necho a # trailing\n\necho b &&\n  echo c |\n cat";
+  ast_node_t *ast = parse_input(input);
+  cr_assert_not_null(ast);
+  cr_assert_eq(ast->type, NODE_SEQUENCE);
+  cr_assert_eq(arrlen(ast->seq.nodes), 2);
+
+  cmd_node_t first_cmd = ast->seq.nodes[0]->cmd;
+  cr_assert_eq(arrlen(first_cmd.argv_parts), 2);
+  cr_assert_str_eq(first_cmd.raw_str, "echo a");
+
+  // newlines after '&&' and '|' continue the statement
+  cond_node_t cond = ast->seq.nodes[1]->cond;
+  cr_assert_eq(cond.op, COND_AND);
+  cr_assert_eq(cond.right->type, NODE_PIPELINE);
+  parser_free_ast(ast);
+}
+
+Test(parser, script_chunks_match_serial) {
+  // large enough to be split and parsed on the thread pool
+  char *script = NULL;
+  for (int i = 0; i < 4000; i++) {
+    char line[128];
+    int n = snprintf(line, sizeof(line),
+                     "echo 'a\nb' %d | cat && \\\n true # c;\nfalse\n", i);
+    for (int j = 0; j < n; j++)
+      arrpush(script, line[j]);
+  }
+
+  ast_node_t *ast = parser_parse_script(script, (size_t)arrlen(script), NULL);
+  ast_node_t *serial = parse_input_n(script, (size_t)arrlen(script));
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 8000);
+  cr_assert_eq(arrlen(ast->seq.nodes), arrlen(serial->seq.nodes));
+
+  for (int i = 0; i < arrlen(ast->seq.nodes); i++) {
+    ast_node_t *a = ast->seq.nodes[i];
+    ast_node_t *b = serial->seq.nodes[i];
+    cr_assert_eq(a->type, b->type);
+    if (a->type == NODE_CMD)
+      cr_assert_str_eq(a->cmd.raw_str, b->cmd.raw_str);
+  }
+  parser_free_ast(ast);
+  parser_free_ast(serial);
+  arrfree(script);
+}
+
+Test(parser, script_with_a_bad_chunk_is_rejected) {
+  // one statement far into a script large enough for the thread pool
+  char *script = NULL;
+  for (int i = 0; i < 8000; i++) {
+    const char *stmt = i == 6000 ? "echo missing >\n" : "echo line | cat\n";
+    for (const char *c = stmt; *c; c++)
+      arrpush(script, *c);
+  }
+  bool error = false;
+  cr_assert_null(parser_parse_script(script, (size_t)arrlen(script), &error));
+  cr_assert(error);
+  arrfree(script);
+}
+
+Test(parser, redirection_errors_are_syntax_errors) {
+  cr_assert_null(parse_input("echo a >"));
+  cr_assert_null(parse_input("cat < | wc"));
+  cr_assert_null(parse_input("echo a |"));
+}
+
+Test(parser, missing_operands_are_syntax_errors) {
+  cr_assert_null(parse_input("echo a &&"));
+  cr_assert_null(parse_input("echo x ||\n"));
+  cr_assert_null(parse_input("| echo hi"));
+  cr_assert_null(parse_input("true && | wc"));
+}
+
+Test(parser, case_command) {
+  const char *input = "case $f in\n"
+                      "  *.c | *.h) echo src; echo ok ;;\n"
+                      "  (README) ;;\n"
+                      "  *) echo other\n"
+                      "esac && echo done";
+  ast_node_t *ast = parse_input(input);
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 1);
+
+  ast_node_t *cond = ast->seq.nodes[0];
+  cr_assert_eq(cond->type, NODE_CONDITIONAL);
+  ast_node_t *node = cond->cond.left;
+  cr_assert_eq(node->type, NODE_CASE);
+
+  case_node_t *c = &node->case_stmt;
+  cr_assert_eq(c->word[0].type, WORD_VARIABLE);
+  cr_assert_eq(arrlen(c->items), 3);
+  cr_assert_eq(arrlen(c->items[0].patterns), 2);
+  cr_assert_eq(arrlen(c->items[0].body->seq.nodes), 2);
+  cr_assert_null(c->items[1].body);
+  cr_assert_str_eq(c->items[2].body->seq.nodes[0]->cmd.raw_str,
+                   "echo other");
+  parser_free_ast(ast);
+}
+
+Test(parser, case_syntax_error) {
+  cr_assert_null(parse_input("case x in a) echo a"));
+  cr_assert_null(parse_input("case x a) echo a;; esac"));
+  cr_assert_null(parse_input("echo (a)"));
+}
+
+Test(parser, script_splits_around_case) {
+  char *script = NULL;
+  for (int i = 0; i < 3000; i++) {
+    const char *stmt = "case $x in\n a) echo a ;;\n *) echo esac\n esac\n"
+                       "echo case\n";
+    for (const char *c = stmt; *c; c++)
+      arrpush(script, *c);
+  }
+
+  ast_node_t *ast = parser_parse_script(script, (size_t)arrlen(script), NULL);
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 6000);
+  for (int i = 0; i < arrlen(ast->seq.nodes); i += 2) {
+    cr_assert_eq(ast->seq.nodes[i]->type, NODE_CASE);
+    cr_assert_eq(ast->seq.nodes[i + 1]->type, NODE_CMD);
+  }
+  parser_free_ast(ast);
+  arrfree(script);
+}
+
+Test(parser, for_loop) {
+  ast_node_t *ast = parse_input("for i in a {1..3} $x; do echo $i; done\n"
+                                "for f\ndo\n echo one\n echo two\ndone");
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 2);
+
+  ast_node_t *node = ast->seq.nodes[0];
+  cr_assert_eq(node->type, NODE_FOR);
+  cr_assert_str_eq(node->for_stmt.var, "i");
+  cr_assert_eq(arrlen(node->for_stmt.words), 3);
+  cr_assert_eq(node->for_stmt.words[1][0].type, WORD_BRACE);
+  cr_assert_eq(arrlen(node->for_stmt.body->seq.nodes), 1);
+
+  node = ast->seq.nodes[1];
+  cr_assert_eq(node->type, NODE_FOR);
+  cr_assert_null(node->for_stmt.words);
+  cr_assert_eq(arrlen(node->for_stmt.body->seq.nodes), 2);
+  parser_free_ast(ast);
+
+  cr_assert_null(parse_input("for i in a b; echo $i; done"));
+  cr_assert_null(parse_input("for i in a; do echo $i"));
+  cr_assert_null(parse_input("for 1x in a; do echo; done"));
+}
+
+Test(parser, arith_command) {
+  ast_node_t *ast = parse_input("(( i += 2 )) && echo $((i))");
+  cr_assert_not_null(ast);
+  ast_node_t *cond = ast->seq.nodes[0];
+  cr_assert_eq(cond->type, NODE_CONDITIONAL);
+  cr_assert_eq(cond->cond.left->type, NODE_ARITH);
+  cr_assert_str_eq(cond->cond.left->arith.expr, " i += 2 ");
+  cr_assert_eq(cond->cond.right->cmd.argv_parts[1][0].type, WORD_ARITH);
+  parser_free_ast(ast);
+}
+
+Test(parser, script_splits_around_loops_and_substitutions) {
+  char *script = NULL;
+  for (int i = 0; i < 3000; i++) {
+    const char *stmt = "for i in a b\ndo\n echo $(echo x\n echo done)\n"
+                       "done\necho `echo\n format`\n";
+    for (const char *c = stmt; *c; c++)
+      arrpush(script, *c);
+  }
+
+  ast_node_t *ast = parser_parse_script(script, (size_t)arrlen(script), NULL);
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 6000);
+  for (int i = 0; i < arrlen(ast->seq.nodes); i += 2) {
+    cr_assert_eq(ast->seq.nodes[i]->type, NODE_FOR);
+    cr_assert_eq(ast->seq.nodes[i + 1]->type, NODE_CMD);
+  }
+  parser_free_ast(ast);
+  arrfree(script);
+}
+
+Test(parser, heredoc_redirections) {
+  ast_node_t *ast = parse_input("cat <<EOF 2<<'Q' <<< \"$s\"\n$x y\nEOF\n"
+                                "$x y\nQ\necho next");
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 2);
+
+  cmd_node_t cmd = ast->seq.nodes[0]->cmd;
+  cr_assert_eq(arrlen(cmd.redir), 3);
+  // an unquoted delimiter expands the body
+  cr_assert_eq(cmd.redir[0].type, REDIR_HEREDOC);
+  cr_assert_eq(cmd.redir[0].fd, 0);
+  cr_assert_eq(arrlen(cmd.redir[0].target_parts), 2);
+  cr_assert_eq(cmd.redir[0].target_parts[0].type, WORD_VARIABLE);
+  cr_assert_str_eq(cmd.redir[0].target_parts[1].value, " y\n");
+
+  // a quoted one keeps it literal
+  cr_assert_eq(cmd.redir[1].fd, 2);
+  cr_assert_eq(arrlen(cmd.redir[1].target_parts), 1);
+  cr_assert_eq(cmd.redir[1].target_parts[0].type, WORD_LITERAL);
+  cr_assert_str_eq(cmd.redir[1].target_parts[0].value, "$x y\n");
+
+  cr_assert_eq(cmd.redir[2].type, REDIR_HERESTRING);
+  cr_assert_eq(cmd.redir[2].target_parts[0].type, WORD_VARIABLE);
+
+  cr_assert_str_eq(ast->seq.nodes[1]->cmd.argv_parts[1][0].value, "next");
+  parser_free_ast(ast);
+}
+
+Test(parser, script_splits_around_heredocs) {
+  char *script = NULL;
+  for (int i = 0; i < 3000; i++) {
+    const char *stmt = "cat <<A <<-'B'\necho no\nA\n\techo no\n\tB\necho yes\n";
+    for (const char *c = stmt; *c; c++)
+      arrpush(script, *c);
+  }
+
+  ast_node_t *ast = parser_parse_script(script, (size_t)arrlen(script), NULL);
+  cr_assert_not_null(ast);
+  cr_assert_eq(arrlen(ast->seq.nodes), 6000);
+  for (int i = 0; i < arrlen(ast->seq.nodes); i += 2) {
+    cr_assert_eq(arrlen(ast->seq.nodes[i]->cmd.redir), 2);
+    cr_assert_str_eq(ast->seq.nodes[i + 1]->cmd.argv_parts[1][0].value,
+                     "yes");
+  }
+  parser_free_ast(ast);
+  arrfree(script);
+}
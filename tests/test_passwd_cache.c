@@ -0,0 +1,56 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "shell/passwd_cache.h"
+#include <criterion/criterion.h>
+#include <pwd.h>
+#include <unistd.h>
+
+Test(passwd_cache, positive_and_negative_entries) {
+  passwd_cache_flush();
+  struct passwd *pw = getpwuid(0);
+  cr_assert_not_null(pw);
+  char *expected = strdup(pw->pw_dir);
+
+  char *home = passwd_cache_home(pw->pw_name);
+  cr_assert_str_eq(home, expected);
+  free(home);
+
+  // unknown users are remembered too
+  cr_assert_null(passwd_cache_home("nsh-no-such-user"));
+  cr_assert_eq(passwd_cache_size(), 2);
+  cr_assert_null(passwd_cache_home("nsh-no-such-user"));
+  cr_assert_eq(passwd_cache_size(), 2);
+
+  passwd_cache_insert("nsh-no-such-user", "/nowhere");
+  home = passwd_cache_home("nsh-no-such-user");
+  cr_assert_str_eq(home, "/nowhere");
+  free(home);
+
+  passwd_cache_flush();
+  cr_assert_eq(passwd_cache_size(), 0);
+  free(expected);
+  passwd_cache_free();
+}
+
+Test(passwd_cache, background_prefetch) {
+  passwd_cache_flush();
+  passwd_cache_prefetch();
+  for (int i = 0; i < 500 && passwd_cache_size() == 0; i++)
+    usleep(10000);
+  cr_assert_gt(passwd_cache_size(), 0);
+
+  // served from the prefetched entries
+  struct passwd *pw = getpwuid(0);
+  cr_assert_not_null(pw);
+  size_t size = passwd_cache_size();
+  char *home = passwd_cache_home(pw->pw_name);
+  cr_assert_str_eq(home, pw->pw_dir);
+  cr_assert_eq(passwd_cache_size(), size);
+  free(home);
+  passwd_cache_free();
+}
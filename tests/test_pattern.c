@@ -0,0 +1,89 @@
+/*
+ * Novash — a minimalist shell implementation
+ * Copyright (C) 2025 Thomas Gons
+ *
+ * This file is licensed under the GNU General Public License v3 or later.
+ * See <https://www.gnu.org/licenses/> for details.
+ */
+#include "expander/pattern.h"
+#include <criterion/criterion.h>
+#include <string.h>
+
+static bool match(const char *pattern, const char *s) {
+  return pattern_match(pattern_get(pattern), s, strlen(s));
+}
+
+Test(pattern, fast_paths) {
+  cr_assert_eq(pattern_get("abc")->kind, PATTERN_EXACT);
+  cr_assert_eq(pattern_get("abc*")->kind, PATTERN_PREFIX);
+  cr_assert_eq(pattern_get("*.c")->kind, PATTERN_SUFFIX);
+  cr_assert_eq(pattern_get("*lib*")->kind, PATTERN_CONTAINS);
+  cr_assert_eq(pattern_get("**")->kind, PATTERN_ANY);
+  cr_assert_eq(pattern_get("a?c")->kind, PATTERN_NFA);
+
+  cr_assert(match("*.c", "main.c"));
+  cr_assert_not(match("*.c", "main.h"));
+  cr_assert(match("\\*lit", "*lit"));
+  cr_assert(match("*lib*", "libc.so"));
+  cr_assert_not(match("abc*", "ab"));
+  pattern_cache_free();
+}
+
+Test(pattern, nfa) {
+  cr_assert(match("f?[0-9]*", "fx1"));
+  cr_assert_not(match("[!a-c]*", "bar"));
+  cr_assert(match("[]x]", "]"));
+  cr_assert(match("*a*b*c", "xxaxbxbc"));
+  cr_assert_not(match("*a*b*c", "xxaxbxbcx"));
+  cr_assert(match("[[:digit:]][[:alpha:]]", "1z"));
+  cr_assert(match("a[b", "a[b"));
+
+  // no backtracking: this pattern takes exponential time on a naive matcher
+  char subject[4097];
+  memset(subject, 'a', sizeof(subject) - 1);
+  subject[sizeof(subject) - 1] = '\0';
+  cr_assert_not(match("*a*a*a*a*a*a*a*a*a*a*a*a*b", subject));
+
+  // more than 64 positions spread the state set over several words
+  char pattern[201];
+  for (int i = 0; i < 100; i++) {
+    pattern[2 * i] = '?';
+    pattern[2 * i + 1] = '*';
+  }
+  pattern[200] = '\0';
+  cr_assert(match(pattern, subject));
+  cr_assert_not(match(pattern, "short"));
+  pattern_cache_free();
+}
+
+Test(pattern, prefix_and_suffix) {
+  const char *s = "archive.tar.gz";
+  size_t len = strlen(s);
+  size_t m;
+  const pattern_t *pat = pattern_get("*.");
+  cr_assert(pattern_match_prefix(pat, s, len, false, &m));
+  cr_assert_eq(m, 8);
+  cr_assert(pattern_match_prefix(pat, s, len, true, &m));
+  cr_assert_eq(m, 12);
+
+  pat = pattern_get(".*");
+  cr_assert(pattern_match_suffix(pat, s, len, false, &m));
+  cr_assert_eq(m, 3);
+  cr_assert(pattern_match_suffix(pat, s, len, true, &m));
+  cr_assert_eq(m, 7);
+  cr_assert_not(pattern_match_suffix(pattern_get("x*"), s, len, true, &m));
+  pattern_cache_free();
+}
+
+Test(pattern, leftmost_longest_search) {
+  size_t start, end;
+  const char *s = "xxabbbcabc";
+  cr_assert(pattern_search(pattern_get("ab*c"), s, strlen(s), &start, &end));
+  cr_assert_eq(start, 2);
+  cr_assert_eq(end, 10);
+  cr_assert(pattern_search(pattern_get("b?"), s, strlen(s), &start, &end));
+  cr_assert_eq(start, 3);
+  cr_assert_eq(end, 5);
+  cr_assert_not(pattern_search(pattern_get("z*"), s, strlen(s), &start, &end));
+  pattern_cache_free();
+}